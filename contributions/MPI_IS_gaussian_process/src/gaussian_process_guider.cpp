@@ -84,9 +84,19 @@ GaussianProcessGuider::GaussianProcessGuider(guide_parameters parameters)
 
 GaussianProcessGuider::~GaussianProcessGuider() { }
 
+GaussianProcessGuider::clock::time_point GaussianProcessGuider::Now() const
+{
+    return clock_ ? clock_() : clock::now();
+}
+
+void GaussianProcessGuider::SetClock(const std::function<clock::time_point()>& clock)
+{
+    clock_ = clock;
+}
+
 void GaussianProcessGuider::SetTimestamp()
 {
-    auto current_time = clock::now();
+    auto current_time = Now();
     double delta_measurement_time = std::chrono::duration<double>(current_time - last_time_).count();
     last_time_ = current_time;
     get_last_point().timestamp = std::chrono::duration<double>(current_time - start_time_).count() -
@@ -238,7 +248,7 @@ double GaussianProcessGuider::PredictGearError(double prediction_location)
     // in the first step of each sequence, use the current time stamp as last prediction end
     if (last_prediction_end_ < 0.0)
     {
-        last_prediction_end_ = std::chrono::duration<double>(clock::now() - start_time_).count();
+        last_prediction_end_ = std::chrono::duration<double>(Now() - start_time_).count();
     }
 
     // prediction from the last endpoint to the prediction point
@@ -296,7 +306,7 @@ double GaussianProcessGuider::result(double input, double SNR, double time_step,
     // the starting time is set at the first call of result after startup or reset
     if (get_number_of_measurements() == 1)
     {
-        start_time_ = clock::now();
+        start_time_ = Now();
         last_time_ = start_time_; // this is OK, since last_time_ only provides a minor correction
     }
 
@@ -325,7 +335,7 @@ double GaussianProcessGuider::result(double input, double SNR, double time_step,
     {
         if (prediction_point < 0.0)
         {
-            prediction_point = std::chrono::duration<double>(clock::now() - start_time_).count();
+            prediction_point = std::chrono::duration<double>(Now() - start_time_).count();
         }
         // the point of highest precision shoud be between now and the next step
         UpdateGP(prediction_point + 0.5 * time_step);
@@ -380,7 +390,7 @@ double GaussianProcessGuider::deduceResult(double time_step, double prediction_p
     {
         if (prediction_point < 0.0)
         {
-            prediction_point = std::chrono::duration<double>(clock::now() - start_time_).count();
+            prediction_point = std::chrono::duration<double>(Now() - start_time_).count();
         }
         // the point of highest precision should be between now and the next step
         UpdateGP(prediction_point + 0.5 * time_step);
@@ -416,8 +426,8 @@ void GaussianProcessGuider::reset()
     circular_buffer_data_[0].control = 0; // set first control to zero
 
     last_prediction_end_ = -1.0; // the negative value signals we didn't predict yet
-    start_time_ = clock::now();
-    last_time_ = clock::now();
+    start_time_ = Now();
+    last_time_ = Now();
 
     dither_offset_ = 0.0;
     dither_steps_ = 0;
@@ -573,7 +583,7 @@ void GaussianProcessGuider::inject_data_point(double timestamp, double input, do
     last_prediction_end_ = timestamp;
     get_last_point().timestamp = timestamp; // overrides the usual HandleTimestamps();
 
-    start_time_ = clock::now() - std::chrono::seconds((int) timestamp);
+    start_time_ = Now() - std::chrono::seconds((int) timestamp);
 
     add_one_point(); // add new point here, since the control is for the next point in time
     HandleControls(control); // already store control signal
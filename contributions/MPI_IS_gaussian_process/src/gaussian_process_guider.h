@@ -48,6 +48,7 @@
 #include "math_tools.h"
 
 #include <chrono>
+#include <functional>
 
 enum Hyperparameters
 {
@@ -118,6 +119,9 @@ private:
     clock::time_point start_time_; // reference time
     clock::time_point last_time_;
 
+    //! time source for the timestamps, the steady clock unless replaced with SetClock
+    std::function<clock::time_point()> clock_;
+
     double control_signal_;
     double prediction_;
     double last_prediction_end_;
@@ -144,6 +148,11 @@ private:
      */
     guide_parameters parameters;
 
+    /**
+     * Returns the current time from the clock set with SetClock, or the steady clock.
+     */
+    clock::time_point Now() const;
+
     /**
      * Stores the current time and creates a timestamp for the GP.
      */
@@ -210,6 +219,13 @@ public:
     GaussianProcessGuider(guide_parameters parameters);
     ~GaussianProcessGuider();
 
+    /**
+     * Replaces the steady clock as the time source, e.g. to run recorded
+     * guiding data through the guider faster than real time. An empty
+     * function restores the steady clock.
+     */
+    void SetClock(const std::function<clock::time_point()>& clock);
+
     /**
      * Calculates the control value based on the current input. 1. The input is
      * stored, 2. the GP is updated with the new data point, 3. the prediction
@@ -36,6 +36,8 @@
 #include "Refine_DefMap.h"
 #include "darks_dialog.h"
 
+#include <wx/progdlg.h>
+
 enum
 {
     ID_PREVIEW = 10001,
@@ -66,7 +68,7 @@ static void AddTableEntryPair(wxWindow *parent, wxFlexGridSizer *pTable, const w
 
 RefineDefMap::RefineDefMap(wxWindow *parent)
     : wxDialog(parent, wxID_ANY, _("Refine Bad-pixel Map"), wxDefaultPosition, wxSize(900, 400), wxCAPTION | wxCLOSE_BOX),
-      m_profileId(-1)
+      m_profileId(-1), m_statsValid(false)
 {
     SetSize(wxSize(900, 400));
 
@@ -242,9 +244,8 @@ bool RefineDefMap::InitUI()
         if (RebuildMasterDarks())
             firstTime = true; // Need to get the UI built before finishing up
     }
-    if (DefectMap::DefectMapExists(m_profileId, false) || firstTime)
+    if ((DefectMap::DefectMapExists(m_profileId, false) || firstTime) && !LoadFromProfile())
     {
-        LoadFromProfile();
         if (firstTime)
             ApplyNewMap();
         RefreshPreview();
@@ -252,19 +253,30 @@ bool RefineDefMap::InitUI()
     }
     else
     {
+        // No master dark files to work with, user didn't build them, or cancelled the statistics
         RestoreCameraMode();
-        return false; // No master dark files to work with, user didn't build them
+        m_profileId = -1; // start over next time
+        return false;
     }
 }
 
-// Do the initial layout of the UI controls
-void RefineDefMap::LoadFromProfile()
+// Do the initial layout of the UI controls; returns true if the user cancelled the statistics
+bool RefineDefMap::LoadFromProfile()
 {
     // Let the user know this might take some time...
     ShowStatus(_("Please wait while image statistics are being computed..."), false);
 
     m_darks.LoadDarks();
-    m_builder.Init(m_darks);
+    {
+        wxProgressDialog dlg(_("Refine Bad-pixel Map"), _("Computing dark frame statistics..."), 100, this,
+                             wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_SMOOTH | wxPD_CAN_ABORT);
+        m_statsValid = !m_builder.Init(m_darks, [&dlg](int pct) { return !dlg.Update(pct); });
+    }
+    if (!m_statsValid)
+    {
+        ShowStatus(_("Statistics cancelled"), false);
+        return true;
+    }
 
     const ImageStats& stats = m_builder.GetImageStats();
 
@@ -297,6 +309,7 @@ void RefineDefMap::LoadFromProfile()
     GetBadPxCounts();
     ShowStatus(_("Statistics completed..."), false);
     LoadPreview();
+    return false;
 }
 
 bool RefineDefMap::RebuildMasterDarks()
@@ -307,11 +320,9 @@ bool RefineDefMap::RebuildMasterDarks()
     if (dlg.ShowModal() == wxOK)
     {
         m_darks.LoadDarks();
+        // the caller computes the statistics from the new darks
         if (m_darks.filteredDark.ImageData && m_darks.masterDark.ImageData)
-        {
-            m_builder.Init(m_darks);
             rslt = true;
-        }
     }
     return rslt;
 }
@@ -338,7 +349,20 @@ void RefineDefMap::ApplyNewMap()
     pHotSlider->Enable(false);
     pColdSlider->Enable(false);
     ShowStatus(_("Building new bad-pixel map"), false);
-    m_builder.BuildDefectMap(m_defectMap, true);
+    bool cancelled;
+    {
+        wxProgressDialog dlg(_("Refine Bad-pixel Map"), _("Building new bad-pixel map..."), 100, this,
+                             wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_SMOOTH | wxPD_CAN_ABORT);
+        cancelled = m_builder.BuildDefectMap(m_defectMap, true, [&dlg](int pct) { return !dlg.Update(pct); });
+    }
+    if (cancelled)
+    {
+        ShowStatus(_("Bad-pixel map NOT changed"), false);
+        LoadPreview(); // the preview shows the map still in use
+        pHotSlider->Enable(true);
+        pColdSlider->Enable(true);
+        return;
+    }
     ShowStatus(_("Saving new bad-pixel map file"), false);
     m_defectMap.Save(m_builder.GetMapInfo());
     ShowStatus(_("Loading new bad-pixel map"), false);
@@ -363,7 +387,8 @@ void RefineDefMap::OnGenerate(wxCommandEvent& evt)
         if (RebuildMasterDarks())
         {
             pRebuildDarks->SetValue(false);
-            LoadFromProfile();
+            if (LoadFromProfile())
+                return;
         }
         else
         {
@@ -371,6 +396,8 @@ void RefineDefMap::OnGenerate(wxCommandEvent& evt)
             return; // Couldn't do what we were asked
         }
     }
+    else if (!m_statsValid && LoadFromProfile())
+        return; // the statistics from the last try were cancelled and are still needed
     ApplyNewMap();
 }
 
@@ -401,6 +428,8 @@ void RefineDefMap::GetMiscInfo(MiscInfo& info)
 // Recompute hot/cold pixel counts based on current aggressiveness settings
 void RefineDefMap::Recalc()
 {
+    if (!m_statsValid)
+        return; // nothing to count until the statistics are computed again
     if (manualPixelCount != 0)
     {
         manualPixelCount = 0;
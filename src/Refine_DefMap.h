@@ -48,6 +48,7 @@ class RefineDefMap : public wxDialog
     };
 
     int m_profileId;
+    bool m_statsValid;
     DefectMap m_defectMap;
     DefectMapDarks m_darks;
     DefectMapBuilder m_builder;
@@ -90,7 +91,7 @@ public:
     bool InitUI();
 
 private:
-    void LoadFromProfile();
+    bool LoadFromProfile();
     void GetBadPxCounts();
     void GetMiscInfo(MiscInfo& info);
     void OnGenerate(wxCommandEvent& evt);
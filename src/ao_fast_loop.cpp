@@ -0,0 +1,274 @@
+/*
+ *  ao_fast_loop.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include "phd.h"
+#include "ao_fast_loop.h"
+
+enum
+{
+    MaxCaptureFailures = 5,
+};
+
+AOFastLoop::AOFastLoop(StepGuider *ao, const CaptureParams& params, const wxSize& frameSize, const PHD_Point& lockPos,
+                       int halfSize, double gain)
+    : wxThread(wxTHREAD_JOINABLE), m_ao(ao), m_params(params), m_frameSize(frameSize), m_halfSize(halfSize), m_gain(gain),
+      m_stop(false), m_running(false), m_lockPos(lockPos), m_sumFrames(0), m_sumAoX(0.0), m_sumAoY(0.0)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_elapsed.Start();
+}
+
+AOFastLoop::~AOFastLoop()
+{
+    Stop();
+}
+
+bool AOFastLoop::Start()
+{
+    if (Create() != wxTHREAD_NO_ERROR)
+        return false;
+
+    m_running = true;
+    if (Run() != wxTHREAD_NO_ERROR)
+    {
+        m_running = false;
+        return false;
+    }
+
+    return true;
+}
+
+void AOFastLoop::Stop()
+{
+    m_stop = true;
+    if (IsRunning())
+        Wait();
+}
+
+void AOFastLoop::SetLockPosition(const PHD_Point& lockPos)
+{
+    wxMutexLocker lock(m_lock);
+    m_lockPos = lockPos;
+}
+
+PHD_Point AOFastLoop::AverageAoPosition() const
+{
+    wxMutexLocker lock(m_lock);
+    return m_avgAoPos;
+}
+
+AOFastLoopStats AOFastLoop::GetStats() const
+{
+    wxMutexLocker lock(m_lock);
+    AOFastLoopStats stats(m_stats);
+    stats.active = m_running;
+    long ms = m_elapsed.Time();
+    stats.rate = ms > 0 ? stats.frames * 1000.0 / ms : 0.0;
+    return stats;
+}
+
+void AOFastLoop::Accumulate(const usImage& img, const wxRect& box)
+{
+    wxMutexLocker lock(m_lock);
+
+    // the box only moves when the star wanders away from the lock position; start the sum over
+    // rather than mix frames of two different boxes
+    if (box != m_sumBox || m_sumFrames == 0)
+    {
+        m_sumBox = box;
+        m_sum.assign(box.width * box.height, 0);
+        m_sumFrames = 0;
+        m_sumAoX = m_sumAoY = 0.0;
+    }
+
+    for (int row = 0; row < box.height; row++)
+    {
+        const unsigned short *src = &img.Pixel(box.x, box.y + row);
+        unsigned int *dst = &m_sum[row * box.width];
+        for (int i = 0; i < box.width; i++)
+            dst[i] += src[i];
+    }
+
+    ++m_sumFrames;
+    m_sumAoX += m_ao->CurrentPosition(RIGHT);
+    m_sumAoY += m_ao->CurrentPosition(UP);
+}
+
+bool AOFastLoop::TakeFrame(usImage& img, int durationMs)
+{
+    // the fast loop keeps capturing while the guide cycle's exposure time goes by; if it stops
+    // meanwhile, use what it has rather than sit out the rest of the cycle
+    wxStopWatch swatch;
+    while (m_running)
+    {
+        long remaining = durationMs - swatch.Time();
+        if (remaining <= 0)
+            break;
+        if (WorkerThread::MilliSleep(wxMin(remaining, 20L), WorkerThread::INT_ANY))
+            return true;
+    }
+
+    while (true)
+    {
+        {
+            wxMutexLocker lock(m_lock);
+
+            if (m_sumFrames > 0)
+            {
+                img.InitImgStartTime();
+                if (img.InitSubframe(m_frameSize, m_sumBox))
+                    return true;
+
+                unsigned int n = m_sumFrames;
+                for (unsigned int i = 0; i < img.NPixels; i++)
+                    img.ImageData[i] = (unsigned short) ((m_sum[i] + n / 2) / n);
+
+                img.LimitFrame = m_params.limitFrame;
+                img.Binning = m_params.CombinedBinning();
+                img.BitsPerPixel = m_params.bpp;
+                img.Gain = m_params.gain;
+                img.ImgExpDur = m_params.duration;
+                img.ImgStackCnt = n;
+
+                m_avgAoPos.SetXY(m_sumAoX / n, m_sumAoY / n);
+                m_sumFrames = 0;
+
+                // the subframes are captured raw; reconstruct the mean as a guide frame would be
+                if (pCamera->HasBayer && m_params.CombinedBinning() == 1)
+                    QuickLRecon(img);
+
+                return false;
+            }
+        }
+
+        // the camera is slower than the guide cycle; wait for its next frame
+        if (!m_running || WorkerThread::MilliSleep(5, WorkerThread::INT_ANY))
+            return true;
+    }
+}
+
+wxThread::ExitCode AOFastLoop::Entry()
+{
+    Debug.Write(wxString::Format("AO fast loop: starting, exposure %d ms, box %d px, gain %.2f\n", m_params.duration,
+                                 2 * m_halfSize + 1, m_gain));
+
+    usImage img;
+    PHD_Point center;
+    {
+        wxMutexLocker lock(m_lock);
+        center = m_lockPos;
+    }
+    unsigned int failures = 0;
+    wxString failure;
+
+    while (!m_stop && !TestDestroy())
+    {
+        TraceSpan span(TRACE_AO_LOOP);
+
+        wxRect box(ROUND(center.X) - m_halfSize, ROUND(center.Y) - m_halfSize, 2 * m_halfSize + 1, 2 * m_halfSize + 1);
+        box.Intersect(wxRect(m_frameSize));
+        m_params.subframe = box;
+
+        if (GuideCamera::Capture(pCamera, img, m_params) || !img.Storage.Contains(box))
+        {
+            if (++failures >= MaxCaptureFailures)
+            {
+                failure = _("AO fast loop stopped: the camera failed to capture repeatedly");
+                break;
+            }
+            continue;
+        }
+        failures = 0;
+
+        double x, y;
+        bool found = Star::FastCentroid(img, box, &x, &y);
+
+        PHD_Point lockPos;
+        {
+            wxMutexLocker lock(m_lock);
+            lockPos = m_lockPos;
+            ++m_stats.frames;
+            if (!found)
+                ++m_stats.lost;
+        }
+
+        if (found)
+        {
+            bool moved = false;
+            if (m_ao->FastLoopMove(PHD_Point(x - lockPos.X, y - lockPos.Y), m_gain, &moved))
+            {
+                failure = _("AO fast loop stopped: the AO failed to step");
+                break;
+            }
+
+            if (moved)
+            {
+                wxMutexLocker lock(m_lock);
+                ++m_stats.moves;
+            }
+
+            // as the guider does with its subframe, keep the box on the lock position unless the star
+            // is well away from it, after a dither for example
+            PHD_Point star(x, y);
+            center = star.Distance(lockPos) > m_halfSize / 3 ? star : lockPos;
+        }
+
+        Accumulate(img, box);
+    }
+
+    AOFastLoopStats stats = GetStats();
+    Debug.Write(wxString::Format("AO fast loop: stopped after %u frames, %.1f fps, %u lost, %u moves\n", stats.frames,
+                                 stats.rate, stats.lost, stats.moves));
+
+    m_running = false;
+
+    if (!failure.IsEmpty())
+        Failed(failure);
+
+    return nullptr;
+}
+
+void AOFastLoop::Failed(const wxString& reason)
+{
+    Debug.Write(wxString::Format("%s\n", reason));
+
+    // the owner still holds the loop while the thread runs; it is only dropped after Stop() joins it
+    std::weak_ptr<AOFastLoop> self(shared_from_this());
+    PhdApp::ExecInMainThread([self, reason]() {
+        std::shared_ptr<AOFastLoop> loop = self.lock();
+        if (loop && TheAO())
+            TheAO()->FastLoopFailed(loop, reason);
+    });
+}
@@ -0,0 +1,114 @@
+/*
+ *  ao_fast_loop.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef AO_FAST_LOOP_INCLUDED
+#define AO_FAST_LOOP_INCLUDED
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class StepGuider;
+
+struct AOFastLoopStats
+{
+    bool active;
+    unsigned int frames; // subframes captured since the loop started
+    unsigned int lost;   // subframes in which no star stood out from the background
+    unsigned int moves;  // AO steps issued
+    double rate;         // subframes per second
+};
+
+// Tip-tilt correction at the camera's frame rate.
+//
+// While guiding with an AO, the fast loop thread takes over the camera. It captures short exposures
+// of a small box around the lock position, centroids them with Star::FastCentroid, and steps the
+// AO toward the lock position after every frame. The main guide loop keeps its normal cadence:
+// in place of its own exposure, each guide cycle takes the mean of the subframes captured since
+// the previous cycle, which shows the residual error of the fast loop. The AO position averaged
+// over the same subframes drives the mount bumps.
+//
+// If the loop gives up on its own, after repeated capture or AO failures, it asks the main thread
+// to drop it and alert the user; the guide loop goes back to its own exposures in the meantime.
+class AOFastLoop : public wxThread, public std::enable_shared_from_this<AOFastLoop>
+{
+    StepGuider *m_ao;
+    CaptureParams m_params;
+    wxSize m_frameSize;
+    int m_halfSize;
+    double m_gain;
+    std::atomic<bool> m_stop;
+    std::atomic<bool> m_running; // from Run() until Entry() returns
+
+    mutable wxMutex m_lock; // protects the members below
+    PHD_Point m_lockPos;
+    // sum of the subframes captured since the last TakeFrame, and of the AO positions at the time
+    std::vector<unsigned int> m_sum;
+    wxRect m_sumBox;
+    unsigned int m_sumFrames;
+    double m_sumAoX;
+    double m_sumAoY;
+    PHD_Point m_avgAoPos; // AO position averaged over the subframes of the last TakeFrame
+    AOFastLoopStats m_stats;
+    wxStopWatch m_elapsed; // since the loop was started
+
+public:
+    AOFastLoop(StepGuider *ao, const CaptureParams& params, const wxSize& frameSize, const PHD_Point& lockPos, int halfSize,
+               double gain);
+    ~AOFastLoop();
+
+    bool Start();
+    void Stop();
+    bool IsActive() const { return m_running; }
+
+    void SetLockPosition(const PHD_Point& lockPos);
+
+    // Wait for the end of a guide cycle of durationMs and return the mean of the subframes captured
+    // during it. If the loop stops during the cycle, returns the subframes captured so far without
+    // waiting further. Returns true on error, or if the loop stopped before capturing a frame.
+    bool TakeFrame(usImage& img, int durationMs);
+
+    PHD_Point AverageAoPosition() const;
+    AOFastLoopStats GetStats() const;
+
+protected:
+    ExitCode Entry() override;
+
+private:
+    void Accumulate(const usImage& img, const wxRect& box);
+    void Failed(const wxString& reason);
+};
+
+#endif // AO_FAST_LOOP_INCLUDED
@@ -447,8 +447,22 @@ static wxString displayName(const wxString& ascomName)
     return ascomName + _T(" (ASCOM)");
 }
 
-// map descriptive name to progid
+// map descriptive name to progid; filled in on the driver registry's probe thread
 static std::map<wxString, wxString> s_progid;
+static wxMutex s_progidLock;
+
+static void SetProgId(const wxString& displName, const wxString& progid)
+{
+    wxMutexLocker lock(s_progidLock);
+    s_progid[displName] = progid;
+}
+
+static wxString GetProgId(const wxString& displName)
+{
+    wxMutexLocker lock(s_progidLock);
+    auto it = s_progid.find(displName);
+    return it != s_progid.end() ? it->second : wxString();
+}
 
 wxArrayString ASCOMCameraFactory::EnumAscomCameras()
 {
@@ -486,7 +500,7 @@ wxArrayString ASCOMCameraFactory::EnumAscomCameras()
                     wxString ascomName = vval.bstrVal;
                     wxString displName = displayName(ascomName);
                     wxString progid = vkey.bstrVal;
-                    s_progid[displName] = progid;
+                    SetProgId(displName, progid);
                     list.Add(displName);
                 }
             }
@@ -509,9 +523,9 @@ bool CameraASCOM::Create(DispatchObj *obj, DispatchClass *cls)
         return true;
     }
 
-    Debug.Write(wxString::Format("Create ASCOM Camera: choice '%s' progid %s\n", m_choice, s_progid[m_choice]));
+    Debug.Write(wxString::Format("Create ASCOM Camera: choice '%s' progid %s\n", m_choice, GetProgId(m_choice)));
 
-    wxBasicString progid(s_progid[m_choice]);
+    wxBasicString progid(GetProgId(m_choice));
 
     if (!obj->Create(progid))
     {
@@ -40,6 +40,7 @@
 
 # include "cam_indi.h"
 # include "camera.h"
+# include "camera_readout.h"
 # include "config_indi.h"
 # include "image_math.h"
 # include "indi_gui.h"
@@ -120,6 +121,8 @@ private:
     CapturedFrame *m_lastFrame;
 
     usImage *StackImg;
+    std::vector<uint32_t> StackSum; // stream frames are summed here, 16-bit sums would overflow the image
+    int StackBpp;
     int StackFrames;
     volatile bool stacking; // TODO: use a wxCondition to signal completion
     bool has_blob;
@@ -149,6 +152,7 @@ private:
     void CheckState();
     void CameraDialog();
     void CameraSetup();
+    bool InitFrame(usImage& img, bool takeSubframe, const wxRect& subframe, int xsize, int ysize);
     bool ReadFITS(CapturedFrame *cf, usImage& img, bool takeSubframe, const wxRect& subframe);
     bool StackStream(CapturedFrame *cf);
     void SendBinning();
@@ -834,8 +838,158 @@ void CameraINDI::SetCCDdevice()
     }
 }
 
+// A FITS BLOB that can be decoded without CFITSIO: a single 2-D image HDU of unsigned 8-bit
+// pixels, or of 16-bit pixels stored the standard way for unsigned data (BZERO = 32768)
+struct SimpleFitsImage
+{
+    int width;
+    int height;
+    int bpp;
+    const unsigned char *data;
+};
+
+// Parse a header card of the form "KEYWORD = value"; logical values read as 1 or 0
+static bool parse_fits_card(const char *card, std::string *keyword, double *val)
+{
+    if (card[8] != '=')
+        return false;
+
+    keyword->assign(card, 8);
+    keyword->erase(keyword->find_last_not_of(' ') + 1);
+
+    char buf[71];
+    memcpy(buf, card + 10, 70);
+    buf[70] = 0;
+    const char *p = buf;
+    while (*p == ' ')
+        ++p;
+    if (*p == 'T' || *p == 'F')
+    {
+        *val = *p == 'T' ? 1.0 : 0.0;
+        return true;
+    }
+    char *end;
+    *val = strtod(p, &end);
+    return end != p;
+}
+
+// Parse the header of a FITS BLOB. Returns true when the BLOB is not a simple image, in which case
+// it is left to CFITSIO.
+static bool parse_simple_fits(const void *blob, size_t size, SimpleFitsImage *fits)
+{
+    enum
+    {
+        BLOCK = 2880,
+        CARD = 80,
+    };
+
+    const char *hdr = static_cast<const char *>(blob);
+    if (size < BLOCK || strncmp(hdr, "SIMPLE  =", 9) != 0)
+        return true;
+
+    double simple = 0.0, bitpix = 0.0, naxis = 0.0, naxis1 = 0.0, naxis2 = 0.0, bzero = 0.0, bscale = 1.0;
+    size_t pos = 0;
+    for (;; pos += CARD)
+    {
+        if (pos + CARD > size)
+            return true;
+        const char *card = hdr + pos;
+        if (strncmp(card, "END     ", 8) == 0)
+            break;
+
+        std::string keyword;
+        double val;
+        if (!parse_fits_card(card, &keyword, &val))
+            continue;
+        if (keyword == "SIMPLE")
+            simple = val;
+        else if (keyword == "BITPIX")
+            bitpix = val;
+        else if (keyword == "NAXIS")
+            naxis = val;
+        else if (keyword == "NAXIS1")
+            naxis1 = val;
+        else if (keyword == "NAXIS2")
+            naxis2 = val;
+        else if (keyword == "BZERO")
+            bzero = val;
+        else if (keyword == "BSCALE")
+            bscale = val;
+    }
+
+    if (simple != 1.0 || naxis != 2.0 || bscale != 1.0 || naxis1 < 1.0 || naxis2 < 1.0)
+        return true;
+    if (!(bitpix == 16.0 && bzero == 32768.0) && !(bitpix == 8.0 && bzero == 0.0))
+        return true;
+
+    fits->width = (int) naxis1;
+    fits->height = (int) naxis2;
+    fits->bpp = (int) bitpix;
+
+    size_t dataStart = (pos / BLOCK + 1) * BLOCK;
+    size_t dataBytes = (size_t) fits->width * fits->height * (fits->bpp / 8);
+    size_t dataEnd = (dataStart + dataBytes + BLOCK - 1) / BLOCK * BLOCK;
+
+    // the data must be complete, and anything following it means more HDUs
+    if (dataStart + dataBytes > size || size > dataEnd)
+        return true;
+
+    fits->data = reinterpret_cast<const unsigned char *>(hdr) + dataStart;
+    return false;
+}
+
+// Set img up to receive a frame of xsize x ysize pixels. A subframe is stored without the rest
+// of the frame. Returns true on error.
+bool CameraINDI::InitFrame(usImage& img, bool takeSubframe, const wxRect& subframe, int xsize, int ysize)
+{
+    if (takeSubframe)
+    {
+        if (xsize < subframe.width || ysize < subframe.height)
+        {
+            Debug.Write(wxString::Format("INDI Camera: frame %dx%d smaller than subframe %dx%d\n", xsize, ysize,
+                                         subframe.width, subframe.height));
+            return true;
+        }
+        if (img.InitSubframe(FrameSize, subframe))
+        {
+            pFrame->Alert(_("Memory allocation error"));
+            return true;
+        }
+    }
+    else
+    {
+        FrameSize.Set(xsize, ysize);
+
+        if (img.Init(FrameSize))
+        {
+            pFrame->Alert(_("Memory allocation error"));
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool CameraINDI::ReadFITS(CapturedFrame *frame, usImage& img, bool takeSubframe, const wxRect& subframe)
 {
+    if (takeSubframe && FrameSize == UNDEFINED_FRAME_SIZE)
+    {
+        // should never happen since we arranged not to take a subframe
+        // unless full frame size is known
+        Debug.Write("internal error: taking subframe before full frame\n");
+        return true;
+    }
+
+    // Most BLOBs are a plain image which can be decoded straight into img
+    SimpleFitsImage simple;
+    if (!parse_simple_fits(frame->m_data, frame->m_size, &simple))
+    {
+        if (InitFrame(img, takeSubframe, subframe, simple.width, simple.height))
+            return true;
+        ReadoutFrame(img, ReadoutBuffer(simple.data, simple.width, simple.bpp, simple.bpp == 16));
+        return false;
+    }
+
     fitsfile *fptr; // FITS file pointer
     int status = 0; // CFITSIO status value MUST be initialized to zero!
 
@@ -858,14 +1012,27 @@ bool CameraINDI::ReadFITS(CapturedFrame *frame, usImage& img, bool takeSubframe,
     int naxis;
     fits_get_img_dim(fptr, &naxis, &status);
 
+    int nhdus = 0;
+    fits_get_num_hdus(fptr, &nhdus, &status);
+
+    if (naxis == 0 && nhdus == 2)
+    {
+        // fpack-compressed: an empty primary HDU followed by the image, which CFITSIO decompresses
+        if (fits_movabs_hdu(fptr, 2, &hdutype, &status) || hdutype != IMAGE_HDU)
+        {
+            pFrame->Alert(_("FITS file is not of an image"));
+            PHD_fits_close_file(fptr);
+            return true;
+        }
+        fits_get_img_dim(fptr, &naxis, &status);
+        nhdus = 1;
+    }
+
     long fits_size[2];
     fits_get_img_size(fptr, 2, fits_size, &status);
     int xsize = (int) fits_size[0];
     int ysize = (int) fits_size[1];
 
-    int nhdus = 0;
-    fits_get_num_hdus(fptr, &nhdus, &status);
-
     if (naxis == 3)
     {
         pFrame->Alert(_("RGB images are not supported, please switch the INDI driver to Mono"));
@@ -879,28 +1046,16 @@ bool CameraINDI::ReadFITS(CapturedFrame *frame, usImage& img, bool takeSubframe,
         return true;
     }
 
-    long fpixel[3] = { 1, 1, 1 };
-
-    if (takeSubframe)
+    if (InitFrame(img, takeSubframe, subframe, xsize, ysize))
     {
-        if (FrameSize == UNDEFINED_FRAME_SIZE)
-        {
-            // should never happen since we arranged not to take a subframe
-            // unless full frame size is known
-            Debug.Write("internal error: taking subframe before full frame\n");
-            PHD_fits_close_file(fptr);
-            return true;
-        }
-        if (img.Init(FrameSize))
-        {
-            pFrame->Alert(_("Memory allocation error"));
-            PHD_fits_close_file(fptr);
-            return true;
-        }
+        PHD_fits_close_file(fptr);
+        return true;
+    }
 
-        img.Clear();
-        img.Subframe = subframe;
+    long fpixel[3] = { 1, 1, 1 };
 
+    if (takeSubframe && xsize != subframe.width)
+    {
         unsigned short *rawdata = new unsigned short[xsize * ysize];
 
         if (fits_read_pix(fptr, TUSHORT, fpixel, xsize * ysize, nullptr, rawdata, nullptr, &status))
@@ -911,29 +1066,14 @@ bool CameraINDI::ReadFITS(CapturedFrame *frame, usImage& img, bool takeSubframe,
             return true;
         }
 
-        int i = 0;
-        for (int y = 0; y < subframe.height; y++)
-        {
-            unsigned short *dataptr = img.ImageData + (y + subframe.y) * img.Size.GetWidth() + subframe.x;
-            memcpy(dataptr, &rawdata[i], subframe.width * sizeof(unsigned short));
-            i += subframe.width;
-        }
+        ReadoutFrame(img, ReadoutBuffer(rawdata, xsize, 16));
 
         delete[] rawdata;
     }
     else
     {
-        FrameSize.Set(xsize, ysize);
-
-        if (img.Init(FrameSize))
-        {
-            pFrame->Alert(_("Memory allocation error"));
-            PHD_fits_close_file(fptr);
-            return true;
-        }
-
         // Read image
-        if (fits_read_pix(fptr, TUSHORT, fpixel, xsize * ysize, nullptr, img.ImageData, nullptr, &status))
+        if (fits_read_pix(fptr, TUSHORT, fpixel, img.NPixels, nullptr, img.ImageData, nullptr, &status))
         {
             pFrame->Alert(_("Error reading data"));
             PHD_fits_close_file(fptr);
@@ -950,22 +1090,54 @@ bool CameraINDI::StackStream(CapturedFrame *cf)
     if (!StackImg)
         return true;
 
-    if (cf->m_size != StackImg->NPixels)
+    // Stream frames are raw 8- or 16-bit pixels in host byte order, or a FITS image
+    unsigned int npixels = StackImg->NPixels;
+    const unsigned char *data = static_cast<const unsigned char *>(cf->m_data);
+    int bpp;
+    bool fits = false;
+    SimpleFitsImage simple;
+
+    if (cf->m_size == npixels)
+        bpp = 8;
+    else if (cf->m_size == 2 * npixels)
+        bpp = 16;
+    else if (!parse_simple_fits(cf->m_data, cf->m_size, &simple) && simple.width == StackImg->Size.GetWidth() &&
+             simple.height == StackImg->Size.GetHeight())
     {
-        Debug.Write(
-            wxString::Format("INDI Camera: discarding blob with size %d, expected %u\n", cf->m_size, StackImg->NPixels));
+        data = simple.data;
+        bpp = simple.bpp;
+        fits = bpp == 16;
+    }
+    else
+    {
+        Debug.Write(wxString::Format("INDI Camera: discarding blob with size %d, expected %u\n", cf->m_size, npixels));
         return true;
     }
 
     // Add new blob to stacked image
     stacking = true;
 
-    unsigned short *outptr = StackImg->ImageData;
-    const unsigned char *inptr = (unsigned char *) cf->m_data;
+    uint32_t *outptr = StackSum.data();
 
-    for (int i = 0; i < StackImg->NPixels; i++)
-        *outptr++ += (unsigned short) *inptr++;
+    if (bpp == 8)
+    {
+        for (unsigned int i = 0; i < npixels; i++)
+            outptr[i] += data[i];
+    }
+    else if (fits)
+    {
+        for (unsigned int i = 0; i < npixels; i++)
+            outptr[i] += (unsigned short) (((data[2 * i] << 8) | data[2 * i + 1]) ^ 0x8000);
+    }
+    else
+    {
+        const unsigned short *inptr = reinterpret_cast<const unsigned short *>(data);
+        for (unsigned int i = 0; i < npixels; i++)
+            outptr[i] += inptr[i];
+    }
 
+    if (bpp == 16)
+        StackBpp = 16;
     ++StackFrames;
 
     stacking = false;
@@ -1119,7 +1291,7 @@ bool CameraINDI::Capture(usImage& img, const CaptureParams& captureParams)
         first_frame = false;
 
         // exposure complete, process the file
-        if (strcmp(frame->m_format, ".fits") == 0)
+        if (strcmp(frame->m_format, ".fits") == 0 || strcmp(frame->m_format, ".fits.fz") == 0)
         {
             if (INDIConfig::Verbose())
                 Debug.Write(wxString::Format("INDI Camera Processing fits file\n"));
@@ -1170,8 +1342,9 @@ bool CameraINDI::Capture(usImage& img, const CaptureParams& captureParams)
             return true;
         }
 
-        img.Clear();
         StackImg = &img;
+        StackSum.assign(img.NPixels, 0);
+        StackBpp = 8;
 
         // Find INDI switch
         ISwitch *v_on;
@@ -1233,6 +1406,12 @@ bool CameraINDI::Capture(usImage& img, const CaptureParams& captureParams)
             wxMilliSleep(loopwait);
         }
 
+        // 8-bit frames are summed to brighten faint stars; 16-bit frames are averaged since their
+        // sum would not fit in 16 bits
+        uint32_t div = StackBpp == 16 && StackFrames > 0 ? StackFrames : 1;
+        for (unsigned int i = 0; i < img.NPixels; i++)
+            img.ImageData[i] = (unsigned short) std::min(StackSum[i] / div, 65535U);
+
         pFrame->StatusMsg(wxString::Format(_("%d frames"), StackFrames));
 
         if (options & CAPTURE_SUBTRACT_DARK)
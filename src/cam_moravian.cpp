@@ -35,6 +35,7 @@
 #ifdef MORAVIAN_CAMERA
 
 # include "cam_moravian.h"
+# include "camera_readout.h"
 // #include "gxeth.h" TODO - ethernet camera support
 # include "gxusb.h"
 
@@ -813,17 +814,18 @@ bool MoravianCamera::Capture(usImage& img, const CaptureParams& captureParams)
         m_curBinning = HwBinning;
     }
 
-    if (img.Init(FrameSize))
-    {
-        DisconnectWithAlert(CAPT_FAIL_MEMORY);
-        return true;
-    }
-
     bool useSubframe = UseSubframes;
 
     if (subframe.width <= 0 || subframe.height <= 0)
         useSubframe = false;
 
+    // a subframe is stored on its own, so the full frame is neither allocated nor cleared
+    if (useSubframe ? img.InitSubframe(FrameSize, subframe) : img.Init(FrameSize))
+    {
+        DisconnectWithAlert(CAPT_FAIL_MEMORY);
+        return true;
+    }
+
     wxRect frame;
     void *buf;
     unsigned int bufsz;
@@ -875,48 +877,9 @@ bool MoravianCamera::Capture(usImage& img, const CaptureParams& captureParams)
             return true;
     }
 
-    if (useSubframe)
-    {
-        img.Subframe = subframe;
-
-        // Clear out the image
-        img.Clear();
-
-        if (m_bpp == 8)
-        {
-            const unsigned char *src = (const unsigned char *) buf;
-            for (int y = 0; y < subframe.height; y++)
-            {
-                unsigned short *dst = img.ImageData + (y + subframe.y) * FrameSize.GetWidth() + subframe.x;
-                for (int x = 0; x < subframe.width; x++)
-                    *dst++ = *src++;
-            }
-        }
-        else
-        {
-            const unsigned short *src = (const unsigned short *) buf;
-            for (int y = 0; y < subframe.height; y++)
-            {
-                unsigned short *dst = img.ImageData + (y + subframe.y) * FrameSize.GetWidth() + subframe.x;
-                for (int x = 0; x < subframe.width; x++)
-                    *dst++ = *src++;
-            }
-        }
-    }
-    else
-    {
-        if (m_bpp == 8)
-        {
-            unsigned short *dst = img.ImageData;
-            const unsigned char *src = (const unsigned char *) buf;
-            for (unsigned int i = 0; i < img.NPixels; i++)
-                *dst++ = *src++;
-        }
-        else
-        {
-            // 16-bit mode and no subframe: data is already in img.ImageData
-        }
-    }
+    // in 16-bit mode without a subframe the data is already in img.ImageData and is not copied
+    ReadoutBuffer readout(buf, frame.width, m_bpp);
+    ReadoutFrame(img, readout);
 
     if (options & CAPTURE_SUBTRACT_DARK)
         SubtractDark(img);
@@ -37,6 +37,7 @@
 #if defined(OGMA_CAMERA)
 
 # include "cam_ogma.h"
+# include "camera_readout.h"
 # include "ogmacam.h"
 
 // Touptek API uses these Windows definitions even on non-Windows platforms
@@ -533,7 +534,8 @@ bool CameraOgma::Capture(usImage& img, const CaptureParams& captureParams)
         }
     }
 
-    if (img.Init(FrameSize))
+    // a subframe is stored on its own, so the full frame is neither allocated nor cleared
+    if (useSubframe ? img.InitSubframe(FrameSize, subframe) : img.Init(FrameSize))
     {
         DisconnectWithAlert(CAPT_FAIL_MEMORY);
         return true;
@@ -657,53 +659,13 @@ bool CameraOgma::Capture(usImage& img, const CaptureParams& captureParams)
 
     if (useSubframe)
     {
-        img.Subframe = subframe;
-        img.Clear();
-
         int xofs = (subframe.GetLeft() * binning - roi.GetLeft()) / binning;
         int yofs = (subframe.GetTop() * binning - roi.GetTop()) / binning;
 
-        int dxr = sz.x - subframe.width - xofs;
-        if (m_cam.m_bpp == 8)
-        {
-            const unsigned char *src = static_cast<unsigned char *>(m_cam.m_buffer) + yofs * sz.x;
-            unsigned short *dst = img.ImageData + subframe.GetTop() * FrameSize.GetWidth() + subframe.GetLeft();
-            for (int y = 0; y < subframe.height; y++)
-            {
-                unsigned short *d = dst;
-                src += xofs;
-                for (int x = 0; x < subframe.width; x++)
-                    *d++ = (unsigned short) *src++;
-                src += dxr;
-                dst += FrameSize.GetWidth();
-            }
-        }
-        else // bpp == 16
-        {
-            const unsigned short *src = static_cast<unsigned short *>(m_cam.m_buffer) + yofs * sz.x;
-            unsigned short *dst = img.ImageData + subframe.GetTop() * FrameSize.GetWidth() + subframe.GetLeft();
-            for (int y = 0; y < subframe.height; y++)
-            {
-                src += xofs;
-                memcpy(dst, src, subframe.width * sizeof(unsigned short));
-                src += subframe.width + dxr;
-                dst += FrameSize.GetWidth();
-            }
-        }
+        ReadoutFrame(img, ReadoutBuffer(buf, sz.x, m_cam.m_bpp), wxPoint(xofs, yofs));
     }
     else
-    {
-        if (m_cam.m_bpp == 8)
-        {
-            const char *src = static_cast<char *>(m_cam.m_buffer);
-            for (unsigned int i = 0; i < img.NPixels; i++)
-                img.ImageData[i] = *src++;
-        }
-        else
-        {
-            // 16-bit, no subframe: data pulled directly to ImageData
-        }
-    }
+        ReadoutFrame(img, ReadoutBuffer(buf, sz.x, m_cam.m_bpp));
 
     // Debug.Write("OGMA: capture: pull done\n");
 
@@ -38,6 +38,7 @@
 
 # include "camera.h"
 # include "cam_qhy.h"
+# include "camera_readout.h"
 # include "qhyccd.h"
 
 # define QHYCCD_OFF 0.0
@@ -945,15 +946,14 @@ bool Camera_QHY::Capture(usImage& img, const CaptureParams& captureParams)
         useSubframe = false; // subframe may be out of bounds now
     }
 
-    if (img.Init(FrameSize))
+    // a subframe is stored on its own, so the full frame is neither allocated nor cleared
+    if (useSubframe ? img.InitSubframe(FrameSize, subframe) : img.Init(FrameSize))
     {
         DisconnectWithAlert(CAPT_FAIL_MEMORY);
         return true;
     }
 
     wxRect frame = useSubframe ? subframe : wxRect(FrameSize);
-    if (useSubframe)
-        img.Clear();
 
     wxRect roi;
 
@@ -1147,60 +1147,11 @@ bool Camera_QHY::Capture(usImage& img, const CaptureParams& captureParams)
     }
 # endif
 
+    ReadoutBuffer readout(RawBuffer, w, bpp);
     if (useSubframe)
-    {
-        img.Subframe = frame;
-
-        int xofs = subframe.GetLeft() - roi.GetLeft();
-        int yofs = subframe.GetTop() - roi.GetTop();
-
-        int dxr = w - frame.width - xofs;
-        if (bpp == 8)
-        {
-            const unsigned char *src = RawBuffer + yofs * w;
-            unsigned short *dst = img.ImageData + frame.GetTop() * FrameSize.GetWidth() + frame.GetLeft();
-            for (int y = 0; y < frame.height; y++)
-            {
-                unsigned short *d = dst;
-                src += xofs;
-                for (int x = 0; x < frame.width; x++)
-                    *d++ = (unsigned short) *src++;
-                src += dxr;
-                dst += FrameSize.GetWidth();
-            }
-        }
-        else // bpp == 16
-        {
-            const unsigned short *src = (const unsigned short *) RawBuffer + yofs * w;
-            unsigned short *dst = img.ImageData + frame.GetTop() * FrameSize.GetWidth() + frame.GetLeft();
-            for (int y = 0; y < frame.height; y++)
-            {
-                src += xofs;
-                memcpy(dst, src, frame.width * sizeof(unsigned short));
-                src += frame.width + dxr;
-                dst += FrameSize.GetWidth();
-            }
-        }
-    }
+        ReadoutFrame(img, readout, subframe.GetLeftTop() - roi.GetLeftTop()); // RawBuffer holds the ROI
     else
-    {
-        if (bpp == 8)
-        {
-            const unsigned char *src = RawBuffer;
-            unsigned short *dst = img.ImageData;
-            for (int y = 0; y < h; y++)
-            {
-                for (int x = 0; x < w; x++)
-                {
-                    *dst++ = (unsigned short) *src++;
-                }
-            }
-        }
-        else // bpp == 16
-        {
-            memcpy(img.ImageData, RawBuffer, w * h * sizeof(unsigned short));
-        }
-    }
+        ReadoutFrame(img, readout);
 
     if (options & CAPTURE_SUBTRACT_DARK)
         SubtractDark(img);
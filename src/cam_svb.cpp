@@ -35,6 +35,7 @@
 #ifdef SVB_CAMERA
 
 # include "cam_svb.h"
+# include "camera_readout.h"
 # include "SVBCameraSDK.h"
 
 # ifdef __WINDOWS__
@@ -597,12 +598,6 @@ bool SVBCamera::Capture(usImage& img, const CaptureParams& captureParams)
         binning_change = true;
     }
 
-    if (img.Init(FrameSize))
-    {
-        DisconnectWithAlert(CAPT_FAIL_MEMORY);
-        return true;
-    }
-
     wxRect frame;
     wxPoint subframePos; // position of subframe within frame
 
@@ -611,6 +606,13 @@ bool SVBCamera::Capture(usImage& img, const CaptureParams& captureParams)
     if (subframe.width <= 0 || subframe.height <= 0)
         useSubframe = false;
 
+    // a subframe is stored on its own, so the full frame is neither allocated nor cleared
+    if (useSubframe ? img.InitSubframe(FrameSize, subframe) : img.Init(FrameSize))
+    {
+        DisconnectWithAlert(CAPT_FAIL_MEMORY);
+        return true;
+    }
+
     if (useSubframe)
     {
         // ensure transfer size is a multiple of 1024
@@ -775,45 +777,9 @@ bool SVBCamera::Capture(usImage& img, const CaptureParams& captureParams)
     }
 
     if (useSubframe)
-    {
-        img.Subframe = subframe;
-
-        // Clear out the image
-        img.Clear();
-
-        if (m_bpp == 8)
-        {
-            for (int y = 0; y < subframe.height; y++)
-            {
-                const unsigned char *src = buffer + (y + subframePos.y) * frame.width + subframePos.x;
-                unsigned short *dst = img.ImageData + (y + subframe.y) * FrameSize.GetWidth() + subframe.x;
-                for (int x = 0; x < subframe.width; x++)
-                    *dst++ = *src++;
-            }
-        }
-        else
-        {
-            for (int y = 0; y < subframe.height; y++)
-            {
-                const unsigned short *src = (unsigned short *) buffer + (y + subframePos.y) * frame.width + subframePos.x;
-                unsigned short *dst = img.ImageData + (y + subframe.y) * FrameSize.GetWidth() + subframe.x;
-                for (int x = 0; x < subframe.width; x++)
-                    *dst++ = *src++;
-            }
-        }
-    }
+        ReadoutFrame(img, ReadoutBuffer(buffer, frame.width, m_bpp), subframePos);
     else
-    {
-        if (m_bpp == 8)
-        {
-            for (unsigned int i = 0; i < img.NPixels; i++)
-                img.ImageData[i] = buffer[i];
-        }
-        else
-        {
-            // 16-bit mode and no subframe: data is already in img.ImageData
-        }
-    }
+        ReadoutFrame(img, ReadoutBuffer(buffer, FrameSize.GetWidth(), m_bpp));
 
     if (options & CAPTURE_SUBTRACT_DARK)
         SubtractDark(img);
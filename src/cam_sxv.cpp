@@ -38,6 +38,7 @@
 #if defined(SXV)
 
 # include "cam_sxv.h"
+# include "camera_readout.h"
 # include "image_math.h"
 
 # include <wx/choicdlg.h>
@@ -683,25 +684,10 @@ static bool InitImgInterlacedSquare(usImage& img, const wxSize& FrameSize, bool
 static bool InitImgProgressive(usImage& img, unsigned int xofs, unsigned int yofs, unsigned int xsize, unsigned int ysize,
                                bool subframe, const wxSize& FrameSize, const unsigned short *raw)
 {
-    if (img.Init(FrameSize))
+    if (subframe ? img.InitSubframe(FrameSize, wxRect(xofs, yofs, xsize, ysize)) : img.Init(FrameSize))
         return true;
 
-    if (subframe)
-    {
-        const unsigned short *src = raw;
-        img.Subframe = wxRect(xofs, yofs, xsize, ysize);
-        img.Clear();
-        for (unsigned int y = 0; y < ysize; y++)
-        {
-            unsigned short *dst = img.ImageData + (yofs + y) * FrameSize.GetWidth() + xofs;
-            memcpy(dst, src, xsize * sizeof(unsigned short));
-            src += xsize;
-        }
-    }
-    else
-    {
-        memcpy(img.ImageData, raw, img.NPixels * sizeof(unsigned short));
-    }
+    ReadoutFrame(img, ReadoutBuffer(raw, subframe ? xsize : FrameSize.GetWidth(), 16));
 
     return false;
 }
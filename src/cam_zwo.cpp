@@ -37,6 +37,7 @@
 #ifdef ZWO_ASI
 
 # include "cam_zwo.h"
+# include "camera_readout.h"
 # include "ASICamera2.h"
 
 # ifdef __WINDOWS__
@@ -725,34 +726,6 @@ static void flush_buffered_image(int cameraId, void *buf, size_t size)
     }
 }
 
-inline static void copy_rect_8bit(usImage& img, const unsigned char *buffer, const wxRect& subframe, const wxPoint& subframePos,
-                                  const wxRect& frame)
-{
-    // copy bytes from source buffer to target usImage
-    int const image_width = img.Size.GetWidth();
-    for (int y = 0; y < subframe.height; y++)
-    {
-        const unsigned char *src = buffer + (y + subframePos.y) * frame.width + subframePos.x;
-        unsigned short *dst = img.ImageData + (y + subframe.y) * image_width + subframe.x;
-        for (int x = 0; x < subframe.width; x++)
-            *dst++ = *src++;
-    }
-}
-
-inline static void copy_rect_16bit(usImage& img, const unsigned char *buffer, const wxRect& subframe,
-                                   const wxPoint& subframePos, const wxRect& frame)
-{
-    // copy shorts from source buffer to target usImage
-    int const image_width = img.Size.GetWidth();
-    for (int y = 0; y < subframe.height; y++)
-    {
-        const unsigned short *src = (unsigned short *) buffer + (y + subframePos.y) * frame.width + subframePos.x;
-        unsigned short *dst = img.ImageData + (y + subframe.y) * image_width + subframe.x;
-        for (int x = 0; x < subframe.width; x++)
-            *dst++ = *src++;
-    }
-}
-
 bool Camera_ZWO::Capture(usImage& img, const CaptureParams& captureParams)
 {
     int duration = captureParams.duration;
@@ -775,12 +748,6 @@ bool Camera_ZWO::Capture(usImage& img, const CaptureParams& captureParams)
     else
         FrameSize = limit_frame.GetSize();
 
-    if (img.Init(FrameSize))
-    {
-        DisconnectWithAlert(CAPT_FAIL_MEMORY);
-        return true;
-    }
-
     wxRect frame;
     wxPoint subframePos; // position of subframe within frame
     wxPoint limitFramePos; // position of LimitFrame-limited frame within frame
@@ -790,6 +757,13 @@ bool Camera_ZWO::Capture(usImage& img, const CaptureParams& captureParams)
     if (useSubframe && (subframe.width <= 0 || subframe.height <= 0 || binning_change))
         useSubframe = false;
 
+    // a subframe is stored on its own, so the full frame is neither allocated nor cleared
+    if (useSubframe ? img.InitSubframe(FrameSize, subframe) : img.Init(FrameSize))
+    {
+        DisconnectWithAlert(CAPT_FAIL_MEMORY);
+        return true;
+    }
+
     if (useSubframe)
     {
         //  moving the sub-frame or resizing it is somewhat costly (stopCapture / startCapture)
@@ -983,39 +957,10 @@ bool Camera_ZWO::Capture(usImage& img, const CaptureParams& captureParams)
         }
     }
 
-    if (useSubframe)
-    {
-        img.Subframe = subframe;
-
-        // Clear out the image
-        img.Clear();
+    ReadoutBuffer readout(buffer, frame.width, m_bpp);
 
-        if (m_bpp == 8)
-            copy_rect_8bit(img, buffer, subframe, subframePos, frame);
-        else
-            copy_rect_16bit(img, buffer, subframe, subframePos, frame);
-    }
-    else if (limit_frame.IsEmpty())
-    {
-        if (m_bpp == 8)
-        {
-            for (unsigned int i = 0; i < img.NPixels; i++)
-                img.ImageData[i] = buffer[i];
-        }
-        else
-        {
-            // 16-bit mode and no subframe and no LimitFrame: data is already in
-            // img.ImageData
-        }
-    }
-    else // LimitFrame
-    {
-        wxRect destFrame(FrameSize); // aka limit_frame.Size() and img.Size
-        if (m_bpp == 8)
-            copy_rect_8bit(img, buffer, destFrame, limitFramePos, frame);
-        else
-            copy_rect_16bit(img, buffer, destFrame, limitFramePos, frame);
-    }
+    // limitFramePos is (0,0) when there is no LimitFrame
+    ReadoutFrame(img, readout, useSubframe ? subframePos : limitFramePos);
 
     if (options & CAPTURE_SUBTRACT_DARK)
         SubtractDark(img);
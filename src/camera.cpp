@@ -37,7 +37,11 @@
 #include "phd.h"
 
 #include "camera.h"
+#include "camera_readout.h"
+#include "dark_library_cache.h"
+#include "driver_registry.h"
 #include "gear_simulator.h"
+#include "latency_trace.h"
 
 #include <wx/stdpaths.h>
 
@@ -228,6 +232,9 @@ GuideCamera::GuideCamera()
     SwBinning = wxClip(pConfig->Profile.GetInt("/camera/SoftwareBinning", 1), 1, (int) GuideCamera::MAX_SOFTWARE_BINNING);
     CurrentDarkFrame = nullptr;
     CurrentDefectMap = nullptr;
+    m_darkCache = nullptr;
+    m_roiMedianDark = nullptr;
+    m_roiMedian = 0;
 }
 
 GuideCamera::~GuideCamera()
@@ -253,7 +260,7 @@ wxArrayString GuideCamera::GuideCameraList()
 
     CameraList.Add(_("None"));
 #if defined(ASCOM_CAMERA)
-    wxArrayString ascomCameras = ASCOMCameraFactory::EnumAscomCameras();
+    wxArrayString ascomCameras = DriverRegistry::Devices("ASCOM cameras", &ASCOMCameraFactory::EnumAscomCameras);
     for (unsigned int i = 0; i < ascomCameras.Count(); i++)
         CameraList.Add(ascomCameras[i]);
 #endif
@@ -369,10 +376,14 @@ wxArrayString GuideCamera::GuideCameraList()
     CameraList.Add(INDICamName());
 #endif
 #if defined(V4L_CAMERA)
-    if (true == Camera_VIDEODEVICE.ProbeDevices())
-    {
-        CameraList.Add(_T("V4L(2) Camera"));
-    }
+    wxArrayString v4lCameras = DriverRegistry::Devices("V4L cameras", []() {
+        wxArrayString devices;
+        if (true == Camera_VIDEODEVICE.ProbeDevices())
+            devices.Add(_T("V4L(2) Camera"));
+        return devices;
+    });
+    for (unsigned int i = 0; i < v4lCameras.Count(); i++)
+        CameraList.Add(v4lCameras[i]);
 #endif
 #if defined(SIMULATOR)
     CameraList.Add(_T("Simulator"));
@@ -910,6 +921,7 @@ void CameraConfigDialogPane::LayoutControls(GuideCamera *pCamera, BrainCtrlIdMap
     this->Add(pTopline, def_flags);
     this->Add(GetSizerCtrl(CtrlMap, AD_szVariableExposureDelay), def_flags);
     this->Add(GetSizerCtrl(CtrlMap, AD_szAutoExposure), def_flags);
+    this->Add(GetSingleCtrl(CtrlMap, AD_cbPipelinedCapture), def_flags);
 
     this->Layout();
 
@@ -1365,6 +1377,15 @@ wxString GuideCamera::GetSettingsSummary()
                             CurrentDefectMap ? "defect map in use" : "no defect map", pixelSizeStr);
 }
 
+// Drop the pixels of a dark that is backed by the dark library cache; they are loaded again
+// when the dark is next selected
+static void ReleaseDarkPixels(usImage *dark)
+{
+    delete[] dark->ImageData;
+    dark->ImageData = nullptr;
+    dark->NPixels = 0;
+}
+
 void GuideCamera::AddDark(usImage *dark)
 {
     int const expdur = dark->ImgExpDur;
@@ -1372,6 +1393,22 @@ void GuideCamera::AddDark(usImage *dark)
     { // lock scope
         wxCriticalSectionLocker lck(DarkFrameLock);
 
+        if (m_darkCache)
+        {
+            // The library is being modified, so the cache no longer matches it. All the darks are
+            // needed in memory anyway when the modified library is saved.
+            for (ExposureImgMap::iterator it = Darks.begin(); it != Darks.end(); ++it)
+            {
+                usImage *img = it->second;
+                if (!img->ImageData && m_darkCache->Load(m_darkCache->Find(it->first), img))
+                    Debug.Write(wxString::Format("could not load cached dark exposure = %d\n", it->first));
+            }
+            delete m_darkCache;
+            m_darkCache = nullptr;
+        }
+
+        m_roiMedianDark = nullptr;
+
         // free the prior dark with this exposure duration
         ExposureImgMap::iterator pos = Darks.find(expdur);
         if (pos != Darks.end())
@@ -1387,6 +1424,26 @@ void GuideCamera::AddDark(usImage *dark)
     Darks[expdur] = dark;
 }
 
+void GuideCamera::SetDarkLibrary(DarkLibraryCache *cache)
+{
+    ClearDarks();
+
+    wxCriticalSectionLocker lck(DarkFrameLock);
+
+    for (const DarkLibraryCache::Entry& entry : cache->Entries())
+    {
+        usImage *dark = new usImage();
+        DarkLibraryCache::GetInfo(entry, dark);
+
+        ExposureImgMap::iterator pos = Darks.find(entry.expDur);
+        if (pos != Darks.end())
+            delete pos->second;
+        Darks[entry.expDur] = dark;
+    }
+
+    m_darkCache = cache;
+}
+
 void GuideCamera::SelectDark(int exposureDuration)
 {
     // select the dark frame with the smallest exposure >= the requested exposure.
@@ -1394,6 +1451,8 @@ void GuideCamera::SelectDark(int exposureDuration)
 
     wxCriticalSectionLocker lck(DarkFrameLock);
 
+    usImage *prev = CurrentDarkFrame;
+
     CurrentDarkFrame = 0;
     for (ExposureImgMap::const_iterator it = Darks.begin(); it != Darks.end(); ++it)
     {
@@ -1401,6 +1460,25 @@ void GuideCamera::SelectDark(int exposureDuration)
         if (it->first >= exposureDuration)
             break;
     }
+
+    if (m_darkCache)
+    {
+        // keep only the selected dark in memory
+        if (prev && prev != CurrentDarkFrame)
+            ReleaseDarkPixels(prev);
+
+        if (CurrentDarkFrame && !CurrentDarkFrame->ImageData)
+        {
+            int idx = m_darkCache->Find(CurrentDarkFrame->ImgExpDur);
+            if (idx < 0 || m_darkCache->Load(idx, CurrentDarkFrame))
+            {
+                Debug.Write(wxString::Format("could not load cached dark exposure = %d\n", CurrentDarkFrame->ImgExpDur));
+                CurrentDarkFrame = nullptr;
+            }
+        }
+    }
+
+    m_roiMedianDark = nullptr;
 }
 
 void GuideCamera::GetDarkLibraryProperties(int *pNumDarks, double *pMinExp, double *pMaxExp)
@@ -1456,6 +1534,9 @@ void GuideCamera::ClearDarks()
         Darks.erase(it);
     }
     CurrentDarkFrame = nullptr;
+    delete m_darkCache;
+    m_darkCache = nullptr;
+    m_roiMedianDark = nullptr;
 }
 
 void GuideCamera::SubtractDark(usImage& img)
@@ -1464,15 +1545,29 @@ void GuideCamera::SubtractDark(usImage& img)
     // DarkFrameLock to protect against the dark frame disappearing when the main
     // thread does "Load Darks" or "Clear Darks"
 
+    TraceSpan span(TRACE_CALIBRATION);
     wxCriticalSectionLocker lck(DarkFrameLock);
 
     if (CurrentDefectMap)
     {
         RemoveDefects(img, *CurrentDefectMap);
     }
-    else if (CurrentDarkFrame)
+    else if (CurrentDarkFrame && CurrentDarkFrame->ImageData && img.ImageData)
     {
-        Subtract(img, *CurrentDarkFrame);
+        const usImage& dark = *CurrentDarkFrame;
+        if (!IsLightFrameCompatibleWithDarkFrame(img, dark))
+            return;
+
+        // the subframe usually stays put from frame to frame, so its dark median is reused
+        if (m_roiMedianDark != &dark || img.Subframe != m_roiMedianSubframe || img.LimitFrame != m_roiMedianLimitFrame)
+        {
+            m_roiMedian = DarkMedian(img, dark);
+            m_roiMedianDark = &dark;
+            m_roiMedianSubframe = img.Subframe;
+            m_roiMedianLimitFrame = img.LimitFrame;
+        }
+
+        Subtract(img, dark, m_roiMedian);
     }
 }
 
@@ -1549,21 +1644,6 @@ inline static wxRect unbinned_rect(const wxRect& binnedRect, int binning)
     return wxRect(x, y, width, heigth);
 }
 
-// convert a rectangle from un-binned coordinates to binned coordinates
-inline static wxRect binned_rect(const wxRect& unbinnedRect, int binning)
-{
-    auto x = unbinnedRect.GetLeft() / binning;
-    auto y = unbinnedRect.GetTop() / binning;
-    auto width = unbinnedRect.GetWidth() / binning;
-    auto heigth = unbinnedRect.GetHeight() / binning;
-    return wxRect(x, y, width, heigth);
-}
-
-inline static wxSize binned_size(const wxSize& unbinnedSize, int binning)
-{
-    return wxSize(unbinnedSize.x / binning, unbinnedSize.y / binning);
-}
-
 bool GuideCamera::Capture(GuideCamera *camera, usImage& img, const CaptureParams& captureParams)
 {
     // The subframe and LimitFrame are in software-binned coordinates, but the camera
@@ -1583,26 +1663,24 @@ bool GuideCamera::Capture(GuideCamera *camera, usImage& img, const CaptureParams
     img.Gain = captureParams.gain;
     img.ImgExpDur = captureParams.duration;
 
-    bool err = camera->Capture(img, cameraParams);
+    bool err;
+    {
+        wxMutexLocker lock(camera->m_captureLock);
+        TraceSpan span(TRACE_CAPTURE);
+        err = camera->Capture(img, cameraParams);
+    }
     if (err)
         return err;
 
-    // perform software binning if needed
+    // perform software binning if needed, reusing the image's own pixel buffer
     if (swBinning > 1)
     {
-        usImage binnedImage;
-        if (binnedImage.Init(binned_size(img.Size, swBinning)))
+        if (BinImageInPlace(img, swBinning))
         {
-            camera->DisconnectWithAlert(CAPT_FAIL_MEMORY);
+            Debug.Write(wxString::Format("software binning %d failed\n", swBinning));
             return true;
         }
-        BinPixels(binnedImage.ImageData, img.ImageData, img.Size, swBinning);
-        img.SwapImageData(binnedImage);
-        img.Size = binnedImage.Size;
-        img.NPixels = binnedImage.NPixels;
         img.Binning *= swBinning;
-        // scale the subframe from camera coords to binned coords
-        img.Subframe = binned_rect(img.Subframe, swBinning);
     }
 
     return err;
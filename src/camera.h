@@ -37,6 +37,7 @@
 
 typedef std::map<int, usImage *> ExposureImgMap; // map exposure to image
 class DefectMap;
+class DarkLibraryCache;
 
 enum PropDlgType
 {
@@ -131,6 +132,15 @@ class GuideCamera : public wxMessageBoxProxy, public OnboardST4
 
     double m_pixelSize;
 
+    DarkLibraryCache *m_darkCache; // backs the darks while a dark library is loaded and unmodified
+    // dark median over the area of the last subtracted frame, recomputed when the dark or the area changes
+    const usImage *m_roiMedianDark;
+    wxRect m_roiMedianSubframe;
+    wxRect m_roiMedianLimitFrame;
+    unsigned short m_roiMedian;
+
+    wxMutex m_captureLock; // one capture at a time: the worker thread and the AO fast loop share the camera
+
 protected:
     bool m_hasGuideOutput;
     int m_timeoutMs;
@@ -184,6 +194,9 @@ public:
 
     virtual bool HasNonGuiCapture() = 0;
     virtual wxByte BitsPerPixel() = 0;
+    // true if the driver can start a new exposure while a guide pulse from the previous frame is
+    // still being issued on another thread (pipelined capture)
+    virtual bool CanOverlapExposures() { return false; }
 
     static bool Capture(GuideCamera *camera, usImage& img, const CaptureParams& capture);
 
@@ -239,6 +252,9 @@ public:
 
     virtual wxString GetSettingsSummary();
     void AddDark(usImage *dark);
+    // replace the darks with the ones in a dark library cache, taking ownership of the cache; only
+    // the selected dark's pixels are loaded
+    void SetDarkLibrary(DarkLibraryCache *cache);
     void SelectDark(int exposureDuration);
     void SetDefectMap(DefectMap *newMap);
     void ClearDefectMap();
@@ -0,0 +1,203 @@
+/*
+ *  camera_readout.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+#include "camera_readout.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define HAVE_SSE2_READOUT
+#endif
+
+static void WidenRow(unsigned short *dst, const unsigned char *src, int n)
+{
+    int i = 0;
+#ifdef HAVE_SSE2_READOUT
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128((__m128i *) (dst + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = src[i];
+}
+
+// FITS stores unsigned 16-bit data big-endian as signed values with BZERO = 32768: swap the
+// bytes and flip the sign bit
+static void FitsRow(unsigned short *dst, const unsigned char *src, int n)
+{
+    int i = 0;
+#ifdef HAVE_SSE2_READOUT
+    const __m128i sign = _mm_set1_epi16((short) 0x8000);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + 2 * i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_xor_si128(v, sign));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = (unsigned short) (((src[2 * i] << 8) | src[2 * i + 1]) ^ 0x8000);
+}
+
+static void CopyRow(unsigned short *dst, const ReadoutBuffer& buf, int x, int y, int n)
+{
+    size_t ofs = (size_t) y * buf.width + x;
+    if (buf.bpp == 8)
+        WidenRow(dst, static_cast<const unsigned char *>(buf.data) + ofs, n);
+    else if (buf.fits)
+        FitsRow(dst, static_cast<const unsigned char *>(buf.data) + 2 * ofs, n);
+    else
+        memcpy(dst, static_cast<const unsigned short *>(buf.data) + ofs, n * sizeof(unsigned short));
+}
+
+void ReadoutFrame(usImage& img, const ReadoutBuffer& buf, const wxPoint& pos)
+{
+    int width = img.Storage.GetWidth();
+    int height = img.Storage.GetHeight();
+
+    if (buf.data == img.ImageData && buf.bpp == 16 && !buf.fits && buf.width == width && pos == wxPoint(0, 0))
+        return; // pulled straight into the image
+
+    if (buf.width == width && pos.x == 0)
+    {
+        // contiguous rows, copy as a single run
+        CopyRow(img.ImageData, buf, 0, pos.y, width * height);
+        return;
+    }
+
+    for (int y = 0; y < height; y++)
+        CopyRow(img.ImageData + (size_t) y * width, buf, pos.x, pos.y + y, width);
+}
+
+// Average 2x2 blocks of a pair of source rows into one destination row. The destination may be
+// the start of the first source row.
+static void Bin2Row(unsigned short *dst, const unsigned short *r0, const unsigned short *r1, int outWidth)
+{
+    int x = 0;
+#ifdef HAVE_SSE2_READOUT
+    const __m128i lo16 = _mm_set1_epi32(0xffff);
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16((short) 0x8000);
+    for (; x + 8 <= outWidth; x += 8)
+    {
+        // 16 source pixels from each row give 8 output pixels; sums are formed in 32-bit lanes
+        __m128i a0 = _mm_loadu_si128((const __m128i *) (r0 + 2 * x));
+        __m128i a1 = _mm_loadu_si128((const __m128i *) (r0 + 2 * x + 8));
+        __m128i b0 = _mm_loadu_si128((const __m128i *) (r1 + 2 * x));
+        __m128i b1 = _mm_loadu_si128((const __m128i *) (r1 + 2 * x + 8));
+
+        __m128i s0 = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(a0, lo16), _mm_srli_epi32(a0, 16)),
+                                   _mm_add_epi32(_mm_and_si128(b0, lo16), _mm_srli_epi32(b0, 16)));
+        __m128i s1 = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(a1, lo16), _mm_srli_epi32(a1, 16)),
+                                   _mm_add_epi32(_mm_and_si128(b1, lo16), _mm_srli_epi32(b1, 16)));
+
+        // average, then pack to unsigned 16 bits via the signed pack
+        s0 = _mm_sub_epi32(_mm_srli_epi32(s0, 2), bias32);
+        s1 = _mm_sub_epi32(_mm_srli_epi32(s1, 2), bias32);
+        _mm_storeu_si128((__m128i *) (dst + x), _mm_add_epi16(_mm_packs_epi32(s0, s1), bias16));
+    }
+#endif
+    for (; x < outWidth; x++)
+    {
+        unsigned int sum = r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1];
+        dst[x] = (unsigned short) (sum / 4);
+    }
+}
+
+bool BinImageInPlace(usImage& img, int binning)
+{
+    if (binning < 2 || binning > 4)
+        return true;
+
+    // Blocks are aligned to the frame, so when only a subframe is stored the binned image holds
+    // the blocks that lie entirely within it
+    const wxRect& storage = img.Storage;
+    int x0 = (storage.GetLeft() + binning - 1) / binning;
+    int y0 = (storage.GetTop() + binning - 1) / binning;
+    wxRect out(x0, y0, std::max((storage.GetRight() + 1) / binning - x0, 0),
+               std::max((storage.GetBottom() + 1) / binning - y0, 0));
+
+    int width = storage.GetWidth();
+    int outWidth = out.GetWidth();
+    int outHeight = out.GetHeight();
+    unsigned short *const data = img.ImageData;
+    const unsigned short *const first = data + (size_t) (y0 * binning - storage.y) * width + x0 * binning - storage.x;
+
+    // Every binned pixel lands at or before the first source pixel of its block, and blocks are
+    // processed in order, so no source pixel is overwritten before it has been read. The SSE2
+    // row pass reads a full vector of each source row before storing, which keeps that property.
+    for (int y = 0; y < outHeight; y++)
+    {
+        const unsigned short *src = first + (size_t) y * binning * width;
+        unsigned short *dst = data + (size_t) y * outWidth;
+
+        if (binning == 2)
+        {
+            Bin2Row(dst, src, src + width, outWidth);
+            continue;
+        }
+
+        unsigned int n = binning * binning;
+        for (int x = 0; x < outWidth; x++)
+        {
+            unsigned int sum = 0;
+            const unsigned short *p = src + x * binning;
+            for (int j = 0; j < binning; j++, p += width)
+                for (int i = 0; i < binning; i++)
+                    sum += p[i];
+            dst[x] = (unsigned short) (sum / n);
+        }
+    }
+
+    bool subframeStorage = img.HasSubframeStorage();
+
+    img.Size = wxSize(img.Size.GetWidth() / binning, img.Size.GetHeight() / binning);
+    img.Storage = subframeStorage ? out : wxRect(img.Size);
+    img.NPixels = outWidth * outHeight;
+
+    // scale the subframe from camera coords to binned coords
+    if (subframeStorage)
+        img.Subframe = out;
+    else if (!img.Subframe.IsEmpty())
+        img.Subframe = wxRect(img.Subframe.x / binning, img.Subframe.y / binning, img.Subframe.width / binning,
+                              img.Subframe.height / binning);
+
+    return false;
+}
@@ -0,0 +1,72 @@
+/*
+ *  camera_readout.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef CAMERA_READOUT_INCLUDED
+#define CAMERA_READOUT_INCLUDED
+
+class usImage;
+
+// Transfer of frame data from a camera SDK buffer into a usImage.
+//
+// SDKs deliver frames as rows of 8- or 16-bit pixels, often with a row width (the camera ROI)
+// that differs from the usImage. These routines copy the wanted rectangle in a single pass over
+// the destination, widening 8-bit pixels on the way. Drivers set up a subframe capture with
+// usImage::InitSubframe before reading out, so the rest of the frame is neither allocated nor
+// cleared.
+
+// A frame buffer as returned by the SDK
+struct ReadoutBuffer
+{
+    const void *data;
+    int width; // pixels per row
+    int bpp;   // 8 or 16
+    bool fits; // 16-bit FITS data: big-endian signed values offset by BZERO = 32768
+
+    ReadoutBuffer(const void *data_, int width_, int bpp_, bool fits_ = false)
+        : data(data_), width(width_), bpp(bpp_), fits(fits_)
+    {
+    }
+};
+
+// Fill the stored area of img (all of img.Size unless it holds just a subframe) from the buffer,
+// starting at buffer pixel pos. When the buffer is img's own pixel data the copy is skipped.
+extern void ReadoutFrame(usImage& img, const ReadoutBuffer& buf, const wxPoint& pos = wxPoint(0, 0));
+
+// Software-bin img in place by averaging binning x binning blocks. Rows and columns that do not
+// fill a whole block are dropped. No second image is allocated: the binned pixels are written
+// over the start of the pixel buffer, and Size, Storage, NPixels and Subframe are scaled down.
+// Returns true on error.
+extern bool BinImageInPlace(usImage& img, int binning);
+
+#endif
@@ -67,6 +67,7 @@ enum BRAIN_CTRL_IDS
     AD_szSaturationOptions,
     AD_szCameraTimeout,
     AD_szTimeLapse,
+    AD_cbPipelinedCapture,
     AD_szPixelSize,
     AD_szGain,
     AD_szBinning,
@@ -103,6 +104,7 @@ enum BRAIN_CTRL_IDS
     AD_szBumpBLCompCtrls,
     AD_cbClearAOCalibration,
     AD_cbEnableAOGuiding,
+    AD_szAOFastLoop,
     AD_cbRotatorReverse,
     AD_DEVICES_TAB_BOUNDARY // ----------- end of devices tab controls
 };
@@ -0,0 +1,447 @@
+/*
+ *  dark_library_cache.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include "phd.h"
+#include "dark_library_cache.h"
+
+#include <wx/ffile.h>
+
+#include <cstring>
+
+#ifdef __WINDOWS__
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+static const char Magic[8] = { 'P', 'H', 'D', '2', 'D', 'A', 'R', 'K' };
+
+enum
+{
+    CacheVersion = 1,
+    PageSize = 4096, // alignment of each dark's pixels in the file
+};
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    int64_t sourceSize; // size and modification time of the dark library the cache was built from
+    int64_t sourceTime;
+};
+
+static void GetSourceInfo(const wxString& darkLibFile, int64_t *size, int64_t *mtime)
+{
+    wxFileName fn(darkLibFile);
+    *size = (int64_t) fn.GetSize().GetValue();
+    *mtime = (int64_t) fn.GetModificationTime().GetTicks();
+}
+
+static uint64_t PageAlign(uint64_t n)
+{
+    return (n + PageSize - 1) & ~(uint64_t) (PageSize - 1);
+}
+
+DarkLibraryCache::DarkLibraryCache()
+    : m_data(nullptr), m_size(0)
+#ifdef __WINDOWS__
+      ,
+      m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+#endif
+{
+}
+
+DarkLibraryCache::~DarkLibraryCache()
+{
+    Close();
+}
+
+wxString DarkLibraryCache::CacheFileName(const wxString& darkLibFile)
+{
+    wxFileName fn(darkLibFile);
+    fn.SetExt("darkcache");
+    return fn.GetFullPath();
+}
+
+bool DarkLibraryCache::Build(const wxString& darkLibFile, const wxString& cacheFile)
+{
+    bool bError = false;
+    fitsfile *fptr = 0;
+    int status = 0; // CFITSIO status value MUST be initialized to zero!
+    long last_frame_size[] = { -1L, -1L };
+    wxString tmpFile = cacheFile + ".tmp";
+    wxFFile out;
+
+    Debug.Write(wxString::Format("building dark library cache %s\n", cacheFile));
+
+    try
+    {
+        if (PHD_fits_open_diskfile(&fptr, darkLibFile, READONLY, &status) != 0)
+        {
+            pFrame->Alert(wxString::Format(_("Error opening FITS file %s"), darkLibFile));
+            throw ERROR_INFO("error opening file");
+        }
+
+        if (!out.Open(tmpFile, "wb"))
+            throw ERROR_INFO("cannot create dark library cache");
+
+        int nhdus = 0;
+        fits_get_num_hdus(fptr, &nhdus, &status);
+
+        std::vector<Entry> entries;
+        entries.reserve(nhdus);
+
+        // the pixels follow the header and the largest possible index
+        uint64_t offset = PageAlign(sizeof(CacheHeader) + nhdus * sizeof(Entry));
+        usImage img;
+
+        while (true)
+        {
+            int hdutype;
+            fits_get_hdu_type(fptr, &hdutype, &status);
+            if (hdutype != IMAGE_HDU)
+            {
+                pFrame->Alert(wxString::Format(_("FITS file is not of an image: %s"), darkLibFile));
+                throw ERROR_INFO("FITS file is not an image");
+            }
+
+            int naxis;
+            fits_get_img_dim(fptr, &naxis, &status);
+            if (naxis != 2)
+            {
+                pFrame->Alert(wxString::Format(_("Unsupported type or read error loading FITS file %s"), darkLibFile));
+                throw ERROR_INFO("unsupported type");
+            }
+
+            long fsize[2];
+            fits_get_img_size(fptr, 2, fsize, &status);
+            if (last_frame_size[0] != -1L)
+            {
+                if (last_frame_size[0] != fsize[0] || last_frame_size[1] != fsize[1])
+                {
+                    pFrame->Alert(_("Existing dark library has frames with incompatible formats - please rebuild the dark "
+                                    "library from scratch."));
+                    throw ERROR_INFO("Incompatible frame sizes in dark library");
+                }
+            }
+            else if (img.Init((int) fsize[0], (int) fsize[1]))
+            {
+                pFrame->Alert(wxString::Format(_("Memory allocation error reading FITS file %s"), darkLibFile));
+                throw ERROR_INFO("Memory Allocation failure");
+            }
+            last_frame_size[0] = fsize[0];
+            last_frame_size[1] = fsize[1];
+
+            long fpixel[] = { 1, 1, 1 };
+            if (fits_read_pix(fptr, TUSHORT, fpixel, fsize[0] * fsize[1], nullptr, img.ImageData, nullptr, &status))
+            {
+                pFrame->Alert(wxString::Format(_("Error reading data from %s"), darkLibFile));
+                throw ERROR_INFO("Error reading");
+            }
+
+            Entry entry;
+            memset(&entry, 0, sizeof(entry));
+
+            char keyname[] = "EXPOSURE";
+            float exposure;
+            if (fits_read_key(fptr, TFLOAT, keyname, &exposure, nullptr, &status))
+            {
+                exposure = (float) pFrame->RequestedExposureDuration() / 1000.0;
+                Debug.Write(wxString::Format("missing EXPOSURE value, assume %.3f\n", exposure));
+                status = 0;
+            }
+            entry.expDur = ROUNDF(exposure * 1000.0);
+
+            char binning_key[] = "XBINNING";
+            int binning = 1;
+            fits_read_key(fptr, TINT, binning_key, &binning, nullptr, &status);
+            entry.binning = wxMax(binning, 1);
+            status = 0;
+
+            char saturate_key[] = "SATURATE";
+            int saturate = 65535;
+            fits_read_key(fptr, TINT, saturate_key, &saturate, nullptr, &status);
+            entry.bpp = saturate >= 256 ? 16 : 8;
+            status = 0;
+
+            char gain_key[] = "GAIN";
+            int gain = 0;
+            fits_read_key(fptr, TINT, gain_key, &gain, nullptr, &status);
+            entry.gain = gain;
+            status = 0;
+
+            img.CalcStats();
+
+            entry.width = img.Size.x;
+            entry.height = img.Size.y;
+            entry.minADU = img.MinADU;
+            entry.maxADU = img.MaxADU;
+            entry.medianADU = img.MedianADU;
+            entry.filtMin = img.FiltMin;
+            entry.filtMax = img.FiltMax;
+            entry.offset = offset;
+
+            size_t bytes = img.NPixels * sizeof(unsigned short);
+            if (!out.Seek(offset) || out.Write(img.ImageData, bytes) != bytes)
+                throw ERROR_INFO("error writing dark library cache");
+            offset = PageAlign(offset + bytes);
+
+            Debug.Write(wxString::Format("cached dark frame exposure = %d, med = %u, %dx%d bin %d, bpp = %d, gain = %d\n",
+                                         entry.expDur, entry.medianADU, entry.width, entry.height, entry.binning, entry.bpp,
+                                         entry.gain));
+
+            entries.push_back(entry);
+
+            // if this is the last hdu, we are done
+            int hdunr = 0;
+            fits_get_hdu_num(fptr, &hdunr);
+            if (status || hdunr >= nhdus)
+                break;
+
+            // move to the next hdu
+            fits_movrel_hdu(fptr, +1, nullptr, &status);
+        }
+
+        CacheHeader hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, Magic, sizeof(Magic));
+        hdr.version = CacheVersion;
+        hdr.count = entries.size();
+        GetSourceInfo(darkLibFile, &hdr.sourceSize, &hdr.sourceTime);
+
+        if (!out.Seek(0) || out.Write(&hdr, sizeof(hdr)) != sizeof(hdr) ||
+            out.Write(entries.data(), entries.size() * sizeof(Entry)) != entries.size() * sizeof(Entry) ||
+            !out.Close())
+        {
+            throw ERROR_INFO("error writing dark library cache");
+        }
+
+        if (!wxRenameFile(tmpFile, cacheFile, true))
+            throw ERROR_INFO("cannot replace dark library cache");
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+        bError = true;
+    }
+
+    if (fptr)
+    {
+        PHD_fits_close_file(fptr);
+    }
+
+    if (bError)
+    {
+        out.Close();
+        if (wxFileExists(tmpFile))
+            wxRemoveFile(tmpFile);
+    }
+
+    return bError;
+}
+
+bool DarkLibraryCache::Map(const wxString& cacheFile, const wxString& darkLibFile)
+{
+    if (!wxFileExists(cacheFile))
+        return true;
+
+#ifdef __WINDOWS__
+    m_file = ::CreateFileW(cacheFile.wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return true;
+
+    LARGE_INTEGER li;
+    if (!::GetFileSizeEx(m_file, &li) || li.QuadPart < (LONGLONG) sizeof(CacheHeader))
+        return true;
+    m_size = (size_t) li.QuadPart;
+
+    m_mapping = ::CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+        return true;
+    m_data = static_cast<const char *>(::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+        return true;
+#else
+    int fd = ::open(cacheFile.fn_str(), O_RDONLY);
+    if (fd < 0)
+        return true;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(CacheHeader))
+    {
+        ::close(fd);
+        return true;
+    }
+
+    void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return true;
+    m_data = static_cast<const char *>(p);
+    m_size = (size_t) st.st_size;
+#endif
+
+    CacheHeader hdr;
+    memcpy(&hdr, m_data, sizeof(hdr));
+
+    int64_t sourceSize, sourceTime;
+    GetSourceInfo(darkLibFile, &sourceSize, &sourceTime);
+
+    if (memcmp(hdr.magic, Magic, sizeof(Magic)) != 0 || hdr.version != CacheVersion || hdr.count == 0 ||
+        hdr.sourceSize != sourceSize || hdr.sourceTime != sourceTime ||
+        sizeof(CacheHeader) + (uint64_t) hdr.count * sizeof(Entry) > m_size)
+    {
+        Debug.Write(wxString::Format("dark library cache %s is out of date\n", cacheFile));
+        return true;
+    }
+
+    m_entries.resize(hdr.count);
+    memcpy(m_entries.data(), m_data + sizeof(CacheHeader), hdr.count * sizeof(Entry));
+
+    for (const Entry& e : m_entries)
+    {
+        if (e.width <= 0 || e.height <= 0 || e.offset + (uint64_t) e.width * e.height * sizeof(unsigned short) > m_size)
+        {
+            Debug.Write(wxString::Format("dark library cache %s is invalid\n", cacheFile));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool DarkLibraryCache::Open(const wxString& darkLibFile)
+{
+    Close();
+
+    if (!wxFileExists(darkLibFile))
+    {
+        Debug.Write(wxString::Format("dark library %s does not exist\n", darkLibFile));
+        return true;
+    }
+
+    wxString cacheFile = CacheFileName(darkLibFile);
+
+    if (Map(cacheFile, darkLibFile))
+    {
+        Close();
+        if (Build(darkLibFile, cacheFile))
+            return true;
+        if (Map(cacheFile, darkLibFile))
+        {
+            Close();
+            return true;
+        }
+    }
+
+#ifndef __WINDOWS__
+    ::madvise(const_cast<char *>(m_data), m_size, MADV_RANDOM);
+#endif
+
+    Debug.Write(wxString::Format("opened dark library cache %s, %u darks\n", cacheFile, (unsigned int) m_entries.size()));
+
+    return false;
+}
+
+void DarkLibraryCache::Close()
+{
+#ifdef __WINDOWS__
+    if (m_data)
+        ::UnmapViewOfFile(m_data);
+    if (m_mapping)
+        ::CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        ::CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_data)
+        ::munmap(const_cast<char *>(m_data), m_size);
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_entries.clear();
+}
+
+int DarkLibraryCache::Find(int expDur) const
+{
+    for (size_t i = 0; i < m_entries.size(); i++)
+        if (m_entries[i].expDur == expDur)
+            return (int) i;
+    return -1;
+}
+
+void DarkLibraryCache::GetInfo(const Entry& entry, usImage *img)
+{
+    img->Size = wxSize(entry.width, entry.height);
+    img->Storage = wxRect(img->Size);
+    img->ImgExpDur = entry.expDur;
+    img->Binning = entry.binning;
+    img->BitsPerPixel = entry.bpp;
+    img->Gain = entry.gain;
+    img->MinADU = entry.minADU;
+    img->MaxADU = entry.maxADU;
+    img->MedianADU = entry.medianADU;
+    img->FiltMin = entry.filtMin;
+    img->FiltMax = entry.filtMax;
+}
+
+bool DarkLibraryCache::Load(size_t index, usImage *img) const
+{
+    if (index >= m_entries.size())
+        return true;
+
+    const Entry& entry = m_entries[index];
+    if (img->Init(entry.width, entry.height))
+        return true;
+
+    size_t bytes = img->NPixels * sizeof(unsigned short);
+#ifndef __WINDOWS__
+    // the pages are read once, start reading them all now
+    ::madvise(const_cast<char *>(m_data) + entry.offset, bytes, MADV_WILLNEED);
+#endif
+    memcpy(img->ImageData, m_data + entry.offset, bytes);
+
+    GetInfo(entry, img);
+
+    return false;
+}
@@ -0,0 +1,111 @@
+/*
+ *  dark_library_cache.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef DARK_LIBRARY_CACHE_INCLUDED
+#define DARK_LIBRARY_CACHE_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class usImage;
+
+// Memory-mapped copy of a dark library.
+//
+// The dark library FITS file stores each dark as big-endian, offset 16-bit data in its own HDU,
+// so reading it means decoding every dark up front. The cache holds the same darks as native
+// 16-bit pixels at page-aligned offsets, together with each dark's header values and
+// statistics, in a file next to the library. Opening the cache maps the file and reads only the
+// small index at its start; a dark's pixels are read from disk when the dark is loaded, so only
+// the dark in use is ever paged in.
+//
+// The cache is rebuilt from the library, one HDU at a time, whenever it is missing or the
+// library's size or modification time no longer match the ones recorded in the cache.
+class DarkLibraryCache
+{
+public:
+    struct Entry
+    {
+        int32_t expDur; // ms
+        int32_t width;
+        int32_t height;
+        int32_t binning;
+        int32_t bpp;
+        int32_t gain;
+        uint16_t minADU;
+        uint16_t maxADU;
+        uint16_t medianADU;
+        uint16_t filtMin;
+        uint16_t filtMax;
+        uint16_t reserved;
+        uint64_t offset; // byte offset of the pixels in the cache file
+    };
+
+    DarkLibraryCache();
+    ~DarkLibraryCache();
+
+    static wxString CacheFileName(const wxString& darkLibFile);
+
+    // open the cache of the dark library file, building it first if needed; returns true on
+    // error, after alerting the user if the library itself could not be read
+    bool Open(const wxString& darkLibFile);
+    void Close();
+
+    // the darks in the order they are stored in the library
+    const std::vector<Entry>& Entries() const { return m_entries; }
+
+    // index of the entry with the given exposure, -1 if there is none
+    int Find(int expDur) const;
+
+    // set the header values and statistics of an entry on an image, without its pixels
+    static void GetInfo(const Entry& entry, usImage *img);
+    // read an entry's pixels into an image; returns true on error
+    bool Load(size_t index, usImage *img) const;
+
+private:
+    // map the cache file and read its index; returns true if there is no usable cache for the library
+    bool Map(const wxString& cacheFile, const wxString& darkLibFile);
+    static bool Build(const wxString& darkLibFile, const wxString& cacheFile);
+
+    const char *m_data;
+    size_t m_size;
+#ifdef __WINDOWS__
+    void *m_file;
+    void *m_mapping;
+#endif
+    std::vector<Entry> m_entries;
+};
+
+#endif // DARK_LIBRARY_CACHE_INCLUDED
@@ -0,0 +1,237 @@
+/*
+ *  dark_stack.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include "phd.h"
+#include "dark_stack.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define HAVE_SSE2_STACK
+#endif
+
+// pixels per work item when the stack is updated or combined in parallel
+static const unsigned int BAND_PIXELS = 64 * 1024;
+
+static void AccumulateSum(uint32_t *sum, const uint16_t *src, unsigned int n)
+{
+    unsigned int i = 0;
+#ifdef HAVE_SSE2_STACK
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i *s = (__m128i *) (sum + i);
+        _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), _mm_unpacklo_epi16(v, zero)));
+        _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(v, zero)));
+    }
+#endif
+    for (; i < n; i++)
+        sum[i] += src[i];
+}
+
+static void AccumulateClip(uint32_t *sum, uint64_t *sumSq, uint16_t *mn, uint16_t *mx, const uint16_t *src,
+                           unsigned int n)
+{
+    unsigned int i = 0;
+#ifdef HAVE_SSE2_STACK
+    const __m128i zero = _mm_setzero_si128();
+    // SSE2 has only signed 16-bit min/max; flipping the sign bit maps unsigned order onto signed order
+    const __m128i bias = _mm_set1_epi16((short) 0x8000);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+
+        __m128i *s = (__m128i *) (sum + i);
+        _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), _mm_unpacklo_epi16(v, zero)));
+        _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(v, zero)));
+
+        // 32-bit squares from the low and high halves of the 16x16 products, widened to 64 bits
+        __m128i lo = _mm_mullo_epi16(v, v);
+        __m128i hi = _mm_mulhi_epu16(v, v);
+        __m128i sq0 = _mm_unpacklo_epi16(lo, hi);
+        __m128i sq1 = _mm_unpackhi_epi16(lo, hi);
+        __m128i *q = (__m128i *) (sumSq + i);
+        _mm_storeu_si128(q, _mm_add_epi64(_mm_loadu_si128(q), _mm_unpacklo_epi32(sq0, zero)));
+        _mm_storeu_si128(q + 1, _mm_add_epi64(_mm_loadu_si128(q + 1), _mm_unpackhi_epi32(sq0, zero)));
+        _mm_storeu_si128(q + 2, _mm_add_epi64(_mm_loadu_si128(q + 2), _mm_unpacklo_epi32(sq1, zero)));
+        _mm_storeu_si128(q + 3, _mm_add_epi64(_mm_loadu_si128(q + 3), _mm_unpackhi_epi32(sq1, zero)));
+
+        __m128i vb = _mm_xor_si128(v, bias);
+        __m128i *pmn = (__m128i *) (mn + i);
+        __m128i *pmx = (__m128i *) (mx + i);
+        __m128i curMin = _mm_xor_si128(_mm_loadu_si128(pmn), bias);
+        __m128i curMax = _mm_xor_si128(_mm_loadu_si128(pmx), bias);
+        _mm_storeu_si128(pmn, _mm_xor_si128(_mm_min_epi16(curMin, vb), bias));
+        _mm_storeu_si128(pmx, _mm_xor_si128(_mm_max_epi16(curMax, vb), bias));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        uint16_t v = src[i];
+        sum[i] += v;
+        sumSq[i] += (uint32_t) v * v;
+        mn[i] = std::min(mn[i], v);
+        mx[i] = std::max(mx[i], v);
+    }
+}
+
+// whether `val` is more than `k` standard deviations from the mean of `n` other samples with the
+// given sum and sum of squares
+static bool IsOutlier(double val, double sum, double sumSq, double n, double k)
+{
+    double mean = sum / n;
+    double var = (sumSq - sum * mean) / (n - 1.0);
+    // keep quantized, near-constant pixels from clipping on a 1 ADU difference
+    double sigma = std::max(var > 0.0 ? sqrt(var) : 0.0, 1.0);
+    return fabs(val - mean) > k * sigma;
+}
+
+DarkStack::DarkStack(Method method, double clipSigma)
+    : m_method(method), m_clipSigma(clipSigma), m_width(0), m_height(0), m_count(0)
+{
+}
+
+bool DarkStack::Add(const usImage& frame)
+{
+    if (m_count == 0)
+    {
+        try
+        {
+            m_sum.assign(frame.NPixels, 0);
+            if (m_method == SIGMA_CLIP)
+            {
+                m_sumSq.assign(frame.NPixels, 0);
+                m_min.assign(frame.NPixels, 0xffff);
+                m_max.assign(frame.NPixels, 0);
+            }
+        }
+        catch (const std::bad_alloc&)
+        {
+            Debug.Write("DarkStack: could not allocate the stack\n");
+            return true;
+        }
+        m_width = frame.Size.GetWidth();
+        m_height = frame.Size.GetHeight();
+    }
+    else if (frame.Size.GetWidth() != m_width || frame.Size.GetHeight() != m_height)
+    {
+        Debug.Write(wxString::Format("DarkStack: frame size %dx%d does not match the stack size %dx%d\n",
+                                     frame.Size.GetWidth(), frame.Size.GetHeight(), m_width, m_height));
+        return true;
+    }
+
+    unsigned int npix = frame.NPixels;
+    unsigned int bands = (npix + BAND_PIXELS - 1) / BAND_PIXELS;
+
+    ThreadPool::ParallelFor(bands, [&](unsigned int band) {
+        unsigned int start = band * BAND_PIXELS;
+        unsigned int n = std::min(BAND_PIXELS, npix - start);
+        if (m_method == SIGMA_CLIP)
+            AccumulateClip(&m_sum[start], &m_sumSq[start], &m_min[start], &m_max[start], frame.ImageData + start, n);
+        else
+            AccumulateSum(&m_sum[start], frame.ImageData + start, n);
+    });
+
+    ++m_count;
+
+    return false;
+}
+
+unsigned long long DarkStack::Combine(usImage *dark) const
+{
+    assert(m_count > 0);
+    assert(dark->NPixels == m_sum.size());
+
+    unsigned int npix = dark->NPixels;
+    unsigned int bands = (npix + BAND_PIXELS - 1) / BAND_PIXELS;
+    unsigned int count = m_count;
+
+    if (m_method != SIGMA_CLIP || count < MinClipFrames)
+    {
+        ThreadPool::ParallelFor(bands, [&](unsigned int band) {
+            unsigned int start = band * BAND_PIXELS;
+            unsigned int end = std::min(start + BAND_PIXELS, npix);
+            for (unsigned int i = start; i < end; i++)
+                dark->ImageData[i] = (unsigned short) (m_sum[i] / count);
+        });
+        return 0;
+    }
+
+    std::vector<unsigned long long> rejected(bands, 0);
+
+    ThreadPool::ParallelFor(bands, [&](unsigned int band) {
+        unsigned int start = band * BAND_PIXELS;
+        unsigned int end = std::min(start + BAND_PIXELS, npix);
+        double others = count - 1;
+        unsigned long long nrej = 0;
+
+        for (unsigned int i = start; i < end; i++)
+        {
+            double lo = m_min[i];
+            double hi = m_max[i];
+            double sum = m_sum[i];
+            double sumSq = (double) m_sumSq[i];
+            double total = sum;
+            double kept = count;
+
+            // each extreme is tested against the mean and deviation of the other samples
+            if (IsOutlier(hi, sum - hi, sumSq - hi * hi, others, m_clipSigma))
+            {
+                total -= hi;
+                --kept;
+                ++nrej;
+            }
+            if (IsOutlier(lo, sum - lo, sumSq - lo * lo, others, m_clipSigma))
+            {
+                total -= lo;
+                --kept;
+                ++nrej;
+            }
+
+            dark->ImageData[i] = (unsigned short) std::min(floor(total / kept + 0.5), 65535.0);
+        }
+
+        rejected[band] = nrej;
+    });
+
+    unsigned long long total = 0;
+    for (unsigned long long n : rejected)
+        total += n;
+    return total;
+}
@@ -0,0 +1,93 @@
+/*
+ *  dark_stack.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef DARK_STACK_INCLUDED
+#define DARK_STACK_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+class usImage;
+
+// Combines dark frames into a master dark one frame at a time, so no more than one frame needs
+// to be held in memory regardless of the number of frames.
+//
+// MEAN keeps a per-pixel sum. SIGMA_CLIP additionally keeps the per-pixel sum of squares,
+// minimum and maximum; when the stack is combined the highest and lowest sample of each pixel
+// are each tested against the mean and standard deviation of the pixel's other samples and left
+// out if they are more than clipSigma deviations away. That rejects cosmic ray hits and other one-off
+// outliers with bounded memory (16 bytes per pixel); a pixel hit in more than one frame keeps
+// all but the most extreme hit. With fewer than MinClipFrames frames the deviation estimate is
+// too poor to clip on and the plain mean is used.
+class DarkStack
+{
+public:
+    enum Method
+    {
+        MEAN,
+        SIGMA_CLIP,
+    };
+
+    enum
+    {
+        MinClipFrames = 5
+    };
+
+private:
+    Method m_method;
+    double m_clipSigma;
+    int m_width;
+    int m_height;
+    unsigned int m_count;
+    std::vector<uint32_t> m_sum;
+    std::vector<uint64_t> m_sumSq;
+    std::vector<uint16_t> m_min;
+    std::vector<uint16_t> m_max;
+
+public:
+    DarkStack(Method method, double clipSigma = 3.0);
+
+    // add a frame to the stack; returns true on error, when the frame size differs from the
+    // frames already in the stack or memory could not be allocated
+    bool Add(const usImage& frame);
+
+    unsigned int Count() const { return m_count; }
+
+    // Write the combined dark into the pixels of `dark`, which must be the same size as the
+    // stacked frames. Returns the number of samples rejected by clipping.
+    unsigned long long Combine(usImage *dark) const;
+};
+
+#endif // DARK_STACK_INCLUDED
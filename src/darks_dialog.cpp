@@ -35,14 +35,16 @@
 
 #include "phd.h"
 #include "darks_dialog.h"
+#include "dark_stack.h"
 #include <wx/valnum.h>
 
 #include <algorithm>
-#include <sstream>
+#include <atomic>
 
 static const int DefDarkCount = 5;
 static const int DefDMExpTime = 15;
 static const int DefDMCount = 25;
+static const bool DefRejectOutliers = true;
 
 static const int MaxNoteLength = 65; // For now
 
@@ -201,6 +203,13 @@ DarksDialog::DarksDialog(wxWindow *parent, bool darkLib)
     phSizer->Add(pNoteLabel, wxSizerFlags().Border(wxALL, 5));
     phSizer->Add(m_pNotes, wxSizerFlags().Border(wxALL, 5));
     pvSizer->Add(phSizer, wxSizerFlags().Border(wxALL, 5));
+    m_pRejectOutliers = new wxCheckBox(this, wxID_ANY, _("Reject outliers (cosmic rays)"));
+    m_pRejectOutliers->SetToolTip(wxString::Format(
+        _("Leave out pixel values that differ from the same pixel in the other dark frames by more than 3 standard "
+          "deviations. Needs at least %d frames."),
+        (int) DarkStack::MinClipFrames));
+    m_pRejectOutliers->SetValue(pConfig->Profile.GetBoolean("/camera/darks_reject_outliers", DefRejectOutliers));
+    pvSizer->Add(m_pRejectOutliers, wxSizerFlags().Border(wxALL, 5).Border(wxLEFT, 10));
     phSizer = new wxBoxSizer(wxHORIZONTAL);
     m_pProgress = new wxGauge(this, wxID_ANY, 100, wxDefaultPosition, sz);
     m_pProgress->Enable(false);
@@ -356,15 +365,29 @@ void DarksDialog::OnStart(wxCommandEvent& evt)
 
             // create a median-filtered dark
             Debug.AddLine("Starting construction of filtered master dark file");
-            darks.BuildFilteredDark();
-            Debug.AddLine("Completed construction of filtered master dark file");
+            m_pProgress->SetRange(100);
+            m_pProgress->SetValue(0);
+            bool cancelled = darks.BuildFilteredDark([this](int pct) {
+                m_pProgress->SetValue(pct);
+                wxYield();
+                return m_cancelling;
+            });
+
+            if (cancelled)
+            {
+                ShowStatus(_("Operation cancelled"), false);
+            }
+            else
+            {
+                Debug.AddLine("Completed construction of filtered master dark file");
 
-            // save the master dark and the median filtered dark
-            darks.SaveDarks(m_pNotes->GetValue());
+                // save the master dark and the median filtered dark
+                darks.SaveDarks(m_pNotes->GetValue());
 
-            ShowStatus(_("Master dark data files built"), false);
+                ShowStatus(_("Master dark data files built"), false);
 
-            wrapupMsg = _("Master dark data files built");
+                wrapupMsg = _("Master dark data files built");
+            }
         }
     }
 
@@ -416,6 +439,7 @@ void DarksDialog::OnReset(wxCommandEvent& evt)
         m_pNumDefExposures->SetValue(DefDMCount);
         m_pNotes->SetValue("");
     }
+    m_pRejectOutliers->SetValue(DefRejectOutliers);
 }
 
 void DarksDialog::ShowStatus(const wxString msg, bool appending)
@@ -445,131 +469,190 @@ void DarksDialog::SaveProfileInfo()
         pConfig->Profile.SetInt("/camera/dmap_num_frames", m_pNumDefExposures->GetValue());
     }
     pConfig->Profile.SetString("/camera/darks_note", m_pNotes->GetValue());
+    pConfig->Profile.SetBoolean("/camera/darks_reject_outliers", m_pRejectOutliers->GetValue());
 }
 
-struct Histogram
+namespace
+{
+// Combines one captured frame into the dark stack
+class StackFrameThread : public wxThread
 {
-    unsigned long val[256];
-    unsigned int median;
-    double mean;
+    DarkStack& m_stack;
+    const usImage& m_frame;
+
+public:
+    bool err;
 
-    Histogram(const usImage& img)
+    StackFrameThread(DarkStack& stack, const usImage& frame)
+        : wxThread(wxTHREAD_JOINABLE), m_stack(stack), m_frame(frame), err(false)
     {
-        memset(&val[0], 0, sizeof(val));
-        mean = 0.0;
-        for (unsigned int i = 0; i < img.NPixels; i++)
-        {
-            unsigned short v = img.ImageData[i];
-            mean += v;
-            v >>= (img.BitsPerPixel - 8);
-            if (v > 255)
-                v = 255; // should never happen if BitsPerPixel is valid
-            ++val[v];
-        }
-        mean /= img.NPixels;
-        // median (approx)
-        unsigned long sum = 0;
-        int i;
-        for (i = 0; i < 256; i++)
+    }
+
+    ExitCode Entry() override
+    {
+        err = m_stack.Add(m_frame);
+        return 0;
+    }
+};
+
+// Captures the dark frames for one exposure time away from the GUI thread. Each frame is combined
+// into the stack on a second thread while the next frame is being captured; the frames alternate
+// between two buffers, so the one being stacked is never the one being captured into.
+class DarkCaptureThread : public wxThread
+{
+    DarkStack& m_stack;
+    usImage *m_frames[2];
+    usImage m_spare;
+    int m_expTime;
+    int m_frameCount;
+
+public:
+    std::atomic<int> captured;
+    std::atomic<bool> cancel;
+    std::atomic<bool> done;
+    bool err;
+
+    DarkCaptureThread(DarkStack& stack, usImage& frame, int expTime, int frameCount)
+        : wxThread(wxTHREAD_JOINABLE), m_stack(stack), m_expTime(expTime), m_frameCount(frameCount), captured(0),
+          cancel(false), done(false), err(false)
+    {
+        m_frames[0] = &frame;
+        m_frames[1] = &m_spare;
+    }
+
+    ExitCode Entry() override
+    {
+#if defined(__WINDOWS__)
+        HRESULT hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+        Debug.Write(wxString::Format("dark capture thread CoInitializeEx returns %x\n", hr));
+#endif
+
+        StackFrameThread *stacker = nullptr;
+
+        for (int j = 0; j < m_frameCount && !cancel; j++)
         {
-            sum += val[i];
-            if (sum > img.NPixels / 2)
+            usImage& frame = *m_frames[j & 1];
+
+            Debug.Write(wxString::Format("Capture dark frame %d/%d exp=%d\n", j + 1, m_frameCount, m_expTime));
+            CaptureParams captureParams;
+            captureParams.duration = m_expTime;
+            captureParams.hwBinning = pCamera->HwBinning;
+            // darks are not software-binned as this allows the dark library to be re-used
+            // for any software binning level (dark subtraction / bad-pixel map correction
+            // is performed before software binning)
+            captureParams.swBinning = 1;
+            captureParams.bpp = pCamera->BitsPerPixel();
+            captureParams.gain = pCamera->GuideCameraGain;
+            captureParams.captureOptions = CAPTURE_DARK;
+            if (GuideCamera::Capture(pCamera, frame, captureParams))
+            {
+                err = true;
                 break;
+            }
+
+            // the previous frame must be stacked before its buffer is captured into again
+            if (stacker)
+            {
+                stacker->Wait();
+                err = stacker->err;
+                delete stacker;
+                stacker = nullptr;
+                if (err)
+                    break;
+            }
+
+            stacker = new StackFrameThread(m_stack, frame);
+            if (stacker->Create() != wxTHREAD_NO_ERROR || stacker->Run() != wxTHREAD_NO_ERROR)
+            {
+                delete stacker;
+                stacker = nullptr;
+                err = m_stack.Add(frame);
+                if (err)
+                    break;
+            }
+
+            ++captured;
         }
-        median = i << (img.BitsPerPixel - 8);
-    }
 
-    void Dump()
-    {
-        Debug.Write(wxString::Format("mean = %.f  median(approx) = %u\n", mean, median));
-        int i = 0;
-        for (int l = 0; l < 4; l++)
+        if (stacker)
         {
-            std::ostringstream os;
-            os << "histo[" << (l * 64) << ".." << ((l + 1) * 64 - 1) << "]";
-            for (int j = 0; j < 64; j++, i++)
-                os << ' ' << val[i];
-            os << "\n";
-            Debug.Write(os.str());
+            stacker->Wait();
+            err = err || stacker->err;
+            delete stacker;
         }
+
+#if defined(__WINDOWS__)
+        CoUninitialize();
+#endif
+
+        done = true;
+        return 0;
     }
 };
+} // namespace
 
 bool DarksDialog::CreateMasterDarkFrame(usImage& darkFrame, int expTime, int frameCount)
 {
-    bool err = false;
-
     pCamera->InitCapture();
-    darkFrame.ImgExpDur = expTime;
-    darkFrame.ImgStackCnt = frameCount;
 
-    unsigned int *avgimg = 0;
+    DarkStack stack(m_pRejectOutliers->GetValue() ? DarkStack::SIGMA_CLIP : DarkStack::MEAN);
 
-    for (int j = 1; j <= frameCount; j++)
+    DarkCaptureThread thread(stack, darkFrame, expTime, frameCount);
+    if (thread.Create() != wxTHREAD_NO_ERROR || thread.Run() != wxTHREAD_NO_ERROR)
+    {
+        Debug.Write("could not start the dark capture thread\n");
+        ShowStatus(wxString::Format(_("%.1f s dark FAILED"), (double) expTime / 1000.0), true);
+        return true;
+    }
+
+    // keep the dialog responsive while the frames are captured
+    int shown = -1;
+    while (!thread.done)
     {
-        wxYield();
         if (m_cancelling)
-            break;
-        ShowStatus(wxString::Format(_("Taking dark frame %d/%d"), j, frameCount), true);
-
-        Debug.Write(wxString::Format("Capture dark frame %d/%d exp=%d\n", j, frameCount, expTime));
-        CaptureParams captureParams;
-        captureParams.duration = expTime;
-        captureParams.hwBinning = pCamera->HwBinning;
-        // darks are not software-binned as this allows the dark library to be re-used
-        // for any software binning level (dark subtraction / bad-pixel map correction
-        // is performed before software binning)
-        captureParams.swBinning = 1;
-        captureParams.bpp = pCamera->BitsPerPixel();
-        captureParams.gain = pCamera->GuideCameraGain;
-        captureParams.captureOptions = CAPTURE_DARK;
-        err = GuideCamera::Capture(pCamera, darkFrame, captureParams);
-        if (err)
+            thread.cancel = true;
+
+        int captured = thread.captured;
+        if (captured != shown)
         {
-            ShowStatus(wxString::Format(_("%.1f s dark FAILED"), (double) expTime / 1000.0), true);
-            pCamera->ShutterClosed = false;
-            break;
+            if (shown >= 0)
+                m_pProgress->SetValue(m_pProgress->GetValue() + (captured - shown) * expTime);
+            shown = captured;
+            if (captured < frameCount && !m_cancelling)
+                ShowStatus(wxString::Format(_("Taking dark frame %d/%d"), captured + 1, frameCount), true);
         }
 
-        m_pProgress->SetValue(m_pProgress->GetValue() + expTime);
-        wxYield();
-
-        darkFrame.CalcStats();
-
-        Debug.Write(wxString::Format("dark frame stats: bpp %u min %u max %u med %u filtmin %u filtmax %u\n",
-                                     darkFrame.BitsPerPixel, darkFrame.MinADU, darkFrame.MaxADU, darkFrame.MedianADU,
-                                     darkFrame.FiltMin, darkFrame.FiltMax));
-
-        Histogram h(darkFrame);
-        h.Dump();
         wxYield();
+        wxMilliSleep(20);
+    }
+    thread.Wait();
 
-        if (!avgimg)
-        {
-            avgimg = new unsigned int[darkFrame.NPixels];
-            memset(avgimg, 0, darkFrame.NPixels * sizeof(*avgimg));
-        }
+    if (shown >= 0 && thread.captured != shown)
+        m_pProgress->SetValue(m_pProgress->GetValue() + (thread.captured - shown) * expTime);
 
-        unsigned int *iptr = avgimg;
-        const unsigned short *usptr = darkFrame.ImageData;
-        for (unsigned int i = 0; i < darkFrame.NPixels; i++)
-            *iptr++ += *usptr++;
+    bool err = thread.err;
+    if (err)
+    {
+        ShowStatus(wxString::Format(_("%.1f s dark FAILED"), (double) expTime / 1000.0), true);
+        pCamera->ShutterClosed = false;
     }
-
-    if (!m_cancelling && !err)
+    else if (!m_cancelling)
     {
         ShowStatus(_("Dark frames complete"), true);
-        const unsigned int *iptr = avgimg;
-        unsigned short *usptr = darkFrame.ImageData;
-        for (unsigned int i = 0; i < darkFrame.NPixels; i++)
-            *usptr++ = (unsigned short) (*iptr++ / frameCount);
+
+        unsigned long long rejected = stack.Combine(&darkFrame);
+        darkFrame.ImgExpDur = expTime;
+        darkFrame.ImgStackCnt = frameCount;
+        darkFrame.CalcStats();
+
+        Debug.Write(wxString::Format("master dark exp=%d frames=%d rejected=%llu: bpp %u min %u max %u med %u\n", expTime,
+                                     frameCount, rejected, darkFrame.BitsPerPixel, darkFrame.MinADU, darkFrame.MaxADU,
+                                     darkFrame.MedianADU));
     }
 
     m_pProgress->SetValue(m_pProgress->GetValue() + expTime);
     wxYield();
 
-    delete[] avgimg;
-
     return err;
 }
 
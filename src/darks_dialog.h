@@ -50,6 +50,7 @@ private:
     wxRadioButton *m_rbModifyDarkLib;
     wxRadioButton *m_rbNewDarkLib;
     wxTextCtrl *m_pNotes;
+    wxCheckBox *m_pRejectOutliers;
     wxGauge *m_pProgress;
     wxButton *m_pStartBtn;
     wxButton *m_pResetBtn;
@@ -0,0 +1,195 @@
+/*
+ *  driver_registry.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+#include "driver_registry.h"
+
+namespace
+{
+struct ProbeState
+{
+    wxMutex lock;
+    wxCondition cond;
+    bool done;
+    bool timedOut; // a wait for the probe timed out; later requests do not wait for it again
+    wxArrayString devices;
+
+    ProbeState() : cond(lock), done(false), timedOut(false) { }
+};
+
+class ProbeThread : public wxThread
+{
+    wxString m_sdk;
+    DriverRegistry::ProbeFunc m_probe;
+    std::shared_ptr<ProbeState> m_state;
+
+public:
+    ProbeThread(const wxString& sdk, const DriverRegistry::ProbeFunc& probe, const std::shared_ptr<ProbeState>& state)
+        : wxThread(wxTHREAD_DETACHED), m_sdk(sdk), m_probe(probe), m_state(state)
+    {
+    }
+
+protected:
+    ExitCode Entry() override;
+};
+
+struct Registry
+{
+    wxMutex lock;
+    std::map<wxString, std::shared_ptr<ProbeState>> probes;
+    int prefetch; // nesting level of Prefetch objects (main thread only)
+
+    Registry() : prefetch(0) { }
+};
+}
+
+static Registry s_registry;
+
+static void RunProbe(const wxString& sdk, const DriverRegistry::ProbeFunc& probe, ProbeState *state)
+{
+    wxStopWatch swatch;
+    wxArrayString devices = probe();
+    Debug.Write(wxString::Format("DriverRegistry: %s found %u devices in %ld ms\n", sdk, (unsigned int) devices.size(),
+                                 swatch.Time()));
+
+    wxMutexLocker lock(state->lock);
+    state->devices = devices;
+    state->done = true;
+    state->cond.Broadcast();
+}
+
+wxThread::ExitCode ProbeThread::Entry()
+{
+#if defined(__WINDOWS__)
+    HRESULT hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    Debug.Write(wxString::Format("DriverRegistry: %s probe thread CoInitializeEx returns %x\n", m_sdk, hr));
+#endif
+
+    RunProbe(m_sdk, m_probe, m_state.get());
+
+#if defined(__WINDOWS__)
+    if (SUCCEEDED(hr))
+        CoUninitialize();
+#endif
+
+    return nullptr;
+}
+
+wxArrayString DriverRegistry::Devices(const wxString& sdk, const ProbeFunc& probe, int timeoutMs)
+{
+    std::shared_ptr<ProbeState> state;
+    {
+        wxMutexLocker lock(s_registry.lock);
+
+        std::shared_ptr<ProbeState>& entry = s_registry.probes[sdk];
+        if (!entry)
+        {
+            entry = std::make_shared<ProbeState>();
+
+            Debug.Write(wxString::Format("DriverRegistry: probing %s\n", sdk));
+
+            ProbeThread *thread = new ProbeThread(sdk, probe, entry);
+            if (thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR)
+            {
+                delete thread;
+                RunProbe(sdk, probe, entry.get());
+            }
+        }
+
+        state = entry;
+    }
+
+    if (s_registry.prefetch > 0 && wxThread::IsMain())
+        return wxArrayString();
+
+    wxStopWatch swatch;
+    wxMutexLocker lock(state->lock);
+
+    if (!state->done && state->timedOut)
+    {
+        Debug.Write(wxString::Format("DriverRegistry: %s has not answered yet, leaving it out\n", sdk));
+        return wxArrayString();
+    }
+
+    while (!state->done)
+    {
+        long remaining = timeoutMs - swatch.Time();
+        if (remaining <= 0 || state->cond.WaitTimeout(remaining) == wxCOND_TIMEOUT)
+            break;
+    }
+
+    if (!state->done)
+    {
+        state->timedOut = true;
+        Debug.Write(wxString::Format("DriverRegistry: %s did not answer within %d ms, leaving it out\n", sdk, timeoutMs));
+        return wxArrayString();
+    }
+
+    return state->devices;
+}
+
+void DriverRegistry::Refresh()
+{
+    wxMutexLocker lock(s_registry.lock);
+
+    Debug.Write("DriverRegistry: refresh\n");
+
+    // a probe that is still running stays, even one that has timed out: its thread may still be
+    // inside the SDK, and the SDKs are not necessarily safe to probe twice at the same time. Until it
+    // answers the SDK is left out of the lists, and its answer, when it comes, is the fresh one
+    for (auto it = s_registry.probes.begin(); it != s_registry.probes.end();)
+    {
+        bool forget;
+        {
+            wxMutexLocker stateLock(it->second->lock);
+            forget = it->second->done;
+        }
+
+        if (forget)
+            it = s_registry.probes.erase(it);
+        else
+            ++it;
+    }
+}
+
+DriverRegistry::Prefetch::Prefetch()
+{
+    assert(wxThread::IsMain());
+    ++s_registry.prefetch;
+}
+
+DriverRegistry::Prefetch::~Prefetch()
+{
+    --s_registry.prefetch;
+}
@@ -0,0 +1,73 @@
+/*
+ *  driver_registry.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef DRIVER_REGISTRY_INCLUDED
+#define DRIVER_REGISTRY_INCLUDED
+
+// Devices discovered by the driver SDKs that have to be asked at run time (ASCOM, V4L, ...).
+//
+// Some SDKs take seconds to answer, so each one is probed on its own background thread the first
+// time its devices are needed, and the answer is kept until Refresh() is called. Waiting for a probe
+// is limited by a per-SDK timeout: an SDK that does not answer in time is left out of the list
+// rather than holding up the gear dialog, and is not waited for again: it stays left out until its
+// probe answers, and is never probed a second time while the first probe is still running.
+//
+// To probe several SDKs at once, create a Prefetch object and ask for the device lists: while it is
+// in scope, Devices() starts the probes without waiting for them and returns an empty list.
+class DriverRegistry
+{
+public:
+    typedef std::function<wxArrayString()> ProbeFunc;
+
+    enum
+    {
+        DefaultProbeTimeoutMs = 20000,
+    };
+
+    // Devices found by the given SDK, probing it if it has not been probed yet
+    static wxArrayString Devices(const wxString& sdk, const ProbeFunc& probe, int timeoutMs = DefaultProbeTimeoutMs);
+
+    // Forget the devices found so far; the SDKs are probed again the next time their devices are
+    // needed. A probe still running, including one that timed out, is kept until it answers
+    static void Refresh();
+
+    class Prefetch
+    {
+    public:
+        Prefetch();
+        ~Prefetch();
+    };
+};
+
+#endif // DRIVER_REGISTRY_INCLUDED
@@ -33,6 +33,8 @@
  */
 
 #include "phd.h"
+#include "ao_fast_loop.h"
+#include "latency_trace.h"
 
 #include <wx/sstream.h>
 #include <wx/sckstrm.h>
@@ -1600,7 +1602,7 @@ static void get_star_image(JObj& response, const json_value *params)
     B64Encode enc;
     for (int y = rect.GetTop(); y <= rect.GetBottom(); y++)
     {
-        const unsigned short *p = img->ImageData + y * img->Size.GetWidth() + rect.GetLeft();
+        const unsigned short *p = &img->Pixel(rect.GetLeft(), y);
         enc.append(p, rect.GetWidth() * sizeof(unsigned short));
     }
 
@@ -2085,6 +2087,54 @@ static void set_limit_frame(JObj& response, const json_value *params)
         response << jrpc_result(0);
 }
 
+static void get_timing_stats(JObj& response, const json_value *params)
+{
+    Params p("trace", params);
+    bool trace = false;
+    const json_value *val = p.param("trace");
+    if (val && !bool_param(val, &trace))
+    {
+        response << jrpc_error(JSONRPC_INVALID_PARAMS, "expected bool value for trace");
+        return;
+    }
+
+    LatencyTrace::StageStats stats[TRACE_STAGE_COUNT];
+    LatencyTrace::GetStats(stats);
+
+    JObj rslt;
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++)
+    {
+        const LatencyTrace::StageStats& s = stats[i];
+        JObj stage;
+        stage << NV("count", s.count) << NV("p50", s.p50, 3) << NV("p95", s.p95, 3) << NV("p99", s.p99, 3)
+              << NV("max", s.max, 3);
+        rslt << NV(LatencyTrace::StageName((TraceStage) i), stage);
+    }
+
+    if (TheAO())
+    {
+        AOFastLoopStats fl = TheAO()->GetFastLoopStats();
+        JObj fastLoop;
+        fastLoop << NV("active", fl.active) << NV("frames", fl.frames) << NV("lost", fl.lost) << NV("moves", fl.moves)
+                 << NV("rate", fl.rate, 1);
+        rslt << NV("ao_fast_loop", fastLoop);
+    }
+
+    if (trace)
+    {
+        wxString fname = wxFileName::CreateTempFileName(MyFrame::GetDefaultFileDir() + PATHSEPSTR + "phd2_trace_");
+        if (LatencyTrace::WriteChromeTrace(fname))
+        {
+            ::wxRemove(fname);
+            response << jrpc_error(3, "error writing trace file");
+            return;
+        }
+        rslt << NV("trace_file", fname);
+    }
+
+    response << jrpc_result(rslt);
+}
+
 static GUIDE_DIRECTION dir_param(const json_value *p)
 {
     if (!p || p->type != JSON_STRING)
@@ -2465,6 +2515,7 @@ static bool handle_request(JRpcCall& call)
         { "set_variable_delay_settings", &set_variable_delay_settings },
         { "get_limit_frame", &get_limit_frame },
         { "set_limit_frame", &set_limit_frame },
+        { "get_timing_stats", &get_timing_stats },
     };
 
     for (unsigned int i = 0; i < WXSIZEOF(methods); i++)
@@ -0,0 +1,280 @@
+/*
+ *  frame_replay.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+#include "frame_replay.h"
+
+#include <wx/dir.h>
+#include <wx/ffile.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace
+{
+// Simulated mount hosting the profile's scope guide algorithms. The replay uses an identity
+// calibration (camera X is RA, camera Y is Dec), so corrections are reported in pixels and no
+// pulses are ever issued.
+class ReplayMount : public Scope
+{
+    MOVE_RESULT Guide(GUIDE_DIRECTION direction, int durationMs) override { return MOVE_OK; }
+};
+
+struct ReplayFrame
+{
+    wxString fileName;
+    std::unique_ptr<usImage> img;
+};
+
+struct StageTimer
+{
+    wxString name;
+    int64_t total;
+    int64_t max;
+    unsigned int count;
+
+    StageTimer(const wxString& name_) : name(name_), total(0), max(0), count(0) { }
+
+    void Add(int64_t us)
+    {
+        total += us;
+        max = std::max(max, us);
+        ++count;
+    }
+
+    wxString Summary() const
+    {
+        return wxString::Format("%-6s mean %8.1f us  max %8lld us", name, count ? (double) total / count : 0.0,
+                                (long long) max);
+    }
+};
+} // namespace
+
+static int64_t ElapsedUs(const wxStopWatch& sw)
+{
+    return sw.TimeInMicro().GetValue();
+}
+
+static bool LoadFrames(const wxString& path, std::vector<ReplayFrame> *frames)
+{
+    wxArrayString files;
+    if (wxDirExists(path))
+        wxDir::GetAllFiles(path, &files, "*.fit*", wxDIR_FILES | wxDIR_DIRS);
+    else if (wxFileExists(path))
+        files.Add(path);
+
+    // ImageLogger and sim_images file names sort into capture order
+    files.Sort();
+
+    for (const wxString& file : files)
+    {
+        ReplayFrame frame;
+        frame.fileName = file;
+        frame.img.reset(new usImage());
+        if (frame.img->Load(file))
+        {
+            Debug.Write(wxString::Format("Replay: skipping unreadable frame %s\n", file));
+            continue;
+        }
+        frames->push_back(std::move(frame));
+    }
+
+    return !frames->empty();
+}
+
+int FrameReplay::Run(const Options& options)
+{
+    Debug.Write(wxString::Format("Replay: frames %s dark %s\n", options.framesPath, options.darkPath));
+
+    std::vector<ReplayFrame> frames;
+
+    wxStopWatch loadTimer;
+    if (!LoadFrames(options.framesPath, &frames))
+    {
+        wxPrintf("replay: no FITS frames found in %s\n", options.framesPath);
+        return 1;
+    }
+    int64_t loadUs = ElapsedUs(loadTimer);
+
+    size_t bytes = 0;
+    for (const ReplayFrame& frame : frames)
+        bytes += frame.img->NPixels * sizeof(unsigned short);
+
+    wxString reportPath = options.reportPath;
+    if (reportPath.IsEmpty())
+        reportPath = wxFileName(Debug.GetLogDir(), wxDateTime::Now().Format("PHD2_Replay_%Y-%m-%d_%H%M%S.csv")).GetFullPath();
+
+    wxFFile report(reportPath, "w");
+    if (!report.IsOpened())
+    {
+        wxPrintf("replay: cannot create report file %s\n", reportPath);
+        return 1;
+    }
+    report.Write("Frame,File,Found,X,Y,dX,dY,SNR,HFD,RACorrection,DecCorrection,DarkUs,FindUs,GuideUs\n");
+
+    HeadlessCamera camera;
+    if (!options.darkPath.IsEmpty())
+    {
+        usImage *dark = new usImage();
+        if (dark->Load(options.darkPath))
+        {
+            delete dark;
+            wxPrintf("replay: cannot load dark frame %s\n", options.darkPath);
+            return 1;
+        }
+        camera.AddDark(dark);
+        camera.SelectDark(dark->ImgExpDur);
+    }
+
+    GuideCamera *prevCamera = pCamera;
+    pCamera = &camera;
+
+    int exitStatus = 0;
+
+    {
+        ReplayMount mount;
+        mount.NotifyGuidingStarted();
+
+        // stars are measured by the guider itself, so the replay follows the profile's star selection,
+        // multi-star and mass-change settings and the current star-find mode
+        Guider *guider = pFrame->pGuider;
+        bool selected = false;
+
+        StageTimer darkTimer("dark"), findTimer("find"), guideTimer("guide");
+        unsigned int found = 0;
+
+        wxStopWatch runTimer;
+
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            usImage& img = *frames[i].img;
+            img.FrameNum = (unsigned int) i + 1;
+            wxStopWatch sw;
+
+            camera.SubtractDark(img);
+            int64_t darkUs = ElapsedUs(sw);
+            darkTimer.Add(darkUs);
+
+            sw.Start();
+            GuiderOffset ofs;
+            bool ok;
+            if (!selected)
+            {
+                // select the star(s) on the first usable frame the same way the guider does on a new
+                // target; the lock position is set on the selected star
+                usImage *selectImg = new usImage();
+                selectImg->CopyFrom(img);
+                guider->DisplayImage(selectImg);
+                ok = selected = !guider->AutoSelect();
+                ofs.cameraOfs.SetXY(0.0, 0.0);
+            }
+            else
+            {
+                FrameDroppedInfo info;
+                ok = !guider->MeasureFrame(&img, &ofs, &info);
+            }
+            int64_t findUs = ElapsedUs(sw);
+            findTimer.Add(findUs);
+
+            if (!selected)
+            {
+                report.Write(wxString::Format("%u,%s,0,,,,,,,,,%lld,%lld,\n", (unsigned int) i + 1,
+                                              wxFileName(frames[i].fileName).GetFullName(), (long long) darkUs,
+                                              (long long) findUs));
+                continue;
+            }
+
+            double dx = 0.0, dy = 0.0;
+            sw.Start();
+            double raCorrection, decCorrection;
+            if (ok)
+            {
+                ++found;
+                dx = ofs.cameraOfs.X;
+                dy = ofs.cameraOfs.Y;
+                raCorrection = mount.GetXGuideAlgorithm()->result(dx);
+                decCorrection = mount.GetYGuideAlgorithm()->result(dy);
+            }
+            else
+            {
+                raCorrection = mount.GetXGuideAlgorithm()->deduceResult();
+                decCorrection = mount.GetYGuideAlgorithm()->deduceResult();
+            }
+            int64_t guideUs = ElapsedUs(sw);
+            guideTimer.Add(guideUs);
+
+            if (ok)
+            {
+                const Star& star = guider->PrimaryStar();
+                report.Write(wxString::Format("%u,%s,1,%.3f,%.3f,%.3f,%.3f,%.1f,%.2f,%.3f,%.3f,%lld,%lld,%lld\n",
+                                              (unsigned int) i + 1, wxFileName(frames[i].fileName).GetFullName(), star.X,
+                                              star.Y, dx, dy, star.SNR, star.HFD, raCorrection, decCorrection,
+                                              (long long) darkUs, (long long) findUs, (long long) guideUs));
+            }
+            else
+            {
+                report.Write(wxString::Format("%u,%s,0,,,,,,,%.3f,%.3f,%lld,%lld,%lld\n", (unsigned int) i + 1,
+                                              wxFileName(frames[i].fileName).GetFullName(), raCorrection, decCorrection,
+                                              (long long) darkUs, (long long) findUs, (long long) guideUs));
+            }
+        }
+
+        int64_t runUs = ElapsedUs(runTimer);
+
+        mount.NotifyGuidingStopped();
+
+        wxString summary =
+            wxString::Format("replay: %u frames (%.1f MB) loaded in %.2f s\n", (unsigned int) frames.size(),
+                             bytes / (1024.0 * 1024.0), loadUs / 1e6) +
+            wxString::Format("replay: star found in %u frames, multi-star %s, stars used %s, RA %s, Dec %s\n", found,
+                             guider->GetMultiStarMode() ? "on" : "off", guider->GetStarCount(),
+                             mount.GetXGuideAlgorithm()->GetGuideAlgorithmClassName(),
+                             mount.GetYGuideAlgorithm()->GetGuideAlgorithmClassName()) +
+            wxString::Format("replay: pipeline %.3f s, %.1f frames/s\n", runUs / 1e6,
+                             runUs > 0 ? frames.size() * 1e6 / runUs : 0.0) +
+            "replay: " + darkTimer.Summary() + "\n" + "replay: " + findTimer.Summary() + "\n" + "replay: " +
+            guideTimer.Summary() + "\n" + "replay: report written to " + reportPath + "\n";
+
+        wxPrintf("%s", summary);
+        Debug.Write(summary);
+
+        if (!found)
+            exitStatus = 1;
+    }
+
+    pCamera = prevCamera;
+
+    return exitStatus;
+}
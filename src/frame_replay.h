@@ -0,0 +1,75 @@
+/*
+ *  frame_replay.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef FRAME_REPLAY_INCLUDED
+#define FRAME_REPLAY_INCLUDED
+
+// Stand-in for the guide camera in the headless run modes (--replay, --bench). The star finder
+// and dark subtraction read their settings (saturation, dark frame) from pCamera, so a headless
+// run installs one of these while it works; frames never come from Capture.
+class HeadlessCamera : public GuideCamera
+{
+public:
+    HeadlessCamera() { Name = _T("Headless"); }
+
+    bool HasNonGuiCapture() override { return true; }
+    wxByte BitsPerPixel() override { return 16; }
+    bool Connect(const wxString& cameraId) override { return false; }
+    bool Disconnect() override { return false; }
+    bool Capture(usImage& img, const CaptureParams& captureParams) override { return true; }
+};
+
+// Replay of recorded guide camera frames through the guiding pipeline without the camera,
+// the mount or the UI (phd2 --replay <dir>).
+//
+// Every frame is read into memory before the run starts so the measurements cover the pipeline
+// and not the disk. Each frame then goes through dark subtraction, the guider's own star
+// measurement (star selection, multi-star refinement and mass-change checks as configured in the
+// profile) and the profile's mount guide algorithms, and the per-frame corrections and stage
+// timings are written to a CSV report.
+class FrameReplay
+{
+public:
+    struct Options
+    {
+        wxString framesPath; // directory of FITS frames, e.g. sim_images or PHD2_CameraFrames_*
+        wxString darkPath;   // optional dark frame to subtract
+        wxString reportPath; // CSV report, defaults to a file in the log directory
+    };
+
+    // run the replay, returns the process exit status
+    static int Run(const Options& options);
+};
+
+#endif // FRAME_REPLAY_INCLUDED
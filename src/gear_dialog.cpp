@@ -33,6 +33,7 @@
  */
 
 #include "phd.h"
+#include "driver_registry.h"
 #include "profile_wizard.h"
 
 #include <wx/gbsizer.h>
@@ -363,6 +364,14 @@ void GearDialog::Initialize()
 
     pTopLevelSizer->Add(pButtonSizer, wxSizerFlags().Align(wxALIGN_TOP | wxALIGN_CENTER_HORIZONTAL).Border(wxALL, 2));
 
+    // probe the driver SDKs side by side rather than one after another as each list is loaded
+    {
+        DriverRegistry::Prefetch prefetch;
+        GuideCamera::GuideCameraList();
+        Scope::MountList();
+        Rotator::RotatorList();
+    }
+
     // preselect the choices
     LoadGearChoices();
 
@@ -969,24 +978,6 @@ void GearDialog::OnChoiceCamera(wxCommandEvent& event)
     m_cameraUpdated = true;
 }
 
-static void AutoLoadDefectMap()
-{
-    if (pConfig->Profile.GetBoolean("/camera/AutoLoadDefectMap", true))
-    {
-        Debug.AddLine("auto-loading defect map");
-        pFrame->LoadDefectMapHandler(true);
-    }
-}
-
-static void AutoLoadDarks()
-{
-    if (pConfig->Profile.GetBoolean("/camera/AutoLoadDarks", true))
-    {
-        Debug.AddLine("Auto-loading dark library");
-        pFrame->LoadDarkHandler(true);
-    }
-}
-
 wxString GearDialog::CameraSelectionKey(const wxString& camName)
 {
     std::hash<std::string> hash_fn;
@@ -1068,8 +1059,9 @@ void GearDialog::OnButtonSetupCamera(wxCommandEvent& event)
 {
     m_pCamera->ShowPropertyDialog();
 
-    // camera setup may have changed camera name so re-load the camera list
+    // camera setup may have changed camera name so re-load the camera list, and may have registered new drivers
     wxString selection = m_pCameras->GetStringSelection();
+    DriverRegistry::Refresh();
     LoadCameras(m_pCameras);
     SetMatchingSelection(m_pCameras, selection);
 }
@@ -1210,12 +1202,9 @@ bool GearDialog::DoConnectCamera(bool autoReconnecting)
 
         if (!autoReconnecting) // On a reconnect, this stuff is already established
         {
-            AutoLoadDefectMap();
-            if (!pCamera->CurrentDefectMap)
-            {
-                AutoLoadDarks();
-            }
+            // the defect map or darks are loaded in the background and installed when ready
             pFrame->SetDarkMenuState();
+            pFrame->AutoLoadCalibrationData();
         }
 
         pFrame->StatusMsg(_("Camera Connected"));
@@ -1379,8 +1368,9 @@ void GearDialog::OnButtonSetupScope(wxCommandEvent& event)
 {
     m_pScope->SetupDialog();
 
-    // scope setup may have changed the scope name so re-load the scope list
+    // scope setup may have changed the scope name so re-load the scope list, and may have registered new drivers
     wxString selection = m_pScopes->GetStringSelection();
+    DriverRegistry::Refresh();
     LoadMounts(m_pScopes);
     SetMatchingSelection(m_pScopes, selection);
 }
@@ -1389,8 +1379,9 @@ void GearDialog::OnButtonSetupAuxScope(wxCommandEvent& event)
 {
     m_pAuxScope->SetupDialog();
 
-    // scope setup may have changed scope name so re-load the aux scope list
+    // scope setup may have changed scope name so re-load the aux scope list, and may have registered new drivers
     wxString selection = m_pAuxScopes->GetStringSelection();
+    DriverRegistry::Refresh();
     LoadAuxMounts(m_pAuxScopes);
     SetMatchingSelection(m_pAuxScopes, selection);
 }
@@ -1638,7 +1629,7 @@ void GearDialog::OnButtonConnectStepGuider(wxCommandEvent& event)
             }
 
             pFrame->StatusMsgNoTimeout(_("Centering AO ..."));
-            if (m_pStepGuider->Center())
+            if (m_pStepGuider->Recenter())
             {
                 m_pStepGuider->Disconnect();
                 throw ERROR_INFO("StepGuider unable to center");
@@ -1745,8 +1736,9 @@ void GearDialog::OnButtonSetupRotator(wxCommandEvent& event)
 {
     m_pRotator->ShowPropertyDialog();
 
-    // setup dialog may have changed device name so re-load the list
+    // setup dialog may have changed device name so re-load the list, and may have registered new drivers
     wxString selection = m_pRotators->GetStringSelection();
+    DriverRegistry::Refresh();
     LoadRotators(m_pRotators);
     SetMatchingSelection(m_pRotators, selection);
 }
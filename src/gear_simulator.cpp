@@ -41,6 +41,7 @@
 # include "camera.h"
 # include "gear_simulator.h"
 # include "image_math.h"
+# include "thread_pool.h"
 
 # include <wx/dir.h>
 # include <wx/gdicmn.h>
@@ -86,10 +87,11 @@ struct SimCamParams
     static double comet_rate_y;
     static bool allow_async_st4;
     static unsigned int frame_download_ms;
+    static unsigned int seed;
 };
 
-unsigned int SimCamParams::width = 752; // simulated camera image width
-unsigned int SimCamParams::height = 580; // simulated camera image height
+unsigned int SimCamParams::width; // simulated camera image width
+unsigned int SimCamParams::height; // simulated camera image height
 unsigned int SimCamParams::border = 12; // do not place any stars within this size border
 unsigned int SimCamParams::nr_stars; // number of stars to generate
 unsigned int SimCamParams::nr_hot_pixels; // number of hot pixels to generate
@@ -116,6 +118,7 @@ double SimCamParams::comet_rate_x;
 double SimCamParams::comet_rate_y;
 bool SimCamParams::allow_async_st4 = true;
 unsigned int SimCamParams::frame_download_ms; // frame download time, ms
+unsigned int SimCamParams::seed; // random number seed for the noise, seeing and clouds, 0 = different every run
 
 // Note: these are all in units appropriate for the UI
 # define NR_STARS_DEFAULT 20
@@ -146,6 +149,10 @@ unsigned int SimCamParams::frame_download_ms; // frame download time, ms
 # define COMET_RATE_X_DEFAULT 555.0 // pixels per hour
 # define COMET_RATE_Y_DEFAULT -123.4 // pixels per hour
 # define SIM_FILE_DISPLACEMENTS_DEFAULT "star_displacements.csv"
+# define SENSOR_WIDTH_DEFAULT 752
+# define SENSOR_HEIGHT_DEFAULT 580
+# define SENSOR_SIZE_MIN 128
+# define SENSOR_SIZE_MAX 8192
 
 // Needed to handle legacy registry values that may no longer be in correct units or range
 static double range_check(double thisval, double minval, double maxval)
@@ -189,6 +196,13 @@ static void load_sim_params()
     SimCamParams::comet_rate_y = pConfig->Profile.GetDouble("/SimCam/comet_rate_y", COMET_RATE_Y_DEFAULT);
 
     SimCamParams::frame_download_ms = pConfig->Profile.GetInt("/SimCam/frame_download_ms", 50);
+
+    // no UI for these, they are for stress-testing with large frames and for reproducible runs
+    SimCamParams::width = (unsigned int) wxClip(pConfig->Profile.GetInt("/SimCam/width", SENSOR_WIDTH_DEFAULT), SENSOR_SIZE_MIN,
+                                                SENSOR_SIZE_MAX);
+    SimCamParams::height = (unsigned int) wxClip(pConfig->Profile.GetInt("/SimCam/height", SENSOR_HEIGHT_DEFAULT),
+                                                 SENSOR_SIZE_MIN, SENSOR_SIZE_MAX);
+    SimCamParams::seed = (unsigned int) pConfig->Profile.GetInt("/SimCam/seed", 0);
 }
 
 static void save_sim_params()
@@ -536,10 +550,63 @@ struct Cooler
     }
 };
 
+// Counter-based random numbers for the simulator. Each value is a hash (the SplitMix64 finalizer) of a
+// per-stream key and the position in the stream, so any stream can be generated from any point
+// without producing the values before it. Pixel noise uses one stream per image row, which lets
+// the rows of a frame be filled on several threads while giving the same image for a given seed
+// however the rows are divided. Unlike rand() it is thread-safe, and cheap enough to call per pixel.
+class SimRandom
+{
+    uint64_t m_key;
+    uint64_t m_ctr;
+
+public:
+    static uint64_t Mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    SimRandom(uint64_t seed, uint64_t stream) : m_key(Mix(seed ^ Mix(stream + 0x9e3779b97f4a7c15ULL))), m_ctr(0) { }
+
+    // the i-th value of the stream, independent of the stream position
+    uint32_t At(uint64_t i) const { return (uint32_t) (Mix(m_key + (i + 1) * 0x9e3779b97f4a7c15ULL) >> 32); }
+
+    uint32_t Next() { return At(m_ctr++); }
+
+    // uniform integer in [0, n)
+    static unsigned int Scale(uint32_t r, unsigned int n) { return (unsigned int) (((uint64_t) r * n) >> 32); }
+    unsigned int Below(unsigned int n) { return Scale(Next(), n); }
+
+    // uniform in (0, 1)
+    double Uniform() { return ((double) Next() + 0.5) * (1.0 / 4294967296.0); }
+
+    // get a pair of normally-distributed independent random values - Box-Muller algorithm, sigma=1
+    void Normal(double r[2])
+    {
+        double const a = sqrt(-2.0 * log(Uniform()));
+        double const p = 2 * M_PI * Uniform();
+        r[0] = a * cos(p);
+        r[1] = a * sin(p);
+    }
+};
+
+// random stream ids, combined with the row number for the per-row streams
+enum SimRandomStream : uint64_t
+{
+    SIM_STREAM_FRAME = 0, // seeing, star intensities
+    SIM_STREAM_NOISE = 1ULL << 32, // background noise, per row
+    SIM_STREAM_CLOUDS = 2ULL << 32, // cloud cover, per row
+};
+
 struct SimCamState
 {
     unsigned int width;
     unsigned int height;
+    uint64_t seed; // base random seed for this run
+    uint64_t frame_seed; // random seed for the frame being rendered
+    unsigned int frame_num;
     wxVector<SimStar> stars; // star positions and intensities (ra, dec)
     wxVector<wxPoint> hotpx; // hot pixels
     double ra_ofs; // assume no backlash in RA
@@ -570,6 +637,7 @@ struct SimCamState
 # endif
 
     void Initialize();
+    void BeginFrame();
     void FillImage(usImage& img, const wxRect& subframe, int exptime, int gain, int offset);
 };
 
@@ -612,6 +680,9 @@ void SimCamState::Initialize()
         hotpx[i].y = rand() % height;
     }
     srand(clock());
+    seed = SimCamParams::seed ? SimCamParams::seed : (uint64_t) wxGetUTCTimeUSec().GetValue();
+    frame_num = 0;
+    frame_seed = seed;
     ra_ofs = 0.;
     dec_ofs = BacklashVal(SimCamParams::dec_backlash);
     cum_dec_drift = 0.;
@@ -659,6 +730,11 @@ void SimCamState::Initialize()
 # endif
 }
 
+void SimCamState::BeginFrame()
+{
+    frame_seed = SimRandom::Mix(seed + SimRandom::Mix(++frame_num));
+}
+
 # if SIMMODE == 1
 bool SimCamState::ReadNextImage(usImage& img, const wxRect& subframe)
 {
@@ -773,17 +849,6 @@ bool SimCamState::ReadNextImage(usImage& img, const wxRect& subframe)
 }
 # endif // SIMMODE == 1
 
-// get a pair of normally-distributed independent random values - Box-Muller algorithm, sigma=1
-static void rand_normal(double r[2])
-{
-    double u = (double) rand() / RAND_MAX;
-    double v = (double) rand() / RAND_MAX;
-    double const a = sqrt(-2.0 * log(u));
-    double const p = 2 * M_PI * v;
-    r[0] = a * cos(p);
-    r[1] = a * sin(p);
-}
-
 inline static unsigned short *pixel_addr(usImage& img, int x, int y)
 {
     if (x < 0 || x >= img.Size.x)
@@ -814,74 +879,63 @@ inline static void incr_pixel(usImage& img, int x, int y, unsigned int val)
     }
 }
 
-static void render_comet(usImage& img, int binning, const wxRect& subframe, const wxRealPoint& p, double inten)
+enum
+{
+    STAR_PSF_WIDTH = 5
+};
+
+// Star profile, normalized to a peak of 0.5
+static const float STAR_PSF[STAR_PSF_WIDTH][STAR_PSF_WIDTH] = {
+    { 0.0f / 256, 0.8f / 256, 2.2f / 256, 0.8f / 256, 0.0f / 256 },
+    { 0.8f / 256, 16.6f / 256, 46.1f / 256, 16.6f / 256, 0.8f / 256 },
+    { 2.2f / 256, 46.1f / 256, 128.0f / 256, 46.1f / 256, 2.2f / 256 },
+    { 0.8f / 256, 16.6f / 256, 46.1f / 256, 16.6f / 256, 0.8f / 256 },
+    { 0.0f / 256, 0.8f / 256, 2.2f / 256, 0.8f / 256, 0.0f / 256 },
+};
+
+// The star profile resampled at a sub-pixel position, ready to be added to the image. The stamp
+// is one pixel wider than the profile, and origin is the image position of its top-left pixel.
+struct StarStamp
 {
     enum
     {
-        WIDTH = 5
-    };
-    double STAR[][WIDTH] = {
-        {
-            0.0,
-            0.8,
-            2.2,
-            0.8,
-            0.0,
-        },
-        {
-            0.8,
-            16.6,
-            46.1,
-            16.6,
-            0.8,
-        },
-        {
-            2.2,
-            46.1,
-            128.0,
-            46.1,
-            2.2,
-        },
-        {
-            0.8,
-            16.6,
-            46.1,
-            16.6,
-            0.8,
-        },
-        {
-            0.0,
-            0.8,
-            2.2,
-            0.8,
-            0.0,
-        },
+        WIDTH = STAR_PSF_WIDTH + 1
     };
+    float val[WIDTH][WIDTH];
+    wxPoint origin;
 
-    wxRealPoint intpart;
-    double fx = modf(p.x / (double) binning, &intpart.x);
-    double fy = modf(p.y / (double) binning, &intpart.y);
-    double f00 = (1.0 - fx) * (1.0 - fy);
-    double f01 = (1.0 - fx) * fy;
-    double f10 = fx * (1.0 - fy);
-    double f11 = fx * fy;
-
-    double d[WIDTH + 1][WIDTH + 1] = { { 0.0 } };
-    for (unsigned int i = 0; i < WIDTH; i++)
-        for (unsigned int j = 0; j < WIDTH; j++)
-        {
-            double s = STAR[i][j];
-            if (s > 0.0)
+    StarStamp(int binning, const wxRealPoint& p, double inten)
+    {
+        wxRealPoint intpart;
+        float const fx = (float) modf(p.x / (double) binning, &intpart.x);
+        float const fy = (float) modf(p.y / (double) binning, &intpart.y);
+        float const s = (float) inten;
+
+        // bilinear split of the profile over the four pixels around each sample, done one axis at a time
+        float wx[WIDTH][STAR_PSF_WIDTH] = { { 0.f } };
+        for (unsigned int i = 0; i < STAR_PSF_WIDTH; i++)
+            for (unsigned int j = 0; j < STAR_PSF_WIDTH; j++)
             {
-                s *= inten / 256.0;
-                d[i][j] += f00 * s;
-                d[i + 1][j] += f10 * s;
-                d[i][j + 1] += f01 * s;
-                d[i + 1][j + 1] += f11 * s;
+                float const v = STAR_PSF[i][j] * s;
+                wx[i][j] += (1.f - fx) * v;
+                wx[i + 1][j] += fx * v;
             }
+        for (unsigned int i = 0; i < WIDTH; i++)
+        {
+            for (unsigned int j = 0; j < STAR_PSF_WIDTH; j++)
+                val[i][j] = (j > 0 ? fy * wx[i][j - 1] : 0.f) + (1.f - fy) * wx[i][j];
+            val[i][STAR_PSF_WIDTH] = fy * wx[i][STAR_PSF_WIDTH - 1];
         }
 
-    wxPoint c((int) intpart.x - (WIDTH - 1) / 2, (int) intpart.y - (WIDTH - 1) / 2);
+        origin = wxPoint((int) intpart.x - (STAR_PSF_WIDTH - 1) / 2, (int) intpart.y - (STAR_PSF_WIDTH - 1) / 2);
+    }
+};
+
+static void render_comet(usImage& img, int binning, const wxRect& subframe, const wxRealPoint& p, double inten)
+{
+    StarStamp stamp(binning, p, inten);
+    const wxPoint& c = stamp.origin;
+    int const peak = (int) stamp.val[2][2];
 
     for (unsigned int x_inc = 0; x_inc < 10; x_inc++)
     {
@@ -890,91 +944,27 @@ static void render_comet(usImage& img, int binning, const wxRect& subframe, cons
             int const cx = c.x + x_inc;
             int const cy = c.y + y * x_inc;
             if (cx < subframe.GetRight() && cy < subframe.GetBottom() && cy > subframe.GetTop())
-                incr_pixel(img, cx, cy, (int) d[2][2]);
+                incr_pixel(img, cx, cy, peak);
         }
     }
 }
 
 static void render_star(usImage& img, int binning, const wxRect& subframe, const wxRealPoint& p, double inten)
 {
-    enum
-    {
-        WIDTH = 5
-    };
-    double STAR[][WIDTH] = {
-        {
-            0.0,
-            0.8,
-            2.2,
-            0.8,
-            0.0,
-        },
-        {
-            0.8,
-            16.6,
-            46.1,
-            16.6,
-            0.8,
-        },
-        {
-            2.2,
-            46.1,
-            128.0,
-            46.1,
-            2.2,
-        },
-        {
-            0.8,
-            16.6,
-            46.1,
-            16.6,
-            0.8,
-        },
-        {
-            0.0,
-            0.8,
-            2.2,
-            0.8,
-            0.0,
-        },
-    };
-
-    wxRealPoint intpart;
-    double fx = modf(p.x / (double) binning, &intpart.x);
-    double fy = modf(p.y / (double) binning, &intpart.y);
-    double f00 = (1.0 - fx) * (1.0 - fy);
-    double f01 = (1.0 - fx) * fy;
-    double f10 = fx * (1.0 - fy);
-    double f11 = fx * fy;
-
-    double d[WIDTH + 1][WIDTH + 1] = { { 0.0 } };
-    for (unsigned int i = 0; i < WIDTH; i++)
-        for (unsigned int j = 0; j < WIDTH; j++)
-        {
-            double s = STAR[i][j];
-            if (s > 0.0)
-            {
-                s *= inten / 256.0;
-                d[i][j] += f00 * s;
-                d[i + 1][j] += f10 * s;
-                d[i][j + 1] += f01 * s;
-                d[i + 1][j + 1] += f11 * s;
-            }
-        }
+    StarStamp stamp(binning, p, inten);
+    const wxPoint& c = stamp.origin;
 
-    wxPoint c((int) intpart.x - (WIDTH - 1) / 2, (int) intpart.y - (WIDTH - 1) / 2);
-
-    for (unsigned int i = 0; i < WIDTH + 1; i++)
+    for (unsigned int i = 0; i < StarStamp::WIDTH; i++)
     {
         int const cx = c.x + i;
         if (cx < subframe.GetLeft() || cx > subframe.GetRight())
             continue;
-        for (unsigned int j = 0; j < WIDTH + 1; j++)
+        for (unsigned int j = 0; j < StarStamp::WIDTH; j++)
         {
             int const cy = c.y + j;
             if (cy < subframe.GetTop() || cy > subframe.GetBottom())
                 continue;
-            int incr = (int) d[i][j];
+            int incr = (int) stamp.val[i][j];
             if (incr > (unsigned short) -1)
                 incr = (unsigned short) -1;
             incr_pixel(img, cx, cy, incr);
@@ -982,21 +972,50 @@ static void render_star(usImage& img, int binning, const wxRect& subframe, const
     }
 }
 
-static void render_clouds(usImage& img, const wxRect& subframe, int exptime, int gain, int offset)
+// Run fn(firstRow, endRow) over the rows of a subframe, split into blocks across the thread pool.
+// Small subframes are not worth handing out and are done on the calling thread.
+template<typename Fn>
+static void parallel_rows(const wxRect& subframe, const Fn& fn)
 {
-    unsigned short cloud_amt;
-    unsigned short *p0 = &img.Pixel(subframe.GetLeft(), subframe.GetTop());
-    for (int r = 0; r < subframe.GetHeight(); r++, p0 += img.Size.GetWidth())
+    enum
     {
-        unsigned short *const end = p0 + subframe.GetWidth();
-        for (unsigned short *p = p0; p < end; p++)
+        MIN_BLOCK_PIXELS = 64 * 1024
+    };
+
+    int const rows = subframe.GetHeight();
+    if (rows <= 0)
+        return;
+    int const blockRows = wxMax(1, MIN_BLOCK_PIXELS / wxMax(subframe.GetWidth(), 1));
+    unsigned int const nblocks = (rows + blockRows - 1) / blockRows;
+
+    ThreadPool::ParallelFor(nblocks, [&](unsigned int block) {
+        int const r0 = block * blockRows;
+        fn(subframe.GetTop() + r0, subframe.GetTop() + wxMin(rows, r0 + blockRows));
+    });
+}
+
+static void render_clouds(usImage& img, const wxRect& subframe, int exptime, int gain, int offset, uint64_t frame_seed)
+{
+    float const base = (float) ((double) gain / 10.0 * offset * exptime / 100.0);
+    float const inten = (float) SimCamParams::clouds_inten;
+    float const opacity = (float) SimCamParams::clouds_opacity;
+    unsigned int const range = gain * 100;
+    int const width = subframe.GetWidth();
+
+    parallel_rows(subframe, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++)
         {
-            // Compute a randomized brightness contribution from clouds, then overlay that on the guide frame
-            cloud_amt = (unsigned short) (SimCamParams::clouds_inten *
-                                          ((double) gain / 10.0 * offset * exptime / 100.0 + ((rand() % (gain * 100)) / 30.0)));
-            *p = (unsigned short) (SimCamParams::clouds_opacity * cloud_amt + (1 - SimCamParams::clouds_opacity) * *p);
+            SimRandom const rng(frame_seed, SIM_STREAM_CLOUDS | y);
+            unsigned short *const p = &img.Pixel(subframe.GetLeft(), y);
+            for (int x = 0; x < width; x++)
+            {
+                // Compute a randomized brightness contribution from clouds, then overlay that on the guide frame
+                unsigned short const cloud_amt =
+                    (unsigned short) (inten * (base + (float) SimRandom::Scale(rng.At(x), range) / 30.f));
+                p[x] = (unsigned short) (opacity * cloud_amt + (1.f - opacity) * p[x]);
+            }
         }
-    }
+    });
 }
 
 # ifdef SIM_FILE_DISPLACEMENTS
@@ -1066,6 +1085,8 @@ void SimCamState::FillImage(usImage& img, const wxRect& subframe, int exptime, i
     CountUp++;
 # endif
 
+    SimRandom rng(frame_seed, SIM_STREAM_FRAME);
+
     // start with original star positions
     wxVector<wxRealPoint> pos(nr_stars);
     for (unsigned int i = 0; i < nr_stars; i++)
@@ -1158,7 +1179,7 @@ void SimCamState::FillImage(usImage& img, const wxRect& subframe, int exptime, i
     // simulate seeing
     if (SimCamParams::seeing_scale > 0.0)
     {
-        rand_normal(seeing);
+        rng.Normal(seeing);
         static const double seeing_adjustment = (2.345 * 1.4 * 2.4); // FWHM, geometry, empirical
         double sigma = SimCamParams::seeing_scale / (seeing_adjustment * SimCamParams::image_scale);
         seeing[0] *= sigma;
@@ -1238,7 +1259,7 @@ void SimCamState::FillImage(usImage& img, const wxRect& subframe, int exptime, i
         {
             double star = stars[i].inten * exptime * gain;
             double dark = (double) gain / 10.0 * offset * exptime / 100.0;
-            double noise = (double) (rand() % (gain * 100));
+            double noise = (double) rng.Below(gain * 100);
             double inten = star + dark + noise;
 
             render_star(img, binning, subframe, cc[i], inten);
@@ -1255,7 +1276,7 @@ void SimCamState::FillImage(usImage& img, const wxRect& subframe, int exptime, i
             double inten = 3.0;
             double star = inten * exptime * gain;
             double dark = (double) gain / 10.0 * offset * exptime / 100.0;
-            double noise = (double) (rand() % (gain * 100));
+            double noise = (double) rng.Below(gain * 100);
             inten = star + dark + noise;
 
             render_comet(img, binning, subframe, wxRealPoint(cx, cy), inten);
@@ -1264,7 +1285,7 @@ void SimCamState::FillImage(usImage& img, const wxRect& subframe, int exptime, i
     }
 
     if (SimCamParams::clouds_opacity > 0)
-        render_clouds(img, subframe, exptime, gain, offset);
+        render_clouds(img, subframe, exptime, gain, offset, frame_seed);
 
     // render hot pixels
     for (unsigned int i = 0; i < hotpx.size(); i++)
@@ -1289,6 +1310,7 @@ public:
     bool Disconnect() override;
     void ShowPropertyDialog() override;
     bool HasNonGuiCapture() override { return true; }
+    bool CanOverlapExposures() override { return true; }
     wxByte BitsPerPixel() override;
     bool SetCoolerOn(bool on) override;
     bool SetCoolerSetpoint(double temperature) override;
@@ -1296,6 +1318,7 @@ public:
     bool GetSensorTemperature(double *temperature) override;
     bool ST4HasNonGuiMove() override { return true; }
     bool ST4SynchronousOnly() override;
+    bool ST4CanGuideAxesSimultaneously() override { return true; }
     bool ST4PulseGuideScope(int direction, int duration) override;
     PierSide SideOfPier() const;
     void FlipPierSide();
@@ -1414,16 +1437,23 @@ bool CameraSimulator::Capture(usImage& img, const CaptureParams& captureParams)
 # endif
 
 # if SIMMODE == 3
-static void fill_noise(usImage& img, const wxRect& subframe, int exptime, int gain, int offset)
+static void fill_noise(usImage& img, const wxRect& subframe, int exptime, int gain, int offset, uint64_t frame_seed)
 {
-    unsigned short *p0 = &img.Pixel(subframe.GetLeft(), subframe.GetTop());
-    for (int r = 0; r < subframe.GetHeight(); r++, p0 += img.Size.GetWidth())
-    {
-        unsigned short *const end = p0 + subframe.GetWidth();
-        for (unsigned short *p = p0; p < end; p++)
-            *p = (unsigned short) (SimCamParams::noise_multiplier *
-                                   ((double) gain / 10.0 * offset * exptime / 100.0 + (rand() % (gain * 100))));
-    }
+    float const mult = (float) SimCamParams::noise_multiplier;
+    float const base = (float) ((double) gain / 10.0 * offset * exptime / 100.0);
+    unsigned int const range = gain * 100;
+    int const width = subframe.GetWidth();
+
+    parallel_rows(subframe, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++)
+        {
+            // the values depend only on the row stream and the column, so this loop vectorizes
+            SimRandom const rng(frame_seed, SIM_STREAM_NOISE | y);
+            unsigned short *const p = &img.Pixel(subframe.GetLeft(), y);
+            for (int x = 0; x < width; x++)
+                p[x] = (unsigned short) (mult * (base + (float) SimRandom::Scale(rng.At(x), range)));
+        }
+    });
 }
 # endif // SIMMODE == 3
 
@@ -1484,7 +1514,9 @@ bool CameraSimulator::Capture(usImage& img, const CaptureParams& captureParams)
     if (usingSubframe)
         img.Clear();
 
-    fill_noise(img, subframe, exptime, gain, offset);
+    sim.BeginFrame();
+
+    fill_noise(img, subframe, exptime, gain, offset, sim.frame_seed);
 
     sim.FillImage(img, subframe, exptime, gain, offset);
 
@@ -84,6 +84,10 @@ public:
     virtual double result(double input) = 0;
     virtual double deduceResult() { return 0.0; }
 
+    // Offline evaluation: describes the recorded frame that the next result() call is for, in place
+    // of the wall clock, the exposure duration and the guide star that live guiding reads.
+    virtual void SetReplayFrame(double time, int exposureMs, int latencyMs, double snr) { }
+
     virtual void GuidingStarted();
     virtual void GuidingStopped();
     virtual void GuidingPaused();
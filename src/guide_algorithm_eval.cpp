@@ -0,0 +1,580 @@
+/*
+ *  guide_algorithm_eval.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include "phd.h"
+#include "guide_algorithm_eval.h"
+#include "guide_log_reader.h"
+#include "thread_pool.h"
+
+#include <wx/tokenzr.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+// candidate algorithms are created under their own profile group so that evaluating them never
+// touches the user's guide algorithm settings
+class TuningMount : public Scope
+{
+    MOVE_RESULT Guide(GUIDE_DIRECTION direction, int durationMs) override { return MOVE_OK; }
+
+public:
+    wxString GetMountClassName() const override { return "tuning"; }
+};
+
+// reads the user's current scope guide algorithm settings
+class ProfileMount : public Scope
+{
+    MOVE_RESULT Guide(GUIDE_DIRECTION direction, int durationMs) override { return MOVE_OK; }
+};
+
+enum
+{
+    MinSectionSamples = 10,
+    TopResults = 5,
+};
+
+struct LogSample
+{
+    double time;       // seconds since guiding started
+    double raw[2];     // RA, Dec offset from the lock position in pixels
+    double applied[2]; // correction sent to the mount in pixels, 0 if no pulse was issued
+    double snr;
+    int exposure; // requested exposure in ms, 0 with auto exposure
+};
+
+// consecutive guide steps with an unchanged lock position and no dropped frames
+typedef std::vector<LogSample> LogSection;
+
+struct Param
+{
+    wxString name;
+    double val;
+};
+
+struct Candidate
+{
+    GUIDE_ALGORITHM algo;
+    std::vector<Param> params;
+    bool current; // the profile's settings
+};
+
+struct Result
+{
+    const Candidate *candidate;
+    GuideAxis axis;
+    double rms;
+};
+
+struct AlgoName
+{
+    const char *name;
+    GUIDE_ALGORITHM algo;
+};
+
+const AlgoName s_algoNames[] = {
+    { "identity", GUIDE_ALGORITHM_IDENTITY },
+    { "hysteresis", GUIDE_ALGORITHM_HYSTERESIS },
+    { "lowpass", GUIDE_ALGORITHM_LOWPASS },
+    { "lowpass2", GUIDE_ALGORITHM_LOWPASS2 },
+    { "resistswitch", GUIDE_ALGORITHM_RESIST_SWITCH },
+    { "zfilter", GUIDE_ALGORITHM_ZFILTER },
+    { "gp", GUIDE_ALGORITHM_GAUSSIAN_PROCESS },
+};
+
+// the Gaussian process guider is orders of magnitude slower than the others, so it is only
+// evaluated when it is named in the grid
+const char *const DefaultGrid = "hysteresis:minMove=0.1..0.4/0.05,hysteresis=0|0.1|0.2,aggression=0.4..1.0/0.1;"
+                                "lowpass2:minMove=0.1..0.4/0.05,aggressiveness=40..100/10;"
+                                "resistswitch:minMove=0.1..0.4/0.05,aggression=0.4..1.0/0.1;"
+                                "zfilter:minMove=0.1..0.4/0.05,expFactor=1..8/1";
+
+} // namespace
+
+static wxString AlgorithmName(GUIDE_ALGORITHM algo)
+{
+    for (const AlgoName& a : s_algoNames)
+        if (a.algo == algo)
+            return a.name;
+    return wxString::Format("algo%d", (int) algo);
+}
+
+static bool ParseDouble(wxString s, double *val)
+{
+    return s.Trim(true).Trim(false).ToCDouble(val);
+}
+
+// requested exposure in ms from the settings logged at the start of a guiding section, 0 with
+// auto exposure ("Exposure = Auto (...)")
+static int SectionExposure(const GuideLogReader::Field& header)
+{
+    static const char key[] = "\nExposure = ";
+    const char *end = header.ptr + header.len;
+    const char *p = std::search(header.ptr, end, key, key + sizeof(key) - 1);
+    if (p == end)
+        return 0;
+    p += sizeof(key) - 1;
+    GuideLogReader::Field val { p, (size_t) (std::find(p, end, ' ') - p) };
+    long ms;
+    return val.ToLong(&ms) ? (int) ms : 0;
+}
+
+static bool Contains(const GuideLogReader::Field& text, const char *s)
+{
+    const char *end = text.ptr + text.len;
+    return std::search(text.ptr, end, s, s + strlen(s)) != end;
+}
+
+static bool LoadSections(const wxString& path, std::vector<LogSection> *sections, unsigned int *aoSections)
+{
+    GuideLogReader log;
+    if (log.Open(path))
+        return false;
+
+    for (const GuideLogReader::Section& sec : log.Sections())
+    {
+        if (sec.type != GuideLogReader::SECTION_GUIDING)
+            continue;
+
+        int exposure = SectionExposure(log.SectionHeader(sec));
+        LogSection section;
+        bool ao = false;
+
+        auto endSection = [&]() {
+            // AO steps and mount bumps interleave in a way the single-mount model cannot replay
+            if (ao)
+                ++*aoSections;
+            else if (section.size() >= MinSectionSamples)
+                sections->push_back(std::move(section));
+            section.clear();
+            ao = false;
+        };
+
+        for (size_t row = sec.firstRow; row < sec.endRow; row++)
+        {
+            // Frame,Time,mount,dx,dy,RARawDistance,DECRawDistance,RAGuideDistance,DECGuideDistance,
+            // RADuration,RADirection,DECDuration,DECDirection,XStep,YStep,StarMass,SNR,ErrorCode
+            GuideLogReader::Field mount = log.GetField(row, 2);
+            if (mount == "\"DROP\"")
+            {
+                endSection();
+                continue;
+            }
+
+            if (mount == "\"AO\"")
+                ao = true;
+            else
+            {
+                LogSample s;
+                double guide[2];
+                long durRA = 0, durDec = 0;
+                if (log.GetDouble(row, 1, &s.time) && log.GetDouble(row, 5, &s.raw[0]) && log.GetDouble(row, 6, &s.raw[1]) &&
+                    log.GetDouble(row, 7, &guide[0]) && log.GetDouble(row, 8, &guide[1]))
+                {
+                    log.GetField(row, 9).ToLong(&durRA);
+                    log.GetField(row, 11).ToLong(&durDec);
+                    if (!log.GetDouble(row, 16, &s.snr))
+                        s.snr = 0.0;
+
+                    s.applied[0] = durRA > 0 ? guide[0] : 0.0;
+                    s.applied[1] = durDec > 0 ? guide[1] : 0.0;
+                    s.exposure = exposure;
+
+                    section.push_back(s);
+                }
+            }
+
+            // a dither or lock position change between two rows starts a new section
+            GuideLogReader::Field info = log.LinesAfter(row);
+            if (!info.empty() && (Contains(info, "INFO: DITHER") || Contains(info, "INFO: SET LOCK POSITION")))
+                endSection();
+        }
+
+        endSection();
+    }
+
+    return true;
+}
+
+// Expand "first..last/step" or "a|b|c" into the list of values
+static bool ParseValues(const wxString& spec, std::vector<double> *vals)
+{
+    int dots = spec.Find("..");
+    if (dots != wxNOT_FOUND)
+    {
+        wxString first = spec.Left(dots);
+        wxString rest = spec.Mid(dots + 2);
+        wxString last = rest.BeforeFirst('/');
+        wxString step = rest.AfterFirst('/');
+
+        double a, b, d;
+        if (!ParseDouble(first, &a) || !ParseDouble(last, &b) || !ParseDouble(step, &d) || d <= 0.0 || b < a)
+            return false;
+
+        // tolerate rounding in the step so the last value is included
+        for (int i = 0; a + i * d <= b + d * 1e-6; i++)
+            vals->push_back(a + i * d);
+        return true;
+    }
+
+    wxStringTokenizer tok(spec, "|");
+    while (tok.HasMoreTokens())
+    {
+        double v;
+        if (!ParseDouble(tok.GetNextToken(), &v))
+            return false;
+        vals->push_back(v);
+    }
+
+    return !vals->empty();
+}
+
+static bool ParseGrid(const wxString& grid, std::vector<Candidate> *candidates, wxString *error)
+{
+    wxStringTokenizer algos(grid, ";");
+    while (algos.HasMoreTokens())
+    {
+        wxString entry = algos.GetNextToken().Trim(true).Trim(false);
+        if (entry.IsEmpty())
+            continue;
+
+        wxString name = entry.BeforeFirst(':').Trim(true).Trim(false).Lower();
+        const AlgoName *algo = std::find_if(std::begin(s_algoNames), std::end(s_algoNames),
+                                            [&name](const AlgoName& a) { return name == a.name; });
+        if (algo == std::end(s_algoNames))
+        {
+            *error = "unknown guide algorithm " + name;
+            return false;
+        }
+
+        // cartesian product of the parameter values
+        std::vector<Candidate> expanded(1);
+        expanded[0].algo = algo->algo;
+        expanded[0].current = false;
+
+        wxStringTokenizer params(entry.AfterFirst(':'), ",");
+        while (params.HasMoreTokens())
+        {
+            wxString param = params.GetNextToken();
+            wxString pname = param.BeforeFirst('=').Trim(true).Trim(false);
+            std::vector<double> vals;
+            if (pname.IsEmpty() || !ParseValues(param.AfterFirst('='), &vals))
+            {
+                *error = "invalid parameter values " + param;
+                return false;
+            }
+
+            std::vector<Candidate> next;
+            next.reserve(expanded.size() * vals.size());
+            for (const Candidate& c : expanded)
+            {
+                for (double v : vals)
+                {
+                    next.push_back(c);
+                    next.back().params.push_back(Param { pname, v });
+                }
+            }
+            expanded.swap(next);
+        }
+
+        candidates->insert(candidates->end(), expanded.begin(), expanded.end());
+    }
+
+    return true;
+}
+
+static wxString ParamSummary(const std::vector<Param>& params)
+{
+    wxString s;
+    for (const Param& p : params)
+    {
+        if (!s.IsEmpty())
+            s += " ";
+        s += wxString::Format("%s=%g", p.name, p.val);
+    }
+    return s;
+}
+
+// Run the recorded sections through the algorithm. The star position is the previous position
+// plus the mount's own motion between the frames, less the candidate's correction. The mount's own
+// motion is recovered from the log as the change in offset plus the correction that was applied.
+static double Simulate(GuideAlgorithm *algo, GuideAxis axis, const std::vector<LogSection>& sections)
+{
+    double sum = 0.0;
+    unsigned int count = 0;
+
+    for (const LogSection& section : sections)
+    {
+        const LogSample& first = section[0];
+        algo->SetReplayFrame(first.time, first.exposure, (int) ((section[1].time - first.time) * 1000.0), first.snr);
+        algo->reset();
+
+        double offset = first.raw[axis];
+
+        for (size_t i = 0; i + 1 < section.size(); i++)
+        {
+            const LogSample& cur = section[i];
+            const LogSample& next = section[i + 1];
+
+            sum += offset * offset;
+            ++count;
+
+            algo->SetReplayFrame(cur.time, cur.exposure, (int) ((next.time - cur.time) * 1000.0), cur.snr);
+            double correction = algo->result(offset);
+
+            double drift = next.raw[axis] - cur.raw[axis] + cur.applied[axis];
+            offset += drift - correction;
+        }
+    }
+
+    return count ? sqrt(sum / count) : 0.0;
+}
+
+static double RecordedRms(GuideAxis axis, const std::vector<LogSection>& sections)
+{
+    double sum = 0.0;
+    unsigned int count = 0;
+
+    for (const LogSection& section : sections)
+    {
+        for (size_t i = 0; i + 1 < section.size(); i++)
+        {
+            sum += section[i].raw[axis] * section[i].raw[axis];
+            ++count;
+        }
+    }
+
+    return count ? sqrt(sum / count) : 0.0;
+}
+
+// Create the algorithm for the candidate. Parameters that are not part of the grid keep the
+// profile's values for that algorithm.
+static GuideAlgorithm *CreateAlgorithm(const Candidate& candidate, GuideAxis axis, Mount *profileMount, Mount *tuningMount)
+{
+    GuideAlgorithm *ref;
+    if (Mount::CreateGuideAlgorithm(candidate.algo, profileMount, axis, &ref))
+        return nullptr;
+    std::unique_ptr<GuideAlgorithm> refHolder(ref);
+
+    GuideAlgorithm *algo;
+    if (Mount::CreateGuideAlgorithm(candidate.algo, tuningMount, axis, &algo))
+        return nullptr;
+
+    wxArrayString names;
+    ref->GetParamNames(names);
+    for (const wxString& name : names)
+    {
+        double val;
+        if (ref->GetParam(name, &val))
+            algo->SetParam(name, val);
+    }
+
+    for (const Param& p : candidate.params)
+    {
+        if (!algo->SetParam(p.name, p.val))
+        {
+            delete algo;
+            return nullptr;
+        }
+    }
+
+    return algo;
+}
+
+int GuideAlgorithmEvaluator::Run(const Options& options)
+{
+    Debug.Write(wxString::Format("Tune: log %s grid %s\n", options.logPath, options.grid));
+
+    std::vector<LogSection> sections;
+    unsigned int aoSections = 0;
+
+    wxStopWatch loadTimer;
+    if (!LoadSections(options.logPath, &sections, &aoSections))
+    {
+        wxPrintf("tune: cannot read guide log %s\n", options.logPath);
+        return 1;
+    }
+    if (sections.empty())
+    {
+        wxPrintf("tune: no usable guiding sections in %s\n", options.logPath);
+        return 1;
+    }
+    long loadMs = loadTimer.Time();
+
+    unsigned int frames = 0;
+    for (const LogSection& section : sections)
+        frames += section.size();
+
+    std::vector<Candidate> candidates;
+    wxString error;
+    if (!ParseGrid(options.grid.IsEmpty() ? wxString(DefaultGrid) : options.grid, &candidates, &error))
+    {
+        wxPrintf("tune: %s\n", error);
+        return 1;
+    }
+
+    wxString reportPath = options.reportPath;
+    if (reportPath.IsEmpty())
+        reportPath = wxFileName(Debug.GetLogDir(), wxDateTime::Now().Format("PHD2_Tuning_%Y-%m-%d_%H%M%S.csv")).GetFullPath();
+
+    wxFFile report(reportPath, "w");
+    if (!report.IsOpened())
+    {
+        wxPrintf("tune: cannot create report file %s\n", reportPath);
+        return 1;
+    }
+
+    int exitStatus = 0;
+
+    {
+        ProfileMount profileMount;
+        TuningMount tuningMount;
+
+        // the profile's current settings on each axis are the baseline
+        Candidate current[2];
+        GuideAlgorithm *profileAlgo[2] = { profileMount.GetXGuideAlgorithm(), profileMount.GetYGuideAlgorithm() };
+        for (int axis = 0; axis < 2; axis++)
+        {
+            current[axis].algo = profileAlgo[axis]->Algorithm();
+            current[axis].current = true;
+
+            wxArrayString names;
+            profileAlgo[axis]->GetParamNames(names);
+            for (const wxString& name : names)
+            {
+                double val;
+                if (profileAlgo[axis]->GetParam(name, &val))
+                    current[axis].params.push_back(Param { name, val });
+            }
+        }
+
+        // algorithms are created on the main thread since they read and write the profile; only the
+        // simulation runs on the thread pool
+        std::vector<std::unique_ptr<GuideAlgorithm>> algos;
+        std::vector<Result> results;
+
+        for (int axis = 0; axis < 2; axis++)
+        {
+            std::vector<const Candidate *> list;
+            list.push_back(&current[axis]);
+            for (const Candidate& c : candidates)
+                list.push_back(&c);
+
+            for (const Candidate *c : list)
+            {
+                GuideAlgorithm *algo = CreateAlgorithm(*c, (GuideAxis) axis, &profileMount, &tuningMount);
+                if (!algo)
+                {
+                    Debug.Write(wxString::Format("Tune: skipping %s %s\n", AlgorithmName(c->algo), ParamSummary(c->params)));
+                    continue;
+                }
+                algos.emplace_back(algo);
+                results.push_back(Result { c, (GuideAxis) axis, 0.0 });
+            }
+        }
+
+        // the per-step debug log output of the algorithms would dwarf the evaluation itself
+        bool debugEnabled = Debug.Enable(false);
+
+        wxStopWatch runTimer;
+        ThreadPool::ParallelFor(results.size(), [&](unsigned int i) {
+            results[i].rms = Simulate(algos[i].get(), results[i].axis, sections);
+        });
+        long runMs = runTimer.Time();
+
+        Debug.Enable(debugEnabled);
+
+        algos.clear();
+        pConfig->Profile.DeleteGroup("/" + tuningMount.GetMountClassName());
+
+        std::stable_sort(results.begin(), results.end(), [](const Result& a, const Result& b) {
+            return a.axis != b.axis ? a.axis < b.axis : a.rms < b.rms;
+        });
+
+        double recorded[2] = { RecordedRms(GUIDE_X, sections), RecordedRms(GUIDE_Y, sections) };
+
+        report.Write("Axis,Rank,Algorithm,Params,Current,RMS,RecordedRMS\n");
+        int rank = 0;
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result& r = results[i];
+            if (i == 0 || r.axis != results[i - 1].axis)
+                rank = 0;
+            ++rank;
+            report.Write(wxString::Format("%s,%d,%s,\"%s\",%d,%.4f,%.4f\n", r.axis == GUIDE_X ? "RA" : "Dec", rank,
+                                          AlgorithmName(r.candidate->algo), ParamSummary(r.candidate->params),
+                                          r.candidate->current, r.rms, recorded[r.axis]));
+        }
+
+        wxString summary = wxString::Format("tune: %u guiding sections, %u frames, loaded in %.2f s\n",
+                                            (unsigned int) sections.size(), frames, loadMs / 1000.0);
+        if (aoSections)
+            summary += wxString::Format("tune: skipped %u sections guided with an AO\n", aoSections);
+        summary += wxString::Format("tune: %u evaluations in %.2f s on %u threads\n", (unsigned int) results.size(),
+                                    runMs / 1000.0, ThreadPool::Concurrency());
+
+        for (int axis = 0; axis < 2; axis++)
+        {
+            summary += wxString::Format("tune: %s recorded RMS %.3f px\n", axis == GUIDE_X ? "RA" : "Dec", recorded[axis]);
+            int shown = 0;
+            for (const Result& r : results)
+            {
+                if (r.axis != axis)
+                    continue;
+                if (shown < TopResults || r.candidate->current)
+                {
+                    summary += wxString::Format("tune:   %.3f px  %s %s%s\n", r.rms, AlgorithmName(r.candidate->algo),
+                                                ParamSummary(r.candidate->params),
+                                                r.candidate->current ? "  (current)" : "");
+                }
+                ++shown;
+            }
+        }
+
+        summary += "tune: report written to " + reportPath + "\n";
+
+        wxPrintf("%s", summary);
+        Debug.Write(summary);
+
+        if (results.empty())
+            exitStatus = 1;
+    }
+
+    return exitStatus;
+}
@@ -0,0 +1,66 @@
+/*
+ *  guide_algorithm_eval.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef GUIDE_ALGORITHM_EVAL_INCLUDED
+#define GUIDE_ALGORITHM_EVAL_INCLUDED
+
+// Offline evaluation of guide algorithm settings against a recorded guide log
+// (phd2 --tune <PHD2_GuideLog_*.txt>).
+//
+// For every guiding section in the log the uncorrected mount error is reconstructed from the
+// recorded offsets and the corrections that were applied. That error is then fed through each
+// candidate algorithm with a simple mount model (the star moves by the uncorrected error minus the
+// candidate's correction), and the predicted RMS is reported. The candidates are a grid of
+// parameter values per algorithm, evaluated in parallel on the shared thread pool.
+class GuideAlgorithmEvaluator
+{
+public:
+    struct Options
+    {
+        wxString logPath;    // PHD2 guide log
+        wxString grid;       // parameter grid, empty for the built-in grids
+        wxString reportPath; // CSV report, defaults to a file in the log directory
+    };
+
+    // Grid syntax: algorithms separated by ';', each one "name:param=values,param=values".
+    // Values are a single number, a list "a|b|c", or a range "first..last/step". For example
+    //     hysteresis:aggression=0.5..1.0/0.1,minMove=0.1|0.2;gp:predictiveWeight=0.3..0.9/0.2
+    // Algorithm names: identity, hysteresis, lowpass, lowpass2, resistswitch, zfilter, gp.
+    // The parameter names are those of get_algo_param.
+
+    // run the evaluation, returns the process exit status
+    static int Run(const Options& options);
+};
+
+#endif // GUIDE_ALGORITHM_EVAL_INCLUDED
@@ -437,7 +437,8 @@ public:
 };
 
 GuideAlgorithmGaussianProcess::GuideAlgorithmGaussianProcess(Mount *pMount, GuideAxis axis)
-    : GuideAlgorithm(pMount, axis), GPG(0), dark_tracking_mode_(false)
+    : GuideAlgorithm(pMount, axis), GPG(0), dark_tracking_mode_(false), replay_time_(0.0), replay_exposure_(0),
+      replay_latency_(0), replay_snr_(0.0)
 {
     // create guide parameters, load default values at first
     GaussianProcessGuider::guide_parameters parameters;
@@ -963,26 +964,51 @@ double GuideAlgorithmGaussianProcess::result(double input)
         return deduceResult();
     }
 
-    // the third parameter of result() is a floating-point in seconds, while RequestedExposureDuration() returns milliseconds
-    const Star& star = pFrame->pGuider->PrimaryStar();
-    double control_signal = GPG->result(input, star.SNR, (double) pFrame->RequestedExposureDuration() / 1000.0);
+    // the third parameter of result() is the prediction horizon as a floating-point in seconds, while
+    // CorrectionLatency() returns milliseconds. The latency is the exposure duration, or two exposures
+    // when capture is pipelined since the correction only shows up in the frame after next.
+    int latency = replay_latency_ ? replay_latency_ : pFrame->CorrectionLatency();
+    int exposure = replay_latency_ ? replay_exposure_ : pFrame->RequestedExposureDuration();
+    double snr = replay_latency_ ? replay_snr_ : pFrame->pGuider->PrimaryStar().SNR;
+    double control_signal = GPG->result(input, snr, (double) latency / 1000.0);
 
-    Debug.Write(wxString::Format("PPEC: input: %.2f, control: %.2f, exposure: %d\n", input, control_signal,
-                                 pFrame->RequestedExposureDuration()));
+    Debug.Write(wxString::Format("PPEC: input: %.2f, control: %.2f, exposure: %d, latency: %d\n", input, control_signal,
+                                 exposure, latency));
 
     return control_signal;
 }
 
 double GuideAlgorithmGaussianProcess::deduceResult()
 {
-    double control_signal = GPG->deduceResult((double) pFrame->RequestedExposureDuration() / 1000.0);
+    int latency = replay_latency_ ? replay_latency_ : pFrame->CorrectionLatency();
+    int exposure = replay_latency_ ? replay_exposure_ : pFrame->RequestedExposureDuration();
+    double control_signal = GPG->deduceResult((double) latency / 1000.0);
 
-    Debug.Write(
-        wxString::Format("PPEC (deduced): control: %.2f, exposure: %d\n", control_signal, pFrame->RequestedExposureDuration()));
+    Debug.Write(wxString::Format("PPEC (deduced): control: %.2f, exposure: %d, latency: %d\n", control_signal, exposure,
+                                 latency));
 
     return control_signal;
 }
 
+void GuideAlgorithmGaussianProcess::SetReplayFrame(double time, int exposureMs, int latencyMs, double snr)
+{
+    if (!replay_latency_)
+    {
+        // from now on the GP timestamps come from the recorded frame times
+        GPG->SetClock([this]() {
+            return GaussianProcessGuider::clock::time_point(std::chrono::duration_cast<GaussianProcessGuider::clock::duration>(
+                std::chrono::duration<double>(replay_time_)));
+        });
+        replay_time_ = time;
+        GPG->reset();
+    }
+
+    replay_time_ = time;
+    replay_exposure_ = exposureMs;
+    replay_latency_ = wxMax(latencyMs, 1);
+    replay_snr_ = snr;
+}
+
 void GuideAlgorithmGaussianProcess::reset()
 {
     Debug.Write("PPEC: reset GP model\n");
@@ -124,6 +124,12 @@ private:
     PierSide guiding_pier_side_;
     std::chrono::steady_clock::time_point guiding_stopped_time_; // time guiding stopped
 
+    // recorded frame being replayed by an offline evaluation, replay_latency_ == 0 when guiding live
+    double replay_time_;
+    int replay_exposure_;
+    int replay_latency_;
+    double replay_snr_;
+
 protected:
     double GetControlGain() const;
     bool SetControlGain(double control_gain);
@@ -175,6 +181,12 @@ public:
      */
     double deduceResult() override;
 
+    /**
+     * Replaces the wall clock, the exposure duration and the star SNR with the
+     * values of a recorded frame, for offline evaluation.
+     */
+    void SetReplayFrame(double time, int exposureMs, int latencyMs, double snr) override;
+
     /**
      * This method tells the guider that guiding has started.
      */
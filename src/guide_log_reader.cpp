@@ -0,0 +1,449 @@
+/*
+ *  guide_log_reader.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include "phd.h"
+#include "guide_log_reader.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __WINDOWS__
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define HAVE_SSE2_SCAN
+#endif
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+static const char GUIDING_BEGINS[] = "Guiding Begins at ";
+static const char GUIDING_ENDS[] = "Guiding Ends at ";
+static const char CALIBRATION_BEGINS[] = "Calibration Begins at ";
+static const char CALIBRATION_ENDS[] = "Calibration complete";
+static const char GA_COMPLETE[] = "INFO: GA Result - Dec Drift Rate=";
+static const char GUIDING_COLUMNS[] = "Frame,";
+static const char CALIBRATION_COLUMNS[] = "Direction,";
+
+#ifdef HAVE_SSE2_SCAN
+inline static unsigned int FirstSetBit(unsigned int mask)
+{
+# ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return idx;
+# else
+    return __builtin_ctz(mask);
+# endif
+}
+#endif
+
+// Returns the position of the next '\n' at or after p, or end. Lines in a guide log are around a
+// hundred bytes, so the 16-byte compare finds most newlines in a handful of iterations.
+static const char *FindNewline(const char *p, const char *end)
+{
+#ifdef HAVE_SSE2_SCAN
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+        if (mask)
+            return p + FirstSetBit(mask);
+        p += 16;
+    }
+#endif
+    const char *nl = static_cast<const char *>(memchr(p, '\n', end - p));
+    return nl ? nl : end;
+}
+
+template<size_t N>
+inline static bool StartsWith(const char *p, size_t len, const char (&pfx)[N])
+{
+    return len >= N - 1 && memcmp(p, pfx, N - 1) == 0;
+}
+
+static wxDateTime ParseTime(const char *p, size_t len)
+{
+    wxDateTime t;
+    t.ParseISOCombined(wxString(p, len), ' ');
+    return t;
+}
+
+// calibration rows are "Direction,Step,..." with a single-word direction and a numeric step, which
+// tells them apart from the free-form messages logged during calibration
+static bool IsCalibrationRow(const char *p, size_t len)
+{
+    const char *comma = static_cast<const char *>(memchr(p, ',', len));
+    if (!comma || comma == p || comma + 1 >= p + len)
+        return false;
+    if (memchr(p, ' ', comma - p))
+        return false;
+    return isdigit((unsigned char) comma[1]) != 0;
+}
+
+bool GuideLogReader::Field::ToDouble(double *val) const
+{
+    // strtod needs a terminated string; numeric fields in the log are short
+    char buf[64];
+    if (len == 0 || len >= sizeof(buf))
+        return false;
+    memcpy(buf, ptr, len);
+    buf[len] = 0;
+    char *end;
+    *val = strtod(buf, &end);
+    return end != buf;
+}
+
+bool GuideLogReader::Field::ToLong(long *val) const
+{
+    char buf[32];
+    if (len == 0 || len >= sizeof(buf))
+        return false;
+    memcpy(buf, ptr, len);
+    buf[len] = 0;
+    char *end;
+    *val = strtol(buf, &end, 10);
+    return end != buf;
+}
+
+bool GuideLogReader::Field::operator==(const char *s) const
+{
+    return strlen(s) == len && memcmp(ptr, s, len) == 0;
+}
+
+GuideLogReader::GuideLogReader()
+    : m_data(nullptr), m_size(0), m_open(false),
+#ifdef __WINDOWS__
+      m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr),
+#endif
+      m_calCount(0), m_guideCount(0), m_guideDuration(0.0), m_gaCount(0)
+{
+}
+
+GuideLogReader::~GuideLogReader()
+{
+    Close();
+}
+
+bool GuideLogReader::Open(const wxString& path)
+{
+    Close();
+
+#ifdef __WINDOWS__
+    m_file = ::CreateFileW(path.wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                           OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return true;
+
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(m_file, &size))
+    {
+        Close();
+        return true;
+    }
+    m_size = (size_t) size.QuadPart;
+
+    if (m_size)
+    {
+        m_mapping = ::CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping)
+            m_data = static_cast<const char *>(::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data)
+        {
+            Close();
+            return true;
+        }
+    }
+#else
+    int fd = ::open(path.fn_str(), O_RDONLY);
+    if (fd < 0)
+        return true;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return true;
+    }
+    m_size = (size_t) st.st_size;
+
+    if (m_size)
+    {
+        void *p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close(fd);
+            m_size = 0;
+            return true;
+        }
+        ::madvise(p, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char *>(p);
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+#endif
+
+    m_open = true;
+
+    Index();
+
+#ifndef __WINDOWS__
+    if (m_data)
+        ::madvise(const_cast<char *>(m_data), m_size, MADV_RANDOM);
+#endif
+
+    return false;
+}
+
+void GuideLogReader::Close()
+{
+#ifdef __WINDOWS__
+    if (m_data)
+        ::UnmapViewOfFile(m_data);
+    if (m_mapping)
+        ::CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        ::CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_data)
+        ::munmap(const_cast<char *>(m_data), m_size);
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+
+    m_rows.clear();
+    m_sections.clear();
+    m_calCount = 0;
+    m_guideCount = 0;
+    m_guideDuration = 0.0;
+    m_gaCount = 0;
+}
+
+void GuideLogReader::Index()
+{
+    const char *end = m_data + m_size;
+    Section *cur = nullptr;
+
+    auto closeSection = [this, &cur]() {
+        if (!cur)
+            return;
+        cur->endRow = m_rows.size();
+        if (cur->endRow > cur->firstRow)
+        {
+            // the frame or step number is the second field of a calibration row
+            unsigned int col = cur->type == SECTION_GUIDING ? 0 : 1;
+            long n;
+            if (GetField(cur->firstRow, col).ToLong(&n))
+                cur->firstFrame = (unsigned int) n;
+            if (GetField(cur->endRow - 1, col).ToLong(&n))
+                cur->lastFrame = (unsigned int) n;
+        }
+        cur = nullptr;
+    };
+
+    auto openSection = [this, &cur, &closeSection](SectionType type, size_t offset, const wxDateTime& start) {
+        closeSection();
+        Section s;
+        s.type = type;
+        s.start = start;
+        s.offset = offset;
+        s.columns = std::string::npos;
+        s.firstRow = s.endRow = m_rows.size();
+        s.firstFrame = s.lastFrame = 0;
+        m_sections.push_back(s);
+        cur = &m_sections.back();
+    };
+
+    for (const char *p = m_data; p < end;)
+    {
+        const char *nl = FindNewline(p, end);
+        size_t len = nl - p;
+        if (len && p[len - 1] == '\r')
+            --len;
+        size_t offset = p - m_data;
+
+        if (len == 0)
+        {
+            p = nl + 1;
+            continue;
+        }
+
+        if (cur && cur->columns != std::string::npos &&
+                 (cur->type == SECTION_GUIDING ? isdigit((unsigned char) *p) != 0 : IsCalibrationRow(p, len)))
+        {
+            m_rows.push_back(offset);
+        }
+        else if (StartsWith(p, len, GUIDING_BEGINS))
+        {
+            openSection(SECTION_GUIDING, offset,
+                        ParseTime(p + sizeof(GUIDING_BEGINS) - 1, len - (sizeof(GUIDING_BEGINS) - 1)));
+        }
+        else if (StartsWith(p, len, CALIBRATION_BEGINS))
+        {
+            openSection(SECTION_CALIBRATION, offset,
+                        ParseTime(p + sizeof(CALIBRATION_BEGINS) - 1, len - (sizeof(CALIBRATION_BEGINS) - 1)));
+        }
+        else if (StartsWith(p, len, GUIDING_ENDS))
+        {
+            if (cur && cur->type == SECTION_GUIDING)
+            {
+                cur->end = ParseTime(p + sizeof(GUIDING_ENDS) - 1, len - (sizeof(GUIDING_ENDS) - 1));
+                if (cur->start.IsValid() && cur->end.IsValid() && cur->end.IsLaterThan(cur->start))
+                {
+                    ++m_guideCount;
+                    m_guideDuration += (cur->end - cur->start).GetSeconds().GetValue();
+                }
+            }
+            closeSection();
+        }
+        else if (StartsWith(p, len, CALIBRATION_ENDS))
+        {
+            ++m_calCount;
+            closeSection();
+        }
+        else if (StartsWith(p, len, GA_COMPLETE))
+        {
+            ++m_gaCount;
+        }
+        else if (cur && cur->columns == std::string::npos &&
+                 (cur->type == SECTION_GUIDING ? StartsWith(p, len, GUIDING_COLUMNS)
+                                               : StartsWith(p, len, CALIBRATION_COLUMNS)))
+        {
+            cur->columns = offset;
+        }
+
+        p = nl + 1;
+    }
+
+    closeSection();
+}
+
+void GuideLogReader::GetSummary(GuideLogSummaryInfo *info) const
+{
+    info->Clear();
+    info->cal_cnt = m_calCount;
+    info->guide_cnt = m_guideCount;
+    info->guide_dur = m_guideDuration;
+    info->ga_cnt = m_gaCount;
+    info->valid = m_open;
+}
+
+GuideLogReader::Field GuideLogReader::LineAt(size_t offset) const
+{
+    const char *p = m_data + offset;
+    const char *nl = FindNewline(p, m_data + m_size);
+    size_t len = nl - p;
+    if (len && p[len - 1] == '\r')
+        --len;
+    return Field { p, len };
+}
+
+GuideLogReader::Field GuideLogReader::Row(size_t row) const
+{
+    return LineAt(m_rows[row]);
+}
+
+GuideLogReader::Field GuideLogReader::LinesAfter(size_t row) const
+{
+    const char *end = m_data + (row + 1 < m_rows.size() ? m_rows[row + 1] : m_size);
+    const char *p = FindNewline(m_data + m_rows[row], end);
+    if (p < end)
+        ++p;
+    return Field { p, (size_t) (end - p) };
+}
+
+GuideLogReader::Field GuideLogReader::GetField(size_t row, unsigned int col) const
+{
+    Field line = Row(row);
+    const char *p = line.ptr;
+    const char *end = line.ptr + line.len;
+
+    for (; col > 0; --col)
+    {
+        const char *comma = static_cast<const char *>(memchr(p, ',', end - p));
+        if (!comma)
+            return Field { end, 0 };
+        p = comma + 1;
+    }
+
+    const char *comma = static_cast<const char *>(memchr(p, ',', end - p));
+    return Field { p, (size_t) ((comma ? comma : end) - p) };
+}
+
+int GuideLogReader::FindColumn(const Section& section, const char *name) const
+{
+    if (section.columns == std::string::npos)
+        return -1;
+
+    Field line = LineAt(section.columns);
+    const char *p = line.ptr;
+    const char *end = line.ptr + line.len;
+
+    for (int col = 0; p <= end; col++)
+    {
+        const char *comma = static_cast<const char *>(memchr(p, ',', end - p));
+        const char *fe = comma ? comma : end;
+        if (Field { p, (size_t) (fe - p) } == name)
+            return col;
+        if (!comma)
+            break;
+        p = comma + 1;
+    }
+
+    return -1;
+}
+
+GuideLogReader::Field GuideLogReader::SectionHeader(const Section& section) const
+{
+    size_t begin = section.offset;
+    size_t end = section.columns != std::string::npos ? section.columns
+        : section.endRow > section.firstRow           ? m_rows[section.firstRow]
+                                                      : begin;
+    return Field { m_data + begin, end - begin };
+}
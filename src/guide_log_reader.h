@@ -0,0 +1,136 @@
+/*
+ *  guide_log_reader.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef GUIDE_LOG_READER_INCLUDED
+#define GUIDE_LOG_READER_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct GuideLogSummaryInfo;
+
+// Read-only access to a PHD2 guide log for analysis.
+//
+// The file is memory-mapped and indexed in a single pass when it is opened: the calibration and
+// guiding sections with their start and end times, and the offset of every data row. Nothing else
+// is parsed up front; fields are located within a row only when they are asked for, and are
+// returned as pointers into the mapping, so opening even a multi-night log costs one scan of the
+// file and a few bytes per row.
+class GuideLogReader
+{
+public:
+    enum SectionType
+    {
+        SECTION_CALIBRATION,
+        SECTION_GUIDING,
+    };
+
+    struct Section
+    {
+        SectionType type;
+        wxDateTime start;
+        wxDateTime end;          // invalid if the section was not closed, e.g. after a crash
+        size_t offset;           // byte offset of the "Calibration Begins" or "Guiding Begins" line
+        size_t columns;          // byte offset of the column header line, npos if there is none
+        size_t firstRow;         // index of the first data row
+        size_t endRow;           // one past the last data row
+        unsigned int firstFrame; // first and last frame (guiding) or step (calibration) number
+        unsigned int lastFrame;
+    };
+
+    // a span of the mapped file, not NUL terminated
+    struct Field
+    {
+        const char *ptr;
+        size_t len;
+
+        bool empty() const { return len == 0; }
+        std::string str() const { return std::string(ptr, len); }
+        bool ToDouble(double *val) const;
+        bool ToLong(long *val) const;
+        bool operator==(const char *s) const;
+    };
+
+    GuideLogReader();
+    ~GuideLogReader();
+
+    // map and index the file, returns true on error
+    bool Open(const wxString& path);
+    void Close();
+    bool IsOpen() const { return m_open; }
+
+    size_t FileSize() const { return m_size; }
+
+    const std::vector<Section>& Sections() const { return m_sections; }
+
+    // the same counts the guide log records in its closing "Log Summary" line
+    void GetSummary(GuideLogSummaryInfo *info) const;
+
+    size_t RowCount() const { return m_rows.size(); }
+    // the whole text of a data row, without the line terminator
+    Field Row(size_t row) const;
+    // field `col` (0-based) of a data row, empty if the row has fewer columns
+    Field GetField(size_t row, unsigned int col) const;
+    bool GetDouble(size_t row, unsigned int col, double *val) const { return GetField(row, col).ToDouble(val); }
+    // the lines logged after a data row and before the next one (INFO messages, settings changes),
+    // empty if the rows are adjacent
+    Field LinesAfter(size_t row) const;
+
+    // column number of `name` in the section's column header, -1 if not present
+    int FindColumn(const Section& section, const char *name) const;
+    // the settings lines logged between the section start and its column header
+    Field SectionHeader(const Section& section) const;
+
+private:
+    void Index();
+    Field LineAt(size_t offset) const;
+
+    const char *m_data;
+    size_t m_size;
+    bool m_open;
+#ifdef __WINDOWS__
+    void *m_file;
+    void *m_mapping;
+#endif
+    std::vector<uint64_t> m_rows; // byte offset of each data row
+    std::vector<Section> m_sections;
+    unsigned int m_calCount;
+    unsigned int m_guideCount;
+    double m_guideDuration;
+    unsigned int m_gaCount;
+};
+
+#endif // GUIDE_LOG_READER_INCLUDED
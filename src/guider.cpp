@@ -37,6 +37,7 @@
 #include "polardrift_tool.h"
 #include "staticpa_tool.h"
 #include "guiding_assistant.h"
+#include "latency_trace.h"
 
 // un-comment to log star deflections to a file
 // #define CAPTURE_DEFLECTIONS
@@ -208,6 +209,8 @@ Guider::Guider(wxWindow *parent, int xSize, int ySize)
 
 Guider::~Guider()
 {
+    StarPremeasure::ClearPlan();
+
     delete m_displayedImage;
     delete m_pCurrentImage;
 
@@ -1233,6 +1236,11 @@ void Guider::DisplayImage(usImage *img)
     UpdateImageDisplay();
 }
 
+bool Guider::MeasureFrame(const usImage *pImage, GuiderOffset *ofs, FrameDroppedInfo *errorInfo)
+{
+    return UpdateCurrentPosition(pImage, ofs, errorInfo);
+}
+
 inline static bool IsLoopingState(GUIDER_STATE state)
 {
     // returns true for looping, but non-guiding states
@@ -1306,7 +1314,13 @@ void Guider::UpdateGuideState(usImage *pImage, bool bStopping)
         GuiderOffset ofs;
         FrameDroppedInfo info;
 
-        if (UpdateCurrentPosition(pImage, &ofs, &info)) // true means error
+        bool starError;
+        {
+            TraceSpan span(TRACE_STAR_UPDATE);
+            starError = UpdateCurrentPosition(pImage, &ofs, &info);
+        }
+
+        if (starError) // true means error
         {
             info.frameNumber = pImage->FrameNum;
             info.time = pFrame->TimeSinceGuidingStarted();
@@ -1543,13 +1557,34 @@ void Guider::UpdateGuideState(usImage *pImage, bool bStopping)
         m_measurementMode = false;
     }
 
+    PlanNextMeasurement();
+
     pFrame->UpdateButtonsStatus();
 
-    UpdateImageDisplay(pImage);
+    {
+        TraceSpan span(TRACE_DISPLAY);
+        UpdateImageDisplay(pImage);
+    }
 
     Debug.AddLine("UpdateGuideState exits: " + statusMessage);
 }
 
+void Guider::PlanNextMeasurement()
+{
+    StarPremeasure::ClearPlan();
+}
+
+StarPremeasure::Params Guider::StarFindParams() const
+{
+    StarPremeasure::Params params;
+    params.searchRegion = m_searchRegion;
+    params.mode = pFrame->GetStarFindMode();
+    params.minHFD = GetMinStarHFD();
+    params.maxHFD = GetMaxStarHFD();
+    params.saturation = pCamera ? pCamera->GetSaturationADU() : 0;
+    return params;
+}
+
 bool Guider::ShiftLockPosition()
 {
     m_lockPosition.UpdateShift();
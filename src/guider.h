@@ -113,6 +113,13 @@ class DefectMap;
  * It is also responsible for drawing and decorating the acquired
  * image in a way that makes sense for its type.
  *
+ * Thread safety: all Guider state is owned by the main thread. The
+ * worker threads never read or write it; the only guide-loop work
+ * done on the worker thread for the guider is star measurement, and
+ * that runs on a copy of the search positions the guider publishes
+ * through StarPremeasure (see PlanNextMeasurement). Results flow
+ * back the same way, so no Guider member needs a lock.
+ *
  */
 
 class GuiderConfigDialogCtrlSet : public ConfigDialogCtrlSet
@@ -208,6 +215,8 @@ protected:
 
     void ToggleBookmark(const wxRealPoint& pt);
 
+    StarPremeasure::Params StarFindParams() const;
+
 public:
     bool IsPaused() const;
     PauseType GetPauseType() const;
@@ -249,6 +258,9 @@ public:
     void StopGuiding();
     void UpdateGuideState(usImage *pImage, bool bStopping = false);
     void DisplayImage(usImage *img);
+    // Measure the guide star(s) on an image the way the guide loop does, without running the guider
+    // state machine, the mount or the display. Used by the headless frame replay; returns true on error.
+    bool MeasureFrame(const usImage *pImage, GuiderOffset *ofs, FrameDroppedInfo *errorInfo);
 
     bool SetScaleImage(bool newScaleValue);
     bool GetScaleImage() const;
@@ -298,6 +310,9 @@ public:
 
 private:
     virtual bool UpdateCurrentPosition(const usImage *pImage, GuiderOffset *ofs, FrameDroppedInfo *errorInfo) = 0;
+    // publish the stars the next UpdateCurrentPosition will measure so the worker thread can
+    // measure them as soon as the frame arrives; the default is to measure on the main thread
+    virtual void PlanNextMeasurement();
     virtual bool SetCurrentPosition(const usImage *pImage, const PHD_Point& position) = 0;
 
 public:
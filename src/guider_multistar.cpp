@@ -41,6 +41,7 @@
  */
 
 #include "phd.h"
+#include "windowed_median.h"
 
 #include <wx/dir.h>
 #include <algorithm>
@@ -56,33 +57,22 @@ class MassChecker
         DefaultTimeWindowMs = 22500
     };
 
-    struct Entry
-    {
-        wxLongLong_t time;
-        double mass;
-    };
-
-    std::deque<Entry> m_data;
+    WindowedMedian m_data;
     double m_highMass; // high-water mark
     double m_lowMass; // low-water mark
-    unsigned long m_timeWindow;
-    double *m_tmp;
-    size_t m_tmpSize;
     int m_exposure;
     bool m_isAutoExposure;
 
 public:
-    MassChecker() : m_highMass(0.), m_lowMass(9e99), m_tmp(0), m_tmpSize(0), m_exposure(0), m_isAutoExposure(false)
+    MassChecker() : m_highMass(0.), m_lowMass(9e99), m_exposure(0), m_isAutoExposure(false)
     {
         SetTimeWindow(DefaultTimeWindowMs);
     }
 
-    ~MassChecker() { delete[] m_tmp; }
-
     void SetTimeWindow(unsigned int milliseconds)
     {
         // an abrupt change in mass will affect the median after approx m_timeWindow/2
-        m_timeWindow = milliseconds * 2;
+        m_data.SetWindow((int64_t) milliseconds * 2);
     }
 
     void SetExposure(int exposure, bool isAutoExp)
@@ -108,38 +98,15 @@ public:
     void AppendData(double mass)
     {
         wxLongLong_t now = ::wxGetUTCTimeMillis().GetValue();
-        wxLongLong_t oldest = now - m_timeWindow;
-
-        while (m_data.size() > 0 && m_data.front().time < oldest)
-            m_data.pop_front();
-
-        Entry entry;
-        entry.time = now;
-        entry.mass = AdjustedMass(mass);
-        m_data.push_back(entry);
+        m_data.Add(now, AdjustedMass(mass));
     }
 
     bool CheckMass(double mass, double threshold, double limits[4])
     {
-        if (m_data.size() < 5)
+        if (m_data.Size() < 5)
             return false;
 
-        if (m_tmpSize < m_data.size())
-        {
-            delete[] m_tmp;
-            m_tmpSize = m_data.size() + 10;
-            m_tmp = new double[m_tmpSize];
-        }
-
-        std::deque<Entry>::const_iterator it = m_data.begin();
-        std::deque<Entry>::const_iterator end = m_data.end();
-        double *p = &m_tmp[0];
-        for (; it != end; ++it)
-            *p++ = it->mass;
-
-        size_t mid = m_data.size() / 2;
-        std::nth_element(&m_tmp[0], &m_tmp[mid], &m_tmp[m_data.size()]);
-        double med = m_tmp[mid];
+        double med = m_data.Median();
 
         if (med > m_highMass)
             m_highMass = med;
@@ -173,7 +140,7 @@ public:
 
     void Reset()
     {
-        m_data.clear();
+        m_data.Clear();
         m_highMass = 0.;
         m_lowMass = 9e99;
     }
@@ -761,18 +728,21 @@ bool GuiderMultiStar::RefineOffset(const usImage *pImage, GuiderOffset *pOffset)
                         {
                             m_lockPositionMoved = false;
                             Debug.Write("MultiStar: updating star positions after lock position change\n");
-                            for (auto pGS = m_guideStars.begin() + 1; pGS != m_guideStars.end();)
+                            std::vector<Star::FindJob> jobs;
+                            jobs.reserve(m_guideStars.size() - 1);
+                            for (auto pGS = m_guideStars.begin() + 1; pGS != m_guideStars.end(); ++pGS)
                             {
                                 PHD_Point expectedLoc = m_primaryStar + pGS->offsetFromPrimary;
-                                bool found;
-                                if (IsValidSecondaryStarPosition(expectedLoc))
-                                    found = pGS->Find(pImage, m_searchRegion, expectedLoc.X, expectedLoc.Y,
-                                                      pFrame->GetStarFindMode(), GetMinStarHFD(), GetMaxStarHFD(),
-                                                      pCamera->GetSaturationADU(), Star::FIND_LOGGING_VERBOSE);
-                                else
-                                    found = pGS->Find(pImage, m_searchRegion, pGS->X, pGS->Y, pFrame->GetStarFindMode(),
-                                                      GetMinStarHFD(), GetMaxStarHFD(), pCamera->GetSaturationADU(),
-                                                      Star::FIND_LOGGING_VERBOSE);
+                                if (!IsValidSecondaryStarPosition(expectedLoc))
+                                    expectedLoc = PHD_Point(pGS->X, pGS->Y);
+                                jobs.push_back({ &*pGS, (int) expectedLoc.X, (int) expectedLoc.Y, Star::FIND_LOGGING_VERBOSE,
+                                                 false });
+                            }
+                            StarPremeasure::FindStars(pImage, StarFindParams(), jobs);
+                            auto job = jobs.begin();
+                            for (auto pGS = m_guideStars.begin() + 1; pGS != m_guideStars.end(); ++job)
+                            {
+                                bool found = job->found;
                                 if (found)
                                 {
                                     pGS->referencePoint.X = pGS->X;
@@ -798,24 +768,29 @@ bool GuiderMultiStar::RefineOffset(const usImage *pImage, GuiderOffset *pOffset)
 
             if (!m_stabilizing && m_guideStars.size() > 1 && (sumX != 0 || sumY != 0))
             {
+                // Measure all the secondary stars in one batch. The results go into copies so that stars the
+                // loop below never reaches (once m_maxStars are in use) are left untouched, as before.
+                std::vector<Star> measured(m_guideStars.begin() + 1, m_guideStars.end());
+                std::vector<Star::FindJob> jobs(measured.size());
+                for (size_t i = 0; i < jobs.size(); i++)
+                {
+                    const GuideStar& gs = m_guideStars[i + 1];
+                    // Look for a lost star based on its original offset from the primary star, otherwise
+                    // look for it where we last found it
+                    PHD_Point searchLoc = gs.wasLost ? m_primaryStar + gs.offsetFromPrimary : PHD_Point(gs.X, gs.Y);
+                    jobs[i] = { &measured[i], (int) searchLoc.X, (int) searchLoc.Y, Star::FIND_LOGGING_MINIMAL, false };
+                }
+                StarPremeasure::FindStars(pImage, StarFindParams(), jobs);
+
                 wxString secondaryInfo = "MultiStar: ";
+                size_t jobIdx = 0;
                 for (auto pGS = m_guideStars.begin() + 1; pGS != m_guideStars.end();)
                 {
                     if (m_starsUsed >= m_maxStars || m_guideStars.size() == 1)
                         break;
-                    bool found = false;
-                    if (pGS->wasLost)
-                    {
-                        // Look for it based on its original offset from the primary star
-                        PHD_Point expectedLoc = m_primaryStar + pGS->offsetFromPrimary;
-                        found = pGS->Find(pImage, m_searchRegion, expectedLoc.X, expectedLoc.Y, pFrame->GetStarFindMode(),
-                                          GetMinStarHFD(), GetMaxStarHFD(), pCamera->GetSaturationADU(),
-                                          Star::FIND_LOGGING_MINIMAL);
-                    }
-                    else
-                        // Look for it where we last found it
-                        found = pGS->Find(pImage, m_searchRegion, pGS->X, pGS->Y, pFrame->GetStarFindMode(), GetMinStarHFD(),
-                                          GetMaxStarHFD(), pCamera->GetSaturationADU(), Star::FIND_LOGGING_MINIMAL);
+                    const Star::FindJob& job = jobs[jobIdx++];
+                    static_cast<Star&>(*pGS) = *job.star;
+                    bool found = job.found;
                     if (found)
                     {
                         double dX = pGS->X - pGS->referencePoint.X;
@@ -922,6 +897,36 @@ bool GuiderMultiStar::RefineOffset(const usImage *pImage, GuiderOffset *pOffset)
 
 static DistanceChecker s_distanceChecker;
 
+void GuiderMultiStar::PlanNextMeasurement()
+{
+    if (!m_primaryStar.IsValid() && m_primaryStar.X == 0.0 && m_primaryStar.Y == 0.0)
+    {
+        StarPremeasure::ClearPlan();
+        return;
+    }
+
+    // The primary star is searched for where it was last found. Secondary stars are only
+    // measured by RefineOffset while guiding; plan the ones that are not lost, since a lost star
+    // is searched for relative to the primary position that is not known until the frame arrives.
+    std::vector<Star> stars(1, m_primaryStar);
+    bool planSecondaries = IsGuiding() && m_multiStarMode && m_guideStars.size() > 1 && !m_stabilizing;
+    if (planSecondaries)
+    {
+        for (auto pGS = m_guideStars.begin() + 1; pGS != m_guideStars.end(); ++pGS)
+            if (!pGS->wasLost)
+                stars.push_back(*pGS);
+    }
+
+    std::vector<Star::FindJob> jobs(stars.size());
+    for (size_t i = 0; i < stars.size(); i++)
+    {
+        jobs[i] = { &stars[i], (int) stars[i].X, (int) stars[i].Y,
+                    i == 0 ? Star::FIND_LOGGING_VERBOSE : Star::FIND_LOGGING_MINIMAL, false };
+    }
+
+    StarPremeasure::SetPlan(StarFindParams(), jobs);
+}
+
 bool GuiderMultiStar::UpdateCurrentPosition(const usImage *pImage, GuiderOffset *ofs, FrameDroppedInfo *errorInfo)
 {
     if (!m_primaryStar.IsValid() && m_primaryStar.X == 0.0 && m_primaryStar.Y == 0.0)
@@ -942,8 +947,10 @@ bool GuiderMultiStar::UpdateCurrentPosition(const usImage *pImage, GuiderOffset
     {
         Star newStar(m_primaryStar);
 
-        if (!newStar.Find(pImage, m_searchRegion, pFrame->GetStarFindMode(), GetMinStarHFD(), GetMaxStarHFD(),
-                          pCamera->GetSaturationADU(), Star::FIND_LOGGING_VERBOSE))
+        std::vector<Star::FindJob> jobs(1, { &newStar, (int) newStar.X, (int) newStar.Y, Star::FIND_LOGGING_VERBOSE, false });
+        StarPremeasure::FindStars(pImage, StarFindParams(), jobs);
+
+        if (!jobs[0].found)
         {
             errorInfo->starError = newStar.GetError();
             errorInfo->starMass = 0.0;
@@ -1286,13 +1293,17 @@ void GuiderMultiStar::SaveStarFITS()
         start_x = pImage->Size.GetWidth() - 60;
     if ((start_y + 60) > pImage->Size.GetHeight())
         start_y = pImage->Size.GetHeight() - 60;
-    int x, y, width;
-    width = pImage->Size.GetWidth();
+    int x, y;
     unsigned short *usptr = tmpimg.ImageData;
     for (y = 0; y < 60; y++)
     {
         for (x = 0; x < 60; x++, usptr++)
-            *usptr = *(pImage->ImageData + (y + start_y) * width + (x + start_x));
+        {
+            // pixels outside a stored subframe are zero
+            int const px = x + start_x;
+            int const py = y + start_y;
+            *usptr = pImage->Storage.Contains(px, py) ? pImage->Pixel(px, py) : 0;
+        }
     }
 
     imgLogDirectory = Debug.GetLogDir() + PATHSEPSTR + "PHD2_Stars";
@@ -151,6 +151,7 @@ private:
     void InvalidateCurrentPosition(bool fullReset = false) override;
     bool UpdateCurrentPosition(const usImage *pImage, GuiderOffset *ofs, FrameDroppedInfo *errorInfo) override;
     bool SetCurrentPosition(const usImage *pImage, const PHD_Point& position) override;
+    void PlanNextMeasurement() override;
 
     void OnLClick(wxMouseEvent& evt);
 
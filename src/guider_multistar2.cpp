@@ -49,7 +49,6 @@
 #include "guider_multistar2.h"
 
 #include <algorithm>
-#include <deque>
 #include <utility>
 #include <vector>
 
@@ -274,6 +273,62 @@ void GuiderMultiStar2::EnsureStarStateSize()
         m_starState.resize(m_guideStars.size());
 }
 
+void GuiderMultiStar2::BuildFindJobs(const PHD_Point& refPrimary, std::vector<GuideStar>& measured,
+                                     std::vector<Star::FindJob>& jobs) const
+{
+    // Determine whether we can use secondaries (respect subframes behavior)
+    bool allowSecondaries = m_multiStarMode && m_guideStars.size() > 1 && !pCamera->UseSubframes;
+
+    size_t measureCount = allowSecondaries ? m_guideStars.size() : std::min(m_guideStars.size(), (size_t) 1);
+    measured.assign(m_guideStars.begin(), m_guideStars.begin() + measureCount);
+    jobs.resize(measureCount);
+    for (size_t i = 0; i < measureCount; i++)
+    {
+        const StarState& st = m_starState[i];
+        Star::FindJob& job = jobs[i];
+        job.star = &measured[i];
+        job.loggingControl = Star::FIND_LOGGING_MINIMAL;
+        job.found = false;
+
+        if (st.lastPosValid)
+        {
+            job.X = (int) st.lastPos.X;
+            job.Y = (int) st.lastPos.Y;
+        }
+        else if (i == 0)
+        {
+            job.X = (int) measured[i].X;
+            job.Y = (int) measured[i].Y;
+            job.loggingControl = Star::FIND_LOGGING_VERBOSE;
+        }
+        else
+        {
+            PHD_Point expected = refPrimary + m_guideStars[i].offsetFromPrimary;
+            job.X = (int) expected.X;
+            job.Y = (int) expected.Y;
+        }
+    }
+}
+
+void GuiderMultiStar2::PlanNextMeasurement()
+{
+    if ((!m_primaryStar.IsValid() && m_primaryStar.X == 0.0 && m_primaryStar.Y == 0.0) || !pCamera)
+    {
+        StarPremeasure::ClearPlan();
+        return;
+    }
+
+    // Same search positions the next UpdateCurrentPosition will use
+    EnsureStarStateSize();
+    PHD_Point refPrimary = m_solutionStar.WasFound() ? static_cast<const PHD_Point&>(m_solutionStar)
+                                                     : static_cast<const PHD_Point&>(m_primaryStar);
+    std::vector<GuideStar> measured;
+    std::vector<Star::FindJob> jobs;
+    BuildFindJobs(refPrimary, measured, jobs);
+
+    StarPremeasure::SetPlan(StarFindParams(), jobs);
+}
+
 bool GuiderMultiStar2::IsLocked() const
 {
     return m_solutionStar.WasFound();
@@ -395,25 +450,13 @@ bool GuiderMultiStar2::UpdateCurrentPosition(const usImage *pImage, GuiderOffset
 
         // Keep a simple time window, similar spirit to MassChecker
         wxLongLong_t now = ::wxGetUTCTimeMillis().GetValue();
-        wxLongLong_t oldest = now - 22500 * 2; // DefaultTimeWindowMs * 2 in multistar
-
-        while (!st.massHist.empty() && st.massHist.front().first < oldest)
-            st.massHist.pop_front();
-
         double am = adjMass(mass);
-        st.massHist.push_back({ now, am });
+        st.massHist.Add(now, am);
 
-        if (st.massHist.size() < 5)
+        if (st.massHist.Size() < 5)
             return false;
 
-        std::vector<double> tmp;
-        tmp.reserve(st.massHist.size());
-        for (const auto& e : st.massHist)
-            tmp.push_back(e.second);
-
-        size_t mid = tmp.size() / 2;
-        std::nth_element(tmp.begin(), tmp.begin() + mid, tmp.end());
-        double med = tmp[mid];
+        double med = st.massHist.Median();
 
         if (med > st.highMass)
             st.highMass = med;
@@ -437,41 +480,24 @@ bool GuiderMultiStar2::UpdateCurrentPosition(const usImage *pImage, GuiderOffset
     std::vector<Found> found;
     found.reserve(m_guideStars.size());
 
-    // Determine whether we can use secondaries (respect subframes behavior)
-    bool allowSecondaries = m_multiStarMode && m_guideStars.size() > 1 && !pCamera->UseSubframes;
-
     // Use last solution as reference primary estimate for searching lost secondaries
     PHD_Point refPrimary = prevSolution.WasFound() ? static_cast<const PHD_Point&>(prevSolution)
                                                    : static_cast<const PHD_Point&>(m_primaryStar);
 
-    // Find/update each star in m_guideStars (index 0 is primary)
-    for (size_t i = 0; i < m_guideStars.size(); i++)
-    {
-        if (i > 0 && !allowSecondaries)
-            break;
+    // Measure each star in m_guideStars in one batch (index 0 is primary)
+    std::vector<GuideStar> measured;
+    std::vector<Star::FindJob> jobs;
+    BuildFindJobs(refPrimary, measured, jobs);
+    size_t measureCount = jobs.size();
+
+    StarPremeasure::FindStars(pImage, StarFindParams(), jobs);
 
+    for (size_t i = 0; i < measureCount; i++)
+    {
         GuideStar& gs = m_guideStars[i];
         StarState& st = m_starState[i];
-
-        GuideStar s(gs);
-        bool ok = false;
-
-        if (st.lastPosValid)
-        {
-            ok = s.Find(pImage, m_searchRegion, st.lastPos.X, st.lastPos.Y, pFrame->GetStarFindMode(), GetMinStarHFD(),
-                        GetMaxStarHFD(), pCamera->GetSaturationADU(), Star::FIND_LOGGING_MINIMAL);
-        }
-        else if (i == 0)
-        {
-            ok = s.Find(pImage, m_searchRegion, pFrame->GetStarFindMode(), GetMinStarHFD(), GetMaxStarHFD(),
-                        pCamera->GetSaturationADU(), Star::FIND_LOGGING_VERBOSE);
-        }
-        else
-        {
-            PHD_Point expected = refPrimary + gs.offsetFromPrimary;
-            ok = s.Find(pImage, m_searchRegion, expected.X, expected.Y, pFrame->GetStarFindMode(), GetMinStarHFD(), GetMaxStarHFD(),
-                        pCamera->GetSaturationADU(), Star::FIND_LOGGING_MINIMAL);
-        }
+        const GuideStar& s = measured[i];
+        bool ok = jobs[i].found;
 
         st.foundThisFrame = ok;
         if (!ok)
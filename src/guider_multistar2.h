@@ -49,8 +49,7 @@
 #define GUIDER_MULTISTAR2_H_INCLUDED
  
 #include "guider_multistar.h"
-#include <deque>
-#include <utility>
+#include "windowed_median.h"
 #include <vector>
  
 // Compile-time switch for extra multistar2 logging.
@@ -83,6 +82,11 @@ private:
     void SetDroppedFrameInfo(const usImage *pImage, FrameDroppedInfo *errorInfo, const wxString& status, double mass,
                              double snr, double hfd, bool setStatusMsg, bool resetAutoExposure) const;
 
+    enum
+    {
+        MassWindowMs = 22500 * 2 // DefaultTimeWindowMs * 2 in multistar
+    };
+
     struct StarState
     {
         PHD_Point lastPos;
@@ -92,12 +96,15 @@ private:
         unsigned int reacquireGoodCount = 0;
 
         // Mass-change tracking (per star)
-        std::deque<std::pair<wxLongLong_t, double>> massHist; // (time_ms, adj_mass)
+        WindowedMedian massHist { MassWindowMs }; // adj_mass over the last MassWindowMs
         double highMass = 0.;
         double lowMass = 9e99;
     };
 
     void EnsureStarStateSize();
+    void BuildFindJobs(const PHD_Point& refPrimary, std::vector<GuideStar>& measured,
+                       std::vector<Star::FindJob>& jobs) const;
+    void PlanNextMeasurement() override;
 
     Star m_solutionStar;   // estimated primary position (aggregate solution)
     Star m_displayStar;    // a real found star for UI/status (mass/SNR)
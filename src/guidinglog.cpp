@@ -34,6 +34,7 @@
  */
 
 #include "phd.h"
+#include "guidinglog_binary.h"
 
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
@@ -42,9 +43,29 @@
 
 const int RetentionPeriod = 60;
 
-GuidingLog::GuidingLog() : m_enabled(false), m_keepFile(false), m_isGuiding(false) { }
+GuidingLog::GuidingLog()
+    : m_enabled(false), m_binary(nullptr), m_keepFile(false), m_isGuiding(false), m_simultaneousMoves(0), m_pulseOverlap(0.),
+      m_pulseElapsed(0.), m_aoAxesSteps(0), m_aoStepElapsed(0.)
+{
+}
+
+GuidingLog::~GuidingLog()
+{
+    delete m_binary;
+}
+
+bool GuidingLog::IsOpened() const
+{
+    return m_file.IsOpened() || m_binary;
+}
 
-GuidingLog::~GuidingLog() { }
+void GuidingLog::Write(const wxString& s)
+{
+    if (m_binary)
+        m_binary->WriteText(s);
+    else
+        m_file.Write(s);
+}
 
 static wxString PierSideStr(PierSide p)
 {
@@ -165,46 +186,50 @@ static wxString PointingInfo()
     return rslt;
 }
 
-static void GuidingHeader(wxFFile& file)
-// output guiding header to log file
+static wxString GuidingHeader()
+// guiding header for the log file
 {
-    file.Write("Equipment Profile = " + pConfig->GetCurrentProfile() + "\n");
+    wxString s;
+
+    s += "Equipment Profile = " + pConfig->GetCurrentProfile() + "\n";
 
-    file.Write(pFrame->GetSettingsSummary());
-    file.Write(pFrame->pGuider->GetSettingsSummary());
+    s += pFrame->GetSettingsSummary();
+    s += pFrame->pGuider->GetSettingsSummary();
 
     if (pCamera)
     {
-        file.Write(pCamera->GetSettingsSummary());
-        file.Write("Exposure = " + pFrame->ExposureDurationSummary() + "\n");
+        s += pCamera->GetSettingsSummary();
+        s += "Exposure = " + pFrame->ExposureDurationSummary() + "\n";
     }
 
     if (pMount)
-        file.Write(pMount->GetSettingsSummary());
+        s += pMount->GetSettingsSummary();
 
     if (pSecondaryMount)
-        file.Write(pSecondaryMount->GetSettingsSummary());
+        s += pSecondaryMount->GetSettingsSummary();
 
-    file.Write(PointingInfo());
-    file.Write("\n");
+    s += PointingInfo();
+    s += "\n";
 
     const Star& star = pFrame->pGuider->PrimaryStar();
 
-    file.Write(wxString::Format("Lock position = %.3f, %.3f, Star position = %.3f, %.3f, HFD = %.2f px\n",
-                                pFrame->pGuider->LockPosition().X, pFrame->pGuider->LockPosition().Y,
-                                pFrame->pGuider->CurrentPosition().X, pFrame->pGuider->CurrentPosition().Y, star.HFD));
+    s += wxString::Format("Lock position = %.3f, %.3f, Star position = %.3f, %.3f, HFD = %.2f px\n",
+                          pFrame->pGuider->LockPosition().X, pFrame->pGuider->LockPosition().Y,
+                          pFrame->pGuider->CurrentPosition().X, pFrame->pGuider->CurrentPosition().Y, star.HFD);
 
-    file.Write("Frame,Time,mount,dx,dy,RARawDistance,DECRawDistance,RAGuideDistance,DECGuideDistance,"
-               "RADuration,RADirection,DECDuration,DECDirection,XStep,YStep,StarMass,SNR,ErrorCode\n");
+    s += "Frame,Time,mount,dx,dy,RARawDistance,DECRawDistance,RAGuideDistance,DECGuideDistance,"
+         "RADuration,RADirection,DECDuration,DECDirection,XStep,YStep,StarMass,SNR,ErrorCode\n";
+
+    return s;
 }
 
-static void WriteSummaryInfo(wxFFile& file, const GuideLogSummaryInfo& summary)
+static wxString SummaryInfo(const GuideLogSummaryInfo& summary)
 {
     if (!summary.valid)
-        return;
+        return wxEmptyString;
 
-    file.Write(wxString::Format("Log Summary: calcnt:%u gcnt:%u gdur:%.f gacnt:%u\n", summary.cal_cnt, summary.guide_cnt,
-                                summary.guide_dur, summary.ga_cnt));
+    return wxString::Format("Log Summary: calcnt:%u gcnt:%u gdur:%.f gacnt:%u\n", summary.cal_cnt, summary.guide_cnt,
+                            summary.guide_dur, summary.ga_cnt);
 }
 
 void GuideLogSummaryInfo::LoadSummaryInfo(wxFFile& file)
@@ -263,17 +288,40 @@ void GuidingLog::EnableLogging()
     try
     {
         const wxDateTime& logFileTime = wxGetApp().GetLogFileTime();
-        if (!m_file.IsOpened())
+        if (!IsOpened())
         {
             // Keep log files separated for multiple PHD2 instances
             wxString qualifier = wxGetApp().GetInstanceNumber() > 1 ? std::to_string(wxGetApp().GetInstanceNumber()) + "_" : "";
             m_fileName =
                 GetLogDir() + PATHSEPSTR + _("PHD2_GuideLog_") + qualifier + logFileTime.Format(_T("%Y-%m-%d_%H%M%S.txt"));
 
+            bool binary = pConfig->Global.GetBoolean("/BinaryGuideLog", false);
+            wxString binaryFileName = BinaryGuideLog::FileName(m_fileName);
+
+            // a binary log that was not converted when it was closed, e.g. after a crash, goes into the
+            // text log first so that the summary and the new session follow it
+            if (wxFileExists(binaryFileName) && !BinaryGuideLog::ConvertToText(binaryFileName, m_fileName))
+                wxRemove(binaryFileName);
+
+            // the text log is opened even when logging to the binary log, so that it exists while
+            // guiding; the binary log is appended to it when the log is closed
             if (!m_file.Open(m_fileName, "a+"))
             {
                 throw ERROR_INFO("unable to open file");
             }
+
+            if (binary)
+            {
+                m_binary = new BinaryGuideLog();
+                if (m_binary->Open(binaryFileName))
+                {
+                    delete m_binary;
+                    m_binary = nullptr;
+                    m_file.Close();
+                    throw ERROR_INFO("unable to open file");
+                }
+            }
+
             if (m_file.Length() > 0)
             {
                 m_keepFile = true;
@@ -287,9 +335,9 @@ void GuidingLog::EnableLogging()
             }
         }
 
-        assert(m_file.IsOpened());
+        assert(IsOpened());
 
-        m_file.Write(_T("PHD2 version ") FULLVER _T(" [") PHD_OSNAME _T("]")
+        Write(_T("PHD2 version ") FULLVER _T(" [") PHD_OSNAME _T("]")
                      _T(", Log version ") GUIDELOG_VERSION _T(". Log enabled at ") +
                      logFileTime.Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
 
@@ -300,7 +348,7 @@ void GuidingLog::EnableLogging()
 
         // dump guiding header if logging enabled during guide
         if (pFrame && pFrame->pGuider->IsGuiding())
-            GuidingHeader(m_file);
+            Write(GuidingHeader());
 
         Flush();
     }
@@ -323,12 +371,12 @@ void GuidingLog::DisableLogging()
     if (!m_enabled)
         return;
 
-    if (m_file.IsOpened())
+    if (IsOpened())
     {
         wxDateTime now = wxDateTime::Now();
 
-        m_file.Write("\n");
-        m_file.Write("Log disabled at " + now.Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
+        Write("\n");
+        Write("Log disabled at " + now.Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
         Flush();
     }
 
@@ -362,6 +410,7 @@ bool GuidingLog::ChangeDirLog(const wxString& newdir)
 void GuidingLog::RemoveOldFiles()
 {
     Logger::RemoveMatchingFiles("PHD2_GuideLog*.txt", RetentionPeriod);
+    Logger::RemoveMatchingFiles("PHD2_GuideLog*.bin", RetentionPeriod);
 }
 
 bool GuidingLog::Flush()
@@ -373,9 +422,11 @@ bool GuidingLog::Flush()
 
     try
     {
-        assert(m_file.IsOpened());
+        assert(IsOpened());
 
-        if (!m_file.Flush())
+        if (m_binary)
+            m_binary->Flush();
+        else if (!m_file.Flush())
         {
             throw ERROR_INFO("unable to flush file");
         }
@@ -391,19 +442,35 @@ bool GuidingLog::Flush()
 
 void GuidingLog::CloseGuideLog()
 {
-    if (m_file.IsOpened())
+    if (IsOpened())
     {
         if (m_keepFile)
         {
             wxDateTime now = wxDateTime::Now();
 
-            m_file.Write("\n");
-            WriteSummaryInfo(m_file, m_summary);
-            m_file.Write("Log closed at " + now.Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
+            Write("\n");
+            Write(SummaryInfo(m_summary));
+            Write("Log closed at " + now.Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
             Flush();
         }
 
         m_file.Close();
+
+        if (m_binary)
+        {
+            wxString binaryFileName = BinaryGuideLog::FileName(m_fileName);
+            m_binary->Close();
+            delete m_binary;
+            m_binary = nullptr;
+
+            // the binary log is only deleted once its text is safely in the text log
+            if (!m_keepFile)
+                wxRemove(binaryFileName);
+            else if (BinaryGuideLog::ConvertToText(binaryFileName, m_fileName))
+                Debug.Write(wxString::Format("GuidingLog: could not convert %s, keeping it\n", binaryFileName));
+            else
+                wxRemove(binaryFileName);
+        }
     }
 
     m_enabled = false;
@@ -421,40 +488,40 @@ void GuidingLog::StartCalibration(const Mount *pCalibrationMount)
     if (!m_enabled)
         return;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
     wxDateTime now = wxDateTime::Now();
 
-    m_file.Write("\n");
-    m_file.Write("Calibration Begins at " + now.Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
-    m_file.Write("Equipment Profile = " + pConfig->GetCurrentProfile() + "\n");
+    Write("\n");
+    Write("Calibration Begins at " + now.Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
+    Write("Equipment Profile = " + pConfig->GetCurrentProfile() + "\n");
 
-    m_file.Write(pFrame->GetSettingsSummary());
-    m_file.Write(pFrame->pGuider->GetSettingsSummary());
+    Write(pFrame->GetSettingsSummary());
+    Write(pFrame->pGuider->GetSettingsSummary());
 
     if (pCamera)
     {
-        m_file.Write(pCamera->GetSettingsSummary());
-        m_file.Write("Exposure = " + pFrame->ExposureDurationSummary() + "\n");
+        Write(pCamera->GetSettingsSummary());
+        Write("Exposure = " + pFrame->ExposureDurationSummary() + "\n");
     }
 
     assert(pCalibrationMount && pCalibrationMount->IsConnected());
 
-    m_file.Write("Mount = " + pCalibrationMount->Name());
+    Write("Mount = " + pCalibrationMount->Name());
     wxString calSettings = pCalibrationMount->CalibrationSettingsSummary();
     if (!calSettings.IsEmpty())
-        m_file.Write(", " + calSettings);
-    m_file.Write("\n");
+        Write(", " + calSettings);
+    Write("\n");
 
-    m_file.Write(PointingInfo());
-    m_file.Write("\n");
+    Write(PointingInfo());
+    Write("\n");
 
     const Star& star = pFrame->pGuider->PrimaryStar();
 
-    m_file.Write(wxString::Format("Lock position = %.3f, %.3f, Star position = %.3f, %.3f, HFD = %.2f px\n",
-                                  pFrame->pGuider->LockPosition().X, pFrame->pGuider->LockPosition().Y,
-                                  pFrame->pGuider->CurrentPosition().X, pFrame->pGuider->CurrentPosition().Y, star.HFD));
+    Write(wxString::Format("Lock position = %.3f, %.3f, Star position = %.3f, %.3f, HFD = %.2f px\n",
+                           pFrame->pGuider->LockPosition().X, pFrame->pGuider->LockPosition().Y,
+                           pFrame->pGuider->CurrentPosition().X, pFrame->pGuider->CurrentPosition().Y, star.HFD));
 
-    m_file.Write("Direction,Step,dx,dy,x,y,Dist\n");
+    Write("Direction,Step,dx,dy,x,y,Dist\n");
 
     Flush();
 
@@ -468,10 +535,10 @@ void GuidingLog::CalibrationFailed(const Mount *pCalibrationMount, const wxStrin
     if (!m_enabled)
         return;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
 
-    m_file.Write(msg);
-    m_file.Write("\n");
+    Write(msg);
+    Write("\n");
     Flush();
 }
 
@@ -480,11 +547,11 @@ void GuidingLog::CalibrationStep(const CalibrationStepInfo& info)
     if (!m_enabled)
         return;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
 
     // Direction,Step,dx,dy,x,y,Dist
-    m_file.Write(wxString::Format("%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", info.direction, info.stepNumber, info.dx, info.dy,
-                                  info.pos.X, info.pos.Y, info.dist));
+    Write(wxString::Format("%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", info.direction, info.stepNumber, info.dx, info.dy,
+                           info.pos.X, info.pos.Y, info.dist));
 
     Flush();
 }
@@ -495,10 +562,10 @@ void GuidingLog::CalibrationDirectComplete(const Mount *pCalibrationMount, const
     if (!m_enabled)
         return;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
 
-    m_file.Write(wxString::Format("%s calibration complete. Angle = %.1f deg, Rate = %.3f px/sec, Parity = %s\n", direction,
-                                  degrees(angle), rate * 1000.0, ParityStr(parity)));
+    Write(wxString::Format("%s calibration complete. Angle = %.1f deg, Rate = %.3f px/sec, Parity = %s\n", direction,
+                           degrees(angle), rate * 1000.0, ParityStr(parity)));
 
     Flush();
 }
@@ -512,9 +579,9 @@ void GuidingLog::CalibrationComplete(const Mount *pCalibrationMount)
 
     ++m_summary.cal_cnt;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
 
-    m_file.Write(wxString::Format("Calibration complete, mount = %s.\n", pCalibrationMount->Name()));
+    Write(wxString::Format("Calibration complete, mount = %s.\n", pCalibrationMount->Name()));
 
     Flush();
 }
@@ -522,17 +589,21 @@ void GuidingLog::CalibrationComplete(const Mount *pCalibrationMount)
 void GuidingLog::GuidingStarted()
 {
     m_isGuiding = true;
+    m_simultaneousMoves = 0;
+    m_pulseOverlap = m_pulseElapsed = 0.;
+    m_aoAxesSteps = 0;
+    m_aoStepElapsed = 0.;
 
     if (!m_enabled)
         return;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
 
-    m_file.Write("\n");
-    m_file.Write("Guiding Begins at " + pFrame->m_guidingStarted.Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
+    Write("\n");
+    Write("Guiding Begins at " + pFrame->m_guidingStarted.Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
 
     // add common guiding header
-    GuidingHeader(m_file);
+    Write(GuidingHeader());
 
     Flush();
 
@@ -546,12 +617,25 @@ void GuidingLog::GuidingStopped()
     if (!m_enabled)
         return;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
 
     ++m_summary.guide_cnt;
     m_summary.guide_dur += pFrame->TimeSinceGuidingStarted();
 
-    m_file.Write("Guiding Ends at " + wxDateTime::Now().Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
+    if (m_simultaneousMoves > 0)
+    {
+        // the overlap is the time saved versus issuing the RA and Dec pulses one after the other
+        Write(wxString::Format("INFO: Simultaneous RA/Dec pulses: %u moves, elapsed %.1f s, overlap %.1f s\n",
+                               m_simultaneousMoves, m_pulseElapsed / 1000., m_pulseOverlap / 1000.));
+    }
+
+    if (m_aoAxesSteps > 0)
+    {
+        Write(wxString::Format("INFO: AO steps on both axes: %u steps, elapsed %.1f s\n", m_aoAxesSteps,
+                               m_aoStepElapsed / 1000.));
+    }
+
+    Write("Guiding Ends at " + wxDateTime::Now().Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
     Flush();
 }
 
@@ -560,8 +644,34 @@ void GuidingLog::GuideStep(const GuideStepInfo& step)
     if (!m_enabled)
         return;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
+
+    if (m_binary)
+        m_binary->WriteStep(step);
+    else
+        WriteStepText(step);
+
+    if (step.mount->IsStepGuider())
+    {
+        if (step.aoStepElapsed > 0)
+        {
+            ++m_aoAxesSteps;
+            m_aoStepElapsed += step.aoStepElapsed;
+        }
+    }
+    else if (step.moveElapsed > 0)
+    {
+        ++m_simultaneousMoves;
+        m_pulseElapsed += step.moveElapsed;
+        m_pulseOverlap += step.moveOverlap;
+    }
+
+    Flush();
+}
 
+void GuidingLog::WriteStepText(const GuideStepInfo& step)
+{
+    // BinaryGuideLogCodec::AppendStepText must produce the same output
     m_file.Write(wxString::Format("%d,%.3f,\"%s\",%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,", step.frameNumber, step.time,
                                   step.mount->IsStepGuider() ? "AO" : "Mount", step.cameraOffset.X, step.cameraOffset.Y,
                                   step.mountOffset.X, step.mountOffset.Y, step.guideDistanceRA, step.guideDistanceDec));
@@ -581,8 +691,6 @@ void GuidingLog::GuideStep(const GuideStepInfo& step)
     }
 
     m_file.Write(wxString::Format("%.f,%.2f,%d\n", step.starMass, step.starSNR, step.starError));
-
-    Flush();
 }
 
 void GuidingLog::FrameDropped(const FrameDroppedInfo& info)
@@ -590,10 +698,10 @@ void GuidingLog::FrameDropped(const FrameDroppedInfo& info)
     if (!m_enabled)
         return;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
 
-    m_file.Write(wxString::Format("%d,%.3f,\"DROP\",,,,,,,,,,,,,%.f,%.2f,%d,\"%s\"\n", info.frameNumber, info.time,
-                                  info.starMass, info.starSNR, info.starError, info.status));
+    Write(wxString::Format("%d,%.3f,\"DROP\",,,,,,,,,,,,,%.f,%.2f,%d,\"%s\"\n", info.frameNumber, info.time,
+                           info.starMass, info.starSNR, info.starError, info.status));
 
     Flush();
 }
@@ -603,10 +711,10 @@ void GuidingLog::CalibrationFrameDropped(const FrameDroppedInfo& info)
     if (!m_enabled)
         return;
 
-    assert(m_file.IsOpened());
+    assert(IsOpened());
 
-    m_file.Write(wxString::Format("INFO: STAR LOST during calibration, Mass= %.f, SNR= %.2f, Error= %d, Status=%s\n",
-                                  info.starMass, info.starSNR, info.starError, info.status));
+    Write(wxString::Format("INFO: STAR LOST during calibration, Mass= %.f, SNR= %.2f, Error= %d, Status=%s\n",
+                           info.starMass, info.starSNR, info.starError, info.status));
 
     Flush();
 }
@@ -616,8 +724,8 @@ void GuidingLog::NotifyGuidingDithered(Guider *guider, double dx, double dy)
     if (!m_enabled || !m_isGuiding)
         return;
 
-    m_file.Write(wxString::Format("INFO: DITHER by %.3f, %.3f, new lock pos = %.3f, %.3f\n", dx, dy, guider->LockPosition().X,
-                                  guider->LockPosition().Y));
+    Write(wxString::Format("INFO: DITHER by %.3f, %.3f, new lock pos = %.3f, %.3f\n", dx, dy, guider->LockPosition().X,
+                           guider->LockPosition().Y));
 
     Flush();
 }
@@ -626,7 +734,7 @@ void GuidingLog::NotifySettlingStateChange(const wxString& msg)
 {
     if (!m_enabled)
         return;
-    m_file.Write(wxString::Format("INFO: SETTLING STATE CHANGE, %s\n", msg));
+    Write(wxString::Format("INFO: SETTLING STATE CHANGE, %s\n", msg));
     Flush();
 }
 
@@ -644,7 +752,7 @@ void GuidingLog::NotifyGAResult(const wxString& msg)
         return;
 
     // Client needs to handle end-of-line formatting
-    m_file.Write(wxString::Format("INFO: GA Result - %s", msg));
+    Write(wxString::Format("INFO: GA Result - %s", msg));
     Flush();
 }
 
@@ -653,8 +761,8 @@ void GuidingLog::NotifySetLockPosition(Guider *guider)
     if (!m_enabled || !m_isGuiding)
         return;
 
-    m_file.Write(wxString::Format("INFO: SET LOCK POSITION, new lock pos = %.3f, %.3f\n", guider->LockPosition().X,
-                                  guider->LockPosition().Y));
+    Write(wxString::Format("INFO: SET LOCK POSITION, new lock pos = %.3f, %.3f\n", guider->LockPosition().X,
+                           guider->LockPosition().Y));
 
     Flush();
 
@@ -677,7 +785,7 @@ void GuidingLog::NotifyLockShiftParams(const LockPosShiftParams& shiftParams, co
             cameraRate.IsValid() ? cameraRate.Y * 3600.0 : 0.0);
     }
 
-    m_file.Write(wxString::Format("INFO: LOCK SHIFT, enabled = %d %s\n", shiftParams.shiftEnabled, details));
+    Write(wxString::Format("INFO: LOCK SHIFT, enabled = %d %s\n", shiftParams.shiftEnabled, details));
     Flush();
 
     m_keepFile = true;
@@ -688,7 +796,7 @@ void GuidingLog::ServerCommand(Guider *guider, const wxString& cmd)
     if (!m_enabled || !m_isGuiding)
         return;
 
-    m_file.Write(wxString::Format("INFO: Server received %s\n", cmd));
+    Write(wxString::Format("INFO: Server received %s\n", cmd));
     Flush();
 
     m_keepFile = true;
@@ -699,9 +807,9 @@ void GuidingLog::NotifyManualGuide(const Mount *mount, int direction, int durati
     if (!m_enabled || !m_isGuiding)
         return;
 
-    m_file.Write(wxString::Format("INFO: Manual guide (%s) %s %d %s\n", mount->IsStepGuider() ? "AO" : "Mount",
-                                  mount->DirectionStr(static_cast<GUIDE_DIRECTION>(direction)), duration,
-                                  mount->IsStepGuider() ? (duration != 1 ? "steps" : "step") : "ms"));
+    Write(wxString::Format("INFO: Manual guide (%s) %s %d %s\n", mount->IsStepGuider() ? "AO" : "Mount",
+                           mount->DirectionStr(static_cast<GUIDE_DIRECTION>(direction)), duration,
+                           mount->IsStepGuider() ? (duration != 1 ? "steps" : "step") : "ms"));
     Flush();
 
     m_keepFile = true;
@@ -727,7 +835,7 @@ void GuidingLog::SetGuidingParam(const wxString& name, const wxString& val)
     if (!m_enabled || !m_isGuiding)
         return;
 
-    m_file.Write(wxString::Format("INFO: Guiding parameter change, %s = %s\n", name, val));
+    Write(wxString::Format("INFO: Guiding parameter change, %s = %s\n", name, val));
     Flush();
 
     m_keepFile = true;
@@ -735,7 +843,7 @@ void GuidingLog::SetGuidingParam(const wxString& name, const wxString& val)
 
 void GuidingLog::SetGuidingParam(const wxString& name, const wxString& val, bool AlwaysLog)
 {
-    m_file.Write(wxString::Format("INFO: Guiding parameter change, %s = %s\n", name, val));
+    Write(wxString::Format("INFO: Guiding parameter change, %s = %s\n", name, val));
     Flush();
 
     m_keepFile = true;
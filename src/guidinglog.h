@@ -84,6 +84,9 @@ struct GuideStepInfo
     double starHFD;
     double avgDist;
     int starError;
+    int moveElapsed; // ms, when the RA and Dec pulses were issued simultaneously, otherwise 0
+    int moveOverlap; // ms the RA and Dec pulses were both active
+    int aoStepElapsed; // ms taken by the AO to step both axes together, otherwise 0
 };
 
 struct FrameDroppedInfo
@@ -98,6 +101,8 @@ struct FrameDroppedInfo
     wxString status;
 };
 
+class BinaryGuideLog;
+
 struct GuideLogSummaryInfo
 {
     bool valid;
@@ -122,13 +127,22 @@ class GuidingLog : public Logger
 {
     bool m_enabled;
     wxFFile m_file;
+    BinaryGuideLog *m_binary; // replaces m_file when the binary guide log is enabled
     wxString m_fileName;
     bool m_keepFile;
     bool m_isGuiding;
     GuideLogSummaryInfo m_summary;
+    unsigned int m_simultaneousMoves; // guide steps this session with RA and Dec pulsed together
+    double m_pulseOverlap; // total time both pulses were active, ms
+    double m_pulseElapsed; // total time taken by those moves, ms
+    unsigned int m_aoAxesSteps; // AO guide steps this session with both axes stepped together
+    double m_aoStepElapsed; // total time taken by those steps, ms
 
     void EnableLogging();
     void DisableLogging();
+    bool IsOpened() const;
+    void Write(const wxString& s);
+    void WriteStepText(const GuideStepInfo& step);
 
 public:
     GuidingLog();
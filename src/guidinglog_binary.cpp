@@ -0,0 +1,338 @@
+/*
+ *  guidinglog_binary.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include "phd.h"
+#include "guidinglog_binary.h"
+
+#include <deque>
+
+using namespace BinaryGuideLogCodec;
+
+namespace
+{
+struct Block
+{
+    BlockType type;
+    std::string text;
+    std::vector<BinaryGuideStep> steps;
+};
+
+void EncodeBlock(const Block& block, std::string *out)
+{
+    out->clear();
+    if (block.type == BLOCK_TEXT)
+        AppendTextBlock(block.text, out);
+    else
+        AppendStepBlock(block.steps, out);
+}
+
+} // namespace
+
+class BinaryGuideLogWriter : public wxThread
+{
+    wxFFile m_file;
+    wxMutex m_lock;
+    wxCondition m_wake;
+    std::deque<Block> m_queue;
+    bool m_exiting;
+    bool m_running;
+
+    void WriteBlocks(std::deque<Block>& blocks)
+    {
+        std::string buf;
+        for (const Block& block : blocks)
+        {
+            EncodeBlock(block, &buf);
+            m_file.Write(buf.data(), buf.size());
+        }
+        m_file.Flush();
+    }
+
+public:
+    BinaryGuideLogWriter() : wxThread(wxTHREAD_JOINABLE), m_wake(m_lock), m_exiting(false), m_running(false) { }
+
+    bool Open(const wxString& fileName)
+    {
+        if (!m_file.Open(fileName, "ab"))
+            return true;
+
+        if (m_file.Length() == 0)
+        {
+            std::string header;
+            AppendFileHeader(&header);
+            m_file.Write(header.data(), header.size());
+            m_file.Flush();
+        }
+
+        // without a thread the blocks are written synchronously
+        m_running = Create() == wxTHREAD_NO_ERROR && Run() == wxTHREAD_NO_ERROR;
+
+        return false;
+    }
+
+    void Queue(Block&& block)
+    {
+        if (!m_running)
+        {
+            std::deque<Block> blocks;
+            blocks.push_back(std::move(block));
+            WriteBlocks(blocks);
+            return;
+        }
+
+        wxMutexLocker lck(m_lock);
+        m_queue.push_back(std::move(block));
+        m_wake.Signal();
+    }
+
+    // write out everything that was queued and close the file
+    void Stop()
+    {
+        if (m_running)
+        {
+            {
+                wxMutexLocker lck(m_lock);
+                m_exiting = true;
+                m_wake.Signal();
+            }
+            Wait();
+            m_running = false;
+        }
+        m_file.Close();
+    }
+
+    ExitCode Entry() override
+    {
+        while (true)
+        {
+            std::deque<Block> blocks;
+            bool exiting;
+            {
+                wxMutexLocker lck(m_lock);
+                while (m_queue.empty() && !m_exiting)
+                    m_wake.Wait();
+                blocks.swap(m_queue);
+                exiting = m_exiting;
+            }
+
+            if (!blocks.empty())
+                WriteBlocks(blocks);
+
+            if (exiting)
+                break;
+        }
+
+        return 0;
+    }
+};
+
+BinaryGuideLog::BinaryGuideLog() : m_writer(nullptr) { }
+
+BinaryGuideLog::~BinaryGuideLog()
+{
+    Close();
+}
+
+wxString BinaryGuideLog::FileName(const wxString& textFileName)
+{
+    wxFileName fn(textFileName);
+    fn.SetExt("bin");
+    return fn.GetFullPath();
+}
+
+bool BinaryGuideLog::Open(const wxString& fileName)
+{
+    Close();
+
+    m_writer = new BinaryGuideLogWriter();
+    if (m_writer->Open(fileName))
+    {
+        delete m_writer;
+        m_writer = nullptr;
+        return true;
+    }
+
+    return false;
+}
+
+void BinaryGuideLog::Close()
+{
+    if (!m_writer)
+        return;
+
+    QueueSteps();
+    QueueText();
+
+    m_writer->Stop();
+    delete m_writer;
+    m_writer = nullptr;
+}
+
+void BinaryGuideLog::QueueText()
+{
+    if (m_text.empty())
+        return;
+
+    Block block;
+    block.type = BLOCK_TEXT;
+    block.text.swap(m_text);
+    m_writer->Queue(std::move(block));
+}
+
+void BinaryGuideLog::QueueSteps()
+{
+    if (m_steps.empty())
+        return;
+
+    Block block;
+    block.type = BLOCK_STEPS;
+    block.steps.swap(m_steps);
+    m_writer->Queue(std::move(block));
+
+    m_steps.reserve(ChunkSteps);
+}
+
+void BinaryGuideLog::WriteText(const wxString& text)
+{
+    // text and steps must stay in order
+    QueueSteps();
+    m_text += text.utf8_str().data();
+}
+
+void BinaryGuideLog::WriteStep(const GuideStepInfo& step)
+{
+    QueueText();
+
+    BinaryGuideStep s;
+    s.frame = step.frameNumber;
+    s.time = step.time;
+    s.ao = step.mount->IsStepGuider() ? 1 : 0;
+    s.dx = step.cameraOffset.X;
+    s.dy = step.cameraOffset.Y;
+    s.raRaw = step.mountOffset.X;
+    s.decRaw = step.mountOffset.Y;
+    s.raGuide = step.guideDistanceRA;
+    s.decGuide = step.guideDistanceDec;
+    if (s.ao)
+    {
+        s.raDuration = step.directionRA == LEFT ? -step.durationRA : step.durationRA;
+        s.decDuration = step.directionDec == DOWN ? -step.durationDec : step.durationDec;
+        s.raDirection = s.decDirection = 0;
+    }
+    else
+    {
+        s.raDuration = step.durationRA;
+        s.decDuration = step.durationDec;
+        s.raDirection = step.durationRA > 0 ? step.mount->DirectionChar((GUIDE_DIRECTION) step.directionRA)[0] : 0;
+        s.decDirection = step.durationDec > 0 ? step.mount->DirectionChar((GUIDE_DIRECTION) step.directionDec)[0] : 0;
+    }
+    s.starMass = step.starMass;
+    s.snr = step.starSNR;
+    s.error = step.starError;
+
+    if (!m_steps.empty() && s.time - m_steps[0].time >= ChunkSeconds)
+        QueueSteps();
+
+    m_steps.push_back(s);
+
+    if (m_steps.size() >= ChunkSteps)
+        QueueSteps();
+}
+
+void BinaryGuideLog::Flush()
+{
+    if (m_writer)
+        QueueText();
+}
+
+bool BinaryGuideLog::ConvertToText(const wxString& binaryFileName, const wxString& textFileName)
+{
+    wxFFile in(binaryFileName, "rb");
+    if (!in.IsOpened())
+        return true;
+
+    char header[FileHeaderSize];
+    if (in.Read(header, sizeof(header)) != sizeof(header) || CheckFileHeader(header, sizeof(header)))
+    {
+        Debug.Write(wxString::Format("BinaryGuideLog: %s is not a binary guide log\n", binaryFileName));
+        return true;
+    }
+
+    // text mode, same as the text guide log; appended because the text log may already hold an
+    // earlier part of the session
+    wxFFile out(textFileName, "a");
+    if (!out.IsOpened())
+        return true;
+
+    std::vector<char> payload;
+    std::string text;
+    bool err = false;
+
+    while (true)
+    {
+        char blockHeader[BlockHeaderSize];
+        if (in.Read(blockHeader, sizeof(blockHeader)) != sizeof(blockHeader))
+            break;
+
+        uint32_t type, size;
+        ReadBlockHeader(blockHeader, &type, &size);
+
+        payload.resize(size);
+        if (in.Read(payload.data(), payload.size()) != payload.size())
+        {
+            // the last block is incomplete if PHD2 did not exit cleanly
+            Debug.Write(wxString::Format("BinaryGuideLog: %s is truncated\n", binaryFileName));
+            break;
+        }
+
+        text.clear();
+        if (AppendBlockText(type, payload.data(), payload.size(), &text))
+        {
+            Debug.Write(wxString::Format("BinaryGuideLog: invalid step block in %s\n", binaryFileName));
+            break;
+        }
+
+        if (!text.empty() && out.Write(text.data(), text.size()) != text.size())
+        {
+            err = true;
+            break;
+        }
+    }
+
+    if (!out.Close())
+        err = true;
+
+    return err;
+}
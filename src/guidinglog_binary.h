@@ -0,0 +1,96 @@
+/*
+ *  guidinglog_binary.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef GUIDINGLOG_BINARY_INCLUDED
+#define GUIDINGLOG_BINARY_INCLUDED
+
+#include "guidinglog_binary_codec.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct GuideStepInfo;
+class BinaryGuideLogWriter;
+
+// Binary guide log, the alternative to the text guide log when the global setting
+// /BinaryGuideLog is enabled.
+//
+// Text that GuidingLog writes (headers, INFO lines) is stored verbatim. Guide steps are stored as
+// fixed-width records, grouped into chunks of up to ChunkSteps steps. A chunk is stored column by
+// column with the minimum and maximum of each column in the chunk header, so a reader can skip
+// chunks or pull out single columns without decoding the rest. Blocks are encoded and written by
+// a background thread; the guiding thread only copies the step into the pending chunk. The
+// encoding is in guidinglog_binary_codec.h.
+//
+// When the log is closed GuidingLog appends its text to the PHD2_GuideLog_*.txt file, so the text
+// log ends up identical to what the text log would have contained.
+class BinaryGuideLog
+{
+public:
+    enum
+    {
+        ChunkSteps = 256,
+        ChunkSeconds = 30, // a chunk is also written when its first step is this old
+    };
+
+    BinaryGuideLog();
+    ~BinaryGuideLog();
+
+    // the binary log file name that goes with a text guide log file name
+    static wxString FileName(const wxString& textFileName);
+
+    // open for append, returns true on error
+    bool Open(const wxString& fileName);
+    void Close();
+    bool IsOpened() const { return m_writer != nullptr; }
+
+    void WriteText(const wxString& text);
+    void WriteStep(const GuideStepInfo& step);
+    // hand the pending text to the writer thread; guide steps are written a chunk at a time
+    void Flush();
+
+    // append the text of a binary guide log to a text guide log, returns true on error
+    static bool ConvertToText(const wxString& binaryFileName, const wxString& textFileName);
+
+private:
+    void QueueText();
+    void QueueSteps();
+
+    BinaryGuideLogWriter *m_writer;
+    std::string m_text; // pending text
+    std::vector<BinaryGuideStep> m_steps; // pending chunk
+};
+
+#endif // GUIDINGLOG_BINARY_INCLUDED
@@ -0,0 +1,209 @@
+/*
+ *  guidinglog_binary_codec.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include "guidinglog_binary_codec.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace BinaryGuideLogCodec
+{
+static const char Magic[8] = { 'P', 'H', 'D', '2', 'G', 'L', 'O', 'G' };
+
+// Calls v with a pointer to each column's member, in Column order
+template<typename Visitor> static void VisitColumns(Visitor&& v)
+{
+    v(&BinaryGuideStep::frame);
+    v(&BinaryGuideStep::time);
+    v(&BinaryGuideStep::ao);
+    v(&BinaryGuideStep::dx);
+    v(&BinaryGuideStep::dy);
+    v(&BinaryGuideStep::raRaw);
+    v(&BinaryGuideStep::decRaw);
+    v(&BinaryGuideStep::raGuide);
+    v(&BinaryGuideStep::decGuide);
+    v(&BinaryGuideStep::raDuration);
+    v(&BinaryGuideStep::raDirection);
+    v(&BinaryGuideStep::decDuration);
+    v(&BinaryGuideStep::decDirection);
+    v(&BinaryGuideStep::starMass);
+    v(&BinaryGuideStep::snr);
+    v(&BinaryGuideStep::error);
+}
+
+static void AppendU32(std::string *out, uint32_t val)
+{
+    out->append(reinterpret_cast<const char *>(&val), sizeof(val));
+}
+
+void AppendFileHeader(std::string *out)
+{
+    out->append(Magic, sizeof(Magic));
+    AppendU32(out, Version);
+    AppendU32(out, 0);
+}
+
+bool CheckFileHeader(const char *p, size_t len)
+{
+    if (len < FileHeaderSize || memcmp(p, Magic, sizeof(Magic)) != 0)
+        return true;
+    uint32_t version;
+    memcpy(&version, p + sizeof(Magic), sizeof(version));
+    return version > Version;
+}
+
+void ReadBlockHeader(const char *p, uint32_t *type, uint32_t *size)
+{
+    memcpy(type, p, sizeof(*type));
+    memcpy(size, p + sizeof(*type), sizeof(*size));
+}
+
+void AppendTextBlock(const std::string& text, std::string *out)
+{
+    AppendU32(out, BLOCK_TEXT);
+    AppendU32(out, (uint32_t) text.size());
+    out->append(text);
+}
+
+void AppendStepBlock(const std::vector<BinaryGuideStep>& steps, std::string *out)
+{
+    size_t start = out->size();
+    AppendU32(out, BLOCK_STEPS);
+    AppendU32(out, 0); // payload size, filled in below
+    AppendU32(out, (uint32_t) steps.size());
+
+    size_t rangePos = out->size();
+    out->append(COLUMN_COUNT * 2 * sizeof(double), '\0');
+
+    unsigned int col = 0;
+    VisitColumns([&](auto field) {
+        double lo = DBL_MAX;
+        double hi = -DBL_MAX;
+        for (const BinaryGuideStep& s : steps)
+        {
+            auto v = s.*field;
+            out->append(reinterpret_cast<const char *>(&v), sizeof(v));
+            lo = std::min(lo, (double) v);
+            hi = std::max(hi, (double) v);
+        }
+        char *range = &(*out)[rangePos + 2 * sizeof(double) * col++];
+        memcpy(range, &lo, sizeof(lo));
+        memcpy(range + sizeof(lo), &hi, sizeof(hi));
+    });
+
+    uint32_t size = (uint32_t) (out->size() - start - BlockHeaderSize);
+    memcpy(&(*out)[start + sizeof(uint32_t)], &size, sizeof(size));
+}
+
+bool DecodeSteps(const char *p, size_t len, std::vector<BinaryGuideStep> *steps)
+{
+    uint32_t count;
+    if (len < sizeof(count))
+        return true;
+    memcpy(&count, p, sizeof(count));
+    p += sizeof(count);
+    len -= sizeof(count);
+
+    size_t ranges = COLUMN_COUNT * 2 * sizeof(double);
+    if (len < ranges)
+        return true;
+    p += ranges;
+    len -= ranges;
+
+    steps->assign(count, BinaryGuideStep());
+
+    bool err = false;
+    VisitColumns([&](auto field) {
+        typedef typename std::remove_reference<decltype((*steps)[0].*field)>::type T;
+        if (err || len < count * sizeof(T))
+        {
+            err = true;
+            return;
+        }
+        for (uint32_t i = 0; i < count; i++)
+            memcpy(&((*steps)[i].*field), p + i * sizeof(T), sizeof(T));
+        p += count * sizeof(T);
+        len -= count * sizeof(T);
+    });
+
+    return err;
+}
+
+bool AppendBlockText(uint32_t type, const char *payload, size_t len, std::string *out)
+{
+    if (type == BLOCK_TEXT)
+    {
+        out->append(payload, len);
+    }
+    else if (type == BLOCK_STEPS)
+    {
+        std::vector<BinaryGuideStep> steps;
+        if (DecodeSteps(payload, len, &steps))
+            return true;
+        for (const BinaryGuideStep& s : steps)
+            AppendStepText(s, out);
+    }
+
+    return false;
+}
+
+void AppendStepText(const BinaryGuideStep& s, std::string *out)
+{
+    // keep in sync with GuidingLog::GuideStep
+    char buf[512];
+    int n = snprintf(buf, sizeof(buf), "%d,%.3f,\"%s\",%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,", s.frame, s.time, s.ao ? "AO" : "Mount",
+                     s.dx, s.dy, s.raRaw, s.decRaw, s.raGuide, s.decGuide);
+    out->append(buf, std::min(n, (int) sizeof(buf) - 1));
+
+    if (s.ao)
+    {
+        n = snprintf(buf, sizeof(buf), ",,,,%d,%d,", s.raDuration, s.decDuration);
+    }
+    else
+    {
+        char ra[2] = { (char) s.raDirection, 0 };
+        char dec[2] = { (char) s.decDirection, 0 };
+        n = snprintf(buf, sizeof(buf), "%d,%s,%d,%s,,,", s.raDuration, ra, s.decDuration, dec);
+    }
+    out->append(buf, std::min(n, (int) sizeof(buf) - 1));
+
+    n = snprintf(buf, sizeof(buf), "%.f,%.2f,%d\n", s.starMass, s.snr, s.error);
+    out->append(buf, std::min(n, (int) sizeof(buf) - 1));
+}
+
+} // namespace BinaryGuideLogCodec
@@ -0,0 +1,130 @@
+/*
+ *  guidinglog_binary_codec.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef GUIDINGLOG_BINARY_CODEC_INCLUDED
+#define GUIDINGLOG_BINARY_CODEC_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One guide step as stored in the binary guide log. The members map one-to-one onto the columns
+// of the text log's guide step rows, and hold exactly the values that GuidingLog formats, so the
+// text can be regenerated byte for byte.
+struct BinaryGuideStep
+{
+    int32_t frame;
+    double time;
+    uint8_t ao;         // 1 for an AO step, 0 for a mount step
+    double dx;          // camera offset
+    double dy;
+    double raRaw;       // mount offset
+    double decRaw;
+    double raGuide;     // guide distance
+    double decGuide;
+    int32_t raDuration; // ms, or signed steps for an AO
+    uint8_t raDirection; // direction character, 0 if there was no pulse
+    int32_t decDuration;
+    uint8_t decDirection;
+    double starMass;
+    double snr;
+    int32_t error;
+};
+
+// Encoding of the binary guide log file, independent of the file I/O so that it can be tested on
+// its own.
+//
+// File layout (little-endian):
+//     "PHD2GLOG" uint32 version uint32 reserved
+//     blocks: uint32 type, uint32 payload size, payload
+//         BLOCK_TEXT:  UTF-8 text
+//         BLOCK_STEPS: uint32 count, COLUMN_COUNT x (double min, double max), then each column's values
+namespace BinaryGuideLogCodec
+{
+enum
+{
+    Version = 1,
+    FileHeaderSize = 16,
+    BlockHeaderSize = 8,
+};
+
+enum BlockType
+{
+    BLOCK_TEXT = 1,
+    BLOCK_STEPS = 2,
+};
+
+enum Column
+{
+    COL_FRAME,
+    COL_TIME,
+    COL_AO,
+    COL_DX,
+    COL_DY,
+    COL_RA_RAW,
+    COL_DEC_RAW,
+    COL_RA_GUIDE,
+    COL_DEC_GUIDE,
+    COL_RA_DURATION,
+    COL_RA_DIRECTION,
+    COL_DEC_DURATION,
+    COL_DEC_DIRECTION,
+    COL_STAR_MASS,
+    COL_SNR,
+    COL_ERROR,
+    COLUMN_COUNT
+};
+
+void AppendFileHeader(std::string *out);
+// returns true if the data does not start with a header this version can read
+bool CheckFileHeader(const char *p, size_t len);
+
+void AppendTextBlock(const std::string& text, std::string *out);
+void AppendStepBlock(const std::vector<BinaryGuideStep>& steps, std::string *out);
+// p points at BlockHeaderSize bytes
+void ReadBlockHeader(const char *p, uint32_t *type, uint32_t *size);
+
+// returns true if the payload is invalid
+bool DecodeSteps(const char *payload, size_t len, std::vector<BinaryGuideStep> *steps);
+// append the text log for one block, returns true if the payload is invalid; unknown block types
+// from a later version append nothing
+bool AppendBlockText(uint32_t type, const char *payload, size_t len, std::string *out);
+
+// append the text log row for a guide step, as GuidingLog::GuideStep formats it
+void AppendStepText(const BinaryGuideStep& step, std::string *out);
+} // namespace BinaryGuideLogCodec
+
+#endif // GUIDINGLOG_BINARY_CODEC_INCLUDED
@@ -0,0 +1,309 @@
+/*
+ *  image_bench.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+#include "image_bench.h"
+#include "frame_replay.h"
+#include "latency_trace.h"
+#include "thread_pool.h"
+
+#include <wx/ffile.h>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace
+{
+struct BenchResult
+{
+    wxString kernel;
+    wxString variant;
+    double megapixels;
+    wxSize size;
+    unsigned int iterations;
+    double minMs;
+    double medianMs;
+};
+
+enum
+{
+    MIN_ITERATIONS = 3,
+    MAX_ITERATIONS = 1000,
+};
+
+const uint64_t TIME_BUDGET_NS = 1000000000; // per kernel and frame size
+
+const unsigned short BACKGROUND = 1000;
+const float READ_NOISE = 12.f;
+
+// Frame sizes in megapixels, 4:3 aspect
+const double FRAME_MEGAPIXELS[] = { 1.0, 6.0, 20.0, 60.0 };
+
+wxSize FrameSize(double megapixels)
+{
+    int height = (int) sqrt(megapixels * 1e6 * 3.0 / 4.0) & ~1;
+    int width = (int) (megapixels * 1e6 / height) & ~1;
+    return wxSize(width, height);
+}
+
+void AddStar(usImage& img, double cx, double cy, double peak, double sigma)
+{
+    int r = (int) ceil(sigma * 4.0);
+    int x0 = std::max(0, (int) cx - r), x1 = std::min(img.Size.x - 1, (int) cx + r);
+    int y0 = std::max(0, (int) cy - r), y1 = std::min(img.Size.y - 1, (int) cy + r);
+    double k = -0.5 / (sigma * sigma);
+    for (int y = y0; y <= y1; y++)
+    {
+        unsigned short *row = img.ImageData + (size_t) y * img.Size.x;
+        for (int x = x0; x <= x1; x++)
+        {
+            double dx = x - cx, dy = y - cy;
+            double v = row[x] + peak * exp(k * (dx * dx + dy * dy));
+            row[x] = (unsigned short) std::min(v, 65535.0);
+        }
+    }
+}
+
+// A light frame with one bright star at the center (the star Star::Find measures) and a field of
+// fainter stars at a density of one per 10,000 pixels, or a dark frame with only the background
+// and the hot pixels. The generator is seeded, so every run sees the same frames.
+void MakeFrame(usImage& img, const wxSize& size, bool withStars, unsigned int seed)
+{
+    img.Init(size);
+    img.BitsPerPixel = 16;
+    img.ImgExpDur = 1000;
+
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(BACKGROUND, READ_NOISE);
+    for (unsigned int i = 0; i < img.NPixels; i++)
+        img.ImageData[i] = (unsigned short) std::max(0.f, noise(rng));
+
+    // hot pixels are at the same places in the darks and the lights
+    std::mt19937 hotRng(1);
+    std::uniform_int_distribution<unsigned int> pixel(0, img.NPixels - 1);
+    for (unsigned int i = 0; i < img.NPixels / 2000; i++)
+        img.ImageData[pixel(hotRng)] = 20000;
+
+    if (withStars)
+    {
+        std::uniform_real_distribution<double> xpos(10.0, size.x - 10.0), ypos(10.0, size.y - 10.0);
+        std::uniform_real_distribution<double> peak(200.0, 8000.0);
+        for (unsigned int i = 0; i < img.NPixels / 10000; i++)
+            AddStar(img, xpos(rng), ypos(rng), peak(rng), 1.5);
+        AddStar(img, size.x / 2 + 0.3, size.y / 2 - 0.2, 20000.0, 1.8);
+    }
+
+    img.CalcStats();
+}
+
+BenchResult Measure(const wxString& kernel, const wxString& variant, double megapixels, const wxSize& size,
+                    const std::function<void()>& setup, const std::function<void()>& fn)
+{
+    std::vector<double> times;
+    uint64_t elapsed = 0;
+
+    while (times.size() < MIN_ITERATIONS || (elapsed < TIME_BUDGET_NS && times.size() < MAX_ITERATIONS))
+    {
+        if (setup)
+            setup();
+        uint64_t t0 = LatencyTrace::Now();
+        fn();
+        uint64_t dt = LatencyTrace::Now() - t0;
+        times.push_back(dt / 1e6);
+        elapsed += dt;
+    }
+
+    std::sort(times.begin(), times.end());
+
+    BenchResult r;
+    r.kernel = kernel;
+    r.variant = variant;
+    r.megapixels = megapixels;
+    r.size = size;
+    r.iterations = times.size();
+    r.minMs = times.front();
+    r.medianMs = times[times.size() / 2];
+
+    wxPrintf("bench: %-22s %-9s %4.0f MP %10.3f ms (min %.3f, n=%u)\n", kernel, variant, megapixels, r.medianMs, r.minMs,
+             r.iterations);
+    Debug.Write(wxString::Format("Bench: %s %s %.0f MP median %.3f ms min %.3f ms n=%u\n", kernel, variant, megapixels,
+                                 r.medianMs, r.minMs, r.iterations));
+
+    return r;
+}
+
+void BenchFrameSize(double megapixels, std::vector<BenchResult> *results)
+{
+    wxSize size = FrameSize(megapixels);
+
+    usImage light, dark, work;
+    MakeFrame(light, size, true, 2);
+    MakeFrame(dark, size, false, 3);
+    work.Init(size);
+
+    // restore the working copy for the kernels that modify the image in place
+    auto restore = [&]() {
+        memcpy(work.ImageData, light.ImageData, light.NPixels * sizeof(unsigned short));
+        work.Subframe = light.Subframe;
+        work.BitsPerPixel = light.BitsPerPixel;
+    };
+
+    Guider *guider = pFrame->pGuider;
+    int searchRegion = guider->GetSearchRegion();
+    double minHFD = guider->GetMinStarHFD();
+    double maxHFD = guider->GetMaxStarHFD();
+    unsigned short saturation = pCamera->GetSaturationADU();
+    int cx = size.x / 2, cy = size.y / 2;
+
+    const struct
+    {
+        Star::FindMode mode;
+        const char *name;
+    } modes[] = {
+        { Star::FIND_CENTROID, "centroid" },
+        { Star::FIND_PEAK, "peak" },
+    };
+    for (const auto& m : modes)
+    {
+        Star star;
+        results->push_back(Measure("Star::Find", m.name, megapixels, size, nullptr, [&]() {
+            star.Find(&light, searchRegion, cx, cy, m.mode, minHFD, maxHFD, saturation, Star::FIND_LOGGING_MINIMAL);
+        }));
+    }
+
+    {
+        std::vector<GuideStar> stars;
+        results->push_back(Measure("GuideStar::AutoFind", "", megapixels, size, nullptr, [&]() {
+            GuideStar star;
+            stars.clear();
+            star.AutoFind(light, 0, searchRegion, wxRect(), stars, 9);
+        }));
+    }
+
+    results->push_back(Measure("Median3", "", megapixels, size, restore, [&]() { Median3(work); }));
+    results->push_back(Measure("QuickLRecon", "", megapixels, size, restore, [&]() { QuickLRecon(work); }));
+    results->push_back(Measure("Subtract", "", megapixels, size, restore, [&]() { Subtract(work, dark); }));
+
+    {
+        DefectMap defects;
+        std::mt19937 rng(4);
+        std::uniform_int_distribution<int> xpos(0, size.x - 1), ypos(0, size.y - 1);
+        for (unsigned int i = 0; i < light.NPixels / 2000; i++)
+            defects.AddDefect(wxPoint(xpos(rng), ypos(rng)));
+        results->push_back(Measure("RemoveDefects", "", megapixels, size, restore, [&]() { RemoveDefects(work, defects); }));
+    }
+
+    results->push_back(Measure("usImage::CalcStats", "", megapixels, size, nullptr, [&]() { light.CalcStats(); }));
+
+    {
+        wxImage *disp = nullptr;
+        results->push_back(Measure("usImage::CopyToImage", "", megapixels, size, nullptr, [&]() {
+            light.CopyToImage(&disp, light.FiltMin, light.FiltMax, 1.0);
+        }));
+        delete disp;
+    }
+
+    {
+        usImage rotated;
+        results->push_back(Measure("usImage::Rotate", "", megapixels, size, [&]() { rotated.CopyFrom(light); },
+                                   [&]() { rotated.Rotate(0.3); }));
+    }
+
+    {
+        usImage stretched;
+        results->push_back(Measure("SquarePixels", "", megapixels, size, [&]() { stretched.CopyFrom(light); },
+                                   [&]() { SquarePixels(stretched, 8.6f, 8.3f); }));
+    }
+
+    {
+        DefectMapDarks darks;
+        darks.masterDark.CopyFrom(dark);
+        results->push_back(Measure("DefectMapBuilder", "", megapixels, size, nullptr, [&]() {
+            darks.BuildFilteredDark();
+            DefectMapBuilder builder;
+            builder.Init(darks);
+            DefectMap map;
+            builder.BuildDefectMap(map, false);
+        }));
+    }
+}
+
+wxString ToJson(const std::vector<BenchResult>& results)
+{
+    wxString s;
+    s += "{\n";
+    s += wxString::Format("  \"version\": \"%s%s\",\n", PHDVERSION, PHDSUBVER);
+    s += wxString::Format("  \"threads\": %u,\n", ThreadPool::Concurrency());
+    s += wxString::Format("  \"timestamp\": \"%s\",\n", wxDateTime::UNow().FormatISOCombined());
+    s += "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& r = results[i];
+        s += wxString::Format("    { \"kernel\": \"%s\", \"variant\": \"%s\", \"megapixels\": %.0f, \"width\": %d, "
+                              "\"height\": %d, \"iterations\": %u, \"median_ms\": %.4f, \"min_ms\": %.4f }%s\n",
+                              r.kernel, r.variant, r.megapixels, r.size.x, r.size.y, r.iterations, r.medianMs, r.minMs,
+                              i + 1 < results.size() ? "," : "");
+    }
+    s += "  ]\n";
+    s += "}\n";
+    return s;
+}
+} // namespace
+
+int ImageBench::Run(const wxString& outputFile)
+{
+    Debug.Write(wxString::Format("Bench: starting, output %s\n", outputFile));
+
+    HeadlessCamera camera;
+    GuideCamera *prevCamera = pCamera;
+    pCamera = &camera;
+
+    std::vector<BenchResult> results;
+    for (double megapixels : FRAME_MEGAPIXELS)
+        BenchFrameSize(megapixels, &results);
+
+    pCamera = prevCamera;
+
+    wxFFile file(outputFile, "w");
+    if (!file.IsOpened() || !file.Write(ToJson(results)) || !file.Close())
+    {
+        wxPrintf("bench: cannot write %s\n", outputFile);
+        return 1;
+    }
+
+    wxPrintf("bench: results written to %s\n", outputFile);
+    return 0;
+}
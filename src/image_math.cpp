@@ -34,12 +34,17 @@
 
 #include "phd.h"
 #include "image_math.h"
+#include "image_transform.h"
+#include "median_filter.h"
+#include "thread_pool.h"
 
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
 #include <wx/tokenzr.h>
 
 #include <algorithm>
+#include <cstring>
+#include <memory>
 
 int dbl_sort_func(double *first, double *second)
 {
@@ -76,17 +81,24 @@ double CalcSlope(const ArrayOfDbl& y)
     return (n * s_xy - (s_x * s_y)) / (n * s_xx - (s_x * s_x));
 }
 
+// allocate a scratch image with the same pixel layout as img
+static bool init_like(usImage& tmp, const usImage& img)
+{
+    return img.HasSubframeStorage() ? tmp.InitSubframe(img.Size, img.Storage) : tmp.Init(img.Size);
+}
+
 bool QuickLRecon(usImage& img)
 {
     // Does a simple debayer of luminance data only -- sliding 2x2 window
     usImage tmp;
-    if (tmp.Init(img.Size))
+    if (init_like(tmp, img))
     {
         pFrame->Alert(_("Memory allocation error"));
         return true;
     }
 
-    int const W = img.Size.GetWidth();
+    // pixel data is indexed relative to the stored area of the frame
+    int const W = img.Storage.GetWidth();
     int RX, RY, RW, RH;
     if (img.Subframe.IsEmpty())
     {
@@ -96,8 +108,8 @@ bool QuickLRecon(usImage& img)
     }
     else
     {
-        RX = img.Subframe.GetX();
-        RY = img.Subframe.GetY();
+        RX = img.Subframe.GetX() - img.Storage.GetX();
+        RY = img.Subframe.GetY() - img.Storage.GetY();
         RW = img.Subframe.GetWidth();
         RH = img.Subframe.GetHeight();
         tmp.Clear();
@@ -151,7 +163,7 @@ bool Median3(usImage& img)
 {
     usImage tmp;
 
-    if (tmp.Init(img.Size))
+    if (init_like(tmp, img))
     {
         Debug.Write("Median3: ERROR: memory allocation failure!\n");
         return true;
@@ -163,8 +175,11 @@ bool Median3(usImage& img)
     }
     else
     {
-        tmp.Clear();
-        Median3(tmp.ImageData, img.ImageData, img.Size, img.Subframe);
+        wxRect rect(img.Subframe);
+        rect.Offset(-img.Storage.GetLeftTop());
+        if (!img.HasSubframeStorage())
+            tmp.Clear();
+        Median3(tmp.ImageData, img.ImageData, img.Storage.GetSize(), rect);
     }
 
     img.SwapImageData(tmp);
@@ -507,8 +522,12 @@ void Median3(unsigned short *dst, const unsigned short *src, const wxSize& size,
 static unsigned short MedianBorderingPixels(const usImage& img, int x, int y)
 {
     unsigned short array[8];
-    int const xsize = img.Size.GetWidth();
-    int const ysize = img.Size.GetHeight();
+
+    // the edges of the stored area are treated as the edges of the image
+    int const xsize = img.Storage.GetWidth();
+    int const ysize = img.Storage.GetHeight();
+    x -= img.Storage.GetX();
+    y -= img.Storage.GetY();
 
     if (x > 0 && y > 0 && x < xsize - 1 && y < ysize - 1)
     {
@@ -613,34 +632,14 @@ bool SquarePixels(usImage& img, float xsize, float ysize)
     if (xsize <= ysize)
         return false;
 
-    // Move the existing data to a temp image
-    usImage tempimg;
-    if (tempimg.Init(img.Size))
-    {
-        pFrame->Alert(_("Memory allocation error"));
-        return true;
-    }
-    tempimg.SwapImageData(img);
-
     // if X > Y, when viewing stock, Y is unnaturally stretched, so stretch X to match
     double ratio = ysize / xsize;
-    int newsize = ROUND((double) tempimg.Size.GetWidth() / ratio); // make new image correct size
-    img.Init(newsize, tempimg.Size.GetHeight());
-    unsigned short *optr = img.ImageData;
-    int linesize = tempimg.Size.GetWidth(); // size of an original line
-    for (int y = 0; y < img.Size.GetHeight(); y++)
+    int newsize = ROUND((double) img.Size.GetWidth() / ratio); // make new image correct size
+
+    if (ResizeImage(img, wxSize(newsize, img.Size.GetHeight())))
     {
-        for (int x = 0; x < newsize; x++, optr++)
-        {
-            double oldposition = x * ratio;
-            int ind1 = (unsigned int) floor(oldposition);
-            int ind2 = (unsigned int) ceil(oldposition);
-            if (ind2 > (tempimg.Size.GetWidth() - 1))
-                ind2 = tempimg.Size.GetWidth() - 1;
-            double weight = ceil(oldposition) - oldposition;
-            *optr = (unsigned short) (((float) *(tempimg.ImageData + y * linesize + ind1) * weight) +
-                                      ((float) *(tempimg.ImageData + y * linesize + ind1) * (1.0 - weight)));
-        }
+        pFrame->Alert(_("Memory allocation error"));
+        return true;
     }
 
     return false;
@@ -687,6 +686,36 @@ static unsigned short median_value_in_roi(const usImage& dark, const wxRect& roi
     return median;
 }
 
+// the areas of the light and of the dark that are subtracted, each in its own frame's coordinates
+static void subtraction_rois(const usImage& light, wxRect *light_roi, wxRect *dark_roi)
+{
+    const wxRect& limit_frame = light.LimitFrame;
+    if (!light.Subframe.IsEmpty())
+    {
+        *dark_roi = *light_roi = light.Subframe;
+        dark_roi->Offset(limit_frame.GetLeftTop());
+    }
+    else if (!limit_frame.IsEmpty())
+    {
+        *dark_roi = limit_frame;
+        *light_roi = wxRect(light.Size);
+    }
+    else
+    {
+        *dark_roi = *light_roi = wxRect(light.Size);
+    }
+}
+
+unsigned short DarkMedian(const usImage& light, const usImage& dark)
+{
+    if (light.Subframe.IsEmpty() && light.LimitFrame.IsEmpty())
+        return dark.MedianADU; // use the pre-computed full frame median ADU
+
+    wxRect light_roi, dark_roi;
+    subtraction_rois(light, &light_roi, &dark_roi);
+    return median_value_in_roi(dark, dark_roi);
+}
+
 // Dark subtraction algorithm:
 //     Pedestal = max(median(dark_frame) - median(light_frame), 0) - handles overall gain/gradient differences
 //     Dark_corrected(i) = min(max(light(i) + pedestal - dark(i), 0), 65335)
@@ -697,28 +726,18 @@ bool Subtract(usImage& light, const usImage& dark)
     if (!IsLightFrameCompatibleWithDarkFrame(light, dark))
         return true;
 
-    const wxRect& limit_frame = light.LimitFrame;
-    unsigned short median_light, median_dark;
-    median_light = light.MedianADU; // median of frame or subframe
+    return Subtract(light, dark, DarkMedian(light, dark));
+}
+
+bool Subtract(usImage& light, const usImage& dark, unsigned short median_dark)
+{
+    if (!light.ImageData || !dark.ImageData)
+        return true;
+
+    unsigned short median_light = light.MedianADU; // median of frame or subframe
 
     wxRect light_roi, dark_roi;
-    if (!light.Subframe.IsEmpty())
-    {
-        dark_roi = light_roi = light.Subframe;
-        dark_roi.Offset(limit_frame.GetLeftTop());
-        median_dark = median_value_in_roi(dark, dark_roi);
-    }
-    else if (!limit_frame.IsEmpty())
-    {
-        dark_roi = limit_frame;
-        light_roi = wxRect(light.Size);
-        median_dark = median_value_in_roi(dark, limit_frame);
-    }
-    else
-    {
-        dark_roi = light_roi = wxRect(light.Size);
-        median_dark = dark.MedianADU; // use the pre-computed full frame median ADU
-    }
+    subtraction_rois(light, &light_roi, &dark_roi);
 
     if (median_dark > median_light)
     {
@@ -730,7 +749,7 @@ bool Subtract(usImage& light, const usImage& dark)
     const unsigned short *pd0 = &dark.Pixel(dark_roi.x, dark_roi.y);
     const unsigned int height = light_roi.height;
     const unsigned int width = light_roi.width;
-    for (unsigned int r = 0; r < height; r++, pl0 += light.Size.GetWidth(), pd0 += dark.Size.GetWidth())
+    for (unsigned int r = 0; r < height; r++, pl0 += light.Storage.GetWidth(), pd0 += dark.Storage.GetWidth())
     {
         unsigned short *const endl = pl0 + width;
         unsigned short *pl;
@@ -749,161 +768,188 @@ bool Subtract(usImage& light, const usImage& dark)
     return false;
 }
 
-inline static unsigned short histo_median(unsigned short histo1[256], unsigned short histo2[65536], int n)
+// Runs fn over count items on the thread pool. When there is a progress function the items are
+// run in batches, and progress, scaled into [lo, hi], is reported and a cancel request checked on
+// the calling thread between batches. Returns true if the computation was cancelled.
+static bool ParallelForWithProgress(unsigned int count, const std::function<void(unsigned int)>& fn,
+                                    const ImageProgressFn& progress, int lo, int hi)
 {
-    n /= 2;
-    unsigned int i;
-    for (i = 0; i < 256; i++)
-    {
-        if (histo1[i] > n)
-            break;
-        n -= histo1[i];
-    }
-    for (i <<= 8; i < 65536; i++)
+    unsigned int batch = progress ? ThreadPool::Concurrency() * 2 : count;
+
+    for (unsigned int start = 0; start < count; start += batch)
     {
-        if (histo2[i] > n)
-            break;
-        n -= histo2[i];
+        unsigned int n = std::min(batch, count - start);
+        ThreadPool::ParallelFor(n, [&](unsigned int i) { fn(start + i); });
+        if (progress && progress(lo + (int) ((long long) (hi - lo) * (start + n) / count)))
+            return true;
     }
-    return i;
+
+    return false;
 }
 
-static void MedianFilter(usImage& dst, const usImage& src, int halfWidth)
+enum
+{
+    MEDIAN_BAND_ROWS = 32, // rows of the image filtered by one work item
+};
+
+static bool MedianFilter(usImage& dst, const usImage& src, int halfWidth, const ImageProgressFn& progress)
 {
     dst.Init(src.Size);
-    unsigned short *d = &dst.ImageData[0];
 
-    int const width = src.Size.GetWidth();
     int const height = src.Size.GetHeight();
-
-    for (int y = 0; y < height; y++)
-    {
-        int top = std::max(0, y - halfWidth);
-        int bot = std::min(y + halfWidth, height - 1);
-        int left = 0;
-        int right = halfWidth;
-
-        // TODO: we initialize the histogram at the start of each row, but we could make this faster
-        // if we scan left to right, move down, scan right to left, move down so we never need to
-        // reinitialize the histogram
-
-        // initialize 2-level histogram
-        unsigned short histo1[256];
-        unsigned short histo2[65536];
-        memset(&histo1[0], 0, sizeof(histo1));
-        memset(&histo2[0], 0, sizeof(histo2));
-
-        for (int j = top; j <= bot; j++)
-        {
-            const unsigned short *p = &src.Pixel(left, j);
-            for (int i = left; i <= right; i++, p++)
-            {
-                ++histo1[*p >> 8];
-                ++histo2[*p];
-            }
-        }
-        unsigned int n = (right - left + 1) * (bot - top + 1);
-
-        // read off first value for this row
-        *d++ = histo_median(histo1, histo2, n);
-
-        // loop across remaining columns for this row
-        for (int i = 1; i < width; i++)
-        {
-            left = std::max(0, i - halfWidth);
-            right = std::min(i + halfWidth, width - 1);
-
-            // remove leftmost column
-            if (left > 0)
-            {
-                const unsigned short *p = &src.Pixel(left - 1, top);
-                for (int j = top; j <= bot; j++, p += width)
-                {
-                    --histo1[*p >> 8];
-                    --histo2[*p];
-                }
-                n -= (bot - top + 1);
-            }
-
-            // add new column on right
-            if (i + halfWidth <= width - 1)
-            {
-                const unsigned short *p = &src.Pixel(right, top);
-                for (int j = top; j <= bot; j++, p += width)
-                {
-                    ++histo1[*p >> 8];
-                    ++histo2[*p];
-                }
-                n += (bot - top + 1);
-            }
-
-            *d++ = histo_median(histo1, histo2, n);
-        }
-    }
+    unsigned int bands = (height + MEDIAN_BAND_ROWS - 1) / MEDIAN_BAND_ROWS;
+
+    return ParallelForWithProgress(
+        bands,
+        [&](unsigned int band) {
+            int y0 = band * MEDIAN_BAND_ROWS;
+            int y1 = std::min(y0 + MEDIAN_BAND_ROWS, height);
+            std::unique_ptr<MedianHisto> h(new MedianHisto()); // too big for the stack
+            MedianFilterRows(dst.ImageData, src.ImageData, src.Size.GetWidth(), height, halfWidth, y0, y1, *h);
+        },
+        progress, 0, 100);
 }
 
-struct ImageStatsWork
+enum
 {
-    ImageStats stats;
-    usImage temp;
+    STATS_BAND_ROWS = 64, // rows of the image scanned by one work item
 };
 
-static void GetImageStats(ImageStatsWork& w, const usImage& img, const wxRect& win)
+// Mean, standard deviation, median and median absolute deviation of the pixels in a window of an
+// image. The window is split into bands of rows that are scanned in parallel: a first pass
+// collects each band's pixel sum and histogram, and with the mean known a second pass sums the
+// squared deviations. The median and MAD are read off the merged histogram, so the image is
+// neither copied nor sorted. Returns true if cancelled.
+static bool GetImageStats(ImageStats *stats, const usImage& img, const wxRect& win, const ImageProgressFn& progress)
 {
-    w.temp.Init(img.Size);
+    int const winPixels = win.GetWidth() * win.GetHeight();
+    if (winPixels <= 0)
+        return false;
 
-    // Determine the mean and standard deviation
-    double a = 0.0;
-    double q = 0.0;
-    double k = 1.0;
-    double km1 = 0.0;
+    unsigned int bands = (win.GetHeight() + STATS_BAND_ROWS - 1) / STATS_BAND_ROWS;
 
-    const unsigned short *p0 = &img.Pixel(win.GetLeft(), win.GetTop());
-    unsigned short *dst = &w.temp.ImageData[0];
-    for (int y = 0; y < win.GetHeight(); y++)
+    std::vector<unsigned long long> sums(bands, 0);
+    std::vector<std::vector<unsigned int>> histos(bands);
+
+    auto bandRows = [&](unsigned int band, int *y0, int *y1) {
+        *y0 = win.GetTop() + band * STATS_BAND_ROWS;
+        *y1 = std::min(*y0 + STATS_BAND_ROWS, win.GetBottom() + 1);
+    };
+
+    if (ParallelForWithProgress(
+            bands,
+            [&](unsigned int band) {
+                int y0, y1;
+                bandRows(band, &y0, &y1);
+                std::vector<unsigned int>& histo = histos[band];
+                histo.assign(65536, 0);
+                unsigned long long sum = 0;
+                for (int y = y0; y < y1; y++)
+                {
+                    const unsigned short *p = &img.Pixel(win.GetLeft(), y);
+                    const unsigned short *end = p + win.GetWidth();
+                    for (; p < end; p++)
+                    {
+                        sum += *p;
+                        ++histo[*p];
+                    }
+                }
+                sums[band] = sum;
+            },
+            progress, 0, 60))
     {
-        const unsigned short *end = p0 + win.GetWidth();
-        for (const unsigned short *p = p0; p < end; p++)
-        {
-            *dst++ = *p;
-            double const x = (double) *p;
-            double const a0 = a;
-            a += (x - a) / k;
-            q += (x - a0) * (x - a);
-            km1 = k;
-            k += 1.0;
-        }
-        p0 += img.Size.GetWidth();
+        return true;
     }
 
-    w.stats.mean = a;
-    w.stats.stdev = sqrt(q / km1);
+    unsigned long long sum = 0;
+    for (unsigned long long s : sums)
+        sum += s;
+    double const mean = (double) sum / winPixels;
 
-    int winPixels = win.GetWidth() * win.GetHeight();
-    unsigned short *tmp = &w.temp.ImageData[0];
-    std::nth_element(tmp, tmp + winPixels / 2, tmp + winPixels);
+    std::vector<double> sqdevs(bands, 0.0);
 
-    w.stats.median = tmp[winPixels / 2];
+    if (ParallelForWithProgress(
+            bands,
+            [&](unsigned int band) {
+                int y0, y1;
+                bandRows(band, &y0, &y1);
+                double q = 0.0;
+                for (int y = y0; y < y1; y++)
+                {
+                    const unsigned short *p = &img.Pixel(win.GetLeft(), y);
+                    const unsigned short *end = p + win.GetWidth();
+                    for (; p < end; p++)
+                    {
+                        double const d = (double) *p - mean;
+                        q += d * d;
+                    }
+                }
+                sqdevs[band] = q;
+            },
+            progress, 60, 90))
+    {
+        return true;
+    }
 
-    // replace each pixel with the absolute deviation from the median
-    unsigned short *p = tmp;
-    for (int i = 0; i < winPixels; i++)
+    double q = 0.0;
+    for (double s : sqdevs)
+        q += s;
+
+    stats->mean = mean;
+    stats->stdev = sqrt(q / winPixels);
+
+    // merge the band histograms
+    std::vector<unsigned int> histo(65536, 0);
+    for (const std::vector<unsigned int>& h : histos)
+        for (unsigned int i = 0; i < 65536; i++)
+            histo[i] += h[i];
+
+    // the median is the pixel at position winPixels / 2 in sorted order
+    int const mid = winPixels / 2;
+    int n = 0;
+    unsigned int median = 0;
+    while (n + (int) histo[median] <= mid)
+        n += histo[median++];
+    stats->median = (unsigned short) median;
+
+    // absolute deviations from the median: deviation d comes from the pixels at median - d and
+    // median + d
+    n = 0;
+    unsigned int mad = 0;
+    for (;; mad++)
     {
-        unsigned short ad = (unsigned short) std::abs((int) *p - (int) w.stats.median);
-        *p++ = ad;
+        int cnt = mad == 0 ? histo[median] : 0;
+        if (mad > 0 && mad <= median)
+            cnt += histo[median - mad];
+        if (mad > 0 && median + mad < 65536)
+            cnt += histo[median + mad];
+        if (n + cnt > mid)
+            break;
+        n += cnt;
     }
-    std::nth_element(tmp, tmp + winPixels / 2, tmp + winPixels);
-    w.stats.mad = tmp[winPixels / 2];
+    stats->mad = (unsigned short) mad;
+
+    return false;
 }
 
-void DefectMapDarks::BuildFilteredDark()
+bool DefectMapDarks::BuildFilteredDark(const ImageProgressFn& progress)
 {
     enum
     {
         WINDOW = 15
     };
-    filteredDark.Init(masterDark.Size);
-    MedianFilter(filteredDark, masterDark, WINDOW);
+
+    wxStopWatch swatch;
+
+    if (MedianFilter(filteredDark, masterDark, WINDOW, progress))
+    {
+        Debug.Write("BuildFilteredDark: cancelled\n");
+        return true;
+    }
+
+    Debug.Write(wxString::Format("BuildFilteredDark: %dx%d filtered in %ld ms\n", masterDark.Size.GetWidth(),
+                                 masterDark.Size.GetHeight(), swatch.Time()));
+    return false;
 }
 
 static wxString DefectMapMasterPath(int profileId)
@@ -957,7 +1003,7 @@ typedef std::set<BadPx> BadPxSet;
 struct DefectMapBuilderImpl
 {
     DefectMapDarks *darks;
-    ImageStatsWork w;
+    ImageStats stats;
     wxArrayString mapInfo;
     int aggrCold;
     int aggrHot;
@@ -985,16 +1031,36 @@ inline static double AggrToSigma(int val)
     return exp2(3.0 - (6.0 / 100.0) * (double) val);
 }
 
-void DefectMapBuilder::Init(DefectMapDarks& darks)
+enum
+{
+    DEFECT_SCAN_BAND_ROWS = 64, // rows of the dark scanned for potential defects by one work item
+};
+
+bool DefectMapBuilder::Init(DefectMapDarks& darks, const ImageProgressFn& progress)
 {
     m_impl->darks = &darks;
+    m_impl->threshValid = false;
 
     Debug.AddLine("DefectMapBuilder: Init");
 
-    ::GetImageStats(m_impl->w, darks.masterDark,
-                    wxRect(0, 0, darks.masterDark.Size.GetWidth(), darks.masterDark.Size.GetHeight()));
+    wxStopWatch swatch;
+
+    m_impl->coldPx.clear();
+    m_impl->hotPx.clear();
+
+    // statistics take the first half of the progress range, the defect scan the second half
+    ImageProgressFn statsProgress;
+    if (progress)
+        statsProgress = [&progress](int pct) { return progress(pct / 2); };
 
-    const ImageStats& stats = m_impl->w.stats;
+    if (::GetImageStats(&m_impl->stats, darks.masterDark,
+                        wxRect(0, 0, darks.masterDark.Size.GetWidth(), darks.masterDark.Size.GetHeight()), statsProgress))
+    {
+        Debug.AddLine("DefectMapBuilder: Init cancelled");
+        return true;
+    }
+
+    const ImageStats& stats = m_impl->stats;
 
     Debug.Write(wxString::Format("DefectMapBuilder: Dark N = %u Mean = %.f Median = %d Standard Deviation = %.f MAD=%d\n",
                                  darks.masterDark.NPixels, stats.mean, stats.median, stats.stdev, stats.mad));
@@ -1005,36 +1071,56 @@ void DefectMapBuilder::Init(DefectMapDarks& darks)
 
     Debug.Write(wxString::Format("DefectMapBuilder: load potential defects thresh = %d\n", thresh));
 
-    usImage& dark = m_impl->darks->masterDark;
-    usImage& medianFilt = m_impl->darks->filteredDark;
-
-    m_impl->coldPx.clear();
-    m_impl->hotPx.clear();
+    const usImage& dark = m_impl->darks->masterDark;
+    const usImage& medianFilt = m_impl->darks->filteredDark;
+
+    // scan bands of rows in parallel, then add the candidates to the sets in row-major order, the
+    // order they would be found by a serial scan
+    int const height = dark.Size.GetHeight();
+    int const width = dark.Size.GetWidth();
+    unsigned int bands = (height + DEFECT_SCAN_BAND_ROWS - 1) / DEFECT_SCAN_BAND_ROWS;
+    std::vector<std::vector<BadPx>> hot(bands), cold(bands);
+
+    if (ParallelForWithProgress(
+            bands,
+            [&](unsigned int band) {
+                int y0 = band * DEFECT_SCAN_BAND_ROWS;
+                int y1 = std::min(y0 + DEFECT_SCAN_BAND_ROWS, height);
+                for (int y = y0; y < y1; y++)
+                {
+                    const unsigned short *pd = &dark.Pixel(0, y);
+                    const unsigned short *pf = &medianFilt.Pixel(0, y);
+                    for (int x = 0; x < width; x++)
+                    {
+                        int v = (int) pd[x] - (int) pf[x];
+                        if (v > thresh)
+                            hot[band].push_back(BadPx(x, y, v));
+                        else if (-v > thresh)
+                            cold[band].push_back(BadPx(x, y, -v));
+                    }
+                }
+            },
+            progress, 50, 100))
+    {
+        Debug.AddLine("DefectMapBuilder: Init cancelled");
+        return true;
+    }
 
-    for (int y = 0; y < dark.Size.GetHeight(); y++)
+    for (unsigned int band = 0; band < bands; band++)
     {
-        for (int x = 0; x < dark.Size.GetWidth(); x++)
-        {
-            int filt = (int) medianFilt.Pixel(x, y);
-            int val = (int) dark.Pixel(x, y);
-            int v = val - filt;
-            if (v > thresh)
-            {
-                m_impl->hotPx.insert(BadPx(x, y, v));
-            }
-            else if (-v > thresh)
-            {
-                m_impl->coldPx.insert(BadPx(x, y, -v));
-            }
-        }
+        m_impl->hotPx.insert(hot[band].begin(), hot[band].end());
+        m_impl->coldPx.insert(cold[band].begin(), cold[band].end());
     }
 
-    Debug.Write(wxString::Format("DefectMapBuilder: Loaded %d cold %d hot\n", m_impl->coldPx.size(), m_impl->hotPx.size()));
+    Debug.Write(wxString::Format("DefectMapBuilder: Loaded %d cold %d hot in %ld ms\n", m_impl->coldPx.size(),
+                                 m_impl->hotPx.size(), swatch.Time()));
+
+    return false;
 }
 
 const ImageStats& DefectMapBuilder::GetImageStats() const
 {
-    return m_impl->w.stats;
+    return m_impl->stats;
 }
 
 void DefectMapBuilder::SetAggressiveness(int aggrCold, int aggrHot)
@@ -1052,8 +1138,8 @@ static void FindThresh(DefectMapBuilderImpl *impl)
     double multCold = AggrToSigma(impl->aggrCold);
     double multHot = AggrToSigma(impl->aggrHot);
 
-    int coldThresh = (int) (multCold * impl->w.stats.stdev);
-    int hotThresh = (int) (multHot * impl->w.stats.stdev);
+    int coldThresh = (int) (multCold * impl->stats.stdev);
+    int hotThresh = (int) (multHot * impl->stats.stdev);
 
     Debug.Write(wxString::Format("DefectMap: find thresholds aggr:(%d,%d) sigma:(%.1f,%.1f) px:(%+d,%+d)\n", impl->aggrCold,
                                  impl->aggrHot, multCold, multHot, -coldThresh, hotThresh));
@@ -1081,11 +1167,16 @@ int DefectMapBuilder::GetHotPixelCnt() const
     return m_impl->hotPxSelected;
 }
 
-inline static unsigned int emit_defects(DefectMap& defectMap, BadPxSet::const_iterator p0, BadPxSet::const_iterator p1,
-                                        double stdev, int sign, bool verbose)
+enum
+{
+    EMIT_PROGRESS_INTERVAL = 4096, // defects emitted between progress reports
+};
+
+// returns true if cancelled by the progress function
+inline static bool emit_defects(DefectMap& defectMap, BadPxSet::const_iterator p0, BadPxSet::const_iterator p1, double stdev,
+                                int sign, bool verbose, unsigned int total, const ImageProgressFn& progress)
 {
-    unsigned int cnt = 0;
-    for (BadPxSet::const_iterator it = p0; it != p1; ++it, ++cnt)
+    for (BadPxSet::const_iterator it = p0; it != p1; ++it)
     {
         if (verbose)
         {
@@ -1094,17 +1185,23 @@ inline static unsigned int emit_defects(DefectMap& defectMap, BadPxSet::const_it
                                          stdev > 0.1 ? (double) v / stdev : 0.0));
         }
         defectMap.push_back(wxPoint(it->x, it->y));
+
+        if (progress && defectMap.size() % EMIT_PROGRESS_INTERVAL == 0 &&
+            progress((int) ((unsigned long long) defectMap.size() * 100 / total)))
+        {
+            return true;
+        }
     }
-    return cnt;
+    return false;
 }
 
-void DefectMapBuilder::BuildDefectMap(DefectMap& defectMap, bool verbose) const
+bool DefectMapBuilder::BuildDefectMap(DefectMap& defectMap, bool verbose, const ImageProgressFn& progress) const
 {
     wxArrayString& info = m_impl->mapInfo;
 
     double multCold = AggrToSigma(m_impl->aggrCold);
     double multHot = AggrToSigma(m_impl->aggrHot);
-    const ImageStats& stats = m_impl->w.stats;
+    const ImageStats& stats = m_impl->stats;
 
     info.Clear();
     info.push_back(wxString::Format("Generated: %s", wxDateTime::UNow().FormatISOCombined(' ')));
@@ -1132,12 +1229,25 @@ void DefectMapBuilder::BuildDefectMap(DefectMap& defectMap, bool verbose) const
     FindThresh(m_impl);
 
     defectMap.clear();
-    unsigned int nr_cold = emit_defects(defectMap, m_impl->coldPxThresh, m_impl->coldPx.end(), stats.stdev, -1, verbose);
-    unsigned int nr_hot = emit_defects(defectMap, m_impl->hotPxThresh, m_impl->hotPx.end(), stats.stdev, +1, verbose);
+    unsigned int total = m_impl->coldPxSelected + m_impl->hotPxSelected;
+    if (emit_defects(defectMap, m_impl->coldPxThresh, m_impl->coldPx.end(), stats.stdev, -1, verbose, total, progress))
+    {
+        defectMap.clear();
+        return true;
+    }
+    unsigned int nr_cold = defectMap.size();
+    if (emit_defects(defectMap, m_impl->hotPxThresh, m_impl->hotPx.end(), stats.stdev, +1, verbose, total, progress))
+    {
+        defectMap.clear();
+        return true;
+    }
+    unsigned int nr_hot = defectMap.size() - nr_cold;
 
     if (verbose)
         Debug.Write(
             wxString::Format("New defect map created, count=%d (cold=%d, hot=%d)\n", defectMap.size(), nr_cold, nr_hot));
+
+    return false;
 }
 
 const wxArrayString& DefectMapBuilder::GetMapInfo() const
@@ -1194,6 +1304,117 @@ wxString DefectMap::DefectMapFileName(int profileId)
         wxString::Format("PHD2_defect_map%s_%d.txt", inst > 1 ? wxString::Format("_%d", inst) : "", profileId);
 }
 
+// The defect map text file is the master copy: it is what the user edits and what AddDefect
+// appends to. A binary copy of the points is kept next to it so the map can be loaded with a
+// single read; the binary copy records the size and modification time of the text file it was
+// made from and is rebuilt whenever they no longer match.
+
+static const char DefectMapMagic[8] = { 'P', 'H', 'D', '2', 'D', 'M', 'A', 'P' };
+
+enum
+{
+    DefectMapBinaryVersion = 1,
+};
+
+struct DefectMapBinaryHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    int64_t sourceSize; // size and modification time of the text file the points came from
+    int64_t sourceTime;
+};
+
+static wxString DefectMapBinaryFileName(const wxString& textFile)
+{
+    wxFileName fn(textFile);
+    fn.SetExt("bpm");
+    return fn.GetFullPath();
+}
+
+static void GetDefectMapSourceInfo(const wxString& textFile, int64_t *size, int64_t *mtime)
+{
+    wxFileName fn(textFile);
+    *size = (int64_t) fn.GetSize().GetValue();
+    *mtime = (int64_t) fn.GetModificationTime().GetTicks();
+}
+
+static void SaveBinaryDefectMap(const DefectMap& defectMap, const wxString& textFile)
+{
+    wxString binFile = DefectMapBinaryFileName(textFile);
+    wxString tmpFile = binFile + ".tmp";
+
+    DefectMapBinaryHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, DefectMapMagic, sizeof(DefectMapMagic));
+    hdr.version = DefectMapBinaryVersion;
+    hdr.count = defectMap.size();
+    GetDefectMapSourceInfo(textFile, &hdr.sourceSize, &hdr.sourceTime);
+
+    std::vector<int32_t> pts;
+    pts.reserve(defectMap.size() * 2);
+    for (const wxPoint& pt : defectMap)
+    {
+        pts.push_back(pt.x);
+        pts.push_back(pt.y);
+    }
+
+    wxFile out;
+    size_t bytes = pts.size() * sizeof(int32_t);
+    if (!out.Create(tmpFile, true) || out.Write(&hdr, sizeof(hdr)) != sizeof(hdr) || out.Write(pts.data(), bytes) != bytes ||
+        !out.Close() || !wxRenameFile(tmpFile, binFile, true))
+    {
+        Debug.AddLine(wxString::Format("Failed to save binary defect map %s", binFile));
+        out.Close();
+        if (wxFileExists(tmpFile))
+            wxRemoveFile(tmpFile);
+    }
+}
+
+// load the binary copy of the defect map text file; returns false if there is no usable copy
+static bool LoadBinaryDefectMap(DefectMap *defectMap, const wxString& textFile)
+{
+    wxString binFile = DefectMapBinaryFileName(textFile);
+    if (!wxFileExists(binFile))
+        return false;
+
+    wxFile in(binFile);
+    wxFileOffset len = in.IsOpened() ? in.Length() : wxInvalidOffset;
+    if (len < (wxFileOffset) sizeof(DefectMapBinaryHeader))
+        return false;
+
+    std::vector<char> buf(len);
+    if (in.Read(buf.data(), buf.size()) != (ssize_t) buf.size())
+        return false;
+
+    DefectMapBinaryHeader hdr;
+    memcpy(&hdr, buf.data(), sizeof(hdr));
+
+    int64_t sourceSize, sourceTime;
+    GetDefectMapSourceInfo(textFile, &sourceSize, &sourceTime);
+
+    if (memcmp(hdr.magic, DefectMapMagic, sizeof(DefectMapMagic)) != 0 || hdr.version != DefectMapBinaryVersion ||
+        hdr.sourceSize != sourceSize || hdr.sourceTime != sourceTime ||
+        sizeof(hdr) + (uint64_t) hdr.count * 2 * sizeof(int32_t) != buf.size())
+    {
+        Debug.AddLine(wxString::Format("Binary defect map %s is out of date", binFile));
+        return false;
+    }
+
+    const char *p = buf.data() + sizeof(hdr);
+    defectMap->resize(hdr.count);
+    for (wxPoint& pt : *defectMap)
+    {
+        int32_t xy[2];
+        memcpy(xy, p, sizeof(xy));
+        p += sizeof(xy);
+        pt.x = xy[0];
+        pt.y = xy[1];
+    }
+
+    return true;
+}
+
 bool DefectMap::ImportFromProfile(int srcId, int destId)
 {
     wxString sourceName;
@@ -1301,6 +1522,8 @@ void DefectMap::Save(const wxArrayString& info) const
 
     oStream.Close();
     Debug.AddLine(wxString::Format("Saved defect map to %s", filename));
+
+    SaveBinaryDefectMap(*this, filename);
 }
 
 DefectMap::DefectMap() : m_profileId(pConfig->GetCurrentProfileId()) { }
@@ -1345,6 +1568,17 @@ DefectMap *DefectMap::LoadDefectMap(int profileId)
         return 0;
     }
 
+    wxStopWatch swatch;
+
+    DefectMap *defectMap = new DefectMap(profileId);
+
+    if (LoadBinaryDefectMap(defectMap, filename))
+    {
+        Debug.AddLine(wxString::Format("Loaded %u defects from binary defect map in %ld ms", (unsigned int) defectMap->size(),
+                                       swatch.Time()));
+        return defectMap;
+    }
+
     wxFileInputStream iStream(filename);
     wxTextInputStream inText(iStream);
 
@@ -1352,11 +1586,10 @@ DefectMap *DefectMap::LoadDefectMap(int profileId)
     if (iStream.GetLastError() != wxSTREAM_NO_ERROR)
     {
         Debug.AddLine(wxString::Format("Unexpected eof on defect map file %s", filename));
+        delete defectMap;
         return 0;
     }
 
-    DefectMap *defectMap = new DefectMap(profileId);
-
     int linenum = 0;
     while (!inText.GetInputStream().Eof())
     {
@@ -1382,7 +1615,10 @@ DefectMap *DefectMap::LoadDefectMap(int profileId)
         }
     }
 
-    Debug.AddLine(wxString::Format("Loaded %d defects", defectMap->size()));
+    Debug.AddLine(wxString::Format("Loaded %u defects in %ld ms", (unsigned int) defectMap->size(), swatch.Time()));
+
+    SaveBinaryDefectMap(*defectMap, filename);
+
     return defectMap;
 }
 
@@ -1394,4 +1630,8 @@ void DefectMap::DeleteDefectMap(int profileId)
         Debug.AddLine("Removing defect map file: " + filename);
         wxRemoveFile(filename);
     }
+
+    wxString binFile = DefectMapBinaryFileName(filename);
+    if (wxFileExists(binFile))
+        wxRemoveFile(binFile);
 }
@@ -36,6 +36,8 @@
 #ifndef IMAGE_MATH_INCLUDED
 #define IMAGE_MATH_INCLUDED
 
+#include <functional>
+
 class DefectMap : public std::vector<wxPoint>
 {
     int m_profileId;
@@ -58,18 +60,30 @@ extern void Median3(unsigned short *dst, const unsigned short *src, const wxSize
 extern bool Median3(usImage& img);
 extern bool SquarePixels(usImage& img, float xsize, float ysize);
 extern int dbl_sort_func(double *first, double *second);
+extern bool IsLightFrameCompatibleWithDarkFrame(usImage& light, const usImage& dark);
 extern bool Subtract(usImage& light, const usImage& dark);
+// dark subtraction with the dark's median over the light's area already computed by DarkMedian();
+// the light must be compatible with the dark
+extern bool Subtract(usImage& light, const usImage& dark, unsigned short medianDark);
+// median of the dark over the area that lines up with the light; it depends only on the dark and
+// on the light's Subframe and LimitFrame
+extern unsigned short DarkMedian(const usImage& light, const usImage& dark);
 extern double CalcSlope(const ArrayOfDbl& y);
 extern bool RemoveDefects(usImage& light, const DefectMap& defectMap);
 
 struct DefectMapBuilderImpl;
 
+// Reports the progress of a long image computation, as a percentage, on the thread that started
+// it; returns true to cancel the computation
+typedef std::function<bool(int)> ImageProgressFn;
+
 struct DefectMapDarks
 {
     usImage masterDark;
     usImage filteredDark;
 
-    void BuildFilteredDark();
+    // returns true if cancelled by the progress function
+    bool BuildFilteredDark(const ImageProgressFn& progress = ImageProgressFn());
     void SaveDarks(const wxString& notes);
     void LoadDarks();
 };
@@ -90,12 +104,14 @@ public:
     DefectMapBuilder();
     ~DefectMapBuilder();
 
-    void Init(DefectMapDarks& darks);
+    // Init and BuildDefectMap return true if cancelled by the progress function; a cancelled Init
+    // leaves the builder without defect candidates, so it must be run again before use
+    bool Init(DefectMapDarks& darks, const ImageProgressFn& progress = ImageProgressFn());
     const ImageStats& GetImageStats() const;
     void SetAggressiveness(int aggrCold, int aggrHot);
     int GetColdPixelCnt() const;
     int GetHotPixelCnt() const;
-    void BuildDefectMap(DefectMap& defectMap, bool verbose) const;
+    bool BuildDefectMap(DefectMap& defectMap, bool verbose, const ImageProgressFn& progress = ImageProgressFn()) const;
     const wxArrayString& GetMapInfo() const;
 };
 
@@ -0,0 +1,227 @@
+/*
+ *  image_resample.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include "image_resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define HAVE_SSE2_TRANSFORM
+#endif
+
+static inline unsigned short ToPixel(float v)
+{
+    return (unsigned short) std::lrint(std::min(std::max(v, 0.f), 65535.f));
+}
+
+// whether a source position is within half a pixel of the frame
+static inline bool InFrame(double sx, double sy, int width, int height)
+{
+    // written so that NaN positions are outside
+    return sx >= -0.5 && sx <= width - 0.5 && sy >= -0.5 && sy <= height - 0.5;
+}
+
+// The taps of a bilinear row: for each output pixel the offsets of the 2x2 source neighborhood,
+// clamped at the frame edges, the interpolation weights, and a mask that zeroes pixels that fall
+// outside the source.
+struct BilinearTaps
+{
+    std::vector<int> o00, o01, o10, o11;
+    std::vector<float> ax, ay, mask;
+
+    explicit BilinearTaps(int n) : o00(n), o01(n), o10(n), o11(n), ax(n), ay(n), mask(n) { }
+};
+
+static void BilinearRow(unsigned short *out, int n, const unsigned short *d, int width, int height, double sx0, double sy0,
+                        double dsx, double dsy, BilinearTaps& t)
+{
+    for (int x = 0; x < n; x++)
+    {
+        double sx = sx0 + dsx * x;
+        double sy = sy0 + dsy * x;
+
+        if (!InFrame(sx, sy, width, height))
+        {
+            t.o00[x] = t.o01[x] = t.o10[x] = t.o11[x] = 0;
+            t.ax[x] = t.ay[x] = t.mask[x] = 0.f;
+            continue;
+        }
+
+        sx = std::min(std::max(sx, 0.0), width - 1.0);
+        sy = std::min(std::max(sy, 0.0), height - 1.0);
+        int ix = (int) sx;
+        int iy = (int) sy;
+        int ix1 = std::min(ix + 1, width - 1);
+        int iy1 = std::min(iy + 1, height - 1);
+
+        t.o00[x] = iy * width + ix;
+        t.o01[x] = iy * width + ix1;
+        t.o10[x] = iy1 * width + ix;
+        t.o11[x] = iy1 * width + ix1;
+        t.ax[x] = (float) (sx - ix);
+        t.ay[x] = (float) (sy - iy);
+        t.mask[x] = 1.f;
+    }
+
+    int x = 0;
+#ifdef HAVE_SSE2_TRANSFORM
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 maxval = _mm_set1_ps(65535.f);
+    const __m128i bias32 = _mm_set1_epi32(32768);
+    const __m128i bias16 = _mm_set1_epi16((short) 0x8000);
+    for (; x + 4 <= n; x += 4)
+    {
+        // the gathers are scalar, the blend is 4 pixels at a time
+        __m128 p00 = _mm_set_ps(d[t.o00[x + 3]], d[t.o00[x + 2]], d[t.o00[x + 1]], d[t.o00[x]]);
+        __m128 p01 = _mm_set_ps(d[t.o01[x + 3]], d[t.o01[x + 2]], d[t.o01[x + 1]], d[t.o01[x]]);
+        __m128 p10 = _mm_set_ps(d[t.o10[x + 3]], d[t.o10[x + 2]], d[t.o10[x + 1]], d[t.o10[x]]);
+        __m128 p11 = _mm_set_ps(d[t.o11[x + 3]], d[t.o11[x + 2]], d[t.o11[x + 1]], d[t.o11[x]]);
+        __m128 ax = _mm_loadu_ps(&t.ax[x]);
+        __m128 ay = _mm_loadu_ps(&t.ay[x]);
+
+        __m128 top = _mm_add_ps(p00, _mm_mul_ps(ax, _mm_sub_ps(p01, p00)));
+        __m128 bot = _mm_add_ps(p10, _mm_mul_ps(ax, _mm_sub_ps(p11, p10)));
+        __m128 v = _mm_mul_ps(_mm_add_ps(top, _mm_mul_ps(ay, _mm_sub_ps(bot, top))), _mm_loadu_ps(&t.mask[x]));
+        v = _mm_min_ps(_mm_max_ps(v, zero), maxval);
+
+        // SSE2 only packs with signed saturation, so pack with the values shifted into signed range
+        __m128i i32 = _mm_sub_epi32(_mm_cvtps_epi32(v), bias32);
+        __m128i i16 = _mm_xor_si128(_mm_packs_epi32(i32, i32), bias16);
+        _mm_storel_epi64((__m128i *) (out + x), i16);
+    }
+#endif
+    for (; x < n; x++)
+    {
+        float p00 = d[t.o00[x]], p01 = d[t.o01[x]], p10 = d[t.o10[x]], p11 = d[t.o11[x]];
+        float top = p00 + t.ax[x] * (p01 - p00);
+        float bot = p10 + t.ax[x] * (p11 - p10);
+        out[x] = ToPixel((top + t.ay[x] * (bot - top)) * t.mask[x]);
+    }
+}
+
+// Catmull-Rom weights of the 4 taps around a position with fractional part t
+static inline void CubicWeights(float t, float w[4])
+{
+    float t2 = t * t;
+    float t3 = t2 * t;
+    w[0] = -0.5f * t3 + t2 - 0.5f * t;
+    w[1] = 1.5f * t3 - 2.5f * t2 + 1.f;
+    w[2] = -1.5f * t3 + 2.f * t2 + 0.5f * t;
+    w[3] = 0.5f * t3 - 0.5f * t2;
+}
+
+static void BicubicRow(unsigned short *out, int n, const unsigned short *d, int width, int height, double sx0, double sy0,
+                       double dsx, double dsy)
+{
+    for (int x = 0; x < n; x++)
+    {
+        double sx = sx0 + dsx * x;
+        double sy = sy0 + dsy * x;
+
+        if (!InFrame(sx, sy, width, height))
+        {
+            out[x] = 0;
+            continue;
+        }
+
+        sx = std::min(std::max(sx, 0.0), width - 1.0);
+        sy = std::min(std::max(sy, 0.0), height - 1.0);
+        int ix = (int) sx;
+        int iy = (int) sy;
+
+        float wx[4], wy[4];
+        CubicWeights((float) (sx - ix), wx);
+        CubicWeights((float) (sy - iy), wy);
+
+#ifdef HAVE_SSE2_TRANSFORM
+        if (ix >= 1 && ix + 2 < width && iy >= 1 && iy + 2 < height)
+        {
+            // away from the edges each row of the 4x4 neighborhood is one 8-byte load
+            const __m128i zero = _mm_setzero_si128();
+            const __m128 wxv = _mm_loadu_ps(wx);
+            const unsigned short *p = d + (iy - 1) * width + ix - 1;
+            __m128 acc = _mm_setzero_ps();
+            for (int k = 0; k < 4; k++, p += width)
+            {
+                __m128 row = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) p), zero));
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_mul_ps(row, wxv), _mm_set1_ps(wy[k])));
+            }
+            acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+            acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+            out[x] = ToPixel(_mm_cvtss_f32(acc));
+            continue;
+        }
+#endif
+
+        int cols[4], rows[4];
+        for (int k = 0; k < 4; k++)
+        {
+            cols[k] = std::min(std::max(ix - 1 + k, 0), width - 1);
+            rows[k] = std::min(std::max(iy - 1 + k, 0), height - 1) * width;
+        }
+
+        float v = 0.f;
+        for (int j = 0; j < 4; j++)
+        {
+            const unsigned short *row = d + rows[j];
+            v += wy[j] * (wx[0] * row[cols[0]] + wx[1] * row[cols[1]] + wx[2] * row[cols[2]] + wx[3] * row[cols[3]]);
+        }
+        out[x] = ToPixel(v);
+    }
+}
+
+void ResampleRows(unsigned short *dst, int dstWidth, int y0, int y1, const unsigned short *src, int srcWidth, int srcHeight,
+                  const AffineTransform& xf, ResampleKernel kernel)
+{
+    std::unique_ptr<BilinearTaps> taps;
+    if (kernel == RESAMPLE_BILINEAR)
+        taps.reset(new BilinearTaps(dstWidth));
+
+    for (int y = y0; y < y1; y++)
+    {
+        unsigned short *out = dst + (size_t) y * dstWidth;
+        double sx = xf.xy * y + xf.x0;
+        double sy = xf.yy * y + xf.y0;
+
+        if (kernel == RESAMPLE_BICUBIC)
+            BicubicRow(out, dstWidth, src, srcWidth, srcHeight, sx, sy, xf.xx, xf.yx);
+        else
+            BilinearRow(out, dstWidth, src, srcWidth, srcHeight, sx, sy, xf.xx, xf.yx, *taps);
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ *  image_resample.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef IMAGE_RESAMPLE_INCLUDED
+#define IMAGE_RESAMPLE_INCLUDED
+
+// Resampling of 16-bit pixel buffers through an affine transform, the kernel behind the image
+// transforms in image_transform.h. It works on plain buffers so that it does not depend on usImage.
+
+enum ResampleKernel
+{
+    RESAMPLE_BILINEAR,
+    RESAMPLE_BICUBIC, // Catmull-Rom; sharper, but can ring next to hot pixels and saturated stars
+};
+
+// Maps a pixel of the output image to the position in the source image it is sampled from:
+//   sx = xx * x + xy * y + x0
+//   sy = yx * x + yy * y + y0
+struct AffineTransform
+{
+    double xx, xy, x0;
+    double yx, yy, y0;
+};
+
+// Compute rows [y0, y1) of a dstWidth-wide output image from a srcWidth x srcHeight source. Output
+// pixels that map outside the source are zero.
+extern void ResampleRows(unsigned short *dst, int dstWidth, int y0, int y1, const unsigned short *src, int srcWidth,
+                         int srcHeight, const AffineTransform& xf, ResampleKernel kernel);
+
+#endif // IMAGE_RESAMPLE_INCLUDED
@@ -0,0 +1,152 @@
+/*
+ *  image_transform.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include "phd.h"
+#include "image_transform.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+// rows of the output image computed by one work item
+static const int BAND_ROWS = 16;
+
+// The in-place transforms move the source pixels out of the image into a temporary that is freed
+// once the output is computed. The output buffer is allocated for each call: it is handed over
+// with the image, which is usually a new capture, so there is no buffer of the output's size to
+// reuse.
+static void TakeSource(usImage *src, usImage& img)
+{
+    std::swap(img.ImageData, src->ImageData);
+    std::swap(img.NPixels, src->NPixels);
+    src->Size = img.Size;
+    src->Storage = img.Storage;
+    src->Subframe = img.Subframe;
+}
+
+bool TransformImage(usImage *dst, const wxSize& size, const usImage& src, const AffineTransform& xf, ResampleKernel kernel)
+{
+    assert(dst != &src);
+    assert(!src.HasSubframeStorage());
+
+    if (dst->Init(size))
+        return true;
+
+    if (!dst->NPixels)
+        return false;
+
+    if (!src.NPixels)
+    {
+        dst->Clear();
+        return false;
+    }
+
+    int const width = size.GetWidth();
+    int const height = size.GetHeight();
+    unsigned int bands = (height + BAND_ROWS - 1) / BAND_ROWS;
+
+    ThreadPool::ParallelFor(bands, [&](unsigned int band) {
+        int y0 = band * BAND_ROWS;
+        int y1 = std::min(y0 + BAND_ROWS, height);
+        ResampleRows(dst->ImageData, width, y0, y1, src.ImageData, src.Size.GetWidth(), src.Size.GetHeight(), xf, kernel);
+    });
+
+    return false;
+}
+
+bool RotateImage(usImage& img, double theta, bool mirror, ResampleKernel kernel)
+{
+    if (img.ExpandStorage())
+        return true;
+
+    double const c = cos(theta);
+    double const s = sin(theta);
+    double const w = img.Size.GetWidth();
+    double const h = img.Size.GetHeight();
+
+    // bounding box of the rotated frame, found from its corners the same way wxImage::Rotate
+    // finds it, so the output has the size and placement it always had
+    double const xs[4] = { 0.0, -h * s, w * c, w * c - h * s };
+    double const ys[4] = { 0.0, h * c, w * s, w * s + h * c };
+    int x1 = (int) floor(*std::min_element(xs, xs + 4));
+    int y1 = (int) floor(*std::min_element(ys, ys + 4));
+    int x2 = (int) ceil(*std::max_element(xs, xs + 4));
+    int y2 = (int) ceil(*std::max_element(ys, ys + 4));
+
+    // output pixel (x, y) is at (x + x1, y + y1) in the rotated frame; rotating that back by
+    // -theta gives its position in the source, or in the source mirrored top to bottom
+    AffineTransform xf;
+    xf.xx = c;
+    xf.xy = s;
+    xf.x0 = c * x1 + s * y1;
+    xf.yx = -s;
+    xf.yy = c;
+    xf.y0 = c * y1 - s * x1;
+    if (mirror)
+    {
+        xf.yx = -xf.yx;
+        xf.yy = -xf.yy;
+        xf.y0 = h - 1.0 - xf.y0;
+    }
+
+    usImage src;
+    TakeSource(&src, img);
+    return TransformImage(&img, wxSize(x2 - x1 + 1, y2 - y1 + 1), src, xf, kernel);
+}
+
+bool ResizeImage(usImage& img, const wxSize& size, ResampleKernel kernel)
+{
+    if (size.GetWidth() <= 0 || size.GetHeight() <= 0 || img.ExpandStorage())
+        return true;
+
+    if (size == img.Size)
+        return false;
+
+    // pixel centers of the output line up with the pixel centers of the source
+    double const xscale = (double) img.Size.GetWidth() / size.GetWidth();
+    double const yscale = (double) img.Size.GetHeight() / size.GetHeight();
+
+    AffineTransform xf;
+    xf.xx = xscale;
+    xf.xy = 0.0;
+    xf.x0 = 0.5 * xscale - 0.5;
+    xf.yx = 0.0;
+    xf.yy = yscale;
+    xf.y0 = 0.5 * yscale - 0.5;
+
+    usImage src;
+    TakeSource(&src, img);
+    return TransformImage(&img, size, src, xf, kernel);
+}
@@ -0,0 +1,63 @@
+/*
+ *  image_transform.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef IMAGE_TRANSFORM_INCLUDED
+#define IMAGE_TRANSFORM_INCLUDED
+
+#include "image_resample.h"
+
+class usImage;
+
+// Geometric transforms of 16-bit images: rotation, mirroring and scaling done directly on the
+// 16-bit pixels, so the data is not quantized the way it is by a round trip through an 8-bit
+// wxImage. Output rows are computed in parallel on the thread pool.
+
+// Resample src into dst, which is given the requested size; dst's buffer is reused when it
+// already holds that many pixels. Output pixels that map outside the source are zero. src must
+// hold its full frame (see usImage::ExpandStorage). Returns true on error.
+extern bool TransformImage(usImage *dst, const wxSize& size, const usImage& src, const AffineTransform& xf,
+                           ResampleKernel kernel);
+
+// Rotate an image in place by theta radians about its origin, after mirroring it top to bottom
+// if requested, the way wxImage::Mirror(false) followed by wxImage::Rotate(theta, wxPoint(0, 0))
+// would: the result is sized to the bounding box of the rotated frame and is zero outside it.
+// Returns true on error.
+extern bool RotateImage(usImage& img, double theta, bool mirror, ResampleKernel kernel = RESAMPLE_BILINEAR);
+
+// Resample an image in place to a new size, scaling each axis independently. Returns true on
+// error.
+extern bool ResizeImage(usImage& img, const wxSize& size, ResampleKernel kernel = RESAMPLE_BILINEAR);
+
+#endif // IMAGE_TRANSFORM_INCLUDED
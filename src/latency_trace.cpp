@@ -0,0 +1,277 @@
+/*
+ *  latency_trace.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+#include "latency_trace.h"
+#include "spmc_ring.h"
+
+#include <wx/ffile.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+struct TraceEntry
+{
+    uint64_t start;
+    uint64_t end;
+    unsigned int stage;
+};
+
+struct TraceRing
+{
+    enum
+    {
+        SIZE = 1024
+    };
+
+    // the owning thread is the only producer, snapshots are taken from any thread
+    SpmcRing<TraceEntry> entries;
+    unsigned int threadId;
+    bool mainThread;
+    bool inUse;
+
+    TraceRing(unsigned int id) : entries(SIZE), threadId(id), mainThread(false), inUse(false) { }
+};
+
+struct SpanRecord
+{
+    uint64_t start;
+    uint64_t end;
+    unsigned int stage;
+    const TraceRing *ring;
+};
+
+wxCriticalSection s_lock;
+std::vector<TraceRing *> s_rings; // never freed, a ring is reused when its thread exits
+
+TraceRing *AcquireRing()
+{
+    wxCriticalSectionLocker lck(s_lock);
+
+    TraceRing *ring = nullptr;
+    for (TraceRing *r : s_rings)
+    {
+        if (!r->inUse)
+        {
+            ring = r;
+            break;
+        }
+    }
+    if (!ring)
+    {
+        ring = new TraceRing(s_rings.size() + 1);
+        s_rings.push_back(ring);
+    }
+    ring->inUse = true;
+    ring->mainThread = wxThread::IsMain();
+    return ring;
+}
+
+// returns the calling thread's ring to the free list when the thread exits
+struct ThreadRingHolder
+{
+    TraceRing *ring;
+
+    ThreadRingHolder() : ring(nullptr) { }
+    ~ThreadRingHolder()
+    {
+        if (ring)
+        {
+            wxCriticalSectionLocker lck(s_lock);
+            ring->inUse = false;
+        }
+    }
+};
+
+thread_local ThreadRingHolder t_ring;
+
+// Copy out the spans currently held in the rings. A ring may be written while it is being
+// copied; the ring drops the entries the owner could have overwritten in the meantime.
+void Snapshot(std::vector<SpanRecord> *spans)
+{
+    wxCriticalSectionLocker lck(s_lock);
+
+    std::vector<TraceEntry> entries;
+    for (const TraceRing *ring : s_rings)
+    {
+        entries.clear();
+        ring->entries.Read(0, &entries);
+
+        for (const TraceEntry& e : entries)
+        {
+            SpanRecord rec;
+            rec.start = e.start;
+            rec.end = e.end;
+            rec.stage = e.stage;
+            rec.ring = ring;
+            spans->push_back(rec);
+        }
+    }
+}
+
+double Percentile(const std::vector<double>& sorted, double p)
+{
+    size_t rank = (size_t) ceil(p * sorted.size());
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+} // namespace
+
+const char *LatencyTrace::StageName(TraceStage stage)
+{
+    switch (stage)
+    {
+    case TRACE_CAPTURE:
+        return "capture";
+    case TRACE_PREPARE:
+        return "prepare";
+    case TRACE_CALIBRATION:
+        return "calibration";
+    case TRACE_STATISTICS:
+        return "statistics";
+    case TRACE_STAR_PREMEASURE:
+        return "star_premeasure";
+    case TRACE_STAR_UPDATE:
+        return "star_update";
+    case TRACE_ALGORITHM:
+        return "algorithm";
+    case TRACE_EVENT:
+        return "event";
+    case TRACE_MOVE:
+        return "move";
+    case TRACE_DISPLAY:
+        return "display";
+    case TRACE_AO_LOOP:
+        return "ao_loop";
+    default:
+        return "unknown";
+    }
+}
+
+uint64_t LatencyTrace::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void LatencyTrace::Record(TraceStage stage, uint64_t start, uint64_t end)
+{
+    TraceRing *ring = t_ring.ring;
+    if (!ring)
+        ring = t_ring.ring = AcquireRing();
+
+    TraceEntry e;
+    e.start = start;
+    e.end = end;
+    e.stage = stage;
+    ring->entries.Push(e);
+}
+
+void LatencyTrace::GetStats(StageStats stats[TRACE_STAGE_COUNT])
+{
+    std::vector<SpanRecord> spans;
+    Snapshot(&spans);
+
+    std::vector<double> durations[TRACE_STAGE_COUNT];
+    for (const SpanRecord& span : spans)
+    {
+        if (span.stage < TRACE_STAGE_COUNT)
+            durations[span.stage].push_back((span.end - span.start) / 1e6);
+    }
+
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++)
+    {
+        std::vector<double>& d = durations[i];
+        StageStats& s = stats[i];
+        s.count = d.size();
+        if (d.empty())
+        {
+            s.p50 = s.p95 = s.p99 = s.max = 0.0;
+            continue;
+        }
+        std::sort(d.begin(), d.end());
+        s.p50 = Percentile(d, 0.50);
+        s.p95 = Percentile(d, 0.95);
+        s.p99 = Percentile(d, 0.99);
+        s.max = d.back();
+    }
+}
+
+bool LatencyTrace::WriteChromeTrace(const wxString& fileName)
+{
+    std::vector<SpanRecord> spans;
+    Snapshot(&spans);
+
+    wxFFile file(fileName, "w");
+    if (!file.IsOpened())
+        return true;
+
+    uint64_t origin = UINT64_MAX;
+    for (const SpanRecord& span : spans)
+        origin = std::min(origin, span.start);
+
+    wxString out("{\"traceEvents\":[");
+    bool first = true;
+
+    {
+        wxCriticalSectionLocker lck(s_lock);
+        for (const TraceRing *ring : s_rings)
+        {
+            if (!first)
+                out += ",";
+            first = false;
+            wxString name = ring->mainThread ? wxString("main") : wxString::Format("thread %u", ring->threadId);
+            out += wxString::Format("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                                    ring->threadId, name);
+        }
+    }
+
+    for (const SpanRecord& span : spans)
+    {
+        if (!first)
+            out += ",";
+        first = false;
+        out += wxString::Format("\n{\"name\":\"%s\",\"cat\":\"guide\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                                "\"ts\":%.3f,\"dur\":%.3f}",
+                                StageName((TraceStage) span.stage), span.ring->threadId, (span.start - origin) / 1e3,
+                                (span.end - span.start) / 1e3);
+    }
+
+    out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return !file.Write(out) || !file.Close();
+}
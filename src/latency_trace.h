@@ -0,0 +1,105 @@
+/*
+ *  latency_trace.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef LATENCY_TRACE_INCLUDED
+#define LATENCY_TRACE_INCLUDED
+
+#include <cstdint>
+
+// Guide loop stages covered by the latency trace
+enum TraceStage
+{
+    TRACE_CAPTURE,         // camera driver capture: exposure and download
+    TRACE_PREPARE,         // frame preparation after download: ROI check and noise reduction
+    TRACE_CALIBRATION,     // dark subtraction or defect map removal
+    TRACE_STATISTICS,      // image statistics
+    TRACE_STAR_PREMEASURE, // planned guide star measurement on the worker thread
+    TRACE_STAR_UPDATE,     // guider position update on the main thread, including any star not premeasured
+    TRACE_ALGORITHM,       // guide algorithms
+    TRACE_EVENT,           // guide step event broadcast
+    TRACE_MOVE,            // mount move request, including the guide pulses
+    TRACE_DISPLAY,         // guider image display update
+    TRACE_AO_LOOP,         // one AO fast loop iteration: subframe capture, centroid and AO step
+
+    TRACE_STAGE_COUNT
+};
+
+// Lightweight timing of the guide loop stages.
+//
+// Each thread records its spans into its own fixed-size ring, so recording a span is two
+// monotonic clock reads and a few stores, with no locking and no allocation. The rings keep the
+// most recent spans of each thread; statistics and trace dumps are computed from a snapshot of
+// them on request.
+class LatencyTrace
+{
+public:
+    struct StageStats
+    {
+        unsigned int count;
+        double p50; // milliseconds
+        double p95;
+        double p99;
+        double max;
+    };
+
+    static const char *StageName(TraceStage stage);
+
+    // monotonic clock, nanoseconds
+    static uint64_t Now();
+
+    static void Record(TraceStage stage, uint64_t start, uint64_t end);
+
+    // rolling percentiles over the spans currently held in the rings
+    static void GetStats(StageStats stats[TRACE_STAGE_COUNT]);
+
+    // write the spans currently held in the rings in Chrome trace event format
+    // (chrome://tracing, Perfetto); returns true on error
+    static bool WriteChromeTrace(const wxString& fileName);
+};
+
+// Records the time from construction to destruction as a span of the given stage
+class TraceSpan
+{
+    TraceStage m_stage;
+    uint64_t m_start;
+
+public:
+    explicit TraceSpan(TraceStage stage) : m_stage(stage), m_start(LatencyTrace::Now()) { }
+    ~TraceSpan() { LatencyTrace::Record(m_stage, m_start, LatencyTrace::Now()); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif // LATENCY_TRACE_INCLUDED
@@ -35,9 +35,10 @@
 #include "log_uploader.h"
 #include "phd.h"
 
+#include "guide_log_reader.h"
+
 #include <algorithm>
 #include <curl/curl.h>
-#include <fstream>
 #include <sstream>
 #include <wx/clipbrd.h>
 #include <wx/dir.h>
@@ -121,8 +122,6 @@ struct LogScanner
 {
     wxGrid *m_grid;
     std::deque<int> m_q; // indexes remaining to be checked
-    std::ifstream m_ifs;
-    wxDateTime m_guiding_starts;
     void Init(wxGrid *grid);
     void FindNextRow();
     bool DoWork(unsigned int millis);
@@ -137,7 +136,6 @@ void LogScanner::Init(wxGrid *grid)
         if (s_session[idx].summary_loaded != ST_LOADED)
             m_q.push_back(idx);
     }
-    m_guiding_starts = wxInvalidDateTime;
     FindNextRow();
 }
 
@@ -227,8 +225,7 @@ void LogScanner::FindNextRow()
         int row = s_grid_row[idx];
 
         wxFileName fn(Debug.GetLogDir(), GuideLogName(session));
-        m_ifs.open(fn.GetFullPath().fn_str());
-        if (!m_ifs)
+        if (!fn.FileExists())
         {
             // should never get here since we have already scanned the list once
             session.summary_loaded = ST_LOADED;
@@ -244,79 +241,28 @@ void LogScanner::FindNextRow()
     }
 }
 
-static std::string GUIDING_BEGINS("Guiding Begins at ");
-static std::string GUIDING_ENDS("Guiding Ends at ");
-static std::string CALIBRATION_ENDS("Calibration complete");
-static std::string GA_COMPLETE("INFO: GA Result - Dec Drift Rate=");
-
-inline static bool StartsWith(const std::string& s, const std::string& pfx)
-{
-    return s.length() >= pfx.length() && s.compare(0, pfx.length(), pfx) == 0;
-}
-
 bool LogScanner::DoWork(unsigned int millis)
 {
-    int n = 0;
     wxStopWatch swatch;
 
     while (!m_q.empty())
     {
+        if (swatch.Time() > millis)
+            return true;
+
         auto idx = m_q.front();
         Session& session = s_session[idx];
 
-        std::string line;
-        while (true)
-        {
-            if (++n % 1000 == 0)
-            {
-                if (swatch.Time() > millis)
-                    return true;
-            }
-
-            if (!std::getline(m_ifs, line))
-                break;
-
-            if (StartsWith(line, GUIDING_BEGINS))
-            {
-                std::string datestr = line.substr(GUIDING_BEGINS.length());
-                m_guiding_starts.ParseISOCombined(datestr, ' ');
-                continue;
-            }
-
-            if (StartsWith(line, GUIDING_ENDS) && m_guiding_starts.IsValid())
-            {
-                std::string datestr = line.substr(GUIDING_ENDS.length());
-                wxDateTime end;
-                end.ParseISOCombined(datestr, ' ');
-                if (end.IsValid() && end.IsLaterThan(m_guiding_starts))
-                {
-                    wxTimeSpan dt = end - m_guiding_starts;
-                    ++session.summary.guide_cnt;
-                    session.summary.guide_dur += dt.GetSeconds().GetValue();
-                }
-                m_guiding_starts = wxInvalidDateTime;
-                continue;
-            }
-
-            if (StartsWith(line, CALIBRATION_ENDS))
-            {
-                ++session.summary.cal_cnt;
-                continue;
-            }
-
-            if (StartsWith(line, GA_COMPLETE))
-            {
-                ++session.summary.ga_cnt;
-                continue;
-            }
-        }
+        // indexing maps the log and makes a single pass over it, fast enough to do a whole log at once
+        GuideLogReader reader;
+        if (!reader.Open(wxFileName(Debug.GetLogDir(), GuideLogName(session)).GetFullPath()))
+            reader.GetSummary(&session.summary);
 
         session.summary.valid = true;
         session.summary_loaded = ST_LOADED;
 
         FillActivity(m_grid, s_grid_row[idx], session, true);
 
-        m_ifs.close();
         m_q.pop_front();
         FindNextRow();
     }
@@ -0,0 +1,198 @@
+/*
+ *  median_filter.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef MEDIAN_FILTER_INCLUDED
+#define MEDIAN_FILTER_INCLUDED
+
+#include <algorithm>
+#include <cstring>
+
+// 2-level histogram of the pixels in a median filter window. The median of the previous window
+// is kept along with the number of pixels below it, so finding the median of the next window
+// only needs to walk the histogram from the old median to the new one, a whole coarse bin at a
+// time where possible.
+struct MedianHisto
+{
+    unsigned short histo1[256];
+    unsigned short histo2[65536];
+    unsigned int med;
+    int below; // number of pixels < med
+
+    void Clear()
+    {
+        memset(&histo1[0], 0, sizeof(histo1));
+        memset(&histo2[0], 0, sizeof(histo2));
+        med = 0;
+        below = 0;
+    }
+
+    // add the pixels in columns [x0, x1] and rows [y0, y1] of an image of the given width
+    void Add(const unsigned short *src, int width, int x0, int x1, int y0, int y1)
+    {
+        for (int y = y0; y <= y1; y++)
+        {
+            const unsigned short *p = src + y * width + x0;
+            for (int x = x0; x <= x1; x++, p++)
+            {
+                ++histo1[*p >> 8];
+                ++histo2[*p];
+                below += *p < med;
+            }
+        }
+    }
+
+    void Remove(const unsigned short *src, int width, int x0, int x1, int y0, int y1)
+    {
+        for (int y = y0; y <= y1; y++)
+        {
+            const unsigned short *p = src + y * width + x0;
+            for (int x = x0; x <= x1; x++, p++)
+            {
+                --histo1[*p >> 8];
+                --histo2[*p];
+                below -= *p < med;
+            }
+        }
+    }
+
+    // the smallest value v such that more than n / 2 of the n pixels in the window are <= v
+    unsigned short Median(int n)
+    {
+        int const half = n / 2;
+
+        while (below > half)
+        {
+            if ((med & 0xff) == 0 && below - histo1[(med >> 8) - 1] > half)
+            {
+                med -= 256;
+                below -= histo1[med >> 8];
+            }
+            else
+            {
+                --med;
+                below -= histo2[med];
+            }
+        }
+
+        while (below + histo2[med] <= half)
+        {
+            if ((med & 0xff) == 0 && below + histo1[med >> 8] <= half)
+            {
+                below += histo1[med >> 8];
+                med += 256;
+            }
+            else
+            {
+                below += histo2[med];
+                ++med;
+            }
+        }
+
+        return (unsigned short) med;
+    }
+};
+
+// Median filter rows [y0, y1) of a width x height image into dst, with a window of
+// (2 * halfWidth + 1) pixels square clipped to the image. The window is slid along the rows in a
+// serpentine scan (left to right, down one row, right to left, down one row, ...) so the
+// histogram is only built from scratch once, at the start of the rows.
+inline void MedianFilterRows(unsigned short *dst, const unsigned short *src, int width, int height, int halfWidth, int y0,
+                             int y1, MedianHisto& h)
+{
+    int top = std::max(0, y0 - halfWidth);
+    int bot = std::min(y0 + halfWidth, height - 1);
+    int left = 0;
+    int right = std::min(halfWidth, width - 1);
+
+    h.Clear();
+    h.Add(src, width, left, right, top, bot);
+
+    int x = 0;
+    int dir = +1;
+
+    for (int y = y0;;)
+    {
+        unsigned short *d = dst + y * width + x;
+
+        for (;;)
+        {
+            *d = h.Median((right - left + 1) * (bot - top + 1));
+
+            int const nx = x + dir;
+            if (nx < 0 || nx >= width)
+                break;
+
+            int const nleft = std::max(0, nx - halfWidth);
+            int const nright = std::min(nx + halfWidth, width - 1);
+
+            if (dir > 0)
+            {
+                if (nleft > left)
+                    h.Remove(src, width, left, left, top, bot);
+                if (nright > right)
+                    h.Add(src, width, nright, nright, top, bot);
+            }
+            else
+            {
+                if (nright < right)
+                    h.Remove(src, width, right, right, top, bot);
+                if (nleft < left)
+                    h.Add(src, width, nleft, nleft, top, bot);
+            }
+
+            left = nleft;
+            right = nright;
+            x = nx;
+            d += dir;
+        }
+
+        if (++y >= y1)
+            break;
+
+        // move the window down one row
+        int const ntop = std::max(0, y - halfWidth);
+        int const nbot = std::min(y + halfWidth, height - 1);
+        if (ntop > top)
+            h.Remove(src, width, left, right, top, top);
+        if (nbot > bot)
+            h.Add(src, width, left, right, nbot, nbot);
+        top = ntop;
+        bot = nbot;
+
+        dir = -dir;
+    }
+}
+
+#endif // MEDIAN_FILTER_INCLUDED
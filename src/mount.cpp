@@ -37,8 +37,10 @@
 #include "backlash_comp.h"
 #include "guiding_assistant.h"
 #include "gaussian_process_guider.h"
+#include "latency_trace.h"
 
 #include <wx/tokenzr.h>
+#include <chrono>
 #include <cstdarg>
 
 enum
@@ -859,8 +861,12 @@ Mount::Mount()
     m_guidingEnabled = true;
 
     m_backlashComp = nullptr;
+    m_axisMoveThread = nullptr;
     m_lastStep.mount = this;
     m_lastStep.frameNumber = -1; // invalidate
+    m_lastStep.moveElapsed = 0;
+    m_lastStep.moveOverlap = 0;
+    m_lastStep.aoStepElapsed = 0;
 
     ClearCalibration();
 
@@ -874,6 +880,12 @@ Mount::~Mount()
     delete m_pXGuideAlgorithm;
     delete m_pYGuideAlgorithm;
     delete m_backlashComp;
+
+    if (m_axisMoveThread)
+    {
+        m_axisMoveThread->Shutdown();
+        delete m_axisMoveThread;
+    }
 }
 
 double Mount::yAngle() const
@@ -963,7 +975,10 @@ void Mount::LogGuideStepInfo()
 
     pFrame->UpdateStatusBarGuiderInfo(m_lastStep);
     GuideLog.GuideStep(m_lastStep);
-    EvtServer.NotifyGuideStep(m_lastStep);
+    {
+        TraceSpan span(TRACE_EVENT);
+        EvtServer.NotifyGuideStep(m_lastStep);
+    }
 
     if (m_lastStep.moveOptions & MOVEOPT_GRAPH)
     {
@@ -975,6 +990,152 @@ void Mount::LogGuideStepInfo()
     m_lastStep.frameNumber = -1; // invalidate
 }
 
+typedef std::chrono::steady_clock PulseClock;
+
+// Issues single-axis moves for a mount on a thread of its own, so that a Dec move can run alongside
+// the RA move made on the worker thread. The thread is started on first use and lives as long as
+// the mount, waiting for the next move in between.
+class AxisMoveThread : public wxThread
+{
+    Mount *m_mount;
+    wxMutex m_lock;
+    wxCondition m_cond;
+    bool m_pending; // a move has been posted and has not completed yet
+    bool m_exit;
+
+    WorkerThread *m_owner;
+    GUIDE_DIRECTION m_direction;
+    int m_amount;
+    unsigned int m_moveOptions;
+
+public:
+    Mount::MOVE_RESULT result;
+    MoveResultInfo moveResult;
+    PulseClock::time_point start;
+    PulseClock::time_point end;
+
+    AxisMoveThread(Mount *mount)
+        : wxThread(wxTHREAD_JOINABLE), m_mount(mount), m_cond(m_lock), m_pending(false), m_exit(false), m_owner(nullptr),
+          m_direction(NONE), m_amount(0), m_moveOptions(0), result(Mount::MOVE_ERROR)
+    {
+    }
+
+    // Start a move; the move sees the interrupt requests (Stop, Terminate) of the given worker thread
+    void Post(WorkerThread *owner, GUIDE_DIRECTION direction, int amount, unsigned int moveOptions)
+    {
+        wxMutexLocker lck(m_lock);
+        m_owner = owner;
+        m_direction = direction;
+        m_amount = amount;
+        m_moveOptions = moveOptions;
+        m_pending = true;
+        m_cond.Broadcast();
+    }
+
+    void WaitForMove()
+    {
+        wxMutexLocker lck(m_lock);
+        while (m_pending)
+            m_cond.Wait();
+    }
+
+    // finish the move in progress, if any, and join the thread
+    void Shutdown()
+    {
+        {
+            wxMutexLocker lck(m_lock);
+            m_exit = true;
+            m_cond.Broadcast();
+        }
+        Wait();
+    }
+
+    ExitCode Entry() override
+    {
+        m_lock.Lock();
+
+        while (true)
+        {
+            while (!m_pending && !m_exit)
+                m_cond.Wait();
+
+            if (!m_pending)
+                break;
+
+            WorkerThread *owner = m_owner;
+            GUIDE_DIRECTION direction = m_direction;
+            int amount = m_amount;
+            unsigned int moveOptions = m_moveOptions;
+
+            m_lock.Unlock();
+
+            WorkerThread::SetInterruptSource(owner);
+            start = PulseClock::now();
+            result = m_mount->MoveAxis(direction, amount, moveOptions, &moveResult);
+            end = PulseClock::now();
+            WorkerThread::SetInterruptSource(nullptr);
+
+            m_lock.Lock();
+            m_pending = false;
+            m_cond.Broadcast();
+        }
+
+        m_lock.Unlock();
+        return nullptr;
+    }
+};
+
+static int ElapsedMs(const PulseClock::time_point& from, const PulseClock::time_point& to)
+{
+    return (int) std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+}
+
+// Issue the RA and Dec moves of a guide step at the same time: Dec on the mount's axis move thread,
+// RA on the calling worker thread, then wait for the longer of the two. If the axis move thread
+// cannot be started the moves are made one after the other.
+void Mount::MoveAxesConcurrently(GUIDE_DIRECTION xDirection, int xAmount, GUIDE_DIRECTION yDirection, int yAmount,
+                                 unsigned int moveOptions, MOVE_RESULT *result, MoveResultInfo *xMoveResult,
+                                 MoveResultInfo *yMoveResult)
+{
+    if (!m_axisMoveThread)
+    {
+        AxisMoveThread *thread = new AxisMoveThread(this);
+        if (thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR)
+        {
+            delete thread;
+            Debug.Write("MoveOffset: could not start the axis move thread, moving axes sequentially\n");
+
+            *result = MoveAxis(xDirection, xAmount, moveOptions, xMoveResult);
+            if (*result != MOVE_ERROR_SLEWING && *result != MOVE_ERROR_AO_LIMIT_REACHED)
+                *result = MoveAxis(yDirection, yAmount, moveOptions, yMoveResult);
+            return;
+        }
+        m_axisMoveThread = thread;
+    }
+
+    AxisMoveThread *decThread = m_axisMoveThread;
+    decThread->Post(WorkerThread::This(), yDirection, yAmount, moveOptions);
+
+    PulseClock::time_point raStart = PulseClock::now();
+    MOVE_RESULT raResult = MoveAxis(xDirection, xAmount, moveOptions, xMoveResult);
+    PulseClock::time_point raEnd = PulseClock::now();
+
+    decThread->WaitForMove();
+
+    *yMoveResult = decThread->moveResult;
+    *result = raResult != MOVE_OK ? raResult : decThread->result;
+
+    PulseClock::time_point overlapStart = std::max(raStart, decThread->start);
+    PulseClock::time_point overlapEnd = std::min(raEnd, decThread->end);
+
+    m_lastStep.moveElapsed = ElapsedMs(std::min(raStart, decThread->start), std::max(raEnd, decThread->end));
+    m_lastStep.moveOverlap = overlapEnd > overlapStart ? ElapsedMs(overlapStart, overlapEnd) : 0;
+
+    Debug.Write(wxString::Format("MoveOffset: simultaneous RA %d ms / Dec %d ms, elapsed %d ms, overlap %d ms\n",
+                                 xMoveResult->amountMoved, yMoveResult->amountMoved, m_lastStep.moveElapsed,
+                                 m_lastStep.moveOverlap));
+}
+
 Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions)
 {
     MOVE_RESULT result = MOVE_OK;
@@ -985,6 +1146,7 @@ Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions
 
         if (moveOptions & MOVEOPT_ALGO_DEDUCE)
         {
+            TraceSpan span(TRACE_ALGORITHM);
             xDistance = m_pXGuideAlgorithm ? m_pXGuideAlgorithm->deduceResult() : 0.0;
             yDistance = m_pYGuideAlgorithm ? m_pYGuideAlgorithm->deduceResult() : 0.0;
             if (xDistance == 0.0 && yDistance == 0.0)
@@ -1017,6 +1179,8 @@ Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions
 
             if (moveOptions & MOVEOPT_ALGO_RESULT)
             {
+                TraceSpan span(TRACE_ALGORITHM);
+
                 // Feed the raw distances to the guide algorithms
                 if (m_pXGuideAlgorithm)
                 {
@@ -1036,17 +1200,38 @@ Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions
 
         int requestedXAmount = ROUND(fabs(xDistance / m_xRate));
         MoveResultInfo xMoveResult;
-        result = MoveAxis(xDirection, requestedXAmount, moveOptions, &xMoveResult);
-
         MoveResultInfo yMoveResult;
-        if (result != MOVE_ERROR_SLEWING && result != MOVE_ERROR_AO_LIMIT_REACHED)
-        {
-            int requestedYAmount = ROUND(fabs(yDistance / m_cal.yRate));
 
+        m_lastStep.moveElapsed = 0;
+        m_lastStep.moveOverlap = 0;
+        m_lastStep.aoStepElapsed = 0;
+
+        // When the driver allows it, a step with a correction on both axes issues the two pulses at the
+        // same time, so the move takes as long as the longer pulse rather than the sum of the two.
+        int requestedYAmount = ROUND(fabs(yDistance / m_cal.yRate));
+
+        if (requestedXAmount > 0 && requestedYAmount > 0 && (moveOptions & MOVEOPT_MANUAL) == 0 &&
+            CanGuideAxesSimultaneously())
+        {
+            // the Dec pulse starts together with the RA pulse, so backlash compensation cannot wait for
+            // the RA move to finish
             if (m_backlashComp)
                 m_backlashComp->ApplyBacklashComp(moveOptions, yDistance, &requestedYAmount);
 
-            result = MoveAxis(yDirection, requestedYAmount, moveOptions, &yMoveResult);
+            MoveAxesConcurrently(xDirection, requestedXAmount, yDirection, requestedYAmount, moveOptions, &result,
+                                 &xMoveResult, &yMoveResult);
+        }
+        else
+        {
+            result = MoveAxis(xDirection, requestedXAmount, moveOptions, &xMoveResult);
+
+            if (result != MOVE_ERROR_SLEWING && result != MOVE_ERROR_AO_LIMIT_REACHED)
+            {
+                if (m_backlashComp)
+                    m_backlashComp->ApplyBacklashComp(moveOptions, yDistance, &requestedYAmount);
+
+                result = MoveAxis(yDirection, requestedYAmount, moveOptions, &yMoveResult);
+            }
         }
 
         // Record the info about the guide step. The info will be picked up back in the main UI thread.
@@ -1435,6 +1620,11 @@ bool Mount::SynchronousOnly()
     return false;
 }
 
+bool Mount::CanGuideAxesSimultaneously()
+{
+    return false;
+}
+
 bool Mount::HasSetupDialog() const
 {
     return false;
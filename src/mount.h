@@ -40,6 +40,7 @@
 #include "image_math.h"
 #include "messagebox_proxy.h"
 
+class AxisMoveThread;
 class BacklashComp;
 struct GuiderOffset;
 
@@ -163,6 +164,15 @@ public:
     virtual void UnloadValues();
 };
 
+/*
+ * Thread safety: Mount state, including calibration and the guide algorithms, is
+ * handed back and forth between threads rather than locked. MoveOffset (which
+ * runs the guide algorithms), MoveAxis and the driver Guide routines run on the
+ * worker thread that services the mount's move requests (see WorkerThread). While
+ * a move is outstanding IsBusy() is true and the main thread must not change
+ * mount state; it picks the mount back up when the MoveComplete event arrives.
+ * Code running on the worker thread must not call into the Guider or GUI objects.
+ */
 class Mount : public wxMessageBoxProxy
 {
     bool m_connected;
@@ -182,6 +192,7 @@ protected:
 
     wxString m_Name;
     BacklashComp *m_backlashComp;
+    AxisMoveThread *m_axisMoveThread; // Dec moves for MoveAxesConcurrently, started on first use
     GuideStepInfo m_lastStep;
 
     // Things related to the Advanced Config Dialog
@@ -342,6 +353,8 @@ public:
 public:
     virtual bool HasNonGuiMove();
     virtual bool SynchronousOnly();
+    // true if the driver can take an RA move and a Dec move at the same time, see MoveAxesConcurrently()
+    virtual bool CanGuideAxesSimultaneously();
     virtual bool HasSetupDialog() const;
     virtual void SetupDialog();
 
@@ -375,6 +388,12 @@ public:
 
     bool MountIsCalibrated() const { return m_calibrated; }
     const Calibration& MountCal() const { return m_cal; }
+
+protected:
+    // the default issues the two moves from different threads
+    virtual void MoveAxesConcurrently(GUIDE_DIRECTION xDirection, int xAmount, GUIDE_DIRECTION yDirection, int yAmount,
+                                      unsigned int moveOptions, MOVE_RESULT *result, MoveResultInfo *xMoveResult,
+                                      MoveResultInfo *yMoveResult);
 };
 
 inline double Mount::xRate() const
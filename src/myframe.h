@@ -140,6 +140,7 @@ class MyFrameConfigDialogCtrlSet : public ConfigDialogCtrlSet
     wxCheckBox *m_ditherRaOnly;
     wxChoice *m_pNoiseReduction;
     wxSpinCtrl *m_pTimeLapse;
+    wxCheckBox *m_pPipelinedCapture;
     wxTextCtrl *m_pFocalLength;
     wxChoice *m_pLanguage;
     int m_oldLanguageChoice;
@@ -189,6 +190,9 @@ protected:
     int GetTimeLapse() const;
     int GetExposureDelay();
 
+    bool GetPipelinedCapture() const;
+    void SetPipelinedCapture(bool enable);
+
     bool SetFocalLength(int focalLength);
 
     friend class MyFrameConfigDialogPane;
@@ -203,6 +207,9 @@ private:
     DitherSpiral m_ditherSpiral;
     bool m_serverMode;
     int m_timeLapse; // Delay between frames (useful for vid cameras)
+    bool m_pipelinedCapture; // user setting: start the next exposure before the current frame is processed
+    bool m_pipelineActive; // the current guide frame was captured with pipelining in effect
+    usImage *m_pipelineHeldFrame; // frame that arrived while the previous guide pulse was still running
     VarDelayCfg m_varDelayConfig;
     int m_focalLength;
     bool m_beepForLostStar;
@@ -274,7 +281,7 @@ public:
     bool CaptureActive; // Is camera looping captures?
     bool m_exposurePending; // exposure scheduled and not completed
     double Stretch_gamma;
-    unsigned int m_frameCounter;
+    std::atomic<unsigned int> m_frameCounter; // frames are numbered on the worker thread as they are captured
     wxDateTime m_guidingStarted;
     wxStopWatch m_guidingElapsed;
     Star::FindMode m_starFindMode;
@@ -282,6 +289,7 @@ public:
     bool m_rawImageMode;
     bool m_rawImageModeWarningDone;
     wxSize m_prevDarkFrameSize;
+    unsigned int m_calibrationLoadGen; // identifies the latest background load of darks or defect map
 
     void RegisterTextCtrl(wxTextCtrl *ctrl);
 
@@ -405,6 +413,9 @@ public:
     void SetDarkMenuState();
     bool LoadDarkHandler(bool checkIt); // Use to also set menu item states
     void LoadDefectMapHandler(bool checkIt);
+    void AutoLoadCalibrationData();
+    void InstallCalibrationData(unsigned int generation, int profileId, GuideCamera *camera, DefectMap *defectMap,
+                                DarkLibraryCache *darks);
     void CheckDarkFrameGeometry();
     void UpdateStatusBarCalibrationStatus();
     void UpdateStatusBarStateLabels();
@@ -423,6 +434,7 @@ public:
     void OnRequestMountMove(wxCommandEvent& evt);
 
     void ScheduleExposure();
+    int CorrectionLatency();
 
     void SchedulePrimaryMove(Mount *mount, const GuiderOffset& ofs, unsigned int moveOptions);
     void ScheduleSecondaryMove(Mount *mount, const GuiderOffset& ofs, unsigned int moveOptions);
@@ -535,6 +547,8 @@ private:
     int GetTextWidth(wxControl *pControl, const wxString& string);
     void SetComboBoxWidth(wxComboBox *pComboBox, unsigned int extra);
     void FinishStop();
+    bool CanPipelineCapture();
+    void DiscardPipelineHeldFrame();
     void DoTryReconnect();
 
     // and of course, an event table
@@ -796,6 +810,11 @@ inline int MyFrame::GetTimeLapse() const
     return m_timeLapse;
 }
 
+inline bool MyFrame::GetPipelinedCapture() const
+{
+    return m_pipelinedCapture;
+}
+
 inline int MyFrame::GetFocalLength() const
 {
     return m_focalLength;
@@ -400,6 +400,7 @@ void MyFrame::OnButtonLoop(wxCommandEvent& WXUNUSED(event))
 void MyFrame::FinishStop(void)
 {
     assert(!CaptureActive);
+    m_pipelineActive = false;
     if (m_singleExposure.enabled)
         m_singleExposure.Complete(true);
     EvtServer.NotifyLoopingStopped();
@@ -525,6 +526,16 @@ void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
     {
         Debug.Write("OnExposeComplete: enter\n");
 
+        if (m_pipelineActive && !err && pMount && pMount->IsBusy())
+        {
+            // The guide pulse for the previous frame is still running. Hold on to this frame until the
+            // move completes; the exposure is still considered pending so nothing else gets scheduled.
+            assert(!m_pipelineHeldFrame);
+            m_pipelineHeldFrame = pNewFrame;
+            Debug.Write("OnExposeComplete: mount busy, holding pipelined frame\n");
+            return;
+        }
+
         m_exposurePending = false;
 
         if (pGuider->GetPauseType() == PAUSE_FULL)
@@ -539,6 +550,7 @@ void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
             Debug.Write("OnExposeComplete: Capture Error reported\n");
 
             delete pNewFrame;
+            m_pipelineActive = false;
 
             bool stopping = !m_continueCapturing;
             StopCapturing();
@@ -563,8 +575,6 @@ void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
             throw ERROR_INFO("Error reported capturing image");
         }
 
-        pNewFrame->FrameNum = ++m_frameCounter;
-
         if (m_rawImageMode && !m_rawImageModeWarningDone)
         {
             WarnRawImageMode();
@@ -577,6 +587,17 @@ void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
             CheckDarkFrameGeometry();
         }
 
+        bool pipeline = m_continueCapturing && CanPipelineCapture();
+        if (pipeline != m_pipelineActive)
+        {
+            Debug.Write(wxString::Format("Pipelined capture %s\n", pipeline ? "active" : "inactive"));
+            m_pipelineActive = pipeline;
+        }
+
+        // with pipelining, get the next exposure going before this frame is processed
+        if (m_pipelineActive)
+            ScheduleExposure();
+
         pGuider->UpdateGuideState(pNewFrame, !m_continueCapturing);
         pNewFrame = NULL; // the guider owns it now
 
@@ -585,15 +606,24 @@ void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
         Debug.Write(wxString::Format("OnExposeComplete: CaptureActive=%d m_continueCapturing=%d\n", CaptureActive,
                                      m_continueCapturing));
 
-        CaptureActive = m_continueCapturing;
-
-        if (CaptureActive)
+        if (m_exposurePending && !m_continueCapturing)
         {
-            ScheduleExposure();
+            // capture was stopped while the pipelined exposure was in flight; finish stopping when it
+            // completes, the same as stopping during any other exposure
+            StopCapturing();
         }
         else
         {
-            FinishStop();
+            CaptureActive = m_continueCapturing;
+
+            if (!CaptureActive)
+            {
+                FinishStop();
+            }
+            else if (!m_exposurePending)
+            {
+                ScheduleExposure();
+            }
         }
     }
     catch (const wxString& Msg)
@@ -610,6 +640,27 @@ void MyFrame::OnExposeComplete(wxThreadEvent& event)
     OnExposeComplete(image, err);
 }
 
+// The move a pipelined frame was waiting on failed. The frame was exposed while the failed move
+// was running, so it is not guided on; the capture loop carries on as it would have after it.
+void MyFrame::DiscardPipelineHeldFrame()
+{
+    Debug.Write("OnMoveComplete: move failed, discarding held pipelined frame\n");
+
+    delete m_pipelineHeldFrame;
+    m_pipelineHeldFrame = nullptr;
+    m_exposurePending = false;
+
+    if (pGuider->GetPauseType() == PAUSE_FULL)
+        return;
+
+    CaptureActive = m_continueCapturing;
+
+    if (!CaptureActive)
+        FinishStop();
+    else
+        ScheduleExposure();
+}
+
 void MyFrame::OnMoveComplete(wxThreadEvent& event_)
 {
     try
@@ -631,6 +682,10 @@ void MyFrame::OnMoveComplete(wxThreadEvent& event_)
 
         mount->LogGuideStepInfo();
 
+        // a pipelined frame waiting on this move is only handed to the guider once the move result
+        // has been dealt with
+        bool releaseHeldFrame = m_pipelineHeldFrame && !mount->IsBusy();
+
         // deliver the outstanding GuidingStopped notification if this is a late-arriving
         // move completion event
         if (!pGuider->IsCalibratingOrGuiding() && (!pMount || !pMount->IsBusy()) &&
@@ -679,8 +734,19 @@ void MyFrame::OnMoveComplete(wxThreadEvent& event_)
                 }
             }
 
+            if (releaseHeldFrame && m_pipelineHeldFrame)
+                DiscardPipelineHeldFrame();
+
             throw ERROR_INFO("Error reported moving");
         }
+
+        if (releaseHeldFrame && m_pipelineHeldFrame)
+        {
+            usImage *frame = m_pipelineHeldFrame;
+            m_pipelineHeldFrame = nullptr;
+            Debug.Write("OnMoveComplete: releasing held pipelined frame\n");
+            OnExposeComplete(frame, false);
+        }
     }
     catch (const wxString& Msg)
     {
@@ -727,6 +793,8 @@ void MyFrame::OnDark(wxCommandEvent& WXUNUSED(event))
 // Outside event handler because loading a dark library will automatically unload a defect map
 bool MyFrame::LoadDarkHandler(bool checkIt)
 {
+    ++m_calibrationLoadGen; // supersedes any background load
+
     if (!pCamera || !pCamera->Connected)
     {
         Alert(_("You must connect a camera before loading a dark library"));
@@ -770,6 +838,8 @@ void MyFrame::OnLoadDark(wxCommandEvent& evt)
 // Outside event handler because loading a defect map will automatically unload a dark library
 void MyFrame::LoadDefectMapHandler(bool checkIt)
 {
+    ++m_calibrationLoadGen; // supersedes any background load
+
     if (!pCamera || !pCamera->Connected)
     {
         Alert(_("You must connect a camera before loading a bad-pixel map"));
@@ -57,6 +57,11 @@ bool OnboardST4::ST4SynchronousOnly(void)
     return true;
 }
 
+bool OnboardST4::ST4CanGuideAxesSimultaneously(void)
+{
+    return false;
+}
+
 bool OnboardST4::ST4PulseGuideScope(int direction, int duration)
 {
     assert(false);
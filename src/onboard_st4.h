@@ -43,6 +43,7 @@ public:
     virtual bool ST4HostConnected();
     virtual bool ST4HasNonGuiMove();
     virtual bool ST4SynchronousOnly();
+    virtual bool ST4CanGuideAxesSimultaneously();
     virtual bool ST4PulseGuideScope(int direction, int duration);
 };
 
@@ -34,7 +34,12 @@
 
 #include "phd.h"
 
+#include "frame_replay.h"
+#include "guide_algorithm_eval.h"
+#include "guidinglog_binary.h"
+#include "image_bench.h"
 #include "phdupdate.h"
+#include "thread_pool.h"
 
 #include <curl/curl.h>
 #include <memory>
@@ -65,11 +70,27 @@ int YWinSize = 512;
 
 static const wxCmdLineEntryDesc cmdLineDesc[] = {
     { wxCMD_LINE_SWITCH, "?", "help", "display this help and exit" },
+    { wxCMD_LINE_OPTION, nullptr, "bench", "benchmark the image-processing kernels, write JSON results to a file and exit",
+      wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, nullptr, "convert-guidelog", "append a binary guide log (.bin) to its text guide log and exit",
+      wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_OPTION, "i", "instanceNumber", "sets the PHD2 instance number (default = 1)", wxCMD_LINE_VAL_NUMBER,
       wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_OPTION, "l", "load", "load settings from file and exit", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_SWITCH, "R", "Reset", "Reset all PHD2 settings to default values" },
+    { wxCMD_LINE_OPTION, nullptr, "replay", "replay the FITS frames in a directory through the guiding pipeline and exit",
+      wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, nullptr, "replay-dark", "dark frame to subtract during --replay", wxCMD_LINE_VAL_STRING,
+      wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, nullptr, "replay-report", "CSV report file for --replay", wxCMD_LINE_VAL_STRING,
+      wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_OPTION, "s", "save", "save settings to file and exit", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, nullptr, "tune", "evaluate guide algorithm settings against a guide log and exit",
+      wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, nullptr, "tune-grid", "guide algorithm parameter grid for --tune", wxCMD_LINE_VAL_STRING,
+      wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, nullptr, "tune-report", "CSV report file for --tune", wxCMD_LINE_VAL_STRING,
+      wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_SWITCH, "v", "version", "print the program version and exit" },
     { wxCMD_LINE_NONE }
 };
@@ -82,6 +103,10 @@ enum ConfigOp
 };
 static ConfigOp s_configOp = CONFIG_OP_NONE;
 static wxString s_configPath;
+static FrameReplay::Options s_replayOptions;
+static wxString s_benchFile;
+static GuideAlgorithmEvaluator::Options s_tuneOptions;
+static wxString s_convertGuideLog;
 
 wxIMPLEMENT_APP(PhdApp);
 
@@ -124,6 +149,8 @@ PhdApp::PhdApp()
 {
     m_resetConfig = false;
     m_instanceNumber = 1;
+    m_headless = false;
+    m_exitStatus = 0;
 #ifdef __linux__
     XInitThreads();
 #endif // __linux__
@@ -611,11 +638,44 @@ bool PhdApp::OnInit()
 
     ImageLogger::Init();
 
+    ThreadPool::Init();
+
     wxImage::AddHandler(new wxJPEGHandler);
     wxImage::AddHandler(new wxPNGHandler);
 
+    // Headless runs finish here and then leave through the ordinary shutdown path (OnRun, OnExit), so
+    // the profile is written back and the thread pool is stopped as on any other exit. Converting a
+    // guide log needs nothing else; the other runs use the guider, the mount guide algorithms and the
+    // dark library, which live in the frame, so they create it but never show it.
+    if (!s_convertGuideLog.IsEmpty())
+    {
+        wxFileName textFile(s_convertGuideLog);
+        textFile.SetExt("txt");
+        bool err = BinaryGuideLog::ConvertToText(s_convertGuideLog, textFile.GetFullPath());
+        if (!err)
+            wxRemove(s_convertGuideLog);
+        wxPrintf("%s %s\n", err ? "failed to convert" : "wrote", textFile.GetFullPath());
+        m_exitStatus = err ? 1 : 0;
+        m_headless = true;
+        return true;
+    }
+
     pFrame = new MyFrame();
 
+    if (!s_benchFile.IsEmpty() || !s_replayOptions.framesPath.IsEmpty() || !s_tuneOptions.logPath.IsEmpty())
+    {
+        if (!s_benchFile.IsEmpty())
+            m_exitStatus = ImageBench::Run(s_benchFile);
+        else if (!s_replayOptions.framesPath.IsEmpty())
+            m_exitStatus = FrameReplay::Run(s_replayOptions);
+        else
+            m_exitStatus = GuideAlgorithmEvaluator::Run(s_tuneOptions);
+
+        m_headless = true;
+        pFrame->Close(true);
+        return true;
+    }
+
     pFrame->Show(true);
 
     if (pConfig->IsNewInstance() || (pConfig->NumProfiles() == 1 && pFrame->pGearDialog->IsEmptyProfile()))
@@ -628,6 +688,19 @@ bool PhdApp::OnInit()
     return true;
 }
 
+int PhdApp::OnRun()
+{
+    if (m_headless)
+    {
+        // the run is over; if it created the frame, the event loop deletes it and then returns
+        if (pFrame)
+            wxApp::OnRun();
+        return m_exitStatus;
+    }
+
+    return wxApp::OnRun();
+}
+
 int PhdApp::OnExit()
 {
     assert(!pMount);
@@ -636,6 +709,8 @@ int PhdApp::OnExit()
 
     ImageLogger::Destroy();
 
+    ThreadPool::Destroy();
+
     PhdController::OnAppExit();
 
     delete pConfig;
@@ -677,6 +752,15 @@ bool PhdApp::OnCmdLineParsed(wxCmdLineParser& parser)
 
     m_resetConfig = parser.Found("R");
 
+    parser.Found("bench", &s_benchFile);
+    parser.Found("convert-guidelog", &s_convertGuideLog);
+    parser.Found("replay", &s_replayOptions.framesPath);
+    parser.Found("replay-dark", &s_replayOptions.darkPath);
+    parser.Found("replay-report", &s_replayOptions.reportPath);
+    parser.Found("tune", &s_tuneOptions.logPath);
+    parser.Found("tune-grid", &s_tuneOptions.grid);
+    parser.Found("tune-report", &s_tuneOptions.reportPath);
+
     return true;
 }
 
@@ -72,9 +72,11 @@
 #include <wx/thread.h>
 #include <wx/utils.h>
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <math.h>
+#include <memory>
 #include <stdarg.h>
 
 #define APPNAME _T("PHD2 Guiding")
@@ -157,6 +159,7 @@ WX_DEFINE_ARRAY_DOUBLE(double, ArrayOfDbl);
 #include "usImage.h"
 #include "point.h"
 #include "star.h"
+#include "star_premeasure.h"
 #include "circbuf.h"
 #include "guidinglog.h"
 #include "graph.h"
@@ -218,6 +221,8 @@ class PhdApp : public wxApp
     bool m_resetConfig;
     wxString m_resourcesDir;
     wxDateTime m_logFileTime;
+    bool m_headless; // a command-line run (--bench, --replay, ...) that has finished in OnInit
+    int m_exitStatus;
 
 protected:
     wxLocale m_locale;
@@ -225,6 +230,7 @@ protected:
 public:
     PhdApp();
     bool OnInit();
+    int OnRun();
     int OnExit();
     void OnInitCmdLine(wxCmdLineParser& parser);
     bool OnCmdLineParsed(wxCmdLineParser& parser);
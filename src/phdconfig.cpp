@@ -53,19 +53,40 @@ ConfigSection::~ConfigSection() { }
 void ConfigSection::SelectProfile(int profileId)
 {
     m_prefix = wxString::Format("/profile/%d", profileId);
+    ReloadCache();
+}
+
+// write any changes held in the cache through to the config backend
+void ConfigSection::FlushCache()
+{
+    if (m_cache)
+        m_cache->Flush();
+}
+
+// discard the cached values and read the profile again from the config backend
+void ConfigSection::ReloadCache()
+{
+    if (m_cache)
+        m_cache->Load(m_prefix);
 }
 
 bool ConfigSection::GetBoolean(const wxString& name, bool defaultValue)
 {
     bool bReturn = defaultValue;
     wxString path = m_prefix + name;
+    bool loaded = true;
 
-    if (m_pConfig)
+    if (m_cache)
+    {
+        bReturn = m_cache->GetBoolean(path, defaultValue, &loaded);
+    }
+    else if (m_pConfig)
     {
         m_pConfig->Read(path, &bReturn, defaultValue);
     }
 
-    Debug.Write(wxString::Format("GetBoolean(\"%s\", %d) returns %d\n", path, defaultValue, bReturn));
+    if (loaded)
+        Debug.Write(wxString::Format("GetBoolean(\"%s\", %d) returns %d\n", path, defaultValue, bReturn));
 
     return bReturn;
 }
@@ -74,13 +95,19 @@ wxString ConfigSection::GetString(const wxString& name, const wxString& defaultV
 {
     wxString sReturn = defaultValue;
     wxString path = m_prefix + name;
+    bool loaded = true;
 
-    if (m_pConfig)
+    if (m_cache)
+    {
+        sReturn = m_cache->GetString(path, defaultValue, &loaded);
+    }
+    else if (m_pConfig)
     {
         m_pConfig->Read(path, &sReturn, defaultValue);
     }
 
-    Debug.Write(wxString::Format("GetString(\"%s\", \"%s\") returns \"%s\"\n", path, defaultValue, sReturn));
+    if (loaded)
+        Debug.Write(wxString::Format("GetString(\"%s\", \"%s\") returns \"%s\"\n", path, defaultValue, sReturn));
 
     return sReturn;
 }
@@ -89,13 +116,19 @@ double ConfigSection::GetDouble(const wxString& name, double defaultValue)
 {
     double dReturn = defaultValue;
     wxString path = m_prefix + name;
+    bool loaded = true;
 
-    if (m_pConfig)
+    if (m_cache)
+    {
+        dReturn = m_cache->GetDouble(path, defaultValue, &loaded);
+    }
+    else if (m_pConfig)
     {
         m_pConfig->Read(path, &dReturn, defaultValue);
     }
 
-    Debug.Write(wxString::Format("GetDouble(\"%s\", %f) returns %f\n", path, defaultValue, dReturn));
+    if (loaded)
+        Debug.Write(wxString::Format("GetDouble(\"%s\", %f) returns %f\n", path, defaultValue, dReturn));
 
     return dReturn;
 }
@@ -104,13 +137,19 @@ long ConfigSection::GetLong(const wxString& name, long defaultValue)
 {
     long lReturn = defaultValue;
     wxString path = m_prefix + name;
+    bool loaded = true;
 
-    if (m_pConfig)
+    if (m_cache)
+    {
+        lReturn = m_cache->GetLong(path, defaultValue, &loaded);
+    }
+    else if (m_pConfig)
     {
         m_pConfig->Read(path, &lReturn, defaultValue);
     }
 
-    Debug.Write(wxString::Format("GetLong(\"%s\", %ld) returns %ld\n", path, defaultValue, lReturn));
+    if (loaded)
+        Debug.Write(wxString::Format("GetLong(\"%s\", %ld) returns %ld\n", path, defaultValue, lReturn));
 
     return lReturn;
 }
@@ -119,13 +158,19 @@ int ConfigSection::GetInt(const wxString& name, int defaultValue)
 {
     long lReturn = defaultValue;
     wxString path = m_prefix + name;
+    bool loaded = true;
 
-    if (m_pConfig)
+    if (m_cache)
+    {
+        lReturn = m_cache->GetLong(path, defaultValue, &loaded);
+    }
+    else if (m_pConfig)
     {
         m_pConfig->Read(path, &lReturn, defaultValue);
     }
 
-    Debug.Write(wxString::Format("GetInt(\"%s\", %d) returns %d\n", path, defaultValue, (int) lReturn));
+    if (loaded)
+        Debug.Write(wxString::Format("GetInt(\"%s\", %d) returns %d\n", path, defaultValue, (int) lReturn));
 
     return (int) lReturn;
 }
@@ -134,7 +179,10 @@ void ConfigSection::SetBoolean(const wxString& name, bool value)
 {
     if (m_pConfig)
     {
-        m_pConfig->Write(m_prefix + name, value);
+        if (m_cache)
+            m_cache->SetBoolean(m_prefix + name, value);
+        else
+            m_pConfig->Write(m_prefix + name, value);
         EvtServer.NotifyConfigurationChange();
     }
 }
@@ -143,7 +191,10 @@ void ConfigSection::SetString(const wxString& name, const wxString& value)
 {
     if (m_pConfig)
     {
-        m_pConfig->Write(m_prefix + name, value);
+        if (m_cache)
+            m_cache->SetString(m_prefix + name, value);
+        else
+            m_pConfig->Write(m_prefix + name, value);
         EvtServer.NotifyConfigurationChange();
     }
 }
@@ -152,7 +203,10 @@ void ConfigSection::SetDouble(const wxString& name, double value)
 {
     if (m_pConfig)
     {
-        m_pConfig->Write(m_prefix + name, value);
+        if (m_cache)
+            m_cache->SetDouble(m_prefix + name, value);
+        else
+            m_pConfig->Write(m_prefix + name, value);
         EvtServer.NotifyConfigurationChange();
     }
 }
@@ -161,7 +215,10 @@ void ConfigSection::SetLong(const wxString& name, long value)
 {
     if (m_pConfig)
     {
-        m_pConfig->Write(m_prefix + name, value);
+        if (m_cache)
+            m_cache->SetLong(m_prefix + name, value);
+        else
+            m_pConfig->Write(m_prefix + name, value);
         EvtServer.NotifyConfigurationChange();
     }
 }
@@ -193,18 +250,26 @@ wxRect ConfigSection::GetRect(const wxString& name)
 
 bool ConfigSection::HasEntry(const wxString& name) const
 {
+    if (m_cache)
+        return m_cache->HasEntry(m_prefix + name);
     return m_pConfig && m_pConfig->HasEntry(m_prefix + name);
 }
 
 void ConfigSection::DeleteEntry(const wxString& name)
 {
-    m_pConfig->DeleteEntry(m_prefix + name);
+    if (m_cache)
+        m_cache->DeleteEntry(m_prefix + name);
+    else
+        m_pConfig->DeleteEntry(m_prefix + name);
     EvtServer.NotifyConfigurationChange();
 }
 
 void ConfigSection::DeleteGroup(const wxString& name)
 {
-    m_pConfig->DeleteGroup(m_prefix + name);
+    if (m_cache)
+        m_cache->DeleteGroup(m_prefix + name);
+    else
+        m_pConfig->DeleteGroup(m_prefix + name);
     EvtServer.NotifyConfigurationChange();
 }
 
@@ -212,6 +277,8 @@ void ConfigSection::DeleteGroup(const wxString& name)
 // e.g. baseName = "scope" would enumerate all the nodes in the profile whose parent is "scope"
 std::vector<wxString> ConfigSection::GetGroupNames(const wxString& baseName)
 {
+    FlushCache();
+
     wxString oldPath = m_pConfig->GetPath();
     m_pConfig->SetPath(m_prefix + baseName);
     long lInx;
@@ -243,6 +310,7 @@ PhdConfig::PhdConfig(int instance)
 {
     wxConfig *config = new wxConfig(ConfigName(instance));
     Global.m_pConfig = Profile.m_pConfig = config;
+    Profile.m_cache.reset(new ProfileCache(config));
 
     m_isNewInstance = false;
 
@@ -260,6 +328,7 @@ PhdConfig::PhdConfig(int instance)
 
 PhdConfig::~PhdConfig()
 {
+    Profile.m_cache.reset(); // writes back any pending changes
     delete Global.m_pConfig;
 }
 
@@ -277,6 +346,286 @@ struct AutoConfigPath
     ~AutoConfigPath() { m_cfg->SetPath(m_savePath); }
 };
 
+enum
+{
+    ProfileFlushDelayMs = 1000, // write changes to the backend once settings have been left alone this long
+};
+
+ProfileCache::ProfileCache(wxConfig *config)
+    : m_config(config), m_snapshot(std::make_shared<EntryMap>()), m_flushScheduled(false), m_flushTimer(this)
+{
+}
+
+ProfileCache::~ProfileCache()
+{
+    m_flushTimer.Stop();
+    Flush();
+}
+
+// Read every value in the group. The backend does not record the type a value was written with
+// (the config file stores strings, the registry strings and integers), so fill in each typed value
+// the way wxConfig would convert it when read; anything else is read through on first use.
+void ProfileCache::LoadGroup(const wxString& group, EntryMap *entries)
+{
+    wxString str;
+    long cookie;
+
+    AutoConfigPath changer(m_config, group);
+
+    bool more = m_config->GetFirstGroup(str, cookie);
+    while (more)
+    {
+        LoadGroup(group + "/" + str, entries);
+        more = m_config->GetNextGroup(str, cookie);
+    }
+
+    more = m_config->GetFirstEntry(str, cookie);
+    while (more)
+    {
+        wxString path = group + "/" + str;
+        Entry& e = (*entries)[path];
+        e.exists = true;
+
+        switch (m_config->GetEntryType(path))
+        {
+        case wxConfigBase::Type_String:
+        {
+            wxString val;
+            m_config->Read(path, &val);
+            e.Store(val);
+            long lval;
+            if (val.ToLong(&lval))
+            {
+                e.Store(lval);
+                e.Store(lval != 0);
+            }
+            double dval;
+            if (val.ToCDouble(&dval) || val.ToDouble(&dval))
+                e.Store(dval);
+            break;
+        }
+        case wxConfigBase::Type_Integer:
+        {
+            long lval;
+            m_config->Read(path, &lval);
+            e.Store(lval);
+            e.Store(lval != 0);
+            break;
+        }
+        default:
+            break;
+        }
+
+        more = m_config->GetNextEntry(str, cookie);
+    }
+}
+
+// make a new set of entries the current snapshot; readers holding the previous one keep it alive
+void ProfileCache::Publish(EntryMap *entries)
+{
+    std::atomic_store(&m_snapshot, std::shared_ptr<const EntryMap>(entries));
+}
+
+void ProfileCache::Load(const wxString& prefix)
+{
+    wxMutexLocker lock(m_lock);
+
+    FlushLocked();
+
+    wxStopWatch swatch;
+    EntryMap *entries = new EntryMap();
+    if (m_config->HasGroup(prefix))
+        LoadGroup(prefix, entries);
+    Publish(entries);
+
+    Debug.Write(wxString::Format("Profile cache: loaded %u values from %s in %ld ms\n", (unsigned int) entries->size(),
+                                 prefix, swatch.Time()));
+}
+
+void ProfileCache::FlushLocked()
+{
+    for (const auto& item : m_pending)
+    {
+        const wxString& path = item.first;
+        const Entry& e = item.second;
+
+        if (e.has & Entry::HAS_STRING)
+            m_config->Write(path, e.s);
+        else if (e.has & Entry::HAS_LONG)
+            m_config->Write(path, e.l);
+        else if (e.has & Entry::HAS_DOUBLE)
+            m_config->Write(path, e.d);
+        else if (e.has & Entry::HAS_BOOL)
+            m_config->Write(path, e.b);
+    }
+
+    m_pending.clear();
+}
+
+void ProfileCache::Flush()
+{
+    wxMutexLocker lock(m_lock);
+    m_flushScheduled = false;
+    FlushLocked();
+}
+
+// (re)start the countdown to writing the pending changes. The timer belongs to the main thread; a
+// change made on another thread starts it if it is not already counting down.
+void ProfileCache::ScheduleFlush()
+{
+    if (wxThread::IsMain())
+        m_flushTimer.StartOnce(ProfileFlushDelayMs);
+    else if (!m_flushScheduled)
+        PhdApp::ExecInMainThread([this]() { m_flushTimer.StartOnce(ProfileFlushDelayMs); });
+
+    m_flushScheduled = true;
+}
+
+template<typename T>
+T ProfileCache::Get(const wxString& path, const T& defaultValue, bool *loaded)
+{
+    T val;
+
+    *loaded = false;
+
+    {
+        std::shared_ptr<const EntryMap> snapshot = std::atomic_load(&m_snapshot);
+        auto it = snapshot->find(path);
+        if (it != snapshot->end())
+        {
+            if (!it->second.exists)
+                return defaultValue;
+            if (it->second.Lookup(&val))
+                return val;
+        }
+    }
+
+    // not seen yet, or not with this type: read through to the backend
+    wxMutexLocker lock(m_lock);
+
+    // the backend must have any pending change to this key before it converts it to another type
+    FlushLocked();
+
+    EntryMap *entries = new EntryMap(*m_snapshot);
+    Entry& e = (*entries)[path];
+    e.exists = m_config->HasEntry(path);
+    val = defaultValue;
+    if (e.exists && m_config->Read(path, &val, defaultValue))
+        e.Store(val);
+    Publish(entries);
+
+    *loaded = true;
+    return val;
+}
+
+template<typename T>
+void ProfileCache::Set(const wxString& path, const T& value)
+{
+    wxMutexLocker lock(m_lock);
+
+    Entry e;
+    e.exists = true;
+    e.Store(value);
+
+    EntryMap *entries = new EntryMap(*m_snapshot);
+    (*entries)[path] = e;
+    Publish(entries);
+
+    m_pending[path] = e;
+    ScheduleFlush();
+}
+
+bool ProfileCache::GetBoolean(const wxString& path, bool defaultValue, bool *loaded)
+{
+    return Get(path, defaultValue, loaded);
+}
+
+wxString ProfileCache::GetString(const wxString& path, const wxString& defaultValue, bool *loaded)
+{
+    return Get(path, defaultValue, loaded);
+}
+
+double ProfileCache::GetDouble(const wxString& path, double defaultValue, bool *loaded)
+{
+    return Get(path, defaultValue, loaded);
+}
+
+long ProfileCache::GetLong(const wxString& path, long defaultValue, bool *loaded)
+{
+    return Get(path, defaultValue, loaded);
+}
+
+void ProfileCache::SetBoolean(const wxString& path, bool value)
+{
+    Set(path, value);
+}
+
+void ProfileCache::SetString(const wxString& path, const wxString& value)
+{
+    Set(path, value);
+}
+
+void ProfileCache::SetDouble(const wxString& path, double value)
+{
+    Set(path, value);
+}
+
+void ProfileCache::SetLong(const wxString& path, long value)
+{
+    Set(path, value);
+}
+
+bool ProfileCache::HasEntry(const wxString& path)
+{
+    {
+        std::shared_ptr<const EntryMap> snapshot = std::atomic_load(&m_snapshot);
+        auto it = snapshot->find(path);
+        if (it != snapshot->end())
+            return it->second.exists;
+    }
+
+    wxMutexLocker lock(m_lock);
+
+    EntryMap *entries = new EntryMap(*m_snapshot);
+    Entry& e = (*entries)[path];
+    e.exists = m_config->HasEntry(path);
+    Publish(entries);
+
+    return e.exists;
+}
+
+void ProfileCache::DeleteEntry(const wxString& path)
+{
+    wxMutexLocker lock(m_lock);
+
+    FlushLocked();
+    m_config->DeleteEntry(path);
+
+    EntryMap *entries = new EntryMap(*m_snapshot);
+    (*entries)[path] = Entry();
+    Publish(entries);
+}
+
+void ProfileCache::DeleteGroup(const wxString& path)
+{
+    wxMutexLocker lock(m_lock);
+
+    FlushLocked();
+    m_config->DeleteGroup(path);
+
+    // forget everything under the group; those keys are read through again if asked for
+    EntryMap *entries = new EntryMap(*m_snapshot);
+    wxString groupPrefix = path + "/";
+    for (auto it = entries->begin(); it != entries->end();)
+    {
+        if (it->first.StartsWith(groupPrefix))
+            it = entries->erase(it);
+        else
+            ++it;
+    }
+    Publish(entries);
+}
+
 int PhdConfig::FirstProfile()
 {
     AutoConfigPath changer(Profile.m_pConfig, "/profile");
@@ -319,6 +668,7 @@ void PhdConfig::DeleteAll()
     if (Global.m_pConfig)
     {
         Debug.Write(wxString::Format("Deleting all configuration data\n"));
+        Profile.FlushCache();
         Global.m_pConfig->DeleteAll();
         InitializeProfile();
     }
@@ -506,6 +856,7 @@ bool PhdConfig::CloneProfile(const wxString& dest, const wxString& source)
         return true; // ??? should never happen
     }
 
+    Profile.FlushCache();
     CopyGroup(Global.m_pConfig, wxString::Format("/profile/%d", srcId), wxString::Format("/profile/%d", dstId));
     // name was overwritten by copy
     Global.SetString(wxString::Format("/profile/%d/name", dstId), dest);
@@ -521,6 +872,7 @@ void PhdConfig::DeleteProfile(const wxString& name)
     if (id <= 0)
         return;
 
+    Profile.FlushCache();
     Global.m_pConfig->DeleteGroup(wxString::Format("/profile/%d", id));
 
     if (NumProfiles() == 0)
@@ -712,7 +1064,10 @@ bool PhdConfig::ReadProfile(const wxString& filename)
     int id = GetProfileId(profileName);
     if (id > 0)
     {
+        Profile.FlushCache();
         Global.m_pConfig->DeleteGroup(wxString::Format("/profile/%d", id));
+        if (id == m_currentProfileId)
+            Profile.ReloadCache();
     }
 
     CreateProfile(profileName);
@@ -807,6 +1162,7 @@ bool PhdConfig::WriteProfile(const wxString& filename)
 
     tos.WriteString("PHD Profile " PROFILE_STREAM_VERSION "\n");
     wxString profile = wxString::Format("/profile/%d", m_currentProfileId);
+    Profile.FlushCache();
     WriteGroup(tos, Profile.m_pConfig, profile, profile);
 
     return false;
@@ -822,6 +1178,7 @@ bool PhdConfig::SaveAll(const wxString& filename)
     wxTextOutputStream tos(os, wxEOL_NATIVE, wxMBConvUTF8());
 
     tos.WriteString("PHD Config " PROFILE_STREAM_VERSION "\n");
+    Profile.FlushCache();
     WriteGroup(tos, Global.m_pConfig, wxEmptyString, wxEmptyString);
 
     return false;
@@ -844,6 +1201,7 @@ bool PhdConfig::RestoreAll(const wxString& filename)
         return true;
     }
 
+    Profile.FlushCache();
     Global.m_pConfig->DeleteAll();
 
     while (!is.Eof())
@@ -855,6 +1213,8 @@ bool PhdConfig::RestoreAll(const wxString& filename)
         LoadVal(Global, s, name, typestr, val);
     }
 
+    Profile.ReloadCache();
+
     EvtServer.NotifyConfigurationChange();
 
     return false;
@@ -864,6 +1224,8 @@ bool PhdConfig::Flush()
 {
     Debug.Write("PhdConfig flush\n");
 
+    Profile.FlushCache();
+
     // On Linux and Mac, this will write the config file if it is dirty
     // (no-op if it is not dirty).  Always a no-op on Windows.
     bool ok = Global.m_pConfig->Flush();
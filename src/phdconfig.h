@@ -63,14 +63,116 @@
  * the configuration values for thier classes, and dialogs that modify them
  * write the values immediately.
  *
+ * Values in the current profile are served from an in-memory copy (see
+ * ProfileCache below), so reading a setting while guiding never goes to
+ * the registry or config file.
+ *
  */
 
 class PhdConfig;
 
+// In-memory copy of the current profile's settings.
+//
+// Readers look values up in an immutable snapshot that is swapped out whenever a value is loaded
+// or changed, so they never wait on the config backend or on a writer. The whole profile is
+// loaded with a single pass over the backend when it is selected; a key that is not there yet
+// is read through once and remembered, present or not. Changes go into the snapshot at once
+// and are written to the backend in a batch shortly after the last one.
+class ProfileCache
+{
+    struct Entry
+    {
+        enum
+        {
+            HAS_STRING = 1 << 0,
+            HAS_LONG = 1 << 1,
+            HAS_DOUBLE = 1 << 2,
+            HAS_BOOL = 1 << 3,
+        };
+
+        bool exists;
+        unsigned int has; // which of the typed values below are known
+        wxString s;
+        long l;
+        double d;
+        bool b;
+
+        Entry() : exists(false), has(0), l(0), d(0.0), b(false) { }
+
+        bool Lookup(wxString *val) const { return Lookup(HAS_STRING, s, val); }
+        bool Lookup(long *val) const { return Lookup(HAS_LONG, l, val); }
+        bool Lookup(double *val) const { return Lookup(HAS_DOUBLE, d, val); }
+        bool Lookup(bool *val) const { return Lookup(HAS_BOOL, b, val); }
+
+        void Store(const wxString& val) { s = val; has |= HAS_STRING; }
+        void Store(long val) { l = val; has |= HAS_LONG; }
+        void Store(double val) { d = val; has |= HAS_DOUBLE; }
+        void Store(bool val) { b = val; has |= HAS_BOOL; }
+
+    private:
+        template<typename T>
+        bool Lookup(unsigned int flag, const T& cached, T *val) const
+        {
+            if ((has & flag) == 0)
+                return false;
+            *val = cached;
+            return true;
+        }
+    };
+    typedef std::map<wxString, Entry> EntryMap;
+
+    class FlushTimer : public wxTimer
+    {
+        ProfileCache *m_cache;
+
+    public:
+        FlushTimer(ProfileCache *cache) : m_cache(cache) { }
+        void Notify() override { m_cache->Flush(); }
+    };
+
+    wxConfig *m_config;
+    std::shared_ptr<const EntryMap> m_snapshot; // accessed with std::atomic_load/atomic_store
+    wxMutex m_lock; // serializes changes to the snapshot and access to the backend
+    EntryMap m_pending; // changes not yet written to the backend
+    bool m_flushScheduled;
+    FlushTimer m_flushTimer;
+
+    template<typename T>
+    T Get(const wxString& path, const T& defaultValue, bool *loaded);
+    template<typename T>
+    void Set(const wxString& path, const T& value);
+    void LoadGroup(const wxString& group, EntryMap *entries);
+    void Publish(EntryMap *entries);
+    void FlushLocked();
+    void ScheduleFlush();
+
+public:
+    ProfileCache(wxConfig *config);
+    ~ProfileCache();
+
+    void Load(const wxString& prefix);
+    void Flush();
+
+    bool GetBoolean(const wxString& path, bool defaultValue, bool *loaded);
+    wxString GetString(const wxString& path, const wxString& defaultValue, bool *loaded);
+    double GetDouble(const wxString& path, double defaultValue, bool *loaded);
+    long GetLong(const wxString& path, long defaultValue, bool *loaded);
+
+    void SetBoolean(const wxString& path, bool value);
+    void SetString(const wxString& path, const wxString& value);
+    void SetDouble(const wxString& path, double value);
+    void SetLong(const wxString& path, long value);
+
+    bool HasEntry(const wxString& path);
+    void DeleteEntry(const wxString& path);
+    void DeleteGroup(const wxString& path);
+};
+
 class ConfigSection
 {
     wxConfig *m_pConfig;
     wxString m_prefix;
+    std::unique_ptr<ProfileCache> m_cache; // only for the profile section
 
     friend class PhdConfig;
 
@@ -79,6 +181,8 @@ public:
     ~ConfigSection();
 
     void SelectProfile(int profileId);
+    void FlushCache();
+    void ReloadCache();
 
     bool GetBoolean(const wxString& name, bool defaultValue);
     wxString GetString(const wxString& name, const wxString& defaultValue);
@@ -34,6 +34,7 @@
 
 #include "phd.h"
 
+#include "driver_registry.h"
 #include "gear_simulator.h"
 #include "rotator_ascom.h"
 #include "rotator_indi.h"
@@ -55,7 +56,7 @@ wxArrayString Rotator::RotatorList()
 
     rotatorList.Add(_("None"));
 #ifdef ROTATOR_ASCOM
-    wxArrayString ascomRotators = RotatorAscom::EnumAscomRotators();
+    wxArrayString ascomRotators = DriverRegistry::Devices("ASCOM rotators", &RotatorAscom::EnumAscomRotators);
     for (unsigned int i = 0; i < ascomRotators.Count(); i++)
         rotatorList.Add(ascomRotators[i]);
 #endif
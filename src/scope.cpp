@@ -36,6 +36,7 @@
 #include "backlash_comp.h"
 #include "calreview_dialog.h"
 #include "calstep_dialog.h"
+#include "driver_registry.h"
 #include "image_math.h"
 #include "socket_server.h"
 
@@ -339,7 +340,7 @@ wxArrayString Scope::MountList()
 
     ScopeList.Add(_("None"));
 #ifdef GUIDE_ASCOM
-    wxArrayString ascomScopes = ScopeASCOM::EnumAscomScopes();
+    wxArrayString ascomScopes = DriverRegistry::Devices("ASCOM telescopes", &ScopeASCOM::EnumAscomScopes);
     for (unsigned int i = 0; i < ascomScopes.Count(); i++)
         ScopeList.Add(ascomScopes[i]);
 #endif
@@ -382,7 +383,7 @@ wxArrayString Scope::AuxMountList()
     scopeList.Add(_("None")); // Keep this at the top of the list
 
 #ifdef GUIDE_ASCOM
-    wxArrayString positionAwareScopes = ScopeASCOM::EnumAscomScopes();
+    wxArrayString positionAwareScopes = DriverRegistry::Devices("ASCOM telescopes", &ScopeASCOM::EnumAscomScopes);
     positionAwareScopes.Sort(&CompareNoCase);
     for (unsigned int i = 0; i < positionAwareScopes.Count(); i++)
         scopeList.Add(positionAwareScopes[i]);
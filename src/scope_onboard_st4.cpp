@@ -208,3 +208,24 @@ bool ScopeOnboardST4::SynchronousOnly(void)
 
     return syncOnly;
 }
+
+bool ScopeOnboardST4::CanGuideAxesSimultaneously(void)
+{
+    bool simultaneous = false;
+
+    try
+    {
+        if (!IsConnected() || !m_pOnboardHost || !m_pOnboardHost->ST4HostConnected())
+        {
+            throw ERROR_INFO("ScopeOnboardST4: Attempt to get CanGuideAxesSimultaneously when not connected");
+        }
+
+        simultaneous = m_pOnboardHost->ST4CanGuideAxesSimultaneously();
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+    }
+
+    return simultaneous;
+}
@@ -39,6 +39,22 @@ SerialPort::SerialPort(void) { }
 
 SerialPort::~SerialPort(void) { }
 
+void SerialPort::Queue(const unsigned char *pData, unsigned count)
+{
+    m_queued.insert(m_queued.end(), pData, pData + count);
+}
+
+bool SerialPort::Flush()
+{
+    if (m_queued.empty())
+        return false;
+
+    bool bError = Send(&m_queued[0], m_queued.size());
+    m_queued.clear();
+
+    return bError;
+}
+
 SerialPort *SerialPort::SerialPortFactory(void)
 {
 #if defined(_WINDOWS_)
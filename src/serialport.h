@@ -36,8 +36,12 @@
 #ifndef SERIALPORT_H_INCLUDED
 #define SERIALPORT_H_INCLUDED
 
+#include <vector>
+
 class SerialPort
 {
+    std::vector<unsigned char> m_queued;
+
 public:
     enum PARITY
     {
@@ -65,6 +69,12 @@ public:
 
     virtual bool SetRTS(bool asserted) = 0;
     virtual bool SetDTR(bool asserted) = 0;
+
+    // Pipelined commands: Queue() appends a command to the outgoing batch and Flush() writes the
+    // whole batch with a single Send(). The caller then collects the responses with Receive(), so a
+    // device that acknowledges each command costs one round trip per batch rather than per command.
+    void Queue(const unsigned char *pData, unsigned count);
+    bool Flush();
 };
 
 #endif // SERIALPORT_H_INCLUDED
@@ -43,8 +43,6 @@ wxArrayString SerialPortLoopback::GetSerialPortList(void)
 
     try
     {
-        DWORD res = 0;
-
         ret.Add("Loopback 1");
     }
     catch (const wxString& Msg)
@@ -55,10 +53,7 @@ wxArrayString SerialPortLoopback::GetSerialPortList(void)
     return ret;
 }
 
-SerialPortLoopback::SerialPortLoopback(void)
-{
-    m_data = 0;
-}
+SerialPortLoopback::SerialPortLoopback(void) { }
 
 SerialPortLoopback::~SerialPortLoopback(void) { }
 
@@ -101,6 +96,8 @@ bool SerialPortLoopback::SetReceiveTimeout(int timeoutMs)
 
     try
     {
+        // like the real ports, discard any unread input
+        m_responses.clear();
     }
     catch (const wxString& Msg)
     {
@@ -117,7 +114,45 @@ bool SerialPortLoopback::Send(const unsigned char *pData, unsigned count)
 
     try
     {
-        m_data = *pData;
+        const unsigned char *end = pData + count;
+
+        while (pData < end)
+        {
+            unsigned char cmd = *pData;
+
+            switch (cmd)
+            {
+            case 'G': // step
+            case 'M': // ST-4 move
+                if (end - pData < 7)
+                {
+                    throw ERROR_INFO("SerialPortLoopback: short long command");
+                }
+                m_responses.push_back(cmd);
+                pData += 7;
+                break;
+            case 'K': // center
+            case 'R': // unjam
+                m_responses.push_back('K');
+                ++pData;
+                break;
+            case 'V': // firmware version
+                m_responses.insert(m_responses.end(), { 'V', '9', '9', '9' });
+                ++pData;
+                break;
+            case 'L': // limit switches, none closed
+                m_responses.push_back('0');
+                ++pData;
+                break;
+            default:
+                m_responses.push_back(cmd);
+                ++pData;
+                break;
+            }
+        }
+
+        // one write, one round trip, however many commands it carried
+        wxMilliSleep(RoundTripMs);
     }
     catch (const wxString& Msg)
     {
@@ -134,26 +169,13 @@ bool SerialPortLoopback::Receive(unsigned char *pData, unsigned count)
 
     try
     {
-        if (count == 3)
+        if (m_responses.size() < count)
         {
-            char *pVersion = "999";
-
-            memcpy(pData, pVersion, strlen(pVersion));
+            throw ERROR_INFO("not enough characters");
         }
-        else
-        {
-            if (m_data == 0)
-            {
-                throw ERROR_INFO("not enough characters");
-            }
-
-            if (m_data == 'R')
-            {
-                m_data = 'K';
-            }
 
-            *pData = m_data;
-        }
+        std::copy(m_responses.begin(), m_responses.begin() + count, pData);
+        m_responses.erase(m_responses.begin(), m_responses.begin() + count);
     }
     catch (const wxString& Msg)
     {
@@ -164,4 +186,14 @@ bool SerialPortLoopback::Receive(unsigned char *pData, unsigned count)
     return bError;
 }
 
+bool SerialPortLoopback::SetRTS(bool asserted)
+{
+    return false;
+}
+
+bool SerialPortLoopback::SetDTR(bool asserted)
+{
+    return false;
+}
+
 #endif // USE_LOOPBACK_SERIAL
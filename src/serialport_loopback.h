@@ -36,10 +36,15 @@
 #if !defined(SERIALPORT_LOOPBACK_H_INCLUDED)
 # define SERIALPORT_LOOPBACK_H_INCLUDED
 
+# include <deque>
+
+// Stands in for an SX AO on the other end of the line: each command sent queues the response the
+// AO would give, after a simulated round trip, so that AO code can be exercised and timed without
+// hardware.
 class SerialPortLoopback : public SerialPort
 {
-    const static int MaxDataSize = 128;
-    char m_data;
+    static const int RoundTripMs = 10;
+    std::deque<unsigned char> m_responses;
 
 public:
     wxArrayString GetSerialPortList() override;
@@ -55,6 +60,9 @@ public:
 
     bool SetReceiveTimeout(int timeoutMs) override;
     bool Receive(unsigned char *pData, unsigned count) override;
+
+    bool SetRTS(bool asserted) override;
+    bool SetDTR(bool asserted) override;
 };
 
 #endif // SERIALPORT_LOOPBACK_H_INCLUDED
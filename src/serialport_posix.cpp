@@ -38,9 +38,12 @@
 
 # include <termios.h>
 # include <unistd.h>
+# include <poll.h>
 # include <sys/ioctl.h>
 # include <errno.h>
 
+# include <chrono>
+
 wxArrayString SerialPortPosix::GetSerialPortList(void)
 {
     wxArrayString ret;
@@ -58,6 +61,8 @@ wxArrayString SerialPortPosix::GetSerialPortList(void)
 SerialPortPosix::SerialPortPosix(void)
 {
     m_fd = -1;
+    m_timeoutMs = 0;
+    m_readPos = m_readEnd = 0;
 }
 
 SerialPortPosix::~SerialPortPosix(void)
@@ -76,6 +81,8 @@ bool SerialPortPosix::Connect(const wxString& portName, int baud, int dataBits,
 
     try
     {
+        m_readPos = m_readEnd = 0;
+
         if ((m_fd = open(portName.mb_str(), O_RDWR | O_NOCTTY)) < 0)
         {
             wxString exposeToUser = wxString::Format("open %s failed %s(%d)", portName, strerror((int) errno), (int) errno);
@@ -141,8 +148,9 @@ bool SerialPortPosix::Connect(const wxString& portName, int baud, int dataBits,
         attr.c_lflag &= ~ICANON; // Do not wait for a line delimiter. Work in noncanonical mode.
         attr.c_lflag &= ~(ECHO | ECHOE | ISIG | IEXTEN | NOFLSH | TOSTOP); // local modes
         attr.c_lflag |= NOFLSH;
-        attr.c_cc[VTIME] = (uint8_t) 0; // timeout in deciseconds
-        attr.c_cc[VMIN] = (uint8_t) 0; // minimum number of characters for noncanonical read
+        // reads never block in the driver; Receive() waits with poll() so that timeouts are in milliseconds
+        attr.c_cc[VTIME] = (uint8_t) 0;
+        attr.c_cc[VMIN] = (uint8_t) 0;
 
         unsigned int speed = B0;
         switch (baud)
@@ -237,10 +245,13 @@ bool SerialPortPosix::Disconnect(void)
     }
 
     m_fd = -1;
+    m_readPos = m_readEnd = 0;
 
     return bError;
 }
 
+// The timeout applies to a whole Receive() call. As with the termios-based timeout this replaces,
+// changing it discards any input that has not been read yet.
 bool SerialPortPosix::SetReceiveTimeout(int timeoutMilliSeconds)
 {
     bool bError = false;
@@ -249,17 +260,12 @@ bool SerialPortPosix::SetReceiveTimeout(int timeoutMilliSeconds)
 
     try
     {
-        struct termios attr;
+        m_timeoutMs = timeoutMilliSeconds;
+        m_readPos = m_readEnd = 0;
 
-        if (tcgetattr(m_fd, &attr) < 0)
+        if (tcflush(m_fd, TCIFLUSH) < 0)
         {
-            throw ERROR_INFO("tcgetattr failed");
-        }
-        int timeoutDeciSeconds = (timeoutMilliSeconds + 99) / 100;
-        attr.c_cc[VTIME] = (uint8_t) timeoutDeciSeconds;
-        if (tcsetattr(m_fd, TCSAFLUSH, &attr) < 0)
-        {
-            throw ERROR_INFO("tcsetattr failed");
+            throw ERROR_INFO("tcflush failed");
         }
     }
     catch (const wxString& Msg)
@@ -300,33 +306,71 @@ bool SerialPortPosix::Send(const unsigned char *pData, unsigned int count)
     return bError;
 }
 
+// Wait up to timeoutMs for input and read whatever is available into the (empty) read buffer.
+// Returns true on error or timeout.
+bool SerialPortPosix::FillReadBuffer(int timeoutMs)
+{
+    struct pollfd pfd;
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int ret = poll(&pfd, 1, timeoutMs);
+    if (ret < 0)
+        return errno != EINTR; // a signal is not an error, the caller will poll again
+    if (ret == 0)
+        return true; // timed out
+
+    ssize_t const receiveCount = read(m_fd, m_readBuf, sizeof(m_readBuf));
+
+    if (receiveCount < 0)
+        return errno != EINTR && errno != EAGAIN;
+
+    if (receiveCount == 0)
+        return true; // eof
+
+    Debug.AddBytes("SerialPortPosix::Receive", m_readBuf, receiveCount);
+
+    m_readPos = 0;
+    m_readEnd = receiveCount;
+
+    return false;
+}
+
 bool SerialPortPosix::Receive(unsigned char *pData, unsigned int count)
 {
     bool bError = false;
 
     try
     {
+        typedef std::chrono::steady_clock clock;
+        clock::time_point const deadline = clock::now() + std::chrono::milliseconds(m_timeoutMs);
+
         size_t rem = count;
 
         while (rem > 0)
         {
-            ssize_t const receiveCount = read(m_fd, pData, rem);
-
-            if (receiveCount == -1)
-                throw ERROR_INFO("SerialPortPosix: read Failed");
-
-            if (receiveCount == 0)
-                break; // eof
-
-            Debug.AddBytes("SerialPortPosix::Receive", pData, receiveCount);
-
-            rem -= receiveCount;
-            pData += receiveCount;
+            if (m_readPos == m_readEnd)
+            {
+                long long const waitUs =
+                    std::chrono::duration_cast<std::chrono::microseconds>(deadline - clock::now()).count();
+                long long const waitMs = (waitUs + 999) / 1000;
+
+                if (FillReadBuffer(waitMs > 0 ? (int) waitMs : 0))
+                    break;
+            }
+
+            size_t n = std::min(rem, (size_t) (m_readEnd - m_readPos));
+            memcpy(pData, m_readBuf + m_readPos, n);
+
+            m_readPos += n;
+            rem -= n;
+            pData += n;
         }
 
         if (rem > 0)
         {
-            throw ERROR_INFO("SerialPortPosix: " + wxString::Format(wxT("%i"), rem) + " remaining bytes to read at eof " +
+            throw ERROR_INFO("SerialPortPosix: " + wxString::Format(wxT("%i"), rem) + " remaining bytes to read at timeout " +
                              ", expected total of " + wxString::Format(wxT("%i"), count));
         }
     }
@@ -45,6 +45,14 @@ class SerialPortPosix : public SerialPort
 #  if defined(__APPLE__)
     struct termios m_originalAttrs;
 #  endif
+    int m_timeoutMs;
+
+    // bytes read from the port but not yet handed to Receive()
+    unsigned char m_readBuf[256];
+    unsigned m_readPos;
+    unsigned m_readEnd;
+
+    bool FillReadBuffer(int timeoutMs);
 
 public:
     wxArrayString GetSerialPortList() override;
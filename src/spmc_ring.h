@@ -0,0 +1,186 @@
+/*
+ *  spmc_ring.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#ifndef SPMC_RING_INCLUDED
+#define SPMC_RING_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Lock-free single-producer, multi-consumer ring.
+//
+// The producer never waits: once the ring is full each new entry overwrites the oldest one.
+// Consumers never block the producer either; each consumer keeps its own read position (an
+// entry index, counting from 0 for the first entry ever pushed) and copies out the entries it
+// has not seen yet, in at most two contiguous runs. Entries the producer overwrote before a
+// consumer got to them are skipped and reported as lost.
+//
+// Overwrite detection works like a sequence lock: the producer bumps a claim counter before it
+// writes a slot and a publish counter after, and a consumer re-checks the claim counter after
+// copying, dropping anything that may have been rewritten during the copy. Entries are copied
+// with memcpy, so T must be trivially copyable.
+//
+// Capacity is rounded up to a power of two so that an index maps to its slot with a mask. The
+// counters that are written by the producer sit on their own cache line so that consumers
+// polling the publish counter do not contend with the slot writes.
+template<typename T>
+class SpmcRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpmcRing entries are copied with memcpy");
+
+    enum
+    {
+        CacheLine = 64
+    };
+
+    // read-only after construction
+    std::unique_ptr<T[]> m_slots;
+    uint64_t m_capacity;
+    uint64_t m_mask;
+    char m_pad0[CacheLine];
+
+    std::atomic<uint64_t> m_claimed; // entries whose write has started
+    std::atomic<uint64_t> m_published; // entries whose write has completed
+    char m_pad1[CacheLine];
+
+    static uint64_t RoundUp(uint64_t n)
+    {
+        uint64_t cap = 1;
+        while (cap < n)
+            cap <<= 1;
+        return cap;
+    }
+
+public:
+    // A run of consecutive entries in the ring storage
+    struct Span
+    {
+        const T *data;
+        size_t size;
+    };
+
+    explicit SpmcRing(size_t capacity)
+        : m_slots(new T[RoundUp(std::max<size_t>(capacity, 1))]), m_capacity(RoundUp(std::max<size_t>(capacity, 1))),
+          m_mask(m_capacity - 1), m_claimed(0), m_published(0)
+    {
+    }
+
+    SpmcRing(const SpmcRing&) = delete;
+    SpmcRing& operator=(const SpmcRing&) = delete;
+
+    size_t Capacity() const { return m_capacity; }
+
+    // total number of entries pushed, the read position just past the newest entry
+    uint64_t Head() const { return m_published.load(std::memory_order_acquire); }
+
+    // producer only
+    void Push(const T& entry)
+    {
+        uint64_t idx = m_claimed.load(std::memory_order_relaxed);
+        m_claimed.store(idx + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&m_slots[idx & m_mask], &entry, sizeof(T));
+        m_published.store(idx + 1, std::memory_order_release);
+    }
+
+    // The published entries from index `from` on that are still in the ring, as at most two
+    // contiguous runs; returns the index of the first entry in the runs. The producer may
+    // overwrite the entries while the caller reads them, so after reading the caller must pass
+    // the returned index to ValidFrom() to find out how much of what it read can be trusted.
+    uint64_t Spans(uint64_t from, Span spans[2]) const
+    {
+        uint64_t head = m_published.load(std::memory_order_acquire);
+        uint64_t first = std::max(from, head > m_capacity ? head - m_capacity : 0);
+        if (first > head)
+            first = head;
+
+        uint64_t count = head - first;
+        uint64_t pos = first & m_mask;
+        uint64_t run = std::min(count, m_capacity - pos);
+        spans[0].data = &m_slots[pos];
+        spans[0].size = run;
+        spans[1].data = &m_slots[0];
+        spans[1].size = count - run;
+
+        return first;
+    }
+
+    // The index of the oldest entry that has certainly not been overwritten since the caller
+    // started reading. Call after reading entries obtained from Spans().
+    uint64_t ValidFrom() const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claimed = m_claimed.load(std::memory_order_relaxed);
+        return claimed > m_capacity ? claimed - m_capacity : 0;
+    }
+
+    // Append the entries from index `from` on to `out`, returning the read position for the next
+    // call. Entries overwritten before they could be copied are skipped; their number is stored
+    // in `lost` when it is given.
+    uint64_t Read(uint64_t from, std::vector<T> *out, uint64_t *lost = nullptr) const
+    {
+        Span spans[2];
+        uint64_t first = Spans(from, spans);
+
+        size_t base = out->size();
+        out->resize(base + spans[0].size + spans[1].size);
+        if (spans[0].size)
+            memcpy(&(*out)[base], spans[0].data, spans[0].size * sizeof(T));
+        if (spans[1].size)
+            memcpy(&(*out)[base + spans[0].size], spans[1].data, spans[1].size * sizeof(T));
+
+        uint64_t valid = ValidFrom();
+        uint64_t end = first + spans[0].size + spans[1].size;
+        if (valid > first)
+        {
+            size_t drop = std::min(valid, end) - first;
+            out->erase(out->begin() + base, out->begin() + base + drop);
+            first += drop;
+        }
+
+        if (lost)
+            *lost = first - std::min(from, first);
+
+        return end;
+    }
+};
+
+#endif // SPMC_RING_INCLUDED
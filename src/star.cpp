@@ -36,7 +36,15 @@
  */
 
 #include "phd.h"
+#include "thread_pool.h"
+
 #include <algorithm>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define HAVE_SSE2_CENTROID
+#endif
 
 Star::Star()
 {
@@ -164,8 +172,12 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
             throw ERROR_INFO("coordinates are invalid");
         }
 
+        // pixel data is addressed relative to the stored area of the frame, which may be just the subframe
+        int const ox = pImg->Storage.GetX();
+        int const oy = pImg->Storage.GetY();
+        int rowsize = pImg->Storage.GetWidth();
         const unsigned short *imgdata = pImg->ImageData;
-        int rowsize = pImg->Size.GetWidth();
+        int const origin = oy * rowsize + ox; // index offset of frame coordinates
 
         int peak_x = 0, peak_y = 0;
         unsigned int peak_val = 0;
@@ -177,7 +189,7 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
             {
                 for (int x = start_x; x <= end_x; x++)
                 {
-                    unsigned short val = imgdata[y * rowsize + x];
+                    unsigned short val = imgdata[y * rowsize + x - origin];
 
                     if (val > peak_val)
                     {
@@ -199,12 +211,10 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
             {
                 for (int x = start_x + 1; x <= end_x - 1; x++)
                 {
-                    unsigned short p = imgdata[y * rowsize + x];
-                    unsigned int val = 4 * (unsigned int) p + imgdata[(y - 1) * rowsize + (x - 1)] +
-                        imgdata[(y - 1) * rowsize + (x + 1)] + imgdata[(y + 1) * rowsize + (x - 1)] +
-                        imgdata[(y + 1) * rowsize + (x + 1)] + 2 * imgdata[(y - 1) * rowsize + (x + 0)] +
-                        2 * imgdata[(y + 0) * rowsize + (x - 1)] + 2 * imgdata[(y + 0) * rowsize + (x + 1)] +
-                        2 * imgdata[(y + 1) * rowsize + (x + 0)];
+                    const unsigned short *c = &imgdata[y * rowsize + x - origin];
+                    unsigned short p = *c;
+                    unsigned int val = 4 * (unsigned int) p + c[-rowsize - 1] + c[-rowsize + 1] + c[rowsize - 1] +
+                        c[rowsize + 1] + 2 * c[-rowsize] + 2 * c[-1] + 2 * c[1] + 2 * c[rowsize];
 
                     if (val > peak_val)
                     {
@@ -252,7 +262,7 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
             double q = 0.0;
             nbg = 0;
 
-            const unsigned short *row = imgdata + rowsize * start_y;
+            const unsigned short *row = imgdata + rowsize * (start_y - oy);
             for (int y = start_y; y <= end_y; y++, row += rowsize)
             {
                 int dy = y - peak_y;
@@ -266,7 +276,7 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
                     if (r2 <= A2 || r2 > B2)
                         continue;
 
-                    double const val = (double) row[x];
+                    double const val = (double) row[x - ox];
 
                     if (iter > 0 && (val < mean_bg - 2.0 * sigma_bg || val > mean_bg + 2.0 * sigma_bg))
                         continue;
@@ -324,7 +334,7 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
 
             n = 0;
 
-            const unsigned short *row = imgdata + rowsize * start_y;
+            const unsigned short *row = imgdata + rowsize * (start_y - oy);
             for (int y = start_y; y <= end_y; y++, row += rowsize)
             {
                 int dy = y - peak_y;
@@ -341,7 +351,7 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
                         continue;
 
                     // exclude points below threshold
-                    unsigned short val = row[x];
+                    unsigned short val = row[x - ox];
                     if (val < thresh)
                         continue;
 
@@ -482,6 +492,148 @@ bool Star::Find(const usImage *pImg, int searchRegion, FindMode mode, double min
     return Find(pImg, searchRegion, X, Y, mode, minHFD, maxHFD, saturation, loggingControl);
 }
 
+static unsigned short RowMax(const unsigned short *row, int n)
+{
+    int i = 0;
+    unsigned short peak = 0;
+#ifdef HAVE_SSE2_CENTROID
+    // SSE2 only has a signed 16-bit max, so compare with the sign bit flipped
+    const __m128i bias = _mm_set1_epi16((short) 0x8000);
+    __m128i vmax = bias;
+    for (; i + 8 <= n; i += 8)
+        vmax = _mm_max_epi16(vmax, _mm_xor_si128(_mm_loadu_si128((const __m128i *) (row + i)), bias));
+    vmax = _mm_xor_si128(vmax, bias);
+    unsigned short lanes[8];
+    _mm_storeu_si128((__m128i *) lanes, vmax);
+    peak = *std::max_element(lanes, lanes + 8);
+#endif
+    for (; i < n; i++)
+        peak = std::max(peak, row[i]);
+    return peak;
+}
+
+// sum of max(row[i] - threshold, 0) and of the same weighted by i
+static void RowMoments(const unsigned short *row, int n, unsigned short threshold, double *mass, double *mx)
+{
+    int i = 0;
+    double m = 0.0, s = 0.0;
+#ifdef HAVE_SSE2_CENTROID
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vt = _mm_set1_epi16((short) threshold);
+    __m128 xlo = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+    __m128 xhi = _mm_setr_ps(4.f, 5.f, 6.f, 7.f);
+    const __m128 step = _mm_set1_ps(8.f);
+    __m128 vm = _mm_setzero_ps();
+    __m128 vs = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_subs_epu16(_mm_loadu_si128((const __m128i *) (row + i)), vt);
+        __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+        __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+        vm = _mm_add_ps(vm, _mm_add_ps(lo, hi));
+        vs = _mm_add_ps(vs, _mm_add_ps(_mm_mul_ps(lo, xlo), _mm_mul_ps(hi, xhi)));
+        xlo = _mm_add_ps(xlo, step);
+        xhi = _mm_add_ps(xhi, step);
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, vm);
+    m = (double) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_ps(lanes, vs);
+    s = (double) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < n; i++)
+    {
+        if (row[i] > threshold)
+        {
+            unsigned int v = row[i] - threshold;
+            m += v;
+            s += (double) v * i;
+        }
+    }
+    *mass = m;
+    *mx = s;
+}
+
+bool Star::FastCentroid(const usImage& img, const wxRect& box, double *x, double *y)
+{
+    wxRect r(box);
+    r.Intersect(img.Storage);
+    if (r.width < 3 || r.height < 3)
+        return false;
+
+    // background and noise from the pixels along the edge of the box, peak from the whole box
+    double bsum = 0.0, bsum2 = 0.0;
+    unsigned int bcnt = 0;
+    unsigned short peak = 0;
+
+    for (int row = 0; row < r.height; row++)
+    {
+        const unsigned short *p = &img.Pixel(r.x, r.y + row);
+        peak = std::max(peak, RowMax(p, r.width));
+
+        if (row == 0 || row == r.height - 1)
+        {
+            for (int i = 0; i < r.width; i++)
+            {
+                bsum += p[i];
+                bsum2 += (double) p[i] * p[i];
+            }
+            bcnt += r.width;
+        }
+        else
+        {
+            bsum += p[0] + p[r.width - 1];
+            bsum2 += (double) p[0] * p[0] + (double) p[r.width - 1] * p[r.width - 1];
+            bcnt += 2;
+        }
+    }
+
+    double bg = bsum / bcnt;
+    double sigma = sqrt(std::max(bsum2 / bcnt - bg * bg, 0.0));
+
+    if (peak <= bg + 5.0 * sigma)
+        return false;
+
+    unsigned short threshold = (unsigned short) std::min(bg + 3.0 * sigma, 65535.0);
+
+    double mass = 0.0, mx = 0.0, my = 0.0;
+
+    for (int row = 0; row < r.height; row++)
+    {
+        double rowMass, rowMx;
+        RowMoments(&img.Pixel(r.x, r.y + row), r.width, threshold, &rowMass, &rowMx);
+        mass += rowMass;
+        mx += rowMx;
+        my += rowMass * row;
+    }
+
+    if (mass <= 0.0)
+        return false;
+
+    *x = r.x + mx / mass;
+    *y = r.y + my / mass;
+
+    return true;
+}
+
+void Star::FindMultiple(const usImage *pImg, int searchRegion, FindMode mode, double minHFD, double maxHFD,
+                        unsigned short saturation, std::vector<FindJob>& jobs)
+{
+    if (jobs.empty())
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    ThreadPool::ParallelFor((unsigned int) jobs.size(), [&](unsigned int i) {
+        FindJob& job = jobs[i];
+        job.found = job.star->Find(pImg, searchRegion, job.X, job.Y, mode, minHFD, maxHFD, saturation, job.loggingControl);
+    });
+
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Debug.Write(wxString::Format("Star::FindMultiple: %u stars, %u threads, %.2f ms frame %u\n", (unsigned int) jobs.size(),
+                                 wxMin(ThreadPool::Concurrency(), (unsigned int) jobs.size()), elapsed, pImg->FrameNum));
+}
+
 struct FloatImg
 {
     float *px;
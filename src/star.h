@@ -85,6 +85,27 @@ public:
     bool Find(const usImage *pImg, int searchRegion, int X, int Y, FindMode mode, double min_hfd, double max_hfd,
               unsigned short saturation, StarFindLogType loggingControl);
 
+    // One entry of a batched measurement: the star to measure (its fields are updated in place,
+    // exactly as a call to Find would update them), where to search for it, and the outcome
+    struct FindJob
+    {
+        Star *star;
+        int X;
+        int Y;
+        StarFindLogType loggingControl;
+        bool found;
+    };
+
+    // Run Find for every job, spreading the jobs across the shared thread pool. Each job only
+    // writes to its own star, so the results are identical to calling Find for the jobs in order.
+    static void FindMultiple(const usImage *pImg, int searchRegion, FindMode mode, double min_hfd, double max_hfd,
+                             unsigned short saturation, std::vector<FindJob>& jobs);
+
+    // Minimal centroid for the AO fast loop: the center of mass of the box above a threshold just
+    // over the background, with none of the HFD, SNR or saturation checks of Find. Returns false
+    // if nothing in the box stands out from the background.
+    static bool FastCentroid(const usImage& img, const wxRect& box, double *x, double *y);
+
     static bool WasFound(FindResult result);
     bool WasFound() const;
     void Invalidate();
@@ -0,0 +1,242 @@
+/*
+ *  star_premeasure.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+#include "star_premeasure.h"
+#include "latency_trace.h"
+
+namespace
+{
+struct Plan
+{
+    bool valid;
+    StarPremeasure::Params params;
+    std::vector<Star> stars;
+    std::vector<Star::FindJob> jobs; // star pointers refer to stars
+
+    Plan() : valid(false) { }
+
+    void Assign(const StarPremeasure::Params& p, const std::vector<Star::FindJob>& src)
+    {
+        params = p;
+        stars.resize(src.size());
+        jobs.resize(src.size());
+        for (size_t i = 0; i < src.size(); i++)
+        {
+            stars[i] = *src[i].star;
+            jobs[i] = src[i];
+            jobs[i].star = &stars[i];
+        }
+        valid = !src.empty();
+    }
+};
+
+struct Results
+{
+    bool valid;
+    unsigned int frameNum; // frame the results were measured on
+    uint64_t measuredAt; // LatencyTrace::Now() when the measurement completed
+
+    Plan measured;
+    std::vector<bool> used; // each result is handed out at most once
+
+    Results() : valid(false), frameNum(0), measuredAt(0) { }
+
+    bool IsFrame(const usImage *img) const { return valid && img->FrameNum == frameNum; }
+};
+
+// running per-frame timings, reset when the plan is cleared
+struct Timing
+{
+    unsigned int count;
+    double total; // milliseconds
+    double max;
+
+    Timing() { Reset(); }
+
+    void Reset()
+    {
+        count = 0;
+        total = max = 0.0;
+    }
+
+    void Add(double ms)
+    {
+        ++count;
+        total += ms;
+        max = std::max(max, ms);
+    }
+
+    double Mean() const { return count ? total / count : 0.0; }
+};
+} // namespace
+
+static wxCriticalSection s_lock;
+static Plan s_plan; // protected by s_lock
+static Results s_results; // protected by s_lock
+static Plan s_work; // worker thread only
+static Timing s_measureTime; // protected by s_lock
+static Timing s_handoffTime; // main thread only
+
+// A planned search is only used for a requested one from the very same position: a search box
+// moved by even a pixel can take in a brighter peak or a different background annulus, and find
+// a different star or centroid than Star::Find would from the requested position
+static bool Matches(const Star::FindJob& measured, const Star::FindJob& requested)
+{
+    return measured.X == requested.X && measured.Y == requested.Y;
+}
+
+void StarPremeasure::SetPlan(const Params& params, const std::vector<Star::FindJob>& jobs)
+{
+    wxCriticalSectionLocker lck(s_lock);
+    s_plan.Assign(params, jobs);
+}
+
+void StarPremeasure::ClearPlan()
+{
+    wxCriticalSectionLocker lck(s_lock);
+    s_plan.valid = false;
+    s_results.valid = false;
+    s_measureTime.Reset();
+    s_handoffTime.Reset();
+}
+
+void StarPremeasure::Run(const usImage *pImage)
+{
+    {
+        wxCriticalSectionLocker lck(s_lock);
+        s_results.valid = false;
+        if (!s_plan.valid)
+            return;
+        s_work.Assign(s_plan.params, s_plan.jobs);
+    }
+
+    uint64_t start = LatencyTrace::Now();
+
+    {
+        TraceSpan span(TRACE_STAR_PREMEASURE);
+        Star::FindMultiple(pImage, s_work.params.searchRegion, s_work.params.mode, s_work.params.minHFD,
+                           s_work.params.maxHFD, s_work.params.saturation, s_work.jobs);
+    }
+
+    uint64_t end = LatencyTrace::Now();
+    double ms = (end - start) / 1e6;
+    unsigned int count;
+    double mean, max;
+
+    {
+        wxCriticalSectionLocker lck(s_lock);
+        s_results.measured.Assign(s_work.params, s_work.jobs);
+        s_results.used.assign(s_work.jobs.size(), false);
+        s_results.frameNum = pImage->FrameNum;
+        s_results.measuredAt = end;
+        s_results.valid = true;
+
+        s_measureTime.Add(ms);
+        count = s_measureTime.count;
+        mean = s_measureTime.Mean();
+        max = s_measureTime.max;
+    }
+
+    Debug.Write(wxString::Format("StarPremeasure: frame %u, %u stars measured in %.1f ms (mean %.1f max %.1f over %u frames)\n",
+                                 pImage->FrameNum, (unsigned int) s_work.jobs.size(), ms, mean, max, count));
+}
+
+void StarPremeasure::FindStars(const usImage *pImage, const Params& params, std::vector<Star::FindJob>& jobs)
+{
+    std::vector<Star::FindJob> remaining;
+    unsigned int premeasured = 0;
+    uint64_t measuredAt = 0;
+
+    {
+        wxCriticalSectionLocker lck(s_lock);
+
+        bool haveResults = s_results.IsFrame(pImage) && s_results.measured.params == params;
+        measuredAt = s_results.measuredAt;
+
+        for (Star::FindJob& job : jobs)
+        {
+            bool matched = false;
+
+            if (haveResults)
+            {
+                const std::vector<Star::FindJob>& measured = s_results.measured.jobs;
+                for (size_t i = 0; i < measured.size(); i++)
+                {
+                    if (s_results.used[i] || !Matches(measured[i], job))
+                        continue;
+
+                    // Star::Find leaves PeakVal alone when it fails with an error, so keep the
+                    // caller's value in that case, just as a direct call would have
+                    unsigned short peakVal = job.star->PeakVal;
+                    *job.star = *measured[i].star;
+                    if (job.star->GetError() == Star::STAR_ERROR)
+                        job.star->PeakVal = peakVal;
+                    job.found = measured[i].found;
+                    s_results.used[i] = true;
+                    matched = true;
+                    ++premeasured;
+                    break;
+                }
+            }
+
+            if (!matched)
+                remaining.push_back(job);
+        }
+    }
+
+    if (premeasured)
+    {
+        // time from the end of the worker thread measurement until the main thread picked it up
+        double ms = (LatencyTrace::Now() - measuredAt) / 1e6;
+        s_handoffTime.Add(ms);
+        Debug.Write(wxString::Format("StarPremeasure: frame %u, %u of %u stars premeasured, handoff %.1f ms "
+                                     "(mean %.1f max %.1f)\n",
+                                     pImage->FrameNum, premeasured, (unsigned int) jobs.size(), ms, s_handoffTime.Mean(),
+                                     s_handoffTime.max));
+    }
+
+    if (remaining.empty())
+        return;
+
+    Star::FindMultiple(pImage, params.searchRegion, params.mode, params.minHFD, params.maxHFD, params.saturation, remaining);
+
+    // copy the outcome back; the stars themselves were updated through the shared pointers
+    size_t r = 0;
+    for (Star::FindJob& job : jobs)
+    {
+        if (r < remaining.size() && remaining[r].star == job.star)
+            job.found = remaining[r++].found;
+    }
+}
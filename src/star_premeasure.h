@@ -0,0 +1,81 @@
+/*
+ *  star_premeasure.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef STAR_PREMEASURE_INCLUDED
+#define STAR_PREMEASURE_INCLUDED
+
+// The star measurement stage of the guide loop, run on the worker thread.
+//
+// After each UpdateGuideState the guider publishes a plan: the search positions (and Star::Find
+// parameters) it expects to use on the next frame. When the next frame has been captured the
+// worker thread measures the planned stars before handing the frame to the main thread, so the
+// centroiding no longer competes with painting, dialogs and other GUI activity. On the main
+// thread the guider asks for its stars through FindStars, which hands back the worker-thread
+// results for every search that matches a planned one, and measures any others (a star was
+// re-selected, a lost star is being searched for, ...) in place. Results are keyed on the frame
+// number, the search parameters and the exact search position, so the result is the star
+// Star::Find would have found on the main thread and the plan is only ever an optimization.
+//
+// Threading contract:
+//   - SetPlan, ClearPlan and FindStars are called on the main thread
+//   - Run is called on the primary worker thread, once per captured frame
+//   - the plan and the results are copied in and out under a lock, so neither thread ever
+//     holds a reference into data owned by the other
+class StarPremeasure
+{
+public:
+    struct Params
+    {
+        int searchRegion;
+        Star::FindMode mode;
+        double minHFD;
+        double maxHFD;
+        unsigned short saturation;
+
+        bool operator==(const Params& rhs) const
+        {
+            return searchRegion == rhs.searchRegion && mode == rhs.mode && minHFD == rhs.minHFD && maxHFD == rhs.maxHFD &&
+                saturation == rhs.saturation;
+        }
+    };
+
+    static void SetPlan(const Params& params, const std::vector<Star::FindJob>& jobs);
+    static void ClearPlan();
+
+    static void Run(const usImage *pImage);
+
+    static void FindStars(const usImage *pImage, const Params& params, std::vector<Star::FindJob>& jobs);
+};
+
+#endif // STAR_PREMEASURE_INCLUDED
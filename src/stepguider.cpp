@@ -34,6 +34,7 @@
  */
 #include "phd.h"
 
+#include "ao_fast_loop.h"
 #include "gear_simulator.h"
 #include "image_math.h"
 #include "socket_server.h"
@@ -46,12 +47,14 @@ static const int DefaultBumpPercentage = 80;
 static const double DefaultBumpMaxStepsPerCycle = 1.00;
 static const int DefaultCalibrationStepsPerIteration = 4;
 static const GUIDE_ALGORITHM DefaultGuideAlgorithm = GUIDE_ALGORITHM_HYSTERESIS;
+static const int DefaultFastLoopExposure = 10; // ms
+static const double DefaultFastLoopGain = 0.70;
 
 // Time limit for bump to complete. If bump does not complete in this amount of time (seconds),
 // we will pop up a warning message with a suggestion to increase the MaxStepsPerCycle setting
 static const int BumpWarnTime = 240;
 
-StepGuider::StepGuider()
+StepGuider::StepGuider() : m_stepLock(wxMUTEX_RECURSIVE)
 {
     m_xOffset = 0;
     m_yOffset = 0;
@@ -83,9 +86,16 @@ StepGuider::StepGuider()
     SetYGuideAlgorithm(yGuideAlgorithm);
 
     m_bumpOnDither = pConfig->Profile.GetBoolean("/stepguider/BumpOnDither", true);
+
+    m_fastLoopEnabled = pConfig->Profile.GetBoolean("/stepguider/FastLoopEnabled", false);
+    SetFastLoopExposure(pConfig->Profile.GetInt("/stepguider/FastLoopExposure", DefaultFastLoopExposure));
+    SetFastLoopGain(pConfig->Profile.GetDouble("/stepguider/FastLoopGain", DefaultFastLoopGain));
 }
 
-StepGuider::~StepGuider() { }
+StepGuider::~StepGuider()
+{
+    StopFastLoop();
+}
 
 GUIDE_ALGORITHM StepGuider::DefaultXGuideAlgorithm() const
 {
@@ -187,6 +197,8 @@ bool StepGuider::Disconnect()
 
     try
     {
+        StopFastLoop();
+
         pFrame->pStepGuiderGraph->SetLimits(0, 0, 0, 0);
 
         if (Mount::Disconnect())
@@ -337,6 +349,139 @@ void StepGuider::SetBumpOnDither(bool val)
     pConfig->Profile.SetBoolean("/stepguider/BumpOnDither", m_bumpOnDither);
 }
 
+bool StepGuider::GetFastLoopEnabled() const
+{
+    return m_fastLoopEnabled;
+}
+
+void StepGuider::SetFastLoopEnabled(bool val)
+{
+    m_fastLoopEnabled = val;
+    pConfig->Profile.SetBoolean("/stepguider/FastLoopEnabled", m_fastLoopEnabled);
+    if (!m_fastLoopEnabled)
+        StopFastLoop();
+}
+
+int StepGuider::GetFastLoopExposure() const
+{
+    return m_fastLoopExposure;
+}
+
+void StepGuider::SetFastLoopExposure(int exposureMs)
+{
+    m_fastLoopExposure = exposureMs > 0 ? exposureMs : DefaultFastLoopExposure;
+    pConfig->Profile.SetInt("/stepguider/FastLoopExposure", m_fastLoopExposure);
+}
+
+double StepGuider::GetFastLoopGain() const
+{
+    return m_fastLoopGain;
+}
+
+void StepGuider::SetFastLoopGain(double gain)
+{
+    m_fastLoopGain = gain > 0.0 && gain <= 1.0 ? gain : DefaultFastLoopGain;
+    pConfig->Profile.SetDouble("/stepguider/FastLoopGain", m_fastLoopGain);
+}
+
+// The fast loop while it is running; once it has given up it no longer drives the AO, even before the
+// main thread gets around to dropping it
+std::shared_ptr<AOFastLoop> StepGuider::FastLoop() const
+{
+    wxMutexLocker lock(m_fastLoopLock);
+    return m_fastLoop && m_fastLoop->IsActive() ? m_fastLoop : std::shared_ptr<AOFastLoop>();
+}
+
+// Supply the guide cycle's frame from the fast loop. Returns true if the fast loop is not running or
+// could not provide a frame, in which case the caller captures one itself.
+bool StepGuider::TakeFastLoopFrame(usImage& img, int durationMs)
+{
+    std::shared_ptr<AOFastLoop> fastLoop = FastLoop();
+    return !fastLoop || fastLoop->TakeFrame(img, durationMs);
+}
+
+void StepGuider::StartFastLoop()
+{
+    if (!m_fastLoopEnabled || !IsConnected() || !IsCalibrated() || !m_guidingEnabled)
+        return;
+
+    if (!pCamera || !pCamera->Connected || !pCamera->HasNonGuiCapture())
+    {
+        Debug.Write("AO fast loop: camera cannot capture from a background thread, not starting\n");
+        return;
+    }
+
+    const usImage *img = pFrame->pGuider->CurrentImage();
+    if (!img || img->Size.GetWidth() == 0)
+        return;
+
+    wxMutexLocker lock(m_fastLoopLock);
+
+    if (m_fastLoop)
+        return;
+
+    CaptureParams params;
+    params.duration = m_fastLoopExposure;
+    params.hwBinning = pCamera->HwBinning;
+    params.swBinning = pCamera->SwBinning;
+    params.bpp = pCamera->BitsPerPixel();
+    params.limitFrame = pCamera->LimitFrame;
+    params.gain = pCamera->GuideCameraGain;
+    // the subframes are summed before TakeFrame hands them to the guider, so they are not reconstructed
+    // one by one
+    params.captureOptions = CAPTURE_SUBTRACT_DARK;
+
+    std::shared_ptr<AOFastLoop> fastLoop = std::make_shared<AOFastLoop>(
+        this, params, img->Size, pFrame->pGuider->LockPosition(), pFrame->pGuider->GetSearchRegion(), m_fastLoopGain);
+
+    if (!fastLoop->Start())
+    {
+        Debug.Write("AO fast loop: could not start the thread\n");
+        return;
+    }
+
+    m_fastLoop = fastLoop;
+}
+
+void StepGuider::StopFastLoop()
+{
+    std::shared_ptr<AOFastLoop> fastLoop;
+    {
+        wxMutexLocker lock(m_fastLoopLock);
+        fastLoop.swap(m_fastLoop);
+    }
+
+    // the worker thread may still be waiting on a frame from the loop; it holds its own reference
+    if (fastLoop)
+        fastLoop->Stop();
+}
+
+// Called in the main thread when the fast loop has stopped on its own
+void StepGuider::FastLoopFailed(const std::shared_ptr<AOFastLoop>& fastLoop, const wxString& reason)
+{
+    {
+        wxMutexLocker lock(m_fastLoopLock);
+        if (m_fastLoop != fastLoop)
+            return; // stopped or replaced in the meantime
+        m_fastLoop.reset();
+    }
+
+    fastLoop->Stop();
+
+    pFrame->Alert(reason);
+}
+
+AOFastLoopStats StepGuider::GetFastLoopStats() const
+{
+    std::shared_ptr<AOFastLoop> fastLoop = FastLoop();
+    if (fastLoop)
+        return fastLoop->GetStats();
+
+    AOFastLoopStats stats;
+    memset(&stats, 0, sizeof(stats));
+    return stats;
+}
+
 int StepGuider::GetCalibrationStepsPerIteration() const
 {
     return m_calibrationStepsPerIteration;
@@ -367,6 +512,12 @@ bool StepGuider::SetCalibrationStepsPerIteration(int calibrationStepsPerIteratio
     return bError;
 }
 
+bool StepGuider::Recenter()
+{
+    wxMutexLocker lock(m_stepLock);
+    return Center();
+}
+
 void StepGuider::ZeroCurrentPosition()
 {
     m_xOffset = 0;
@@ -377,6 +528,8 @@ bool StepGuider::MoveToCenter()
 {
     bool bError = false;
 
+    wxMutexLocker lock(m_stepLock);
+
     try
     {
         int positionUpDown = CurrentPosition(UP);
@@ -827,10 +980,18 @@ bool StepGuider::UpdateCalibrationState(const PHD_Point& currentLocation)
     return bError;
 }
 
+void StepGuider::NotifyGuidingStarted()
+{
+    Mount::NotifyGuidingStarted();
+    StartFastLoop();
+}
+
 void StepGuider::NotifyGuidingStopped()
 {
     // We have stopped guiding.  Reset bump state and recenter the stepguider
 
+    StopFastLoop();
+
     m_avgOffset.Invalidate();
     m_forceStartBump = false;
     m_bumpInProgress = false;
@@ -842,16 +1003,27 @@ void StepGuider::NotifyGuidingStopped()
     MoveToCenter(); // ignore failure
 }
 
+void StepGuider::NotifyGuidingPaused()
+{
+    Mount::NotifyGuidingPaused();
+    StopFastLoop();
+}
+
 void StepGuider::NotifyGuidingResumed()
 {
     Mount::NotifyGuidingResumed();
     m_avgOffset.Invalidate();
+    StartFastLoop();
 }
 
 void StepGuider::NotifyGuidingDithered(double dx, double dy, bool mountCoords)
 {
     Mount::NotifyGuidingDithered(dx, dy, mountCoords);
     m_avgOffset.Invalidate();
+
+    std::shared_ptr<AOFastLoop> fastLoop = FastLoop();
+    if (fastLoop)
+        fastLoop->SetLockPosition(pFrame->pGuider->LockPosition());
 }
 
 void StepGuider::ShowPropertyDialog() { }
@@ -899,6 +1071,111 @@ int StepGuider::CalibrationTotDistance()
     return AO_CALIBRATION_PIXELS_NEEDED;
 }
 
+// Truncate a single-axis step so that it stays within the AO's range of travel. Returns true if the
+// step was truncated.
+bool StepGuider::TruncateStep(GUIDE_DIRECTION direction, int *steps, bool verbose)
+{
+    int yDirection = 0;
+    int xDirection = 0;
+
+    switch (direction)
+    {
+    case UP:
+        yDirection = 1;
+        break;
+    case DOWN:
+        yDirection = -1;
+        break;
+    case RIGHT:
+        xDirection = 1;
+        break;
+    case LEFT:
+        xDirection = -1;
+        break;
+    default:
+        throw ERROR_INFO("StepGuider::Move(): invalid direction");
+        break;
+    }
+
+    assert(yDirection == 0 || xDirection == 0);
+    assert(yDirection != 0 || xDirection != 0);
+
+    if (verbose)
+        Debug.Write(wxString::Format("stepping (%d, %d) + (%d, %d)\n", m_xOffset, m_yOffset, *steps * xDirection,
+                                     *steps * yDirection));
+
+    if (WouldHitLimit(direction, *steps))
+    {
+        int new_steps = MaxPosition(direction) - 1 - CurrentPosition(direction);
+
+        Debug.Write(wxString::Format("StepGuider step would hit limit: truncate move to (%d, %d) + (%d, %d)\n", m_xOffset,
+                                     m_yOffset, new_steps * xDirection, new_steps * yDirection));
+
+        *steps = new_steps;
+        return true;
+    }
+
+    return false;
+}
+
+// Account for a step that has been sent to the AO: track the new position if it succeeded, or recover
+// by re-centering if the AO ran into its limit
+Mount::MOVE_RESULT StepGuider::CompleteStep(GUIDE_DIRECTION direction, int steps, STEP_RESULT stepResult, bool verbose)
+{
+    int yDirection = direction == UP ? 1 : direction == DOWN ? -1 : 0;
+    int xDirection = direction == RIGHT ? 1 : direction == LEFT ? -1 : 0;
+
+    if (stepResult != STEP_OK)
+    {
+        if (stepResult != STEP_LIMIT_REACHED)
+            return MOVE_ERROR;
+
+        Debug.Write("AO: limit reached!\n");
+
+        m_failedStep.x = m_xOffset;
+        m_failedStep.y = m_yOffset;
+        m_failedStep.dx = xDirection * steps;
+        m_failedStep.dy = yDirection * steps;
+
+        // attempt to recover by centering
+        bool err = Center();
+        if (err)
+            Debug.Write("AO Center failed after limit reached\n");
+
+        return MOVE_ERROR_AO_LIMIT_REACHED;
+    }
+
+    m_xOffset += xDirection * steps;
+    m_yOffset += yDirection * steps;
+
+    if (verbose)
+        Debug.Write(wxString::Format("stepped: pos (%d, %d)\n", m_xOffset, m_yOffset));
+
+    return MOVE_OK;
+}
+
+// Send the (already truncated) steps for one or both axes to the AO
+void StepGuider::IssueSteps(GUIDE_DIRECTION xDirection, int xSteps, GUIDE_DIRECTION yDirection, int ySteps,
+                            STEP_RESULT *xResult, STEP_RESULT *yResult)
+{
+    *xResult = STEP_OK;
+    *yResult = STEP_OK;
+
+    if (xSteps > 0 && ySteps > 0)
+        StepAxes(xDirection, xSteps, yDirection, ySteps, xResult, yResult);
+    else if (xSteps > 0)
+        *xResult = Step(xDirection, xSteps);
+    else if (ySteps > 0)
+        *yResult = Step(yDirection, ySteps);
+}
+
+void StepGuider::StepAxes(GUIDE_DIRECTION xDirection, int xSteps, GUIDE_DIRECTION yDirection, int ySteps,
+                          STEP_RESULT *xResult, STEP_RESULT *yResult)
+{
+    *xResult = Step(xDirection, xSteps);
+    *yResult = *xResult == STEP_LIMIT_REACHED ? STEP_ERROR : Step(yDirection, ySteps);
+}
+
 Mount::MOVE_RESULT StepGuider::MoveAxis(GUIDE_DIRECTION direction, int steps, unsigned int moveOptions,
                                         MoveResultInfo *moveResult)
 {
@@ -916,97 +1193,177 @@ Mount::MOVE_RESULT StepGuider::MoveAxis(GUIDE_DIRECTION direction, int steps, un
             throw THROW_INFO("Guiding disabled");
         }
 
+        if ((moveOptions & (MOVEOPT_ALGO_RESULT | MOVEOPT_ALGO_DEDUCE)) != 0 && FastLoop())
+        {
+            Debug.Write("MoveAxis: AO is driven by the fast loop\n");
+            steps = 0;
+        }
+
         // Actually do the guide
         assert(steps >= 0);
 
         if (steps > 0)
         {
-            int yDirection = 0;
-            int xDirection = 0;
+            wxMutexLocker lock(m_stepLock);
 
-            switch (direction)
+            limitReached = TruncateStep(direction, &steps, true);
+
+            if (steps > 0)
             {
-            case UP:
-                yDirection = 1;
-                break;
-            case DOWN:
-                yDirection = -1;
-                break;
-            case RIGHT:
-                xDirection = 1;
-                break;
-            case LEFT:
-                xDirection = -1;
-                break;
-            default:
-                throw ERROR_INFO("StepGuider::Move(): invalid direction");
-                break;
+                result = CompleteStep(direction, steps, Step(direction, steps), true);
+                if (result != MOVE_OK)
+                    throw ERROR_INFO("step failed");
             }
+        }
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+        steps = 0;
+        if (result == MOVE_OK)
+            result = MOVE_ERROR;
+    }
 
-            assert(yDirection == 0 || xDirection == 0);
-            assert(yDirection != 0 || xDirection != 0);
+    if (moveResult)
+    {
+        moveResult->amountMoved = steps;
+        moveResult->limited = limitReached;
+    }
 
-            Debug.Write(wxString::Format("stepping (%d, %d) + (%d, %d)\n", m_xOffset, m_yOffset, steps * xDirection,
-                                         steps * yDirection));
+    return result;
+}
 
-            if (WouldHitLimit(direction, steps))
-            {
-                int new_steps = MaxPosition(direction) - 1 - CurrentPosition(direction);
+bool StepGuider::CanGuideAxesSimultaneously()
+{
+    return true;
+}
 
-                Debug.Write(wxString::Format("StepGuider step would hit limit: truncate move to (%d, %d) + (%d, %d)\n",
-                                             m_xOffset, m_yOffset, new_steps * xDirection, new_steps * yDirection));
+// The AO takes the steps for both axes of a guide step together, from the calling thread, so that a
+// device that can queue commands pays for a single round trip
+void StepGuider::MoveAxesConcurrently(GUIDE_DIRECTION xDirection, int xAmount, GUIDE_DIRECTION yDirection, int yAmount,
+                                      unsigned int moveOptions, MOVE_RESULT *result, MoveResultInfo *xMoveResult,
+                                      MoveResultInfo *yMoveResult)
+{
+    MOVE_RESULT xResult = MOVE_OK;
+    MOVE_RESULT yResult = MOVE_OK;
+    int xSteps = xAmount;
+    int ySteps = yAmount;
 
-                steps = new_steps;
-                limitReached = true;
-            }
+    xMoveResult->limited = false;
+    yMoveResult->limited = false;
 
-            if (steps > 0)
-            {
-                STEP_RESULT sres = Step(direction, steps);
-                if (sres != STEP_OK)
-                {
-                    if (sres == STEP_LIMIT_REACHED)
-                    {
-                        Debug.Write("AO: limit reached!\n");
+    try
+    {
+        Debug.Write(wxString::Format("MoveAxes(%s, %d, %s, %d, %s)\n", DirectionChar(xDirection), xAmount,
+                                     DirectionChar(yDirection), yAmount, DumpMoveOptionBits(moveOptions)));
 
-                        m_failedStep.x = m_xOffset;
-                        m_failedStep.y = m_yOffset;
-                        m_failedStep.dx = xDirection * steps;
-                        m_failedStep.dy = yDirection * steps;
+        if (!m_guidingEnabled)
+        {
+            throw THROW_INFO("Guiding disabled");
+        }
 
-                        // attempt to recover by centering
-                        bool err = Center();
-                        if (err)
-                            Debug.Write("AO Center failed after limit reached\n");
+        if ((moveOptions & (MOVEOPT_ALGO_RESULT | MOVEOPT_ALGO_DEDUCE)) != 0 && FastLoop())
+        {
+            Debug.Write("MoveAxes: AO is driven by the fast loop\n");
+            xSteps = ySteps = 0;
+        }
 
-                        result = MOVE_ERROR_AO_LIMIT_REACHED;
-                    }
+        wxMutexLocker lock(m_stepLock);
 
-                    throw ERROR_INFO("step failed");
-                }
+        xMoveResult->limited = xSteps > 0 && TruncateStep(xDirection, &xSteps, true);
+        yMoveResult->limited = ySteps > 0 && TruncateStep(yDirection, &ySteps, true);
 
-                m_xOffset += xDirection * steps;
-                m_yOffset += yDirection * steps;
+        STEP_RESULT xStep;
+        STEP_RESULT yStep;
+        wxStopWatch swatch;
 
-                Debug.Write(wxString::Format("stepped: pos (%d, %d)\n", m_xOffset, m_yOffset));
-            }
-        }
+        IssueSteps(xDirection, xSteps, yDirection, ySteps, &xStep, &yStep);
+
+        // the AO steps are not guide pulses; keep their timing out of the simultaneous pulse figures
+        long elapsed = swatch.Time();
+        if (xSteps > 0 && ySteps > 0)
+            m_lastStep.aoStepElapsed = elapsed;
+        Debug.Write(wxString::Format("MoveAxes: stepped in %ld ms\n", elapsed));
+
+        if (xSteps > 0)
+            xResult = CompleteStep(xDirection, xSteps, xStep, true);
+
+        // the AO has been re-centered if the RA step ran into the limit, so the Dec step no longer counts
+        if (xResult == MOVE_ERROR_AO_LIMIT_REACHED)
+            ySteps = 0;
+        else if (ySteps > 0)
+            yResult = CompleteStep(yDirection, ySteps, yStep, true);
     }
     catch (const wxString& Msg)
     {
         POSSIBLY_UNUSED(Msg);
-        steps = 0;
-        if (result == MOVE_OK)
-            result = MOVE_ERROR;
+        xResult = MOVE_ERROR;
     }
 
-    if (moveResult)
+    if (xResult != MOVE_OK)
+        xSteps = 0;
+    if (yResult != MOVE_OK)
+        ySteps = 0;
+
+    xMoveResult->amountMoved = xSteps;
+    yMoveResult->amountMoved = ySteps;
+    *result = xResult != MOVE_OK ? xResult : yResult;
+}
+
+// Called by the fast loop after each subframe: step the AO to take out a fraction (gain) of the star's
+// offset from the lock position. Returns true on error.
+bool StepGuider::FastLoopMove(const PHD_Point& cameraOfs, double gain, bool *moved)
+{
+    *moved = false;
+
+    if (!m_guidingEnabled)
+        return false;
+
+    PHD_Point mountOfs;
+    if (TransformCameraCoordinatesToMountCoordinates(cameraOfs, mountOfs, false))
+        return true;
+
+    double xDistance = gain * mountOfs.X;
+    double yDistance = gain * mountOfs.Y;
+
+    GUIDE_DIRECTION xDirection = xDistance > 0.0 ? LEFT : RIGHT;
+    GUIDE_DIRECTION yDirection = yDistance > 0.0 ? DOWN : UP;
+    int xSteps = ROUND(fabs(xDistance / xRate()));
+    int ySteps = ROUND(fabs(yDistance / yRate()));
+
+    if (xSteps == 0 && ySteps == 0)
+        return false;
+
+    try
     {
-        moveResult->amountMoved = steps;
-        moveResult->limited = limitReached;
+        wxMutexLocker lock(m_stepLock);
+
+        if (xSteps > 0)
+            TruncateStep(xDirection, &xSteps, false);
+        if (ySteps > 0)
+            TruncateStep(yDirection, &ySteps, false);
+
+        STEP_RESULT xStep;
+        STEP_RESULT yStep;
+        IssueSteps(xDirection, xSteps, yDirection, ySteps, &xStep, &yStep);
+
+        MOVE_RESULT xResult = xSteps > 0 ? CompleteStep(xDirection, xSteps, xStep, false) : MOVE_OK;
+        MOVE_RESULT yResult = MOVE_OK;
+        if (xResult != MOVE_ERROR_AO_LIMIT_REACHED && ySteps > 0)
+            yResult = CompleteStep(yDirection, ySteps, yStep, false);
+
+        // running into the limit is recovered by re-centering; the loop carries on from there
+        if (xResult == MOVE_ERROR || yResult == MOVE_ERROR)
+            throw ERROR_INFO("AO fast loop step failed");
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+        return true;
     }
 
-    return result;
+    *moved = true;
+    return false;
 }
 
 static wxString SlowBumpWarningEnabledKey()
@@ -1048,8 +1405,21 @@ Mount::MOVE_RESULT StepGuider::MoveOffset(GuiderOffset *ofs, unsigned int moveOp
             return result;
         }
 
-        // keep a moving average of the AO position
-        if (m_avgOffset.IsValid())
+        std::shared_ptr<AOFastLoop> fastLoop = FastLoop();
+        PHD_Point fastLoopAvg;
+        if (fastLoop)
+        {
+            fastLoop->SetLockPosition(pFrame->pGuider->LockPosition());
+            fastLoopAvg = fastLoop->AverageAoPosition();
+        }
+
+        // keep a moving average of the AO position; the fast loop averages it over all of its
+        // subframes since the last guide step
+        if (fastLoopAvg.IsValid())
+        {
+            m_avgOffset = fastLoopAvg;
+        }
+        else if (m_avgOffset.IsValid())
         {
             static double const alpha = .33; // moderately high weighting for latest sample
             m_avgOffset.X += alpha * (m_xOffset - m_avgOffset.X);
@@ -1437,6 +1807,7 @@ void AOConfigDialogPane::LayoutControls(wxPanel *pParent, BrainCtrlIdMap& CtrlMa
         pAoDetailSizer->Add(blBumpSizer);
     pAoDetailSizer->Add(GetSingleCtrl(CtrlMap, AD_cbEnableAOGuiding));
     pAoDetailSizer->Add(GetSingleCtrl(CtrlMap, AD_cbClearAOCalibration));
+    pAoDetailSizer->Add(GetSizerCtrl(CtrlMap, AD_szAOFastLoop));
     this->Add(pAoDetailSizer, def_flags);
 }
 
@@ -1503,6 +1874,31 @@ AOConfigDialogCtrlSet::AOConfigDialogCtrlSet(wxWindow *pParent, Mount *pStepGuid
     m_pEnableAOGuide = new wxCheckBox(GetParentWindow(AD_cbEnableAOGuiding), wxID_ANY, _("Enable AO corrections"));
     AddCtrl(CtrlMap, AD_cbEnableAOGuiding, m_pEnableAOGuide,
             _("Keep this checked for AO guiding. Un-check to disable AO corrections and use only mount guiding"));
+
+    wxWindow *fastLoopHostTab = GetParentWindow(AD_szAOFastLoop);
+    wxBoxSizer *fastLoopSizer = new wxStaticBoxSizer(wxHORIZONTAL, fastLoopHostTab, _("Fast AO Loop"));
+    m_enableFastLoop = new wxCheckBox(fastLoopHostTab, wxID_ANY, _("Enable"));
+    m_enableFastLoop->SetToolTip(_("While guiding, correct the AO after every short exposure of a small box around the "
+                                   "guide star, independently of the guide exposure. Requires a camera that can capture "
+                                   "from a background thread."));
+    fastLoopSizer->Add(m_enableFastLoop, wxSizerFlags().Center());
+    width = StringWidth(_T("0000"));
+    m_fastLoopExposure = pFrame->MakeSpinCtrl(fastLoopHostTab, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(width, -1),
+                                              wxSP_ARROW_KEYS, 1, 1000, DefaultFastLoopExposure, _T("Fast_Loop_Exposure"));
+    fastLoopSizer->Add(MakeLabeledControl(AD_szAOFastLoop, _("Exposure (ms)"), m_fastLoopExposure,
+                                          wxString::Format(_("Exposure of each fast loop frame. Default = %d ms"),
+                                                           DefaultFastLoopExposure)),
+                       wxSizerFlags().Border(wxLEFT, 10));
+    width = StringWidth(_T("000"));
+    m_fastLoopGain = pFrame->MakeSpinCtrl(fastLoopHostTab, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(width, -1),
+                                          wxSP_ARROW_KEYS, 10, 100, ROUND(DefaultFastLoopGain * 100.), _T("Fast_Loop_Gain"));
+    fastLoopSizer->Add(MakeLabeledControl(AD_szAOFastLoop, _("Gain (%)"), m_fastLoopGain,
+                                          wxString::Format(_("Percentage of the measured error corrected after each fast "
+                                                             "loop frame. Default = %d%%"),
+                                                           ROUND(DefaultFastLoopGain * 100.))),
+                       wxSizerFlags().Border(wxLEFT, 10));
+    AddGroup(CtrlMap, AD_szAOFastLoop, fastLoopSizer);
+
     m_pStepGuider->currConfigDialogCtrlSet = this;
 }
 
@@ -1517,6 +1913,9 @@ void AOConfigDialogCtrlSet::LoadValues()
     m_pClearAOCalibration->Enable(m_pStepGuider->IsCalibrated());
     m_pClearAOCalibration->SetValue(false);
     m_pEnableAOGuide->SetValue(m_pStepGuider->GetGuidingEnabled());
+    m_enableFastLoop->SetValue(m_pStepGuider->GetFastLoopEnabled());
+    m_fastLoopExposure->SetValue(m_pStepGuider->GetFastLoopExposure());
+    m_fastLoopGain->SetValue(ROUND(m_pStepGuider->GetFastLoopGain() * 100.));
 }
 
 void AOConfigDialogCtrlSet::UnloadValues()
@@ -1535,4 +1934,7 @@ void AOConfigDialogCtrlSet::UnloadValues()
     }
 
     m_pStepGuider->SetGuidingEnabled(m_pEnableAOGuide->GetValue());
+    m_pStepGuider->SetFastLoopExposure(m_fastLoopExposure->GetValue());
+    m_pStepGuider->SetFastLoopGain(m_fastLoopGain->GetValue() / 100.);
+    m_pStepGuider->SetFastLoopEnabled(m_enableFastLoop->GetValue());
 }
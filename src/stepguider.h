@@ -37,6 +37,8 @@
 #define STEPGUIDER_H_INCLUDED
 
 class StepGuider;
+class AOFastLoop;
+struct AOFastLoopStats;
 
 // The AO has two representations in AdvancedDialog.  One is as a 'mount' sub-class where the AO algorithms are shown in the
 // Algos tab.  The second is as a unique device appearing on the Other_Devices tab.  So there are two distinct
@@ -52,6 +54,9 @@ class AOConfigDialogCtrlSet : ConfigDialogCtrlSet
     wxCheckBox *m_bumpOnDither;
     wxCheckBox *m_pClearAOCalibration;
     wxCheckBox *m_pEnableAOGuide;
+    wxCheckBox *m_enableFastLoop;
+    wxSpinCtrl *m_fastLoopExposure;
+    wxSpinCtrl *m_fastLoopGain;
 
 public:
     AOConfigDialogCtrlSet(wxWindow *pParent, Mount *pStepGuider, AdvancedDialog *pAdvancedDialog, BrainCtrlIdMap& CtrlMap);
@@ -108,6 +113,15 @@ class StepGuider : public Mount, public OnboardST4
 
     StepInfo m_failedStep; // position info for failed ao step
 
+    bool m_fastLoopEnabled;
+    int m_fastLoopExposure;
+    double m_fastLoopGain;
+    mutable wxMutex m_fastLoopLock;
+    std::shared_ptr<AOFastLoop> m_fastLoop; // running while guiding with the fast loop enabled
+    // held while stepping the AO or tracking its position, by the fast loop and the worker thread alike;
+    // recursive since MoveToCenter steps through MoveAxis and a step that runs into the limit re-centers
+    wxMutex m_stepLock;
+
     // Calibration variables
     int m_calibrationStepsPerIteration;
     int m_calibrationIterations;
@@ -199,8 +213,11 @@ public:
     bool Disconnect() override;
 
     virtual bool Center() = 0;
+    bool Recenter();
 
+    void NotifyGuidingStarted() override;
     void NotifyGuidingStopped() override;
+    void NotifyGuidingPaused() override;
     void NotifyGuidingResumed() override;
     void NotifyGuidingDithered(double dx, double dy, bool mountCoords) override;
 
@@ -213,15 +230,34 @@ public:
 
     const StepInfo& GetFailedStepInfo() const;
 
+    bool GetFastLoopEnabled() const;
+    void SetFastLoopEnabled(bool val);
+    int GetFastLoopExposure() const;
+    void SetFastLoopExposure(int exposureMs);
+    double GetFastLoopGain() const;
+    void SetFastLoopGain(double gain);
+
+    std::shared_ptr<AOFastLoop> FastLoop() const;
+    bool TakeFastLoopFrame(usImage& img, int durationMs);
+    bool FastLoopMove(const PHD_Point& cameraOfs, double gain, bool *moved);
+    AOFastLoopStats GetFastLoopStats() const;
+    void FastLoopFailed(const std::shared_ptr<AOFastLoop>& fastLoop, const wxString& reason);
+
     // functions with an implemenation in StepGuider that cannot be over-ridden
     // by a subclass
 private:
     MOVE_RESULT MoveOffset(GuiderOffset *guiderOffset, unsigned int moveOptions) final;
     MOVE_RESULT MoveAxis(GUIDE_DIRECTION direction, int amount, unsigned int moveOptions, MoveResultInfo *moveResultInfo) final;
     MOVE_RESULT MoveAxis(GUIDE_DIRECTION direction, int steps, unsigned int moveOptions) final;
+    bool CanGuideAxesSimultaneously() final;
+    void MoveAxesConcurrently(GUIDE_DIRECTION xDirection, int xAmount, GUIDE_DIRECTION yDirection, int yAmount,
+                              unsigned int moveOptions, MOVE_RESULT *result, MoveResultInfo *xMoveResult,
+                              MoveResultInfo *yMoveResult) final;
     int CalibrationMoveSize() override;
     int CalibrationTotDistance() override;
     void InitBumpPositions();
+    void StartFastLoop();
+    void StopFastLoop();
 
     double CalibrationTime(int nCalibrationSteps);
 
@@ -241,6 +277,17 @@ private:
     virtual int MaxPosition(GUIDE_DIRECTION direction) const = 0;
     virtual bool SetMaxPosition(int steps) = 0;
 
+    bool TruncateStep(GUIDE_DIRECTION direction, int *steps, bool verbose);
+    MOVE_RESULT CompleteStep(GUIDE_DIRECTION direction, int steps, STEP_RESULT stepResult, bool verbose);
+    void IssueSteps(GUIDE_DIRECTION xDirection, int xSteps, GUIDE_DIRECTION yDirection, int ySteps, STEP_RESULT *xResult,
+                    STEP_RESULT *yResult);
+
+protected:
+    // Step both axes. The default issues the two steps one after the other; a device that can
+    // queue commands overrides this to send both before waiting for either acknowledgement.
+    virtual void StepAxes(GUIDE_DIRECTION xDirection, int xSteps, GUIDE_DIRECTION yDirection, int ySteps,
+                          STEP_RESULT *xResult, STEP_RESULT *yResult);
+
     // virtual functions -- these CAN be overridden by a subclass, which should
     // consider whether they need to call the base class functions as part of
     // their operation
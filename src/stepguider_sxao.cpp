@@ -46,6 +46,7 @@ class StepGuiderSxAO : public StepGuider
     wxString m_serialPortName;
     SerialPort *m_pSerialPort;
     int m_maxSteps;
+    bool m_pipelineSteps; // send both axes' steps before reading either acknowledgement
 
 public:
     StepGuiderSxAO();
@@ -59,6 +60,9 @@ public:
 private:
     bool Center() override;
     STEP_RESULT Step(GUIDE_DIRECTION direction, int steps) override;
+    void StepAxes(GUIDE_DIRECTION xDirection, int xSteps, GUIDE_DIRECTION yDirection, int ySteps, STEP_RESULT *xResult,
+                  STEP_RESULT *yResult) override;
+    static STEP_RESULT StepResult(unsigned char response);
     int MaxPosition(GUIDE_DIRECTION direction) const override;
     bool SetMaxPosition(int steps) override;
     bool IsAtLimit(GUIDE_DIRECTION direction, bool *isAtLimit) override;
@@ -67,8 +71,10 @@ private:
 
     bool SendThenReceive(unsigned char sendChar, unsigned char *receivedChar);
     bool SendThenReceive(const unsigned char *pBuffer, unsigned int bufferSize, unsigned char *receivedChar);
+    bool ReceiveResponse(unsigned char *response);
 
     bool SendShortCommand(unsigned char command, unsigned char *response);
+    bool FormatLongCommand(unsigned char command, unsigned char parameter, unsigned count, unsigned char *cmdBuf);
     bool SendLongCommand(unsigned char command, unsigned char parameter, unsigned count, unsigned char *response);
 
     bool FirmwareVersion(unsigned int *version);
@@ -92,6 +98,9 @@ StepGuiderSxAO::StepGuiderSxAO()
 
     m_serialPortName = pConfig->Profile.GetString("/stepguider/sxao/serialport", wxEmptyString);
     m_maxSteps = pConfig->Profile.GetInt("/stepguider/sxao/MaxSteps", DefaultMaxSteps);
+    // off unless enabled in the profile: it relies on the firmware buffering the second command while
+    // the first step runs, which has not been confirmed on a device
+    m_pipelineSteps = pConfig->Profile.GetBoolean("/stepguider/sxao/PipelineSteps", false);
 }
 
 StepGuiderSxAO::~StepGuiderSxAO()
@@ -254,7 +263,6 @@ bool StepGuiderSxAO::SendThenReceive(unsigned char sendChar, unsigned char *rece
         {
             throw ERROR_INFO("StepGuiderSxAO::SendThenReceive serial receive failed");
         }
-        Debug.Write(wxString::Format("StepGuiderSxAO::SendThenReceive sent %c received %c\n", sendChar, receivedChar));
     }
     catch (const wxString& Msg)
     {
@@ -277,24 +285,43 @@ bool StepGuiderSxAO::SendThenReceive(const unsigned char *pBuffer, unsigned int
             throw ERROR_INFO("StepGuiderSxAO::SendThenReceive serial send failed");
         }
 
-        if (m_pSerialPort->Receive(receivedChar, 1))
+        if (ReceiveResponse(receivedChar))
         {
             throw ERROR_INFO("StepGuiderSxAO::SendThenReceive serial receive failed");
         }
-        Debug.AddBytes(wxString::Format("StepGuiderSxAO::SendThenReceive received %c, sent", *receivedChar), pBuffer,
-                       bufferSize);
+    }
+    catch (const wxString& Msg)
+    {
+        Debug.AddBytes("StepGuiderSxAO::SendThenReceive send", pBuffer, bufferSize);
+        POSSIBLY_UNUSED(Msg);
+        bError = true;
+    }
+
+    return bError;
+}
+
+// read the response to a long command
+bool StepGuiderSxAO::ReceiveResponse(unsigned char *response)
+{
+    bool bError = false;
 
-        if (*receivedChar == 'W') // TODO: meaning
+    try
+    {
+        if (m_pSerialPort->Receive(response, 1))
         {
-            if (m_pSerialPort->Receive(receivedChar, 1))
+            throw ERROR_INFO("StepGuiderSxAO::ReceiveResponse serial receive failed");
+        }
+
+        if (*response == 'W') // TODO: meaning
+        {
+            if (m_pSerialPort->Receive(response, 1))
             {
-                throw ERROR_INFO("StepGuiderSxAO::step: Error reading another character after 'W'");
+                throw ERROR_INFO("StepGuiderSxAO::ReceiveResponse: Error reading another character after 'W'");
             }
         }
     }
     catch (const wxString& Msg)
     {
-        Debug.AddBytes("StepGuiderSxAO::SendThenReceive send", pBuffer, bufferSize);
         POSSIBLY_UNUSED(Msg);
         bError = true;
     }
@@ -324,20 +351,18 @@ bool StepGuiderSxAO::SendShortCommand(unsigned char command, unsigned char *resp
  * is the command, the second is the direction and the remaining
  * 5 characters are a count.
  */
-bool StepGuiderSxAO::SendLongCommand(unsigned char command, unsigned char parameter, unsigned int count,
-                                     unsigned char *response)
+bool StepGuiderSxAO::FormatLongCommand(unsigned char command, unsigned char parameter, unsigned int count,
+                                       unsigned char *cmdBuf)
 {
     bool bError = false;
 
     try
     {
-        unsigned char cmdBuf[8]; // 7 chars + NULL
-
         if (count > 99999)
         {
             throw ERROR_INFO("StepGuiderSxAO::SendLongCommand invalid count");
         }
-        int bufsize = sizeof(cmdBuf);
+        int bufsize = 8; // 7 chars + NULL
 # if defined(__WINDOWS__)
         // MSVC-ism _snprintf returns a negative number if there is not enough space in the buffer
         int ret = _snprintf((char *) &cmdBuf[0], bufsize, "%c%c%5.5d", command, parameter, count);
@@ -356,6 +381,29 @@ bool StepGuiderSxAO::SendLongCommand(unsigned char command, unsigned char parame
         {
             throw ERROR_INFO("StepGuiderSxAO::SendLongCommand snprintf buffer to small");
         }
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+        bError = true;
+    }
+
+    return bError;
+}
+
+bool StepGuiderSxAO::SendLongCommand(unsigned char command, unsigned char parameter, unsigned int count,
+                                     unsigned char *response)
+{
+    bool bError = false;
+
+    try
+    {
+        unsigned char cmdBuf[8]; // 7 chars + NULL
+
+        if (FormatLongCommand(command, parameter, count, &cmdBuf[0]))
+        {
+            throw ERROR_INFO("StepGuiderSxAO::SendLongCommand FormatLongCommand failed");
+        }
 
         if (SendThenReceive(&cmdBuf[0], 7, response))
         {
@@ -487,59 +535,118 @@ bool StepGuiderSxAO::Center()
     return err;
 }
 
+static unsigned char StepParameter(GUIDE_DIRECTION direction)
+{
+    switch (direction)
+    {
+    case NORTH:
+        return 'N';
+    case SOUTH:
+        return 'S';
+    case EAST:
+        return 'T';
+    case WEST:
+        return 'W';
+    default:
+        throw ERROR_INFO("StepGuiderSxAO::step: invalid direction");
+    }
+}
+
+StepGuider::STEP_RESULT StepGuiderSxAO::StepResult(unsigned char response)
+{
+    if (response == 'L')
+    {
+        Debug.Write("StepGuiderSxAO::step: at limit\n");
+        return STEP_LIMIT_REACHED;
+    }
+
+    if (response != 'G')
+    {
+        Debug.Write(wxString::Format("StepGuiderSxAO::step: unexpected response %c\n", response));
+        return STEP_ERROR;
+    }
+
+    return STEP_OK;
+}
+
 StepGuider::STEP_RESULT StepGuiderSxAO::Step(GUIDE_DIRECTION direction, int steps)
 {
-    STEP_RESULT result = STEP_OK;
+    STEP_RESULT result = STEP_ERROR;
 
     try
     {
-        unsigned char cmd = 'G';
-        unsigned char parameter;
         unsigned char response;
 
-        switch (direction)
+        if (SendLongCommand('G', StepParameter(direction), steps, &response))
         {
-        case NORTH:
-            parameter = 'N';
-            break;
-        case SOUTH:
-            parameter = 'S';
-            break;
-        case EAST:
-            parameter = 'T';
-            break;
-        case WEST:
-            parameter = 'W';
-            break;
-        default:
-            throw ERROR_INFO("StepGuiderSxAO::step: invalid direction");
-            break;
+            throw ERROR_INFO("StepGuiderSxAO::step: SendLongCommand failed");
+        }
+
+        result = StepResult(response);
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+    }
+
+    return result;
+}
+
+// Send the steps for both axes in one write, then collect the two acknowledgements. Only done when
+// enabled in the profile; otherwise the steps go one after the other like any other AO.
+void StepGuiderSxAO::StepAxes(GUIDE_DIRECTION xDirection, int xSteps, GUIDE_DIRECTION yDirection, int ySteps,
+                              STEP_RESULT *xResult, STEP_RESULT *yResult)
+{
+    if (!m_pipelineSteps)
+    {
+        StepGuider::StepAxes(xDirection, xSteps, yDirection, ySteps, xResult, yResult);
+        return;
+    }
+
+    *xResult = STEP_ERROR;
+    *yResult = STEP_ERROR;
+
+    try
+    {
+        unsigned char xCmd[8];
+        unsigned char yCmd[8];
+
+        if (FormatLongCommand('G', StepParameter(xDirection), xSteps, &xCmd[0]) ||
+            FormatLongCommand('G', StepParameter(yDirection), ySteps, &yCmd[0]))
+        {
+            throw ERROR_INFO("StepGuiderSxAO::StepAxes: FormatLongCommand failed");
         }
 
-        if (SendLongCommand(cmd, parameter, steps, &response))
+        m_pSerialPort->Queue(&xCmd[0], 7);
+        m_pSerialPort->Queue(&yCmd[0], 7);
+
+        if (m_pSerialPort->Flush())
         {
-            throw ERROR_INFO("StepGuiderSxAO::step: SendLongCommand failed");
+            throw ERROR_INFO("StepGuiderSxAO::StepAxes: serial send failed");
         }
 
-        if (response == 'L')
+        // the AO answers the commands in order; read both responses even if the first step
+        // failed so that the next command does not pick up a stale acknowledgement
+        unsigned char response;
+
+        if (ReceiveResponse(&response))
         {
-            result = STEP_LIMIT_REACHED;
-            throw ERROR_INFO("StepGuiderSxAO::step: step: at limit");
+            throw ERROR_INFO("StepGuiderSxAO::StepAxes: no response to first step");
         }
 
-        if (response != cmd)
+        *xResult = StepResult(response);
+
+        if (ReceiveResponse(&response))
         {
-            throw ERROR_INFO("StepGuiderSxAO::step: response != cmd");
+            throw ERROR_INFO("StepGuiderSxAO::StepAxes: no response to second step");
         }
+
+        *yResult = StepResult(response);
     }
     catch (const wxString& Msg)
     {
         POSSIBLY_UNUSED(Msg);
-        if (result == STEP_OK)
-            result = STEP_ERROR;
     }
-
-    return result;
 }
 
 int StepGuiderSxAO::MaxPosition(GUIDE_DIRECTION direction) const
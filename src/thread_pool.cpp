@@ -0,0 +1,207 @@
+/*
+ *  thread_pool.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+enum
+{
+    MAX_POOL_THREADS = 7,
+};
+
+namespace
+{
+class PoolThread;
+
+struct Pool
+{
+    wxMutex m_submitLock; // serializes ParallelFor callers
+    wxMutex m_lock;
+    wxCondition m_workReady;
+    wxCondition m_workDone;
+    std::vector<PoolThread *> m_threads;
+
+    // current job, protected by m_lock except for m_next
+    const std::function<void(unsigned int)> *m_fn;
+    unsigned int m_count;
+    std::atomic<unsigned int> m_next;
+    unsigned int m_busy;
+    unsigned int m_generation;
+    bool m_exiting;
+
+    Pool() : m_workReady(m_lock), m_workDone(m_lock), m_fn(nullptr), m_count(0), m_next(0), m_busy(0), m_generation(0),
+             m_exiting(false)
+    {
+    }
+
+    void RunItems(const std::function<void(unsigned int)>& fn, unsigned int count);
+};
+
+thread_local bool t_inPoolWork;
+
+class PoolThread : public wxThread
+{
+    Pool& m_pool;
+
+public:
+    PoolThread(Pool& pool) : wxThread(wxTHREAD_JOINABLE), m_pool(pool) { }
+
+    ExitCode Entry() override
+    {
+        unsigned int seen = 0;
+
+        while (true)
+        {
+            const std::function<void(unsigned int)> *fn;
+            unsigned int count;
+            {
+                wxMutexLocker lck(m_pool.m_lock);
+                while (m_pool.m_generation == seen && !m_pool.m_exiting)
+                    m_pool.m_workReady.Wait();
+                if (m_pool.m_exiting)
+                    break;
+                seen = m_pool.m_generation;
+                fn = m_pool.m_fn;
+                count = m_pool.m_count;
+            }
+
+            m_pool.RunItems(*fn, count);
+
+            wxMutexLocker lck(m_pool.m_lock);
+            if (--m_pool.m_busy == 0)
+                m_pool.m_workDone.Signal();
+        }
+
+        return nullptr;
+    }
+};
+
+void Pool::RunItems(const std::function<void(unsigned int)>& fn, unsigned int count)
+{
+    t_inPoolWork = true;
+    unsigned int i;
+    while ((i = m_next.fetch_add(1, std::memory_order_relaxed)) < count)
+        fn(i);
+    t_inPoolWork = false;
+}
+
+} // namespace
+
+static Pool *s_pool;
+
+void ThreadPool::Init()
+{
+    if (s_pool)
+        return;
+
+    s_pool = new Pool();
+
+    int cpus = wxThread::GetCPUCount();
+    unsigned int nthreads = cpus > 1 ? wxMin((unsigned int) cpus - 1, (unsigned int) MAX_POOL_THREADS) : 0;
+
+    for (unsigned int i = 0; i < nthreads; i++)
+    {
+        PoolThread *thread = new PoolThread(*s_pool);
+        if (thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR)
+        {
+            Debug.Write("ThreadPool: could not start worker thread\n");
+            delete thread;
+            break;
+        }
+        s_pool->m_threads.push_back(thread);
+    }
+
+    Debug.Write(wxString::Format("ThreadPool: started %u worker threads\n", (unsigned int) s_pool->m_threads.size()));
+}
+
+void ThreadPool::Destroy()
+{
+    if (!s_pool)
+        return;
+
+    {
+        wxMutexLocker lck(s_pool->m_lock);
+        s_pool->m_exiting = true;
+        s_pool->m_workReady.Broadcast();
+    }
+
+    for (PoolThread *thread : s_pool->m_threads)
+    {
+        thread->Wait();
+        delete thread;
+    }
+
+    delete s_pool;
+    s_pool = nullptr;
+}
+
+unsigned int ThreadPool::Concurrency()
+{
+    return s_pool ? (unsigned int) s_pool->m_threads.size() + 1 : 1;
+}
+
+void ThreadPool::ParallelFor(unsigned int count, const std::function<void(unsigned int)>& fn)
+{
+    if (count == 0)
+        return;
+
+    if (!s_pool || s_pool->m_threads.empty() || count == 1 || t_inPoolWork)
+    {
+        for (unsigned int i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    wxMutexLocker submit(s_pool->m_submitLock);
+
+    {
+        wxMutexLocker lck(s_pool->m_lock);
+        s_pool->m_fn = &fn;
+        s_pool->m_count = count;
+        s_pool->m_next.store(0, std::memory_order_relaxed);
+        s_pool->m_busy = (unsigned int) s_pool->m_threads.size();
+        ++s_pool->m_generation;
+        s_pool->m_workReady.Broadcast();
+    }
+
+    s_pool->RunItems(fn, count);
+
+    wxMutexLocker lck(s_pool->m_lock);
+    while (s_pool->m_busy > 0)
+        s_pool->m_workDone.Wait();
+    s_pool->m_fn = nullptr;
+}
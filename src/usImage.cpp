@@ -34,6 +34,7 @@
 
 #include "phd.h"
 #include "image_math.h"
+#include "image_transform.h"
 
 #include <algorithm>
 
@@ -106,33 +107,87 @@ public:
     }
 };
 
-bool usImage::Init(const wxSize& size)
+static bool init_storage(usImage *img, const wxSize& size, const wxRect& storage)
 {
-    // Allocates space for image and sets params up
-    // returns true on error
-
-    unsigned int prev = NPixels;
-    NPixels = size.GetWidth() * size.GetHeight();
-    Size = size;
-    Subframe = wxRect(0, 0, 0, 0);
-    MinADU = MaxADU = MedianADU = 0;
+    unsigned int prev = img->NPixels;
+    img->NPixels = storage.GetWidth() * storage.GetHeight();
+    img->Size = size;
+    img->Storage = storage;
+    img->MinADU = img->MaxADU = img->MedianADU = 0;
 
-    if (NPixels != prev)
+    if (img->NPixels != prev)
     {
-        delete[] ImageData;
+        delete[] img->ImageData;
 
-        if (NPixels)
+        if (img->NPixels)
         {
-            ImageData = new unsigned short[NPixels];
-            if (!ImageData)
+            img->ImageData = new unsigned short[img->NPixels];
+            if (!img->ImageData)
             {
-                NPixels = 0;
+                img->NPixels = 0;
                 return true;
             }
         }
         else
-            ImageData = nullptr;
+            img->ImageData = nullptr;
+    }
+
+    return false;
+}
+
+bool usImage::Init(const wxSize& size)
+{
+    // Allocates space for image and sets params up
+    // returns true on error
+
+    Subframe = wxRect(0, 0, 0, 0);
+    return init_storage(this, size, wxRect(size));
+}
+
+bool usImage::InitSubframe(const wxSize& size, const wxRect& subframe)
+{
+    // Allocates space for just the subframe of an image of the given size; pixels outside the
+    // subframe are not stored and read as zero when the image is expanded, displayed or saved
+    // returns true on error
+
+    Subframe = subframe;
+    return init_storage(this, size, subframe);
+}
+
+// write the full frame of an image to dst, with zeros outside the stored area
+static void expand_to(unsigned short *dst, const usImage& img)
+{
+    const wxRect& s = img.Storage;
+    int const width = img.Size.GetWidth();
+
+    memset(dst, 0, (size_t) s.GetTop() * width * sizeof(unsigned short));
+    for (int y = 0; y < s.height; y++)
+    {
+        unsigned short *row = dst + (size_t) (s.y + y) * width;
+        memset(row, 0, s.x * sizeof(unsigned short));
+        memcpy(row + s.x, img.ImageData + (size_t) y * s.width, s.width * sizeof(unsigned short));
+        memset(row + s.x + s.width, 0, (width - s.x - s.width) * sizeof(unsigned short));
     }
+    size_t below = (size_t) (s.GetBottom() + 1) * width;
+    memset(dst + below, 0, ((size_t) img.Size.GetHeight() * width - below) * sizeof(unsigned short));
+}
+
+bool usImage::ExpandStorage()
+{
+    // Converts an image holding only its subframe to full frame storage
+    // returns true on error
+
+    if (!HasSubframeStorage())
+        return false;
+
+    unsigned int npixels = Size.GetWidth() * Size.GetHeight();
+    unsigned short *data = new unsigned short[npixels];
+    expand_to(data, *this);
+
+    delete[] ImageData;
+    ImageData = data;
+    NPixels = npixels;
+    Storage = wxRect(Size);
 
     return false;
 }
@@ -185,19 +240,21 @@ void usImage::CalcStats()
         // Subframe
 
         unsigned int pixcnt = Subframe.width * Subframe.height;
-        unsigned short *tmpdata = new unsigned short[pixcnt];
-
-        unsigned short *dst;
+        unsigned short *subframeCopy = nullptr;
+        const unsigned short *tmpdata;
 
-        dst = tmpdata;
-        for (int y = 0; y < Subframe.height; y++)
+        if (HasSubframeStorage())
         {
-            const unsigned short *src = ImageData + Subframe.x + (Subframe.y + y) * Size.GetWidth();
-            for (int x = 0; x < Subframe.width; x++)
-            {
-                unsigned short d = *src;
-                *dst++ = *src++;
-            }
+            // only the subframe is stored, use it in place
+            tmpdata = ImageData;
+        }
+        else
+        {
+            subframeCopy = new unsigned short[pixcnt];
+            unsigned short *dst = subframeCopy;
+            for (int y = 0; y < Subframe.height; y++, dst += Subframe.width)
+                memcpy(dst, &Pixel(Subframe.x, Subframe.y + y), Subframe.width * sizeof(unsigned short));
+            tmpdata = subframeCopy;
         }
 
         HistogramBuilder hb;
@@ -206,7 +263,7 @@ void usImage::CalcStats()
         MaxADU = hb.MaxADU;
         MedianADU = hb.median();
 
-        dst = new unsigned short[pixcnt];
+        unsigned short *dst = new unsigned short[pixcnt];
 
         Median3(dst, tmpdata, Subframe.GetSize(), wxRect(Subframe.GetSize()));
 
@@ -221,7 +278,7 @@ void usImage::CalcStats()
         }
 
         delete[] dst;
-        delete[] tmpdata;
+        delete[] subframeCopy;
     }
 }
 
@@ -270,13 +327,32 @@ bool usImage::CopyToImage(wxImage **rawimg, int blevel, int wlevel, double power
 
     unsigned char *lutTable = buildGammaLookupTable(blevel, wlevel, power);
 
-    for (unsigned int i = 0; i < NPixels; i++, RawPtr++)
+    if (HasSubframeStorage())
     {
-        unsigned short v = *RawPtr;
-        unsigned char d = lutTable[v];
-        *ImgPtr++ = d;
-        *ImgPtr++ = d;
-        *ImgPtr++ = d;
+        // everything outside the stored subframe is black level
+        memset(ImgPtr, lutTable[0], (size_t) Size.GetWidth() * Size.GetHeight() * 3);
+        for (int y = 0; y < Storage.height; y++)
+        {
+            unsigned char *p = ImgPtr + ((size_t) (Storage.y + y) * Size.GetWidth() + Storage.x) * 3;
+            for (int x = 0; x < Storage.width; x++, RawPtr++)
+            {
+                unsigned char d = lutTable[*RawPtr];
+                *p++ = d;
+                *p++ = d;
+                *p++ = d;
+            }
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < NPixels; i++, RawPtr++)
+        {
+            unsigned short v = *RawPtr;
+            unsigned char d = lutTable[v];
+            *ImgPtr++ = d;
+            *ImgPtr++ = d;
+            *ImgPtr++ = d;
+        }
     }
 
     delete[] lutTable;
@@ -401,7 +477,16 @@ bool usImage::Save(const wxString& fname, const wxString& hdrNote) const
         }
 
         long fpixel[3] = { 1, 1, 1 };
-        fits_write_pix(fptr, TUSHORT, fpixel, NPixels, ImageData, &status);
+        if (HasSubframeStorage())
+        {
+            unsigned int npixels = Size.GetWidth() * Size.GetHeight();
+            unsigned short *full = new unsigned short[npixels];
+            expand_to(full, *this);
+            fits_write_pix(fptr, TUSHORT, fpixel, npixels, full, &status);
+            delete[] full;
+        }
+        else
+            fits_write_pix(fptr, TUSHORT, fpixel, NPixels, ImageData, &status);
 
         PHD_fits_close_file(fptr);
 
@@ -535,32 +620,16 @@ bool usImage::CopyFrom(const usImage& src)
 {
     if (Init(src.Size))
         return true;
-    memcpy(ImageData, src.ImageData, NPixels * sizeof(unsigned short));
+    if (src.HasSubframeStorage())
+        expand_to(ImageData, src);
+    else
+        memcpy(ImageData, src.ImageData, NPixels * sizeof(unsigned short));
     return false;
 }
 
 bool usImage::Rotate(double theta, bool mirror)
 {
-    wxImage *pImg = 0;
-
-    CalcStats();
-
-    CopyToImage(&pImg, MinADU, MaxADU, 1.0);
-
-    wxImage mirrored = *pImg;
-
-    if (mirror)
-    {
-        mirrored = pImg->Mirror(false);
-    }
-
-    wxImage rotated = mirrored.Rotate(theta, wxPoint(0, 0));
-
-    CopyFromImage(rotated);
-
-    delete pImg;
-
-    return false;
+    return RotateImage(*this, theta, mirror);
 }
 
 bool usImage::CopyFromImage(const wxImage& img)
@@ -41,8 +41,9 @@ public:
     unsigned short *ImageData; // Pointer to raw data
     wxSize Size; // Dimensions of image
     wxRect Subframe; // where the valid data is
+    wxRect Storage; // area of the frame held in ImageData: all of Size, or just the subframe (see InitSubframe)
     wxRect LimitFrame; // associated frame limit, empty rect when no frame limit
-    unsigned int NPixels;
+    unsigned int NPixels; // number of pixels in ImageData
     unsigned short MinADU;
     unsigned short MaxADU;
     unsigned short MedianADU;
@@ -66,6 +67,9 @@ public:
 
     bool Init(const wxSize& size);
     bool Init(int width, int height) { return Init(wxSize(width, height)); }
+    bool InitSubframe(const wxSize& size, const wxRect& subframe);
+    bool HasSubframeStorage() const { return Storage != wxRect(Size); }
+    bool ExpandStorage();
     void SwapImageData(usImage& other);
     void CalcStats();
     void InitImgStartTime();
@@ -75,8 +79,9 @@ public:
     bool Load(const wxString& fname);
     bool Save(const wxString& fname, const wxString& hdrComment = wxEmptyString) const;
     bool Rotate(double theta, bool mirror = false);
-    unsigned short& Pixel(int x, int y) { return ImageData[y * Size.x + x]; }
-    const unsigned short& Pixel(int x, int y) const { return ImageData[y * Size.x + x]; }
+    // pixel at frame coordinates x,y, which must lie within Storage
+    unsigned short& Pixel(int x, int y) { return ImageData[(y - Storage.y) * Storage.width + x - Storage.x]; }
+    const unsigned short& Pixel(int x, int y) const { return ImageData[(y - Storage.y) * Storage.width + x - Storage.x]; }
     void Clear(void);
 };
 
@@ -0,0 +1,136 @@
+/*
+ *  windowed_median.h
+ *  PHD Guiding
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of Craig Stark, Stark Labs,
+ *     Bret McKee, Dad Dog Development, Ltd, nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef WINDOWED_MEDIAN_INCLUDED
+#define WINDOWED_MEDIAN_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streaming median over a sliding time window.
+//
+// Samples are kept twice: in arrival order (a ring, so the oldest sample can be expired in O(1))
+// and in a sorted array (so the median is a direct index). Insert and expire are a binary search
+// plus a memmove of at most the window size, which for the few hundred samples a guiding time
+// window holds is far cheaper than copying the window and running nth_element on every frame.
+// Storage grows geometrically and is never released, so once the window has filled no further
+// allocations take place.
+class WindowedMedian
+{
+    struct Entry
+    {
+        int64_t time;
+        double val;
+    };
+
+    std::vector<Entry> m_ring;   // arrival order, m_ring.size() is the ring capacity
+    std::vector<double> m_sorted; // same samples, ascending
+    size_t m_head;               // index of the oldest entry in m_ring
+    int64_t m_window;
+
+    enum
+    {
+        InitialCapacity = 64
+    };
+
+    void Grow()
+    {
+        size_t count = m_sorted.size();
+        std::vector<Entry> ring(m_ring.size() * 2);
+        for (size_t i = 0; i < count; i++)
+            ring[i] = m_ring[(m_head + i) % m_ring.size()];
+        m_ring.swap(ring);
+        m_head = 0;
+        m_sorted.reserve(m_ring.size());
+    }
+
+    void PopOldest()
+    {
+        double val = m_ring[m_head].val;
+        std::vector<double>::iterator pos = std::lower_bound(m_sorted.begin(), m_sorted.end(), val);
+        assert(pos != m_sorted.end() && *pos == val);
+        m_sorted.erase(pos);
+        m_head = (m_head + 1) % m_ring.size();
+    }
+
+public:
+    WindowedMedian(int64_t windowMs = 0) : m_ring(InitialCapacity), m_head(0), m_window(windowMs)
+    {
+        m_sorted.reserve(InitialCapacity);
+    }
+
+    void SetWindow(int64_t milliseconds) { m_window = milliseconds; }
+    int64_t Window() const { return m_window; }
+
+    void Clear()
+    {
+        m_sorted.clear();
+        m_head = 0;
+    }
+
+    size_t Size() const { return m_sorted.size(); }
+    bool Empty() const { return m_sorted.empty(); }
+
+    // Drop samples that are older than the time window relative to `now`
+    void Expire(int64_t now)
+    {
+        int64_t oldest = now - m_window;
+        while (!m_sorted.empty() && m_ring[m_head].time < oldest)
+            PopOldest();
+    }
+
+    // Expire samples that have aged out of the window, then add a new sample
+    void Add(int64_t now, double val)
+    {
+        Expire(now);
+
+        if (m_sorted.size() == m_ring.size())
+            Grow();
+
+        size_t tail = (m_head + m_sorted.size()) % m_ring.size();
+        m_ring[tail].time = now;
+        m_ring[tail].val = val;
+        m_sorted.insert(std::upper_bound(m_sorted.begin(), m_sorted.end(), val), val);
+    }
+
+    // Median of the samples in the window. For an even count this is the upper of the two middle
+    // values, matching the nth_element(size / 2) selection it replaces.
+    double Median() const
+    {
+        assert(!m_sorted.empty());
+        return m_sorted[m_sorted.size() / 2];
+    }
+};
+
+#endif
@@ -34,6 +34,10 @@
  */
 
 #include "phd.h"
+#include "latency_trace.h"
+
+// worker thread whose interrupt requests apply to a helper thread, see SetInterruptSource
+static thread_local WorkerThread *t_interruptSource;
 
 WorkerThread::WorkerThread(MyFrame *pFrame)
     : wxThread(wxTHREAD_JOINABLE), m_interruptRequested(0), m_killable(true), m_skipSendExposeComplete(false)
@@ -99,6 +103,17 @@ void WorkerThread::EnqueueWorkerThreadExposeRequest(usImage *pImage, const Captu
     EnqueueMessage(message);
 }
 
+void WorkerThread::SetInterruptSource(WorkerThread *thread)
+{
+    t_interruptSource = thread;
+}
+
+WorkerThread *WorkerThread::InterruptSource(void)
+{
+    WorkerThread *thr = WorkerThread::This();
+    return thr ? thr : t_interruptSource;
+}
+
 unsigned int WorkerThread::MilliSleep(int ms, unsigned int checkInterrupts)
 {
     enum
@@ -113,7 +128,7 @@ unsigned int WorkerThread::MilliSleep(int ms, unsigned int checkInterrupts)
         return WorkerThread::InterruptRequested() & checkInterrupts;
     }
 
-    WorkerThread *thr = WorkerThread::This();
+    WorkerThread *thr = WorkerThread::InterruptSource();
     wxStopWatch swatch;
 
     long elapsed = 0;
@@ -152,7 +167,8 @@ static void CameraROITest(usImage *img)
     {
         for (int x = -4; x <= 4; x++)
             for (int y = -4; y <= 4; y++)
-                img->ImageData[X + x + (Y + y) * img->Size.x] = base - (x * x + y * y) * scale;
+                if (img->Storage.Contains(X + x, Y + y))
+                    img->Pixel(X + x, Y + y) = base - (x * x + y * y) * scale;
     }
     dx += ddx;
     if (dx < 0 || dx >= 48)
@@ -182,7 +198,16 @@ bool WorkerThread::HandleExpose(EXPOSE_REQUEST *req)
         }
 
         const CaptureParams& params = req->captureParams;
-        if (pCamera->HasNonGuiCapture())
+        StepGuider *ao = TheAO();
+        if (ao && !ao->TakeFastLoopFrame(*req->pImage, params.duration))
+        {
+            Debug.Write(wxString::Format("Exposure taken from the AO fast loop, %d frames\n", req->pImage->ImgStackCnt));
+        }
+        else if (WorkerThread::InterruptRequested())
+        {
+            throw ERROR_INFO("Exposure interrupted");
+        }
+        else if (pCamera->HasNonGuiCapture())
         {
             Debug.Write(
                 wxString::Format("Handling exposure in thread, d=%d o=%x b=%u g=%d bpp=%u r=(%d,%d,%d,%d) l=(%d,%d,%d,%d)\n",
@@ -219,21 +244,33 @@ bool WorkerThread::HandleExpose(EXPOSE_REQUEST *req)
 
         if (!bError)
         {
-            CameraROITest(req->pImage);
+            req->pImage->FrameNum = ++m_pFrame->m_frameCounter;
+
+            {
+                TraceSpan span(TRACE_PREPARE);
+
+                CameraROITest(req->pImage);
+
+                switch (m_pFrame->GetNoiseReductionMethod())
+                {
+                case NR_NONE:
+                    break;
+                case NR_2x2MEAN:
+                    QuickLRecon(*req->pImage);
+                    break;
+                case NR_3x3MEDIAN:
+                    Median3(*req->pImage);
+                    break;
+                }
+            }
 
-            switch (m_pFrame->GetNoiseReductionMethod())
             {
-            case NR_NONE:
-                break;
-            case NR_2x2MEAN:
-                QuickLRecon(*req->pImage);
-                break;
-            case NR_3x3MEDIAN:
-                Median3(*req->pImage);
-                break;
+                TraceSpan span(TRACE_STATISTICS);
+                req->pImage->CalcStats();
             }
 
-            req->pImage->CalcStats();
+            // measure the guide stars here rather than on the main thread
+            StarPremeasure::Run(req->pImage);
         }
     }
     catch (const wxString& Msg)
@@ -298,6 +335,7 @@ void WorkerThread::EnqueueWorkerThreadAxisMove(Mount *mount, const GUIDE_DIRECTI
 
 void WorkerThread::HandleMove(MOVE_REQUEST *req)
 {
+    TraceSpan span(TRACE_MOVE);
     Mount::MOVE_RESULT result = Mount::MOVE_OK;
 
     try
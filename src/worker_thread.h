@@ -135,7 +135,14 @@ public:
 
     static WorkerThread *This(void);
 
+    // Lets the calling thread, which is doing work on behalf of the given worker thread (e.g. the
+    // simultaneous Dec pulse helper), see that worker thread's interrupt requests. Pass nullptr when
+    // the work is done.
+    static void SetInterruptSource(WorkerThread *thread);
+
 private:
+    static WorkerThread *InterruptSource(void);
+
     wxThread::ExitCode Entry();
 
     /*
@@ -206,12 +213,13 @@ inline void WorkerThread::RequestStop(void)
 
 inline WorkerThread *WorkerThread::This(void)
 {
-    return static_cast<WorkerThread *>(wxThread::This());
+    // other threads (e.g. the simultaneous Dec pulse helper) share code paths with the worker threads
+    return dynamic_cast<WorkerThread *>(wxThread::This());
 }
 
 inline unsigned int WorkerThread::InterruptRequested(void)
 {
-    WorkerThread *thr = WorkerThread::This();
+    WorkerThread *thr = WorkerThread::InterruptSource();
     return thr ? thr->m_interruptRequested : 0;
 }
 
@@ -0,0 +1,256 @@
+/*
+ *  guidinglog_binary_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <gtest/gtest.h>
+#include "guidinglog_binary_codec.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace BinaryGuideLogCodec;
+
+static BinaryGuideStep MountStep(int frame, double time)
+{
+    BinaryGuideStep s = {};
+    s.frame = frame;
+    s.time = time;
+    s.dx = 0.123;
+    s.dy = -1.5;
+    s.raRaw = 0.25;
+    s.decRaw = -0.75;
+    s.raGuide = 0.2;
+    s.decGuide = -0.6;
+    s.raDuration = 120;
+    s.raDirection = 'E';
+    s.decDuration = 0;
+    s.decDirection = 0;
+    s.starMass = 12345.4;
+    s.snr = 45.678;
+    s.error = 0;
+    return s;
+}
+
+static std::vector<BinaryGuideStep> RandomSteps(size_t count, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> ofs(-5.0, 5.0);
+    std::uniform_int_distribution<int> dur(0, 2000);
+    std::uniform_int_distribution<int> coin(0, 3);
+
+    std::vector<BinaryGuideStep> steps;
+    for (size_t i = 0; i < count; i++)
+    {
+        BinaryGuideStep s = MountStep((int) i + 1, i * 2.012);
+        s.ao = coin(rng) == 0;
+        s.dx = ofs(rng);
+        s.dy = ofs(rng);
+        s.raRaw = ofs(rng);
+        s.decRaw = ofs(rng);
+        s.raGuide = ofs(rng);
+        s.decGuide = ofs(rng);
+        if (s.ao)
+        {
+            s.raDuration = dur(rng) / 100 - 10;
+            s.decDuration = dur(rng) / 100 - 10;
+            s.raDirection = s.decDirection = 0;
+        }
+        else
+        {
+            s.raDuration = coin(rng) ? dur(rng) : 0;
+            s.raDirection = s.raDuration ? (coin(rng) & 1 ? 'E' : 'W') : 0;
+            s.decDuration = coin(rng) ? dur(rng) : 0;
+            s.decDirection = s.decDuration ? (coin(rng) & 1 ? 'N' : 'S') : 0;
+        }
+        s.starMass = ofs(rng) * 10000.0 + 60000.0;
+        s.snr = ofs(rng) * 5.0 + 30.0;
+        s.error = coin(rng) == 3 ? 3 : 0;
+        steps.push_back(s);
+    }
+    return steps;
+}
+
+// Converts an in-memory binary log the way BinaryGuideLog::ConvertToText converts the file
+static bool Convert(const std::string& data, std::string *text)
+{
+    if (CheckFileHeader(data.data(), data.size()))
+        return true;
+
+    size_t pos = FileHeaderSize;
+    while (data.size() - pos >= BlockHeaderSize)
+    {
+        uint32_t type, size;
+        ReadBlockHeader(&data[pos], &type, &size);
+        pos += BlockHeaderSize;
+        if (data.size() - pos < size)
+            break; // truncated
+        if (AppendBlockText(type, &data[pos], size, text))
+            return true;
+        pos += size;
+    }
+    return false;
+}
+
+TEST(BinaryGuideLogTest, StepTextMatchesGuidingLog)
+{
+    // rows as GuidingLog::WriteStepText formats them
+    std::string text;
+    AppendStepText(MountStep(17, 34.5678), &text);
+    EXPECT_EQ(text, "17,34.568,\"Mount\",0.123,-1.500,0.250,-0.750,0.200,-0.600,120,E,0,,,,12345,45.68,0\n");
+
+    BinaryGuideStep ao = MountStep(18, 36.0);
+    ao.ao = 1;
+    ao.raDuration = -3;
+    ao.decDuration = 2;
+    ao.raDirection = ao.decDirection = 0;
+    ao.error = 1;
+    text.clear();
+    AppendStepText(ao, &text);
+    EXPECT_EQ(text, "18,36.000,\"AO\",0.123,-1.500,0.250,-0.750,0.200,-0.600,,,,,-3,2,12345,45.68,1\n");
+}
+
+TEST(BinaryGuideLogTest, RoundTrip)
+{
+    std::vector<BinaryGuideStep> steps = RandomSteps(2000, 1);
+
+    std::string data;
+    AppendFileHeader(&data);
+    std::string expected;
+
+    // interleave text blocks with step chunks of varying size, as GuidingLog does
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<size_t> chunk(1, 256);
+    size_t i = 0;
+    int n = 0;
+    while (i < steps.size())
+    {
+        std::string info = "INFO: message " + std::to_string(n++) + "\n";
+        AppendTextBlock(info, &data);
+        expected += info;
+
+        size_t end = std::min(steps.size(), i + chunk(rng));
+        std::vector<BinaryGuideStep> block(steps.begin() + i, steps.begin() + end);
+        AppendStepBlock(block, &data);
+        for (const BinaryGuideStep& s : block)
+            AppendStepText(s, &expected);
+        i = end;
+    }
+
+    std::string text;
+    ASSERT_FALSE(Convert(data, &text));
+    EXPECT_EQ(text, expected);
+}
+
+TEST(BinaryGuideLogTest, DecodePreservesValues)
+{
+    std::vector<BinaryGuideStep> steps = RandomSteps(300, 3);
+
+    std::string block;
+    AppendStepBlock(steps, &block);
+
+    uint32_t type, size;
+    ReadBlockHeader(block.data(), &type, &size);
+    EXPECT_EQ(type, (uint32_t) BLOCK_STEPS);
+    ASSERT_EQ(size, block.size() - BlockHeaderSize);
+
+    std::vector<BinaryGuideStep> decoded;
+    ASSERT_FALSE(DecodeSteps(block.data() + BlockHeaderSize, size, &decoded));
+    ASSERT_EQ(decoded.size(), steps.size());
+    for (size_t i = 0; i < steps.size(); i++)
+    {
+        EXPECT_EQ(decoded[i].frame, steps[i].frame);
+        EXPECT_EQ(decoded[i].time, steps[i].time);
+        EXPECT_EQ(decoded[i].ao, steps[i].ao);
+        EXPECT_EQ(decoded[i].dx, steps[i].dx);
+        EXPECT_EQ(decoded[i].dy, steps[i].dy);
+        EXPECT_EQ(decoded[i].raRaw, steps[i].raRaw);
+        EXPECT_EQ(decoded[i].decRaw, steps[i].decRaw);
+        EXPECT_EQ(decoded[i].raGuide, steps[i].raGuide);
+        EXPECT_EQ(decoded[i].decGuide, steps[i].decGuide);
+        EXPECT_EQ(decoded[i].raDuration, steps[i].raDuration);
+        EXPECT_EQ(decoded[i].raDirection, steps[i].raDirection);
+        EXPECT_EQ(decoded[i].decDuration, steps[i].decDuration);
+        EXPECT_EQ(decoded[i].decDirection, steps[i].decDirection);
+        EXPECT_EQ(decoded[i].starMass, steps[i].starMass);
+        EXPECT_EQ(decoded[i].snr, steps[i].snr);
+        EXPECT_EQ(decoded[i].error, steps[i].error);
+    }
+
+    // a short payload is rejected rather than read past
+    EXPECT_TRUE(DecodeSteps(block.data() + BlockHeaderSize, size - 1, &decoded));
+}
+
+TEST(BinaryGuideLogTest, TruncatedLogKeepsCompleteBlocks)
+{
+    std::string data;
+    AppendFileHeader(&data);
+    AppendTextBlock("Guiding Begins\n", &data);
+    std::vector<BinaryGuideStep> steps = RandomSteps(10, 4);
+    AppendStepBlock(steps, &data);
+    size_t complete = data.size();
+    AppendTextBlock("INFO: lost in a crash\n", &data);
+
+    std::string expected = "Guiding Begins\n";
+    for (const BinaryGuideStep& s : steps)
+        AppendStepText(s, &expected);
+
+    std::string text;
+    ASSERT_FALSE(Convert(data.substr(0, data.size() - 5), &text));
+    EXPECT_EQ(text, expected);
+
+    text.clear();
+    ASSERT_FALSE(Convert(data.substr(0, complete), &text));
+    EXPECT_EQ(text, expected);
+}
+
+TEST(BinaryGuideLogTest, RejectsOtherFiles)
+{
+    std::string data;
+    AppendFileHeader(&data);
+    EXPECT_FALSE(CheckFileHeader(data.data(), data.size()));
+    EXPECT_TRUE(CheckFileHeader(data.data(), data.size() - 1));
+
+    std::string text = "PHD2 version 2.6.13, Log version 2.5. Log enabled at 2026-10-19 20:00:00\n";
+    EXPECT_TRUE(CheckFileHeader(text.data(), text.size()));
+
+    // a log written by a later version
+    data[8] = Version + 1;
+    EXPECT_TRUE(CheckFileHeader(data.data(), data.size()));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
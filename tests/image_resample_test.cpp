@@ -0,0 +1,253 @@
+/*
+ *  image_resample_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <gtest/gtest.h>
+#include "image_resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+struct Image
+{
+    int width;
+    int height;
+    std::vector<unsigned short> px;
+
+    Image(int w, int h) : width(w), height(h), px(w * h) { }
+    unsigned short at(int x, int y) const { return px[y * width + x]; }
+};
+
+static Image RandomImage(int width, int height, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<unsigned int> dist(0, 65535);
+    Image img(width, height);
+    for (auto& p : img.px)
+        p = (unsigned short) dist(rng);
+    return img;
+}
+
+static Image Resample(const Image& src, int width, int height, const AffineTransform& xf, ResampleKernel kernel)
+{
+    Image dst(width, height);
+    ResampleRows(dst.px.data(), width, 0, height, src.px.data(), src.width, src.height, xf, kernel);
+    return dst;
+}
+
+static double Clamp(double v, double lo, double hi)
+{
+    return std::min(std::max(v, lo), hi);
+}
+
+// Reference implementation in double precision with the same edge handling: positions more than
+// half a pixel outside the frame are zero, positions inside are clamped to the frame and the
+// neighborhood is clamped at the edges
+static double ReferencePixel(const Image& src, double sx, double sy, ResampleKernel kernel)
+{
+    if (!(sx >= -0.5 && sx <= src.width - 0.5 && sy >= -0.5 && sy <= src.height - 0.5))
+        return 0.0;
+
+    sx = Clamp(sx, 0.0, src.width - 1.0);
+    sy = Clamp(sy, 0.0, src.height - 1.0);
+    int ix = (int) sx;
+    int iy = (int) sy;
+    double tx = sx - ix;
+    double ty = sy - iy;
+
+    auto px = [&](int x, int y) {
+        return (double) src.at(std::min(std::max(x, 0), src.width - 1), std::min(std::max(y, 0), src.height - 1));
+    };
+
+    double v;
+    if (kernel == RESAMPLE_BILINEAR)
+    {
+        double top = px(ix, iy) + tx * (px(ix + 1, iy) - px(ix, iy));
+        double bot = px(ix, iy + 1) + tx * (px(ix + 1, iy + 1) - px(ix, iy + 1));
+        v = top + ty * (bot - top);
+    }
+    else
+    {
+        auto weights = [](double t, double w[4]) {
+            w[0] = -0.5 * t * t * t + t * t - 0.5 * t;
+            w[1] = 1.5 * t * t * t - 2.5 * t * t + 1.0;
+            w[2] = -1.5 * t * t * t + 2.0 * t * t + 0.5 * t;
+            w[3] = 0.5 * t * t * t - 0.5 * t * t;
+        };
+        double wx[4], wy[4];
+        weights(tx, wx);
+        weights(ty, wy);
+        v = 0.0;
+        for (int j = 0; j < 4; j++)
+            for (int i = 0; i < 4; i++)
+                v += wy[j] * wx[i] * px(ix - 1 + i, iy - 1 + j);
+    }
+
+    return Clamp(v, 0.0, 65535.0);
+}
+
+// the kernels compute in single precision; allow for that in the comparison
+static void ExpectMatchesReference(const Image& src, const Image& dst, const AffineTransform& xf, ResampleKernel kernel)
+{
+    int mismatches = 0;
+    for (int y = 0; y < dst.height; y++)
+    {
+        for (int x = 0; x < dst.width; x++)
+        {
+            double ref = ReferencePixel(src, xf.xx * x + xf.xy * y + xf.x0, xf.yx * x + xf.yy * y + xf.y0, kernel);
+            if (std::fabs(dst.at(x, y) - ref) > 1.0 && ++mismatches <= 10)
+                ADD_FAILURE() << "pixel (" << x << ", " << y << ") is " << dst.at(x, y) << ", expected " << ref;
+        }
+    }
+    EXPECT_EQ(mismatches, 0);
+}
+
+static AffineTransform Transform(double xx, double xy, double x0, double yx, double yy, double y0)
+{
+    AffineTransform xf;
+    xf.xx = xx;
+    xf.xy = xy;
+    xf.x0 = x0;
+    xf.yx = yx;
+    xf.yy = yy;
+    xf.y0 = y0;
+    return xf;
+}
+
+TEST(ImageResampleTest, IdentityIsExact)
+{
+    Image src = RandomImage(37, 23, 1);
+    AffineTransform id = Transform(1, 0, 0, 0, 1, 0);
+
+    EXPECT_EQ(Resample(src, src.width, src.height, id, RESAMPLE_BILINEAR).px, src.px);
+    EXPECT_EQ(Resample(src, src.width, src.height, id, RESAMPLE_BICUBIC).px, src.px);
+}
+
+TEST(ImageResampleTest, QuarterTurnIsExact)
+{
+    // output (x, y) samples source (y, h - 1 - x): every position is on a source pixel
+    Image src = RandomImage(19, 13, 2);
+    AffineTransform xf = Transform(0, 1, 0, -1, 0, src.height - 1);
+
+    for (ResampleKernel kernel : { RESAMPLE_BILINEAR, RESAMPLE_BICUBIC })
+    {
+        Image dst = Resample(src, src.height, src.width, xf, kernel);
+        for (int y = 0; y < dst.height; y++)
+            for (int x = 0; x < dst.width; x++)
+                ASSERT_EQ(dst.at(x, y), src.at(y, src.height - 1 - x));
+    }
+}
+
+TEST(ImageResampleTest, OutsideTheSourceIsZero)
+{
+    Image src(10, 10);
+    std::fill(src.px.begin(), src.px.end(), 1000);
+
+    // shifted by 5.5 pixels: the left 5 columns and top 5 rows are off the frame
+    AffineTransform xf = Transform(1, 0, -5.5, 0, 1, -5.5);
+    for (ResampleKernel kernel : { RESAMPLE_BILINEAR, RESAMPLE_BICUBIC })
+    {
+        Image dst = Resample(src, 10, 10, xf, kernel);
+        for (int y = 0; y < 10; y++)
+            for (int x = 0; x < 10; x++)
+                ASSERT_EQ(dst.at(x, y), x < 5 || y < 5 ? 0 : 1000) << x << ", " << y;
+    }
+}
+
+TEST(ImageResampleTest, ResizeMatchesReference)
+{
+    // odd output widths exercise the scalar tail after the 4-pixel blocks
+    Image src = RandomImage(41, 29, 3);
+    for (int width : { 13, 30, 63, 83 })
+    {
+        int height = width * src.height / src.width + 1;
+        double xscale = (double) src.width / width;
+        double yscale = (double) src.height / height;
+        AffineTransform xf = Transform(xscale, 0, 0.5 * xscale - 0.5, 0, yscale, 0.5 * yscale - 0.5);
+
+        for (ResampleKernel kernel : { RESAMPLE_BILINEAR, RESAMPLE_BICUBIC })
+            ExpectMatchesReference(src, Resample(src, width, height, xf, kernel), xf, kernel);
+    }
+}
+
+TEST(ImageResampleTest, RotationMatchesReference)
+{
+    Image src = RandomImage(48, 32, 4);
+    double const theta = 0.3;
+    double const c = cos(theta), s = sin(theta);
+    AffineTransform xf = Transform(c, s, -4.0, -s, c, 9.0);
+
+    for (ResampleKernel kernel : { RESAMPLE_BILINEAR, RESAMPLE_BICUBIC })
+        ExpectMatchesReference(src, Resample(src, 57, 45, xf, kernel), xf, kernel);
+}
+
+TEST(ImageResampleTest, BicubicOvershootIsClamped)
+{
+    // a hard edge between black and saturated pixels makes Catmull-Rom ring above and below the
+    // range; the output must saturate rather than wrap around
+    Image src(16, 4);
+    for (int y = 0; y < src.height; y++)
+        for (int x = 0; x < src.width; x++)
+            src.px[y * src.width + x] = x < 8 ? 0 : 65535;
+
+    AffineTransform xf = Transform(0.25, 0, 0, 0, 1, 0);
+    Image dst = Resample(src, 61, 4, xf, RESAMPLE_BICUBIC);
+    ExpectMatchesReference(src, dst, xf, RESAMPLE_BICUBIC);
+
+    for (int x = 1; x < dst.width; x++)
+        EXPECT_GE(dst.at(x, 0), dst.at(x - 1, 0)) << x;
+}
+
+TEST(ImageResampleTest, RowRangesDoNotChangeTheResult)
+{
+    Image src = RandomImage(25, 25, 5);
+    AffineTransform xf = Transform(0.7, 0.1, 1.3, -0.1, 0.7, 2.1);
+
+    Image whole = Resample(src, 30, 30, xf, RESAMPLE_BILINEAR);
+    Image banded(30, 30);
+    for (int y0 = 0; y0 < 30; y0 += 7)
+        ResampleRows(banded.px.data(), 30, y0, std::min(y0 + 7, 30), src.px.data(), src.width, src.height, xf,
+                     RESAMPLE_BILINEAR);
+
+    EXPECT_EQ(banded.px, whole.px);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
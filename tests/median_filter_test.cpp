@@ -0,0 +1,147 @@
+/*
+ *  median_filter_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <gtest/gtest.h>
+#include "median_filter.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Reference implementation: gather each window, clipped to the image, and select its middle
+// element, which is what the defect map's median filter did before the histogram scan
+static std::vector<unsigned short> ReferenceFilter(const std::vector<unsigned short>& src, int width, int height,
+                                                   int halfWidth)
+{
+    std::vector<unsigned short> dst(src.size());
+    std::vector<unsigned short> win;
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            win.clear();
+            for (int j = std::max(0, y - halfWidth); j <= std::min(y + halfWidth, height - 1); j++)
+                for (int i = std::max(0, x - halfWidth); i <= std::min(x + halfWidth, width - 1); i++)
+                    win.push_back(src[j * width + i]);
+            std::nth_element(win.begin(), win.begin() + win.size() / 2, win.end());
+            dst[y * width + x] = win[win.size() / 2];
+        }
+    }
+
+    return dst;
+}
+
+// Filter the image in bands of the given number of rows, as the defect map builder does
+static std::vector<unsigned short> Filter(const std::vector<unsigned short>& src, int width, int height, int halfWidth,
+                                          int bandRows)
+{
+    std::vector<unsigned short> dst(src.size());
+    std::unique_ptr<MedianHisto> h(new MedianHisto());
+
+    for (int y0 = 0; y0 < height; y0 += bandRows)
+        MedianFilterRows(dst.data(), src.data(), width, height, halfWidth, y0, std::min(y0 + bandRows, height), *h);
+
+    return dst;
+}
+
+static std::vector<unsigned short> RandomImage(int width, int height, unsigned int lo, unsigned int hi, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<unsigned int> dist(lo, hi);
+    std::vector<unsigned short> img(width * height);
+    for (auto& px : img)
+        px = (unsigned short) dist(rng);
+    return img;
+}
+
+TEST(MedianFilterTest, ConstantImage)
+{
+    std::vector<unsigned short> img(40 * 30, 1234);
+    EXPECT_EQ(Filter(img, 40, 30, 7, 32), img);
+}
+
+TEST(MedianFilterTest, MatchesReferenceOnDarkLikeImage)
+{
+    // a narrow range around a pedestal, as in a dark frame, with a few hot pixels
+    int const width = 67, height = 45;
+    std::vector<unsigned short> img = RandomImage(width, height, 900, 1100, 1);
+    std::mt19937 rng(2);
+    for (int i = 0; i < 50; i++)
+        img[rng() % img.size()] = (unsigned short) (60000 + rng() % 5000);
+
+    EXPECT_EQ(Filter(img, width, height, 7, 32), ReferenceFilter(img, width, height, 7));
+}
+
+TEST(MedianFilterTest, MatchesReferenceOverFullRange)
+{
+    // values spread over the whole 16-bit range make the median cross coarse bins in both directions
+    int const width = 53, height = 38;
+    std::vector<unsigned short> img = RandomImage(width, height, 0, 65535, 3);
+
+    EXPECT_EQ(Filter(img, width, height, 3, 32), ReferenceFilter(img, width, height, 3));
+    EXPECT_EQ(Filter(img, width, height, 7, 32), ReferenceFilter(img, width, height, 7));
+}
+
+TEST(MedianFilterTest, BandsDoNotChangeTheResult)
+{
+    int const width = 31, height = 50;
+    std::vector<unsigned short> img = RandomImage(width, height, 0, 4000, 4);
+    std::vector<unsigned short> expected = ReferenceFilter(img, width, height, 5);
+
+    for (int bandRows : { 1, 2, 7, 32, height })
+        EXPECT_EQ(Filter(img, width, height, 5, bandRows), expected) << "bandRows " << bandRows;
+}
+
+TEST(MedianFilterTest, ImageSmallerThanWindow)
+{
+    // narrower and shorter than the window: the window is clipped to the image on every side
+    for (int width : { 1, 2, 5, 14 })
+    {
+        for (int height : { 1, 3, 9 })
+        {
+            std::vector<unsigned short> img = RandomImage(width, height, 0, 65535, width * 100 + height);
+            EXPECT_EQ(Filter(img, width, height, 7, 32), ReferenceFilter(img, width, height, 7))
+                << width << "x" << height;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,212 @@
+/*
+ *  ring_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+#include <gtest/gtest.h>
+#include "circbuf.h"
+#include "spmc_ring.h"
+
+#include <thread>
+#include <vector>
+
+TEST(CircularBufferTest, WrapsAtCapacity)
+{
+    // a capacity that is not a power of two, like the graph history lengths
+    circular_buffer<int> cb(5);
+    EXPECT_EQ(cb.capacity(), 5u);
+
+    for (int i = 0; i < 3; i++)
+        cb.push_front(i);
+    ASSERT_EQ(cb.size(), 3u);
+    for (unsigned int i = 0; i < 3; i++)
+        EXPECT_EQ(cb[i], (int) i);
+
+    // the oldest entries are overwritten once the buffer is full
+    for (int i = 3; i < 12; i++)
+        cb.push_front(i);
+    ASSERT_EQ(cb.size(), 5u);
+    for (unsigned int i = 0; i < 5; i++)
+        EXPECT_EQ(cb[i], (int) (7 + i));
+
+    int expected = 7;
+    for (circular_buffer<int>::iterator it = cb.begin(); it != cb.end(); ++it)
+        EXPECT_EQ(*it, expected++);
+    EXPECT_EQ(expected, 12);
+}
+
+TEST(CircularBufferTest, PopBackAndClear)
+{
+    circular_buffer<int> cb;
+    cb.resize(3);
+    for (int i = 0; i < 7; i++)
+        cb.push_front(i);
+
+    cb.pop_back(2);
+    ASSERT_EQ(cb.size(), 1u);
+    EXPECT_EQ(cb[0], 6);
+
+    cb.push_front(7);
+    cb.push_front(8);
+    cb.push_front(9);
+    ASSERT_EQ(cb.size(), 3u);
+    EXPECT_EQ(cb[0], 7);
+    EXPECT_EQ(cb[2], 9);
+
+    cb.clear();
+    EXPECT_EQ(cb.size(), 0u);
+    EXPECT_TRUE(cb.begin() == cb.end());
+}
+
+TEST(SpmcRingTest, ReadsInOrder)
+{
+    SpmcRing<int> ring(8);
+    EXPECT_EQ(ring.Capacity(), 8u);
+
+    std::vector<int> out;
+    uint64_t lost = 1;
+    uint64_t pos = ring.Read(0, &out, &lost);
+    EXPECT_EQ(pos, 0u);
+    EXPECT_TRUE(out.empty());
+    EXPECT_EQ(lost, 0u);
+
+    for (int i = 0; i < 5; i++)
+        ring.Push(i);
+    pos = ring.Read(pos, &out, &lost);
+    EXPECT_EQ(pos, 5u);
+    EXPECT_EQ(lost, 0u);
+    EXPECT_EQ(out, std::vector<int>({ 0, 1, 2, 3, 4 }));
+
+    // the next read picks up where the last one stopped, across the end of the storage
+    for (int i = 5; i < 11; i++)
+        ring.Push(i);
+    out.clear();
+    pos = ring.Read(pos, &out, &lost);
+    EXPECT_EQ(pos, 11u);
+    EXPECT_EQ(lost, 0u);
+    EXPECT_EQ(out, std::vector<int>({ 5, 6, 7, 8, 9, 10 }));
+}
+
+TEST(SpmcRingTest, SpansWrap)
+{
+    SpmcRing<int> ring(4);
+    for (int i = 0; i < 6; i++)
+        ring.Push(i);
+
+    SpmcRing<int>::Span spans[2];
+    uint64_t first = ring.Spans(3, spans);
+    EXPECT_EQ(first, 3u);
+    ASSERT_EQ(spans[0].size, 1u);
+    ASSERT_EQ(spans[1].size, 2u);
+    EXPECT_EQ(spans[0].data[0], 3);
+    EXPECT_EQ(spans[1].data[0], 4);
+    EXPECT_EQ(spans[1].data[1], 5);
+    EXPECT_LE(ring.ValidFrom(), first);
+}
+
+TEST(SpmcRingTest, ReportsOverwrittenEntries)
+{
+    SpmcRing<int> ring(4);
+    for (int i = 0; i < 10; i++)
+        ring.Push(i);
+
+    std::vector<int> out;
+    uint64_t lost;
+    uint64_t pos = ring.Read(0, &out, &lost);
+    EXPECT_EQ(pos, 10u);
+    EXPECT_EQ(lost, 6u);
+    EXPECT_EQ(out, std::vector<int>({ 6, 7, 8, 9 }));
+}
+
+// Entries carry a value derived from their index so that a torn or stale copy shows up
+struct Record
+{
+    uint64_t seq;
+    uint64_t check;
+};
+
+TEST(SpmcRingTest, ConcurrentReaders)
+{
+    enum
+    {
+        Count = 200000,
+        Readers = 3,
+    };
+
+    SpmcRing<Record> ring(64);
+
+    std::vector<std::thread> readers;
+    std::vector<uint64_t> received(Readers), lostTotal(Readers), errors(Readers);
+
+    for (unsigned int r = 0; r < Readers; r++)
+    {
+        readers.emplace_back([&, r]() {
+            std::vector<Record> out;
+            uint64_t pos = 0;
+            uint64_t next = 0;
+            while (pos < Count)
+            {
+                out.clear();
+                uint64_t lost;
+                pos = ring.Read(pos, &out, &lost);
+                lostTotal[r] += lost;
+                for (const Record& rec : out)
+                {
+                    // entries arrive in order, skipping only the ones reported lost
+                    if (rec.seq < next || rec.check != ~rec.seq)
+                        ++errors[r];
+                    next = rec.seq + 1;
+                    ++received[r];
+                }
+            }
+        });
+    }
+
+    for (uint64_t i = 0; i < Count; i++)
+        ring.Push(Record { i, ~i });
+
+    for (std::thread& t : readers)
+        t.join();
+
+    for (unsigned int r = 0; r < Readers; r++)
+    {
+        EXPECT_EQ(errors[r], 0u);
+        EXPECT_EQ(received[r] + lostTotal[r], (uint64_t) Count);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
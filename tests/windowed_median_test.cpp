@@ -0,0 +1,147 @@
+/*
+ *  windowed_median_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <gtest/gtest.h>
+#include "windowed_median.h"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <utility>
+
+// Reference implementation: copy the window and select the middle element, which is what the
+// mass-change checks did before WindowedMedian
+static double ReferenceMedian(const std::deque<std::pair<int64_t, double>>& window)
+{
+    std::vector<double> vals;
+    for (const auto& s : window)
+        vals.push_back(s.second);
+    std::nth_element(vals.begin(), vals.begin() + vals.size() / 2, vals.end());
+    return vals[vals.size() / 2];
+}
+
+TEST(WindowedMedianTest, SingleSample)
+{
+    WindowedMedian m(1000);
+    EXPECT_TRUE(m.Empty());
+    m.Add(0, 42.0);
+    EXPECT_EQ(m.Size(), 1u);
+    EXPECT_EQ(m.Median(), 42.0);
+}
+
+TEST(WindowedMedianTest, EvenCountReturnsUpperMiddle)
+{
+    WindowedMedian m(1000);
+    m.Add(0, 4.0);
+    m.Add(1, 1.0);
+    m.Add(2, 3.0);
+    m.Add(3, 2.0);
+    EXPECT_EQ(m.Median(), 3.0);
+}
+
+TEST(WindowedMedianTest, ExpiresOldSamples)
+{
+    WindowedMedian m(100);
+    m.Add(0, 100.0);
+    m.Add(10, 100.0);
+    m.Add(20, 1.0);
+    EXPECT_EQ(m.Median(), 100.0);
+
+    // the first two samples are now older than the window
+    m.Add(115, 2.0);
+    EXPECT_EQ(m.Size(), 2u);
+    EXPECT_EQ(m.Median(), 2.0);
+
+    m.Expire(1000);
+    EXPECT_TRUE(m.Empty());
+}
+
+TEST(WindowedMedianTest, ClearResets)
+{
+    WindowedMedian m(100);
+    for (int i = 0; i < 10; i++)
+        m.Add(i, i);
+    m.Clear();
+    EXPECT_TRUE(m.Empty());
+    m.Add(20, 7.0);
+    EXPECT_EQ(m.Median(), 7.0);
+}
+
+TEST(WindowedMedianTest, MatchesReferenceAcrossGrowth)
+{
+    // enough samples per window to force the ring to grow several times, with duplicates so the
+    // sorted array sees equal keys
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> step(1, 20);
+    std::uniform_int_distribution<int> value(0, 200);
+
+    WindowedMedian m(5000);
+    std::deque<std::pair<int64_t, double>> ref;
+    int64_t now = 0;
+
+    for (int i = 0; i < 20000; i++)
+    {
+        now += step(rng);
+        double val = value(rng) * 0.5;
+
+        m.Add(now, val);
+        while (!ref.empty() && ref.front().first < now - 5000)
+            ref.pop_front();
+        ref.emplace_back(now, val);
+
+        ASSERT_EQ(m.Size(), ref.size());
+        ASSERT_EQ(m.Median(), ReferenceMedian(ref)) << "at sample " << i;
+    }
+}
+
+TEST(WindowedMedianTest, WindowChangeTakesEffectOnNextAdd)
+{
+    WindowedMedian m(1000);
+    for (int i = 0; i < 10; i++)
+        m.Add(i * 100, i);
+    EXPECT_EQ(m.Size(), 10u);
+
+    m.SetWindow(250);
+    EXPECT_EQ(m.Window(), 250);
+    m.Add(1000, 10.0);
+    // samples at 800, 900 and 1000 remain
+    EXPECT_EQ(m.Size(), 3u);
+    EXPECT_EQ(m.Median(), 9.0);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}